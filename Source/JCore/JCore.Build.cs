@@ -14,6 +14,7 @@ public class JCore : ModuleRules
                 "AIModule",
                 "Core",
                 "Engine",
+                "GameplayTags",
                 "UMG"
             }
         );
@@ -25,6 +26,8 @@ public class JCore : ModuleRules
                 "CoreUObject",
                 "CoreOnline",
                 "Engine",
+                "Json",
+                "NetCore",
                 "Slate",
                 "SlateCore"
             }
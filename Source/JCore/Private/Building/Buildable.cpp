@@ -6,12 +6,22 @@
 #include "Net/UnrealNetwork.h"
 
 #include "JCoreUtils.h"
+#include "Building/BuildingOccupancySubsystem.h"
+#include "Building/ConveyorComponent.h"
+#include "Building/PipeComponent.h"
+#include "Building/PowerComponent.h"
 #include "Graph/GraphNodeComponent.h"
 #include "Graph/GraphSubsystem.h"
 
+DECLARE_STATS_GROUP(TEXT("JCore Buildables"), STATGROUP_JCoreBuildable, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ticking Buildables"), STAT_TickingBuildables, STATGROUP_JCoreBuildable);
+
 ABuildable::ABuildable()
 {
-    PrimaryActorTick.bCanEverTick = true;
+    // Enabled by UpdateTickEnabled while previewing or debugging, placed buildables do not tick
+    PrimaryActorTick.bCanEverTick          = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
     this->bReplicates = true;
 
     this->StaticMeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Static Mesh Component"));
@@ -64,6 +74,26 @@ void ABuildable::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifeti
 void ABuildable::BeginPlay()
 {
     Super::BeginPlay();
+
+    this->UpdateTickEnabled();
+    this->UpdateOccupancy();
+}
+
+void ABuildable::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (this->IsActorTickEnabled())
+    {
+        DEC_DWORD_STAT(STAT_TickingBuildables);
+    }
+
+    this->SetActorTickEnabled(false);
+
+    if (UBuildingOccupancySubsystem* OccupancySubsystem = UWorld::GetSubsystem<UBuildingOccupancySubsystem>(this->GetWorld()))
+    {
+        OccupancySubsystem->RemoveBuildable(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
 }
 
 void ABuildable::Destroyed()
@@ -115,8 +145,33 @@ bool ABuildable::RemoveGraphNode()
     return true;
 }
 
+void ABuildable::UpdateTickEnabled()
+{
+    // Tick only does work on the server
+    const bool bShouldTick = this->HasAuthority() && (this->bDebug || (this->bIsPreviewing && this->RequiresOverlapCheck()));
+
+    if (bShouldTick == this->IsActorTickEnabled())
+    {
+        return;
+    }
+
+    if (bShouldTick)
+    {
+        INC_DWORD_STAT(STAT_TickingBuildables);
+    }
+    else
+    {
+        DEC_DWORD_STAT(STAT_TickingBuildables);
+    }
+
+    this->SetActorTickEnabled(bShouldTick);
+}
+
 void ABuildable::UpdatePreviewing()
 {
+    this->UpdateTickEnabled();
+    this->UpdateOccupancy();
+
     if (this->bIsPreviewing)
     {
         this->SetCollisionProfileName(FName(TEXT("BuildablePreview")));
@@ -129,6 +184,26 @@ void ABuildable::UpdatePreviewing()
     }
 }
 
+void ABuildable::UpdateOccupancy()
+{
+    // Placement is checked on the server and snap points on the clients, so the index is kept everywhere
+    UBuildingOccupancySubsystem* OccupancySubsystem = UWorld::GetSubsystem<UBuildingOccupancySubsystem>(this->GetWorld());
+
+    if (!OccupancySubsystem || !this->HasActorBegunPlay())
+    {
+        return;
+    }
+
+    if (this->bIsPreviewing)
+    {
+        OccupancySubsystem->RemoveBuildable(this);
+    }
+    else
+    {
+        OccupancySubsystem->AddBuildable(this);
+    }
+}
+
 void ABuildable::OnConnectionConnected(UBuildingConnectionComponent* FromConnectedConnection,
                                        UBuildingConnectionComponent* ToConnectedConnection)
 {
@@ -170,19 +245,30 @@ void ABuildable::UpdatePlacementValidity()
         //UE_LOG(LogBuildable, Warning, TEXT("UpdatePlacementValidity: this->Size is FVector::Zero and placement validity will not work"));
     }
 
-    // TODO: Put this in ABuildable as a property?
-    FVector OverlapCushion = this->GetSize() * 0.25f;
-    FVector OverlapCheckHalfExtents = (this->GetSize() - OverlapCushion) / 2.0f;
+    FVector OverlapCheckHalfExtents = this->GetOverlapHalfExtents();
+
+    // Walls origin is at the ground, we need to offset the box overlap check to compensate for this
+    //  Is there a better way to do this?
+    FVector OverlapCheckLocation = this->GetActorLocation() + this->GetOriginOffset();
+
+    // Grid aligned placements are answered by the occupancy index, the physics overlap is the fallback for the others
+    if (const UBuildingOccupancySubsystem* OccupancySubsystem = UWorld::GetSubsystem<UBuildingOccupancySubsystem>(this->GetWorld()))
+    {
+        const EBuildingOccupancy Occupancy = OccupancySubsystem->QueryFootprint(OverlapCheckLocation, this->GetActorQuat(), OverlapCheckHalfExtents, this);
+
+        if (Occupancy != EBuildingOccupancy::Unknown)
+        {
+            this->bValidPlacement = Occupancy == EBuildingOccupancy::Free;
+            this->OnRep_bPlacementValid();
+            return;
+        }
+    }
 
     TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes;
     ObjectTypes.Add(UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_WorldStatic));
 
     const TArray<AActor*> ActorsToIgnore{this};
 
-    // Walls origin is at the ground, we need to offset the box overlap check to compensate for this
-    //  Is there a better way to do this?
-    FVector OverlapCheckLocation = this->GetActorLocation() + this->GetOriginOffset();
-
     TArray<AActor*> OverlappingActors;
     float bIsOverlappingActors = UKismetSystemLibrary::BoxOverlapActors(GetWorld(),
                                                                         OverlapCheckLocation,
@@ -269,6 +355,11 @@ void ABuildable::PostInitializeComponents()
 {
     Super::PostInitializeComponents();
 
+    if (USceneComponent* Root = this->GetRootComponent())
+    {
+        Root->TransformUpdated.AddUObject(this, &ABuildable::OnRootTransformUpdated);
+    }
+
     GetComponents<UBuildingConnectionComponent>(this->BuildingConnectionComponents, true);
 }
 
@@ -287,6 +378,13 @@ const FVector& ABuildable::GetSize() const
     return this->Size;
 }
 
+void ABuildable::SetSize(const FVector& InSize)
+{
+    this->Size = InSize;
+
+    this->UpdateOccupancy();
+}
+
 const FVector& ABuildable::GetOriginOffset() const
 {
     return this->OriginOffset;
@@ -359,10 +457,38 @@ const FVector& ABuildable::GetBuildingOffset() const
     return this->BuildingOffset;
 }
 
+FVector ABuildable::GetOverlapHalfExtents() const
+{
+    // TODO: Put the cushion in ABuildable as a property?
+    const FVector OverlapCushion = this->GetSize() * 0.25f;
+
+    return (this->GetSize() - OverlapCushion) / 2.0f;
+}
+
 void ABuildable::CompleteBuilding(UBuildingConnectionComponent* FromSnapConnection, UBuildingConnectionComponent* ToSnapConnection)
 {
     this->SetIsPreviewing(false);
 
+    // Placed buildables do not move, their snap transforms are read by every placement nearby from now on
+    this->UpdateWorldSnapTransforms();
+
+    // A finished conveyor joins the belts, also when it did not snap to anything
+    if (UConveyorComponent* ConveyorComponent = this->FindComponentByClass<UConveyorComponent>())
+    {
+        ConveyorComponent->MarkSegmentsDirty();
+    }
+
+    // Same for a pipe joining the pipe networks and a generator or consumer joining the power networks
+    if (UPipeComponent* PipeComponent = this->FindComponentByClass<UPipeComponent>())
+    {
+        PipeComponent->UpdateNetwork();
+    }
+
+    if (UPowerComponent* PowerComponent = this->FindComponentByClass<UPowerComponent>())
+    {
+        PowerComponent->UpdateNetwork();
+    }
+
     TArray<UNodeBase*> OutNeighborNodes;
 
     if (FromSnapConnection && ToSnapConnection)
@@ -469,6 +595,13 @@ void ABuildable::SetIsPreviewing(bool InIsPreviewing)
     this->UpdatePreviewing();
 }
 
+void ABuildable::SetDebug(bool bInDebug)
+{
+    this->bDebug = bInDebug;
+
+    this->UpdateTickEnabled();
+}
+
 void ABuildable::SetCollisionProfileName(const FName InCollisionProfileName)
 {
     for (UMeshComponent* MeshComponent : this->MeshComponents)
@@ -500,6 +633,8 @@ void ABuildable::SetSnapTransformsOfType(EBuildingSnapType InSnapType, const TAr
     }
 
     this->SnapTransforms[InSnapType] = InSnapTransforms;
+
+    this->bWorldSnapTransformsDirty = true;
 }
 
 void ABuildable::GetSnapTransformsOfType(EBuildingSnapType InSnapType, TArray<FTransform>& OutSnapTransforms) const
@@ -509,20 +644,61 @@ void ABuildable::GetSnapTransformsOfType(EBuildingSnapType InSnapType, TArray<FT
         return;
     }
 
-    TArray<FTransform> WorldSnapTransforms;
-    for (const FTransform LocalSnapTransform : this->SnapTransforms[InSnapType])
+    const TArrayView<const FTransform> WorldSnapTransformsOfType = this->GetWorldSnapTransformsOfType(InSnapType);
+
+    OutSnapTransforms.Reset(WorldSnapTransformsOfType.Num());
+    OutSnapTransforms.Append(WorldSnapTransformsOfType.GetData(), WorldSnapTransformsOfType.Num());
+}
+
+TArrayView<const FTransform> ABuildable::GetWorldSnapTransformsOfType(EBuildingSnapType InSnapType) const
+{
+    if (this->bWorldSnapTransformsDirty)
+    {
+        this->UpdateWorldSnapTransforms();
+    }
+
+    const TArray<FTransform>* WorldSnapTransformsOfType = this->WorldSnapTransforms.Find(InSnapType);
+
+    return WorldSnapTransformsOfType ? TArrayView<const FTransform>(*WorldSnapTransformsOfType) : TArrayView<const FTransform>();
+}
+
+void ABuildable::UpdateWorldSnapTransforms() const
+{
+    this->bWorldSnapTransformsDirty = false;
+
+    // Keeps the arrays, so a buildable that is moved again does not allocate
+    for (TPair<EBuildingSnapType, TArray<FTransform>>& WorldSnapTransformsOfType : this->WorldSnapTransforms)
+    {
+        WorldSnapTransformsOfType.Value.Reset();
+    }
+
+    for (const TPair<EBuildingSnapType, TArray<FTransform>>& LocalSnapTransformsOfType : this->SnapTransforms)
     {
-        const FQuat WorldQuat  = this->GetTransform().TransformRotation(LocalSnapTransform.GetRotation());
-        const FVector WorldLoc = this->GetTransform().TransformPosition(LocalSnapTransform.GetLocation());
+        TArray<FTransform>& WorldSnapTransformsOfType = this->WorldSnapTransforms.FindOrAdd(LocalSnapTransformsOfType.Key);
+
+        for (const FTransform& LocalSnapTransform : LocalSnapTransformsOfType.Value)
+        {
+            const FQuat WorldQuat  = this->GetTransform().TransformRotation(LocalSnapTransform.GetRotation());
+            const FVector WorldLoc = this->GetTransform().TransformPosition(LocalSnapTransform.GetLocation());
 
-        FTransform WorldSnapTransform = LocalSnapTransform;
-        WorldSnapTransform.SetLocation(WorldLoc);
-        WorldSnapTransform.SetRotation(WorldQuat);
+            FTransform WorldSnapTransform = LocalSnapTransform;
+            WorldSnapTransform.SetLocation(WorldLoc);
+            WorldSnapTransform.SetRotation(WorldQuat);
 
-        WorldSnapTransforms.Add(WorldSnapTransform);
+            WorldSnapTransformsOfType.Add(WorldSnapTransform);
+        }
     }
+}
+
+void ABuildable::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+    this->bWorldSnapTransformsDirty = true;
 
-    OutSnapTransforms = WorldSnapTransforms;
+    // Finished buildables rarely move, e.g. on a client whose final location replicates after the preview state, the footprint follows
+    if (!this->bIsPreviewing)
+    {
+        this->UpdateOccupancy();
+    }
 }
 
 void ABuildable::OnActorLoaded_Implementation()
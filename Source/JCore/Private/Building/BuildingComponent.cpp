@@ -2,6 +2,7 @@
 #include "Building/BuildingComponent.h"
 
 #include "Building/Buildable.h"
+#include "Building/BuildingOccupancySubsystem.h"
 #include "JCoreUtils.h"
 #include "Inventory/BuildingSubsystem.h"
 #include "Inventory/InventoryComponent.h"
@@ -42,6 +43,18 @@ UBuildingComponent::UBuildingComponent()
     this->SetIsReplicatedByDefault(true);
 }
 
+void UBuildingComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Placement checks hash footprints by the grid buildings are placed on
+    if (UBuildingOccupancySubsystem* OccupancySubsystem = UWorld::GetSubsystem<UBuildingOccupancySubsystem>(this->GetWorld()))
+    {
+        OccupancySubsystem->SetGrid(FVector(this->GridTileSizeX, this->GridTileSizeY, this->GridTileSizeZ),
+                                    FVector(this->GridOffsetX, this->GridOffsetY, this->GridOffsetZ));
+    }
+}
+
 void UBuildingComponent::TickComponent(float DeltaTime,
                                        ELevelTick TickType,
                                        FActorComponentTickFunction* ThisTickFunction)
@@ -791,29 +804,22 @@ const FTransform UBuildingComponent::GetClosestBuildableSnapTransform(const FVec
     // Don't rotate if we are building a floor.
     // Rotate if we are building a wall and it's getting snapped to a floor
 
-    TArray<FTransform> PossibleSnapTransforms;
     TArray<FTransform> AvailableSnapTransforms;
 
+    const FVector OverlapCheckHalfExtents = this->CurrentBuildingPreview->GetOverlapHalfExtents();
+
     for (AActor* OverlappedActor : OverlappingActors)
     {
         ABuildable* OverlappedBuildable = Cast<ABuildable>(OverlappedActor);
         if (!OverlappedBuildable) continue;
 
-        TArray<FTransform> BuildableSnapTransforms;
-        OverlappedBuildable->GetSnapTransformsOfType(this->CurrentBuildingPreview->GetSnapType(), BuildableSnapTransforms);
-
-        PossibleSnapTransforms.Append(BuildableSnapTransforms);
-    }
-
-    // TODO: Put this in ABuildable as a property?
-    FVector OverlapCushion = this->CurrentBuildingPreview->GetSize() * 0.25f;
-    FVector OverlapCheckHalfExtents = (this->CurrentBuildingPreview->GetSize() - OverlapCushion) / 2.0f;
-
-    for (const FTransform& PossibleSnapTransform : PossibleSnapTransforms)
-    {
-        if (this->IsSnapPointAvailable(PossibleSnapTransform, OverlapCheckHalfExtents))
+        // Cached on the buildable, read in place
+        for (const FTransform& PossibleSnapTransform : OverlappedBuildable->GetWorldSnapTransformsOfType(this->CurrentBuildingPreview->GetSnapType()))
         {
-            AvailableSnapTransforms.Add(PossibleSnapTransform);
+            if (this->IsSnapPointAvailable(PossibleSnapTransform, OverlapCheckHalfExtents))
+            {
+                AvailableSnapTransforms.Add(PossibleSnapTransform);
+            }
         }
     }
 
@@ -822,6 +828,25 @@ const FTransform UBuildingComponent::GetClosestBuildableSnapTransform(const FVec
 
 bool UBuildingComponent::IsSnapPointAvailable(const FTransform& SnapTransform, const FVector& Extents) const
 {
+    // Grid aligned snap points are answered by the occupancy index, the physics overlap is the fallback for the others
+    if (const UBuildingOccupancySubsystem* OccupancySubsystem = UWorld::GetSubsystem<UBuildingOccupancySubsystem>(this->GetWorld()))
+    {
+        const EBuildingOccupancy Occupancy = OccupancySubsystem->QueryFootprint(SnapTransform.GetLocation() + this->CurrentBuildingPreview->GetOriginOffset(),
+                                                                                SnapTransform.GetRotation(),
+                                                                                Extents,
+                                                                                this->CurrentBuildingPreview);
+
+        if (Occupancy != EBuildingOccupancy::Unknown)
+        {
+            if (this->bDebug && Occupancy == EBuildingOccupancy::Free)
+            {
+                DrawDebugSphere(GetWorld(), SnapTransform.GetLocation(), 30.0f, 10, FColor::Green);
+            }
+
+            return Occupancy == EBuildingOccupancy::Free;
+        }
+    }
+
     TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes;
     ObjectTypes.Add(UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_WorldStatic));
 
@@ -10,7 +10,8 @@
 
 UBuildingConnectionComponent::UBuildingConnectionComponent()
 {
-    PrimaryComponentTick.bCanEverTick = true;
+    // Connections have no per frame logic, tens of thousands of them must not be dispatched every frame
+    PrimaryComponentTick.bCanEverTick = false;
     this->SetIsReplicatedByDefault(true);
 
     this->SetArrowFColor(FColor::White);
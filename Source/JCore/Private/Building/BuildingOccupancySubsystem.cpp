@@ -0,0 +1,191 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/BuildingOccupancySubsystem.h"
+
+#include "Building/Buildable.h"
+
+void UBuildingOccupancySubsystem::Deinitialize()
+{
+    this->Footprints.Empty();
+    this->Cells.Empty();
+
+    Super::Deinitialize();
+}
+
+void UBuildingOccupancySubsystem::SetGrid(const FVector& InTileSize, const FVector& InOffset)
+{
+    if (InTileSize.X <= 0.0 || InTileSize.Y <= 0.0 || InTileSize.Z <= 0.0)
+    {
+        UE_LOG(LogBuildingOccupancySubsystem, Error, TEXT("%hs : Tile size %s is not positive"), __FUNCTION__, *InTileSize.ToString());
+        return;
+    }
+
+    if (InTileSize.Equals(this->TileSize) && InOffset.Equals(this->Offset))
+    {
+        return;
+    }
+
+    this->TileSize = InTileSize;
+    this->Offset   = InOffset;
+
+    this->Cells.Reset();
+
+    for (const TPair<const ABuildable*, FBuildingFootprint>& Footprint : this->Footprints)
+    {
+        this->AddToCells(Footprint.Key, Footprint.Value.Box);
+    }
+}
+
+void UBuildingOccupancySubsystem::AddBuildable(ABuildable* Buildable)
+{
+    if (!Buildable)
+    {
+        UE_LOG(LogBuildingOccupancySubsystem, Error, TEXT("%hs : Buildable is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    this->RemoveBuildable(Buildable);
+
+    // Stored at full size like the collision the physics overlap hits, only the querying footprint is cushioned
+    FBuildingFootprint Footprint;
+    Footprint.bGridAligned = GetFootprintBox(Buildable->GetActorLocation() + Buildable->GetOriginOffset(),
+                                             Buildable->GetActorQuat(),
+                                             Buildable->GetSize() / 2.0,
+                                             Footprint.Box);
+
+    this->Footprints.Add(Buildable, Footprint);
+
+    this->AddToCells(Buildable, Footprint.Box);
+}
+
+void UBuildingOccupancySubsystem::RemoveBuildable(const ABuildable* Buildable)
+{
+    FBuildingFootprint Footprint;
+
+    if (this->Footprints.RemoveAndCopyValue(Buildable, Footprint))
+    {
+        this->RemoveFromCells(Buildable, Footprint.Box);
+    }
+}
+
+EBuildingOccupancy UBuildingOccupancySubsystem::QueryFootprint(const FVector& Center,
+                                                               const FQuat&   Rotation,
+                                                               const FVector& HalfExtents,
+                                                               const AActor*  IgnoredActor) const
+{
+    FBox QueryBox;
+
+    if (!GetFootprintBox(Center, Rotation, HalfExtents, QueryBox))
+    {
+        return EBuildingOccupancy::Unknown;
+    }
+
+    EBuildingOccupancy Occupancy = EBuildingOccupancy::Free;
+
+    this->ForEachCell(QueryBox, [&](const FIntVector& Cell)
+    {
+        const TArray<const ABuildable*>* Occupants = this->Cells.Find(Cell);
+
+        if (!Occupants || Occupancy == EBuildingOccupancy::Occupied)
+        {
+            return;
+        }
+
+        for (const ABuildable* Occupant : *Occupants)
+        {
+            if (Occupant == IgnoredActor)
+            {
+                continue;
+            }
+
+            const FBuildingFootprint& Footprint = this->Footprints.FindChecked(Occupant);
+
+            if (!Footprint.Box.Intersect(QueryBox))
+            {
+                continue;
+            }
+
+            // Only the bounds of an occupant that is not grid aligned are known, an overlap on its own is certain
+            if (Footprint.bGridAligned)
+            {
+                Occupancy = EBuildingOccupancy::Occupied;
+                return;
+            }
+
+            Occupancy = EBuildingOccupancy::Unknown;
+        }
+    });
+
+    return Occupancy;
+}
+
+bool UBuildingOccupancySubsystem::GetFootprintBox(const FVector& Center, const FQuat& Rotation, const FVector& HalfExtents, FBox& OutBox)
+{
+    const FRotator Rotator = Rotation.Rotator();
+
+    const double QuarterTurns = Rotator.Yaw / 90.0;
+
+    const bool bGridAligned = FMath::IsNearlyZero(Rotator.Pitch, KINDA_SMALL_NUMBER)
+                              && FMath::IsNearlyZero(Rotator.Roll, KINDA_SMALL_NUMBER)
+                              && FMath::IsNearlyEqual(QuarterTurns, FMath::RoundToDouble(QuarterTurns), 1.0e-3)
+                              && !HalfExtents.IsNearlyZero();
+
+    if (!bGridAligned)
+    {
+        OutBox = FBox(-HalfExtents, HalfExtents).TransformBy(FTransform(Rotation, Center));
+        return false;
+    }
+
+    // A quarter turn swaps the horizontal extents
+    const bool bSwapped = FMath::Abs(FMath::RoundToInt(QuarterTurns)) % 2 == 1;
+
+    const FVector RotatedExtents = bSwapped ? FVector(HalfExtents.Y, HalfExtents.X, HalfExtents.Z) : HalfExtents;
+
+    OutBox = FBox(Center - RotatedExtents, Center + RotatedExtents);
+    return true;
+}
+
+void UBuildingOccupancySubsystem::ForEachCell(const FBox& Box, TFunctionRef<void(const FIntVector&)> Function) const
+{
+    const FVector MinCell = (Box.Min - this->Offset) / this->TileSize;
+    const FVector MaxCell = (Box.Max - this->Offset) / this->TileSize;
+
+    for (int32 X = FMath::FloorToInt(MinCell.X); X <= FMath::FloorToInt(MaxCell.X); X++)
+    {
+        for (int32 Y = FMath::FloorToInt(MinCell.Y); Y <= FMath::FloorToInt(MaxCell.Y); Y++)
+        {
+            for (int32 Z = FMath::FloorToInt(MinCell.Z); Z <= FMath::FloorToInt(MaxCell.Z); Z++)
+            {
+                Function(FIntVector(X, Y, Z));
+            }
+        }
+    }
+}
+
+void UBuildingOccupancySubsystem::AddToCells(const ABuildable* Buildable, const FBox& Box)
+{
+    this->ForEachCell(Box, [this, Buildable](const FIntVector& Cell)
+    {
+        this->Cells.FindOrAdd(Cell).Add(Buildable);
+    });
+}
+
+void UBuildingOccupancySubsystem::RemoveFromCells(const ABuildable* Buildable, const FBox& Box)
+{
+    this->ForEachCell(Box, [this, Buildable](const FIntVector& Cell)
+    {
+        TArray<const ABuildable*>* Occupants = this->Cells.Find(Cell);
+
+        if (!Occupants)
+        {
+            return;
+        }
+
+        Occupants->RemoveSingleSwap(Buildable, false);
+
+        if (Occupants->Num() == 0)
+        {
+            this->Cells.Remove(Cell);
+        }
+    });
+}
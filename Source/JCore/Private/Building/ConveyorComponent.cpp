@@ -0,0 +1,196 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/ConveyorComponent.h"
+
+#include "Building/Buildable.h"
+#include "Building/ConveyorSubsystem.h"
+
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+
+UConveyorComponent::UConveyorComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+
+    this->SetIsReplicatedByDefault(true);
+}
+
+void UConveyorComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (!this->GetOwner())
+    {
+        return;
+    }
+
+    // Segments are only built where the connections are made, clients draw the items the segments replicate
+    if (this->GetOwner()->HasAuthority())
+    {
+        TArray<UBuildingConnectionComponent*> Connections;
+        this->GetOwner()->GetComponents<UBuildingConnectionComponent>(Connections);
+
+        for (UBuildingConnectionComponent* Connection : Connections)
+        {
+            Connection->OnConnectionConnected.AddUniqueDynamic(this, &UConveyorComponent::OnConnectionConnected);
+            Connection->OnConnectionDisconnected.AddUniqueDynamic(this, &UConveyorComponent::OnConnectionDisconnected);
+        }
+    }
+
+    if (UConveyorSubsystem* ConveyorSubsystem = UWorld::GetSubsystem<UConveyorSubsystem>(this->GetWorld()))
+    {
+        ConveyorSubsystem->RegisterConveyor(this);
+    }
+}
+
+void UConveyorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UConveyorSubsystem* ConveyorSubsystem = UWorld::GetSubsystem<UConveyorSubsystem>(this->GetWorld()))
+    {
+        ConveyorSubsystem->UnregisterConveyor(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UConveyorComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+
+    DOREPLIFETIME_WITH_PARAMS_FAST(UConveyorComponent, SegmentState, Params);
+}
+
+void UConveyorComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+    // Only a client opening the channel reads the state, the others follow the events
+    if (this->bSegmentStateStale)
+    {
+        if (UConveyorSubsystem* ConveyorSubsystem = UWorld::GetSubsystem<UConveyorSubsystem>(this->GetWorld()))
+        {
+            ConveyorSubsystem->WriteSegmentState(this);
+        }
+    }
+
+    Super::PreReplication(ChangedPropertyTracker);
+}
+
+UBuildingConnectionComponent* UConveyorComponent::GetInputConnection() const
+{
+    return this->FindConnection(EBuildingConnectionDirection::Input);
+}
+
+UBuildingConnectionComponent* UConveyorComponent::GetOutputConnection() const
+{
+    return this->FindConnection(EBuildingConnectionDirection::Output);
+}
+
+bool UConveyorComponent::IsTransporting() const
+{
+    const ABuildable* Buildable = Cast<ABuildable>(this->GetOwner());
+
+    if (Buildable && Buildable->IsPreviewing())
+    {
+        return false;
+    }
+
+    return this->GetInputConnection() && this->GetOutputConnection();
+}
+
+void UConveyorComponent::MarkSegmentsDirty()
+{
+    if (UConveyorSubsystem* ConveyorSubsystem = UWorld::GetSubsystem<UConveyorSubsystem>(this->GetWorld()))
+    {
+        ConveyorSubsystem->MarkConveyorDirty(this);
+    }
+}
+
+void UConveyorComponent::SendSegmentState(FConveyorSegmentState&& InSegmentState)
+{
+    this->SetSegmentState(MoveTemp(InSegmentState));
+
+    // Through the same reliable stream as the events, so clients never apply an event to the segment from before the rebuild
+    this->MulticastSegmentState(this->SegmentState);
+}
+
+void UConveyorComponent::SendSegmentEvent(const FConveyorSegmentEvent& Event)
+{
+    // The items are written before the state replicates again, the sequence is read when the segment is rebuilt
+    this->SegmentState.Sequence = Event.Sequence;
+    this->bSegmentStateStale    = true;
+
+    this->MulticastSegmentEvent(Event);
+}
+
+void UConveyorComponent::SetSegmentState(FConveyorSegmentState&& InSegmentState)
+{
+    this->SegmentState       = MoveTemp(InSegmentState);
+    this->bSegmentStateStale = false;
+}
+
+void UConveyorComponent::OnConnectionConnected(UBuildingConnectionComponent* OwnConnection, UBuildingConnectionComponent* OtherConnection)
+{
+    this->MarkSegmentsDirty();
+}
+
+void UConveyorComponent::OnConnectionDisconnected(UBuildingConnectionComponent* OwnConnection)
+{
+    this->MarkSegmentsDirty();
+}
+
+UBuildingConnectionComponent* UConveyorComponent::FindConnection(EBuildingConnectionDirection Direction) const
+{
+    if (!this->GetOwner())
+    {
+        return nullptr;
+    }
+
+    TArray<UBuildingConnectionComponent*> Connections;
+    this->GetOwner()->GetComponents<UBuildingConnectionComponent>(Connections);
+
+    for (UBuildingConnectionComponent* Connection : Connections)
+    {
+        if (Connection && Connection->GetDirection() == Direction)
+        {
+            return Connection;
+        }
+    }
+
+    return nullptr;
+}
+
+void UConveyorComponent::MulticastSegmentState_Implementation(const FConveyorSegmentState& InSegmentState)
+{
+    // A listen server sent it
+    if (this->GetOwner() && this->GetOwner()->HasAuthority())
+    {
+        return;
+    }
+
+    this->SegmentState = InSegmentState;
+
+    this->OnRep_SegmentState();
+}
+
+void UConveyorComponent::MulticastSegmentEvent_Implementation(const FConveyorSegmentEvent& Event)
+{
+    if (this->GetOwner() && this->GetOwner()->HasAuthority())
+    {
+        return;
+    }
+
+    if (UConveyorSubsystem* ConveyorSubsystem = UWorld::GetSubsystem<UConveyorSubsystem>(this->GetWorld()))
+    {
+        ConveyorSubsystem->ApplySegmentEvent(this, Event);
+    }
+}
+
+void UConveyorComponent::OnRep_SegmentState()
+{
+    if (UConveyorSubsystem* ConveyorSubsystem = UWorld::GetSubsystem<UConveyorSubsystem>(this->GetWorld()))
+    {
+        ConveyorSubsystem->ApplySegmentState(this);
+    }
+}
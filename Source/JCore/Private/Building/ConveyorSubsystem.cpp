@@ -0,0 +1,1046 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/ConveyorSubsystem.h"
+
+#include "Building/BuildingConnectionComponent.h"
+#include "Building/ConveyorComponent.h"
+#include "Inventory/InventoryComponent.h"
+#include "Inventory/ItemDataAsset.h"
+#include "Inventory/ItemRegistrySubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+
+DECLARE_STATS_GROUP(TEXT("JCore Conveyors"), STATGROUP_JCoreConveyor, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Advance Segments"), STAT_ConveyorAdvanceSegments, STATGROUP_JCoreConveyor);
+DECLARE_CYCLE_STAT(TEXT("Rebuild Segments"), STAT_ConveyorRebuildSegments, STATGROUP_JCoreConveyor);
+DECLARE_CYCLE_STAT(TEXT("Update Instances"), STAT_ConveyorUpdateInstances, STATGROUP_JCoreConveyor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Segments"), STAT_ConveyorSegments, STATGROUP_JCoreConveyor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Items In Transit"), STAT_ConveyorItems, STATGROUP_JCoreConveyor);
+
+void FConveyorSegment::Advance(float Distance)
+{
+    while (Distance > 0.f && this->MovingIndex < this->ItemIds.Num())
+    {
+        const float MinGap = this->MovingIndex == this->FrontIndex ? 0.f : this->ItemSpacing;
+
+        float& Gap = this->Gaps[this->MovingIndex];
+
+        const float Slack = Gap - MinGap;
+
+        if (Slack > Distance)
+        {
+            Gap           -= Distance;
+            this->TailGap += Distance;
+
+            this->bInstancesDirty = true;
+            return;
+        }
+
+        // The item queues up behind the one ahead of it, what is left of the distance moves the items behind it
+        const float Moved = FMath::Max(Slack, 0.f);
+
+        Gap           -= Moved;
+        this->TailGap += Moved;
+        Distance      -= Moved;
+
+        this->bInstancesDirty |= Moved > 0.f;
+
+        this->MovingIndex++;
+    }
+}
+
+void FConveyorSegment::PushBack(uint16 ItemId)
+{
+    this->ItemIds.Add(ItemId);
+    this->Gaps.Add(this->TailGap);
+
+    this->TailGap = 0.f;
+
+    this->bInstancesDirty = true;
+}
+
+uint16 FConveyorSegment::PopFront()
+{
+    const uint16 ItemId = this->ItemIds[this->FrontIndex];
+
+    // The next item's gap now reaches to the end of the belt
+    if (this->FrontIndex + 1 < this->ItemIds.Num())
+    {
+        this->Gaps[this->FrontIndex + 1] += this->Gaps[this->FrontIndex];
+    }
+    else
+    {
+        this->TailGap += this->Gaps[this->FrontIndex];
+    }
+
+    this->FrontIndex++;
+
+    // The items behind the front one can move up again
+    this->MovingIndex = this->FrontIndex;
+
+    this->bInstancesDirty = true;
+
+    // Dropping the entries that left in batches keeps popping O(1) amortized
+    if (this->FrontIndex == this->ItemIds.Num() || (this->FrontIndex >= 64 && this->FrontIndex * 2 >= this->ItemIds.Num()))
+    {
+        this->ItemIds.RemoveAt(0, this->FrontIndex, false);
+        this->Gaps.RemoveAt(0, this->FrontIndex, false);
+
+        this->MovingIndex -= this->FrontIndex;
+        this->FrontIndex   = 0;
+    }
+
+    return ItemId;
+}
+
+void FConveyorSegment::ApplyEventItems(const FConveyorSegmentEvent& Event)
+{
+    for (int32 i = 0; i < Event.NumPopped && this->GetNumItems() > 0; i++)
+    {
+        this->PopFront();
+    }
+
+    for (const uint16 ItemId : Event.PushedItemIds)
+    {
+        this->PushBack(ItemId);
+    }
+}
+
+void UConveyorSubsystem::Deinitialize()
+{
+    this->Conveyors.Reset();
+    this->Segments.Reset();
+    this->ItemInstances.Reset();
+    this->FreeInstanceBlocks.Reset();
+    this->ItemTransforms.Reset();
+    this->ReplicatedSegmentIndices.Reset();
+    this->PendingStateConveyors.Reset();
+    this->DirtyConveyors.Reset();
+    this->DirtySegmentIndices.Reset();
+    this->ConveyorSegmentIndices.Reset();
+
+    if (IsValid(this->InstancesActor))
+    {
+        this->InstancesActor->Destroy();
+        this->InstancesActor = nullptr;
+    }
+
+    Super::Deinitialize();
+}
+
+void UConveyorSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    const bool bHasSegmentAuthority = this->HasSegmentAuthority();
+
+    if (this->bSegmentsDirty && bHasSegmentAuthority)
+    {
+        this->RebuildSegments();
+    }
+
+    SET_DWORD_STAT(STAT_ConveyorSegments, this->Segments.Num());
+
+    if (this->Segments.Num() == 0)
+    {
+        return;
+    }
+
+    {
+        SCOPE_CYCLE_COUNTER(STAT_ConveyorAdvanceSegments);
+
+        // Segments on clients have no source or sink, only loops hand items from their end to their start there
+        for (FConveyorSegment& Segment : this->Segments)
+        {
+            Segment.Advance(Segment.Speed * DeltaTime);
+
+            this->TransferItems(Segment);
+        }
+    }
+
+    SET_DWORD_STAT(STAT_ConveyorItems, this->GetNumItemsInTransit());
+
+    const ENetMode NetMode = this->GetWorld()->GetNetMode();
+
+    if (bHasSegmentAuthority && NetMode != NM_Standalone)
+    {
+        for (FConveyorSegment& Segment : this->Segments)
+        {
+            if (Segment.bStateDirty || Segment.HasPendingEvent())
+            {
+                this->ReplicateSegment(Segment);
+            }
+        }
+    }
+
+    // Nothing to draw on a dedicated server
+    if (NetMode != NM_DedicatedServer)
+    {
+        SCOPE_CYCLE_COUNTER(STAT_ConveyorUpdateInstances);
+
+        for (FConveyorSegment& Segment : this->Segments)
+        {
+            if (Segment.bInstancesDirty)
+            {
+                this->UpdateSegmentInstances(Segment);
+            }
+        }
+    }
+}
+
+TStatId UConveyorSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UConveyorSubsystem, STATGROUP_Tickables);
+}
+
+void UConveyorSubsystem::RegisterConveyor(UConveyorComponent* Conveyor)
+{
+    if (!Conveyor)
+    {
+        UE_LOG(LogConveyorSubsystem, Error, TEXT("%hs : Conveyor is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    this->Conveyors.AddUnique(Conveyor);
+
+    // The state may have replicated before the conveyor began play, also a state listing this conveyor
+    if (!this->HasSegmentAuthority())
+    {
+        this->ApplySegmentState(Conveyor);
+
+        for (const TWeakObjectPtr<UConveyorComponent>& PendingConveyor : TArray<TWeakObjectPtr<UConveyorComponent>>(this->PendingStateConveyors))
+        {
+            this->ApplySegmentState(PendingConveyor.Get());
+        }
+
+        return;
+    }
+
+    this->MarkConveyorDirty(Conveyor);
+}
+
+void UConveyorSubsystem::UnregisterConveyor(UConveyorComponent* Conveyor)
+{
+    if (this->Conveyors.Remove(Conveyor) == 0)
+    {
+        return;
+    }
+
+    if (!this->HasSegmentAuthority())
+    {
+        this->PendingStateConveyors.Remove(Conveyor);
+        this->RemoveReplicatedSegment(Conveyor);
+        return;
+    }
+
+    this->MarkConveyorDirty(Conveyor);
+}
+
+void UConveyorSubsystem::MarkConveyorDirty(UConveyorComponent* Conveyor)
+{
+    if (!Conveyor || !this->HasSegmentAuthority())
+    {
+        return;
+    }
+
+    this->bSegmentsDirty = true;
+
+    this->DirtyConveyors.AddUnique(Conveyor);
+
+    // A connection change also ends or extends the segments of the conveyors it connected or disconnected
+    for (const UConveyorComponent* AffectedConveyor : {Conveyor, UConveyorSubsystem::GetNextConveyor(Conveyor), UConveyorSubsystem::GetPreviousConveyor(Conveyor)})
+    {
+        if (const int32* SegmentIndex = this->ConveyorSegmentIndices.Find(AffectedConveyor))
+        {
+            this->DirtySegmentIndices.Add(*SegmentIndex);
+        }
+    }
+}
+
+void UConveyorSubsystem::ApplySegmentState(UConveyorComponent* Conveyor)
+{
+    if (!Conveyor || this->HasSegmentAuthority())
+    {
+        return;
+    }
+
+    const FConveyorSegmentState& State = Conveyor->GetSegmentState();
+
+    const int32* SegmentIndex = this->ReplicatedSegmentIndices.Find(Conveyor);
+
+    // Events after the state moved the segment on already
+    if (SegmentIndex && State.Sequence < this->Segments[*SegmentIndex].Sequence)
+    {
+        return;
+    }
+
+    this->PendingStateConveyors.Remove(Conveyor);
+
+    if (State.Conveyors.Num() == 0 || State.ItemIds.Num() != State.Gaps.Num())
+    {
+        this->RemoveReplicatedSegment(Conveyor);
+        return;
+    }
+
+    // Conveyors that did not replicate yet apply the state again when they register, the events until then update the state
+    if (State.Conveyors.Contains(nullptr))
+    {
+        this->RemoveReplicatedSegment(Conveyor);
+        this->PendingStateConveyors.AddUnique(Conveyor);
+        return;
+    }
+
+    if (!SegmentIndex)
+    {
+        SegmentIndex = &this->ReplicatedSegmentIndices.Add(Conveyor, this->Segments.AddDefaulted());
+    }
+
+    FConveyorSegment& Segment = this->Segments[*SegmentIndex];
+    Segment.Sequence = State.Sequence;
+    Segment.Parts.Reset();
+    Segment.Length      = 0.f;
+    Segment.Speed       = MAX_flt;
+    Segment.ItemSpacing = 0.f;
+    Segment.bIsLoop     = State.bIsLoop;
+
+    for (UConveyorComponent* PartConveyor : State.Conveyors)
+    {
+        UConveyorSubsystem::AddSegmentPart(Segment, PartConveyor);
+    }
+
+    Segment.ItemIds     = State.ItemIds;
+    Segment.Gaps        = State.Gaps;
+    Segment.TailGap     = State.TailGap;
+    Segment.FrontIndex  = 0;
+    Segment.MovingIndex = 0;
+
+    // Catches up with the server, as the segment moved on there since the state was sent
+    Segment.Advance(Segment.Speed * static_cast<float>(FMath::Max(this->GetServerWorldTime() - State.ServerTime, 0.0)));
+
+    Segment.bInstancesDirty = true;
+}
+
+void UConveyorSubsystem::ApplySegmentEvent(UConveyorComponent* Conveyor, const FConveyorSegmentEvent& Event)
+{
+    if (!Conveyor || this->HasSegmentAuthority())
+    {
+        return;
+    }
+
+    const int32* SegmentIndex = this->ReplicatedSegmentIndices.Find(Conveyor);
+
+    // No segment to move yet, the state it will be built from takes the event instead
+    if (!SegmentIndex)
+    {
+        const FConveyorSegmentState& State = Conveyor->GetSegmentState();
+
+        if (Event.Sequence <= State.Sequence)
+        {
+            return;
+        }
+
+        FConveyorSegment PendingSegment;
+        PendingSegment.ItemIds = State.ItemIds;
+        PendingSegment.Gaps    = State.Gaps;
+        PendingSegment.TailGap = State.TailGap;
+
+        PendingSegment.ApplyEventItems(Event);
+
+        FConveyorSegmentState PendingState;
+        PendingState.Sequence   = Event.Sequence;
+        PendingState.Conveyors  = State.Conveyors;
+        PendingState.bIsLoop    = State.bIsLoop;
+        PendingState.ItemIds    = MoveTemp(PendingSegment.ItemIds);
+        PendingState.Gaps       = MoveTemp(PendingSegment.Gaps);
+        PendingState.TailGap    = PendingSegment.TailGap;
+        PendingState.ServerTime = State.ServerTime;
+
+        Conveyor->SetSegmentState(MoveTemp(PendingState));
+        return;
+    }
+
+    FConveyorSegment& Segment = this->Segments[*SegmentIndex];
+
+    // Already in the state the segment was built from
+    if (Event.Sequence <= Segment.Sequence)
+    {
+        return;
+    }
+
+    // Events are reliable, a gap means the segment missed some while it was not relevant. The next rebuild corrects it
+    if (Event.Sequence != Segment.Sequence + 1)
+    {
+        UE_LOG(LogConveyorSubsystem, Verbose, TEXT("%hs : %s missed %d events"), __FUNCTION__, *Conveyor->GetName(), Event.Sequence - Segment.Sequence - 1);
+    }
+
+    Segment.Sequence = Event.Sequence;
+
+    Segment.ApplyEventItems(Event);
+
+    // The pushed items entered at the event's time and moved on since, as far as the item ahead lets them
+    if (Event.PushedItemIds.Num() > 0 && Segment.GetNumItems() > 0)
+    {
+        const float TargetTailGap = Event.TailGap + Segment.Speed * static_cast<float>(FMath::Max(this->GetServerWorldTime() - Event.ServerTime, 0.0));
+
+        const int32 LastIndex = Segment.ItemIds.Num() - 1;
+        const float MinGap    = LastIndex == Segment.FrontIndex ? 0.f : Segment.ItemSpacing;
+        const float Moved     = FMath::Clamp(TargetTailGap - Segment.TailGap, 0.f, FMath::Max(Segment.Gaps[LastIndex] - MinGap, 0.f));
+
+        Segment.Gaps[LastIndex] -= Moved;
+        Segment.TailGap         += Moved;
+    }
+
+    Segment.bInstancesDirty = true;
+}
+
+void UConveyorSubsystem::WriteSegmentState(UConveyorComponent* Conveyor) const
+{
+    const int32* SegmentIndex = this->ConveyorSegmentIndices.Find(Conveyor);
+
+    if (!SegmentIndex || this->Segments[*SegmentIndex].Parts[0].Conveyor != Conveyor)
+    {
+        return;
+    }
+
+    Conveyor->SetSegmentState(this->MakeSegmentState(this->Segments[*SegmentIndex]));
+}
+
+int32 UConveyorSubsystem::GetNumItemsInTransit() const
+{
+    int32 NumItems = 0;
+
+    for (const FConveyorSegment& Segment : this->Segments)
+    {
+        NumItems += Segment.GetNumItems();
+    }
+
+    return NumItems;
+}
+
+void UConveyorSubsystem::RebuildSegments()
+{
+    SCOPE_CYCLE_COUNTER(STAT_ConveyorRebuildSegments);
+
+    this->bSegmentsDirty = false;
+
+    TArray<int32> SegmentIndices = this->DirtySegmentIndices.Array();
+    SegmentIndices.Sort(TGreater<int32>());
+
+    this->DirtySegmentIndices.Reset();
+
+    // The items by the conveyor they are on and their distance from its start, so they stay in place on the new segments
+    TMap<const UConveyorComponent*, TArray<TPair<float, uint16>>> ConveyorItems;
+
+    // Conveyors of the rebuilt segments and the changed ones, the only ones the new segments can be made of
+    TArray<UConveyorComponent*> CandidateConveyors;
+
+    // First conveyors of the old segments, the ones not starting a segment anymore stop replicating one
+    TArray<TWeakObjectPtr<UConveyorComponent>> OldFirstConveyors;
+
+    for (const int32 SegmentIndex : SegmentIndices)
+    {
+        FConveyorSegment& Segment = this->Segments[SegmentIndex];
+
+        float DistanceToEnd = 0.f;
+        int32 PartIndex     = Segment.Parts.Num() - 1;
+
+        for (int32 ItemIndex = Segment.FrontIndex; ItemIndex < Segment.ItemIds.Num(); ItemIndex++)
+        {
+            DistanceToEnd += Segment.Gaps[ItemIndex];
+
+            const float Distance = Segment.Length - DistanceToEnd;
+
+            while (PartIndex > 0 && Segment.Parts[PartIndex].StartDistance > Distance)
+            {
+                PartIndex--;
+            }
+
+            if (const UConveyorComponent* Conveyor = Segment.Parts[PartIndex].Conveyor.Get())
+            {
+                ConveyorItems.FindOrAdd(Conveyor).Emplace(Distance - Segment.Parts[PartIndex].StartDistance, Segment.ItemIds[ItemIndex]);
+            }
+        }
+
+        for (const FConveyorSegmentPart& Part : Segment.Parts)
+        {
+            UConveyorComponent* Conveyor = Part.Conveyor.Get();
+
+            this->ConveyorSegmentIndices.Remove(Conveyor);
+
+            // Removed conveyors ended play, they are not rebuilt into a segment
+            if (Conveyor && Conveyor->HasBegunPlay())
+            {
+                CandidateConveyors.AddUnique(Conveyor);
+            }
+        }
+
+        if (Segment.Parts.Num() > 0)
+        {
+            OldFirstConveyors.Add(Segment.Parts[0].Conveyor);
+        }
+
+        this->ReleaseInstanceBlocks(Segment);
+
+        // Descending indices, so the last segment taking this one's place is never one that is still to be removed
+        this->Segments.RemoveAtSwap(SegmentIndex);
+
+        if (this->Segments.IsValidIndex(SegmentIndex))
+        {
+            for (const FConveyorSegmentPart& Part : this->Segments[SegmentIndex].Parts)
+            {
+                this->ConveyorSegmentIndices.Add(Part.Conveyor.Get(), SegmentIndex);
+            }
+        }
+    }
+
+    for (const TWeakObjectPtr<UConveyorComponent>& DirtyConveyor : this->DirtyConveyors)
+    {
+        UConveyorComponent* Conveyor = DirtyConveyor.Get();
+
+        if (Conveyor && Conveyor->HasBegunPlay() && !this->ConveyorSegmentIndices.Contains(Conveyor))
+        {
+            CandidateConveyors.AddUnique(Conveyor);
+        }
+    }
+
+    this->DirtyConveyors.Reset();
+
+    this->Conveyors.RemoveAll([](const TWeakObjectPtr<UConveyorComponent>& Conveyor) { return !Conveyor.IsValid(); });
+
+    const int32 FirstNewSegment = this->Segments.Num();
+
+    TSet<const UConveyorComponent*> VisitedConveyors;
+
+    // Chains start at a conveyor no other conveyor feeds, what is left after them are loops
+    for (UConveyorComponent* Conveyor : CandidateConveyors)
+    {
+        if (Conveyor->IsTransporting() && !VisitedConveyors.Contains(Conveyor) && !UConveyorSubsystem::GetPreviousConveyor(Conveyor))
+        {
+            this->BuildSegment(Conveyor, VisitedConveyors);
+        }
+    }
+
+    for (UConveyorComponent* Conveyor : CandidateConveyors)
+    {
+        if (Conveyor->IsTransporting() && !VisitedConveyors.Contains(Conveyor) && !this->ConveyorSegmentIndices.Contains(Conveyor))
+        {
+            this->BuildSegment(Conveyor, VisitedConveyors);
+
+            this->Segments.Last().bIsLoop = true;
+        }
+    }
+
+    for (int32 SegmentIndex = FirstNewSegment; SegmentIndex < this->Segments.Num(); SegmentIndex++)
+    {
+        FConveyorSegment& Segment = this->Segments[SegmentIndex];
+
+        TArray<TPair<float, uint16>> SegmentItems;
+
+        for (const FConveyorSegmentPart& Part : Segment.Parts)
+        {
+            if (const TArray<TPair<float, uint16>>* PartItems = ConveyorItems.Find(Part.Conveyor.Get()))
+            {
+                for (const TPair<float, uint16>& PartItem : *PartItems)
+                {
+                    SegmentItems.Emplace(FMath::Min(Part.StartDistance + PartItem.Key, Segment.Length), PartItem.Value);
+                }
+            }
+        }
+
+        // Front to back, an item closer than the spacing to the one ahead is pushed back, one pushed off the start is lost
+        SegmentItems.Sort([](const TPair<float, uint16>& A, const TPair<float, uint16>& B) { return A.Key > B.Key; });
+
+        float Position = Segment.Length;
+
+        for (const TPair<float, uint16>& SegmentItem : SegmentItems)
+        {
+            const float MinGap = Segment.ItemIds.Num() == 0 ? 0.f : Segment.ItemSpacing;
+            const float Gap    = FMath::Max(Position - SegmentItem.Key, MinGap);
+
+            if (Position - Gap < 0.f)
+            {
+                break;
+            }
+
+            Segment.ItemIds.Add(SegmentItem.Value);
+            Segment.Gaps.Add(Gap);
+
+            Position -= Gap;
+        }
+
+        Segment.TailGap = Position;
+    }
+
+    for (const TWeakObjectPtr<UConveyorComponent>& OldFirstConveyor : OldFirstConveyors)
+    {
+        UConveyorComponent* Conveyor = OldFirstConveyor.Get();
+
+        if (!Conveyor || Conveyor->GetSegmentState().Conveyors.Num() == 0)
+        {
+            continue;
+        }
+
+        const int32* SegmentIndex = this->ConveyorSegmentIndices.Find(Conveyor);
+
+        if (!SegmentIndex || this->Segments[*SegmentIndex].Parts[0].Conveyor != Conveyor)
+        {
+            FConveyorSegmentState State;
+            State.Sequence = Conveyor->GetSegmentState().Sequence + 1;
+
+            Conveyor->SendSegmentState(MoveTemp(State));
+        }
+    }
+
+    UE_LOG(LogConveyorSubsystem, Verbose, TEXT("%hs : Rebuilt %d segments into %d, %d segments in total"),
+           __FUNCTION__, SegmentIndices.Num(), this->Segments.Num() - FirstNewSegment, this->Segments.Num());
+}
+
+void UConveyorSubsystem::BuildSegment(UConveyorComponent* FirstConveyor, TSet<const UConveyorComponent*>& VisitedConveyors)
+{
+    const int32 SegmentIndex = this->Segments.AddDefaulted();
+
+    FConveyorSegment& Segment = this->Segments[SegmentIndex];
+    Segment.Speed       = MAX_flt;
+    Segment.ItemSpacing = 0.f;
+
+    // Continues the sequence the clients have for this conveyor
+    Segment.Sequence = FirstConveyor->GetSegmentState().Sequence;
+
+    UConveyorComponent* LastConveyor = nullptr;
+
+    for (UConveyorComponent* Conveyor = FirstConveyor;
+         Conveyor && Conveyor->IsTransporting() && !VisitedConveyors.Contains(Conveyor) && !this->ConveyorSegmentIndices.Contains(Conveyor);
+         Conveyor = UConveyorSubsystem::GetNextConveyor(Conveyor))
+    {
+        VisitedConveyors.Add(Conveyor);
+
+        this->ConveyorSegmentIndices.Add(Conveyor, SegmentIndex);
+
+        UConveyorSubsystem::AddSegmentPart(Segment, Conveyor);
+
+        LastConveyor = Conveyor;
+    }
+
+    Segment.TailGap = Segment.Length;
+
+    Segment.SourceInventory = UConveyorSubsystem::GetConnectedInventory(FirstConveyor->GetInputConnection());
+    Segment.SinkInventory   = LastConveyor ? UConveyorSubsystem::GetConnectedInventory(LastConveyor->GetOutputConnection()) : nullptr;
+}
+
+void UConveyorSubsystem::AddSegmentPart(FConveyorSegment& Segment, UConveyorComponent* Conveyor)
+{
+    UBuildingConnectionComponent* Input  = Conveyor->GetInputConnection();
+    UBuildingConnectionComponent* Output = Conveyor->GetOutputConnection();
+
+    FConveyorSegmentPart& Part = Segment.Parts.AddDefaulted_GetRef();
+    Part.Conveyor      = Conveyor;
+    Part.Start         = Input ? Input->GetComponentLocation() : Conveyor->GetOwner()->GetActorLocation();
+    Part.End           = Output ? Output->GetComponentLocation() : Part.Start;
+    Part.StartDistance = Segment.Length;
+    Part.Length        = FVector::Distance(Part.Start, Part.End);
+
+    Segment.Length      += Part.Length;
+    Segment.Speed        = FMath::Min(Segment.Speed, Conveyor->GetSpeed());
+    Segment.ItemSpacing  = FMath::Max(Segment.ItemSpacing, Conveyor->GetItemSpacing());
+}
+
+void UConveyorSubsystem::TransferItems(FConveyorSegment& Segment)
+{
+    UInventoryComponent* SinkInventory = Segment.SinkInventory.Get();
+
+    while (Segment.IsFrontAtEnd())
+    {
+        if (Segment.bIsLoop)
+        {
+            if (!Segment.CanPushBack())
+            {
+                break;
+            }
+
+            Segment.PushBack(Segment.PopFront());
+            continue;
+        }
+
+        UItemDataAsset* Item = UItemRegistrySubsystem::Get() ? UItemRegistrySubsystem::Get()->GetItem(Segment.ItemIds[Segment.FrontIndex]) : nullptr;
+
+        // A full or missing sink keeps the item at the end, the items behind it queue up
+        if (!SinkInventory || !Item || SinkInventory->AddItemAmount(Item, 1) > 0)
+        {
+            break;
+        }
+
+        Segment.PopFront();
+
+        Segment.NumPoppedSinceEvent++;
+    }
+
+    UInventoryComponent* SourceInventory = Segment.SourceInventory.Get();
+
+    if (!SourceInventory || !Segment.CanPushBack())
+    {
+        return;
+    }
+
+    const TArray<FInventorySlot>& InventorySlots = SourceInventory->GetInventorySlots();
+
+    for (int32 SlotIndex = 0; SlotIndex < InventorySlots.Num(); SlotIndex++)
+    {
+        if (FInventorySlot::IsSlotEmpty(InventorySlots[SlotIndex]))
+        {
+            continue;
+        }
+
+        const uint16 ItemId = InventorySlots[SlotIndex].ItemId;
+
+        if (SourceInventory->TryRemoveItemAtIndex(SlotIndex, 1))
+        {
+            Segment.PushBack(ItemId);
+
+            Segment.PushedSinceEvent.Add(ItemId);
+        }
+
+        break;
+    }
+}
+
+void UConveyorSubsystem::ReplicateSegment(FConveyorSegment& Segment)
+{
+    const bool bStateDirty = Segment.bStateDirty;
+
+    FConveyorSegmentEvent Event;
+    Event.NumPopped     = Segment.NumPoppedSinceEvent;
+    Event.PushedItemIds = MoveTemp(Segment.PushedSinceEvent);
+
+    Segment.bStateDirty         = false;
+    Segment.NumPoppedSinceEvent = 0;
+    Segment.PushedSinceEvent.Reset();
+
+    UConveyorComponent* FirstConveyor = Segment.Parts.Num() > 0 ? Segment.Parts[0].Conveyor.Get() : nullptr;
+
+    if (!FirstConveyor)
+    {
+        return;
+    }
+
+    Segment.Sequence++;
+
+    // A rebuilt segment's items are new to the clients, otherwise only what entered and left the belt is
+    if (bStateDirty)
+    {
+        FirstConveyor->SendSegmentState(this->MakeSegmentState(Segment));
+        return;
+    }
+
+    Event.Sequence   = Segment.Sequence;
+    Event.TailGap    = Segment.TailGap;
+    Event.ServerTime = this->GetServerWorldTime();
+
+    FirstConveyor->SendSegmentEvent(Event);
+}
+
+FConveyorSegmentState UConveyorSubsystem::MakeSegmentState(const FConveyorSegment& Segment) const
+{
+    FConveyorSegmentState State;
+    State.Sequence   = Segment.Sequence;
+    State.bIsLoop    = Segment.bIsLoop;
+    State.TailGap    = Segment.TailGap;
+    State.ServerTime = this->GetServerWorldTime();
+
+    for (const FConveyorSegmentPart& Part : Segment.Parts)
+    {
+        State.Conveyors.Add(Part.Conveyor.Get());
+    }
+
+    State.ItemIds.Reserve(Segment.GetNumItems());
+    State.Gaps.Reserve(Segment.GetNumItems());
+
+    for (int32 ItemIndex = Segment.FrontIndex; ItemIndex < Segment.ItemIds.Num(); ItemIndex++)
+    {
+        State.ItemIds.Add(Segment.ItemIds[ItemIndex]);
+        State.Gaps.Add(Segment.Gaps[ItemIndex]);
+    }
+
+    return State;
+}
+
+void UConveyorSubsystem::RemoveReplicatedSegment(const UConveyorComponent* Conveyor)
+{
+    int32 SegmentIndex = INDEX_NONE;
+
+    if (!this->ReplicatedSegmentIndices.RemoveAndCopyValue(Conveyor, SegmentIndex))
+    {
+        return;
+    }
+
+    this->ReleaseInstanceBlocks(this->Segments[SegmentIndex]);
+
+    this->Segments.RemoveAtSwap(SegmentIndex);
+
+    // The last segment took the removed one's place
+    if (this->Segments.IsValidIndex(SegmentIndex))
+    {
+        this->ReplicatedSegmentIndices.Add(this->Segments[SegmentIndex].Parts[0].Conveyor.Get(), SegmentIndex);
+    }
+}
+
+void UConveyorSubsystem::UpdateSegmentInstances(FConveyorSegment& Segment)
+{
+    Segment.bInstancesDirty = false;
+
+    for (TPair<uint16, TArray<FTransform>>& Transforms : this->ItemTransforms)
+    {
+        Transforms.Value.Reset();
+    }
+
+    float DistanceToEnd = 0.f;
+    int32 PartIndex     = Segment.Parts.Num() - 1;
+
+    // Items go front to back, so the part they are on only moves towards the start
+    for (int32 ItemIndex = Segment.FrontIndex; ItemIndex < Segment.ItemIds.Num(); ItemIndex++)
+    {
+        DistanceToEnd += Segment.Gaps[ItemIndex];
+
+        const float Distance = Segment.Length - DistanceToEnd;
+
+        while (PartIndex > 0 && Segment.Parts[PartIndex].StartDistance > Distance)
+        {
+            PartIndex--;
+        }
+
+        const FConveyorSegmentPart& Part = Segment.Parts[PartIndex];
+
+        const float Alpha = Part.Length > 0.f ? (Distance - Part.StartDistance) / Part.Length : 0.f;
+
+        const FTransform ItemTransform((Part.End - Part.Start).Rotation(), FMath::Lerp(Part.Start, Part.End, Alpha));
+
+        this->ItemTransforms.FindOrAdd(Segment.ItemIds[ItemIndex]).Add(ItemTransform);
+    }
+
+    // Blocks the segment has are rewritten, also to hide the items of an id that left the belt
+    for (int32 BlockIndex = 0; BlockIndex < Segment.InstanceBlocks.Num(); BlockIndex++)
+    {
+        FConveyorInstanceBlock& Block = Segment.InstanceBlocks[BlockIndex];
+
+        TArray<FTransform>& Transforms = this->ItemTransforms.FindOrAdd(Block.ItemId);
+
+        // Grown with the belt's items of that id, which only happens when the items were put closer than the spacing
+        if (Transforms.Num() > Block.NumInstances)
+        {
+            TArray<FTransform> HiddenTransforms;
+            this->WriteInstanceBlock(Block, HiddenTransforms);
+
+            this->FreeInstanceBlocks.Add(Block);
+            Segment.InstanceBlocks.RemoveAtSwap(BlockIndex);
+            BlockIndex--;
+            continue;
+        }
+
+        this->WriteInstanceBlock(Block, Transforms);
+
+        Transforms.Reset();
+    }
+
+    // What is left are ids the segment has no block for yet
+    for (TPair<uint16, TArray<FTransform>>& Transforms : this->ItemTransforms)
+    {
+        if (Transforms.Value.Num() == 0)
+        {
+            continue;
+        }
+
+        // Enough for every item that fits on the belt, so the block is allocated once per item id
+        const int32 NumInstances = FMath::Max(FMath::FloorToInt32(Segment.Length / FMath::Max(Segment.ItemSpacing, 1.f)) + 1, Transforms.Value.Num());
+
+        if (FConveyorInstanceBlock* Block = this->AllocateInstanceBlock(Segment, Transforms.Key, NumInstances))
+        {
+            this->WriteInstanceBlock(*Block, Transforms.Value);
+        }
+    }
+}
+
+void UConveyorSubsystem::ReleaseInstanceBlocks(FConveyorSegment& Segment)
+{
+    TArray<FTransform> HiddenTransforms;
+
+    for (FConveyorInstanceBlock& Block : Segment.InstanceBlocks)
+    {
+        HiddenTransforms.Reset();
+        this->WriteInstanceBlock(Block, HiddenTransforms);
+
+        this->FreeInstanceBlocks.Add(Block);
+    }
+
+    Segment.InstanceBlocks.Reset();
+    Segment.bInstancesDirty = true;
+}
+
+FConveyorInstanceBlock* UConveyorSubsystem::AllocateInstanceBlock(FConveyorSegment& Segment, uint16 ItemId, int32 NumInstances)
+{
+    UInstancedStaticMeshComponent* Instances = this->GetItemInstances(ItemId);
+
+    if (!Instances)
+    {
+        return nullptr;
+    }
+
+    // The smallest free block that fits, so large ones stay for long belts
+    int32 BestFreeIndex = INDEX_NONE;
+
+    for (int32 FreeIndex = 0; FreeIndex < this->FreeInstanceBlocks.Num(); FreeIndex++)
+    {
+        const FConveyorInstanceBlock& FreeBlock = this->FreeInstanceBlocks[FreeIndex];
+
+        if (FreeBlock.ItemId == ItemId && FreeBlock.NumInstances >= NumInstances &&
+            (BestFreeIndex == INDEX_NONE || FreeBlock.NumInstances < this->FreeInstanceBlocks[BestFreeIndex].NumInstances))
+        {
+            BestFreeIndex = FreeIndex;
+        }
+    }
+
+    if (BestFreeIndex != INDEX_NONE)
+    {
+        Segment.InstanceBlocks.Add(this->FreeInstanceBlocks[BestFreeIndex]);
+
+        this->FreeInstanceBlocks.RemoveAtSwap(BestFreeIndex);
+
+        return &Segment.InstanceBlocks.Last();
+    }
+
+    FConveyorInstanceBlock& Block = Segment.InstanceBlocks.AddDefaulted_GetRef();
+    Block.ItemId        = ItemId;
+    Block.FirstInstance = Instances->GetInstanceCount();
+    Block.NumInstances  = NumInstances;
+
+    TArray<FTransform> HiddenTransforms;
+    HiddenTransforms.Init(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), NumInstances);
+
+    Instances->AddInstances(HiddenTransforms, false, true);
+
+    return &Block;
+}
+
+void UConveyorSubsystem::WriteInstanceBlock(FConveyorInstanceBlock& Block, TArray<FTransform>& Transforms)
+{
+    UInstancedStaticMeshComponent* Instances = this->GetItemInstances(Block.ItemId);
+
+    if (!Instances)
+    {
+        return;
+    }
+
+    const int32 NumUsed = Transforms.Num();
+
+    // Instances that showed an item the last time are hidden by scaling them to nothing
+    for (int32 InstanceIndex = NumUsed; InstanceIndex < Block.NumUsed; InstanceIndex++)
+    {
+        Transforms.Add(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector));
+    }
+
+    if (Transforms.Num() > 0)
+    {
+        Instances->BatchUpdateInstancesTransforms(Block.FirstInstance, Transforms, true, true, true);
+    }
+
+    Block.NumUsed = NumUsed;
+}
+
+UInstancedStaticMeshComponent* UConveyorSubsystem::GetItemInstances(uint16 ItemId)
+{
+    if (UInstancedStaticMeshComponent** Instances = this->ItemInstances.Find(ItemId))
+    {
+        return *Instances;
+    }
+
+    UItemDataAsset* Item = UItemRegistrySubsystem::Get() ? UItemRegistrySubsystem::Get()->GetItem(ItemId) : nullptr;
+
+    // Cached as nullptr as well, an item without a mesh is not drawn
+    UInstancedStaticMeshComponent*& Instances = this->ItemInstances.Add(ItemId, nullptr);
+
+    if (!Item || !Item->GetStaticMesh())
+    {
+        return nullptr;
+    }
+
+    if (!this->InstancesActor)
+    {
+        FActorSpawnParameters SpawnParameters;
+        SpawnParameters.ObjectFlags |= RF_Transient;
+
+        this->InstancesActor = this->GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+
+        USceneComponent* Root = NewObject<USceneComponent>(this->InstancesActor, TEXT("Root"));
+        this->InstancesActor->SetRootComponent(Root);
+        Root->RegisterComponent();
+    }
+
+    Instances = NewObject<UInstancedStaticMeshComponent>(this->InstancesActor);
+    Instances->SetStaticMesh(Item->GetStaticMesh());
+    Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Instances->SetupAttachment(this->InstancesActor->GetRootComponent());
+    Instances->RegisterComponent();
+
+    return Instances;
+}
+
+double UConveyorSubsystem::GetServerWorldTime() const
+{
+    const UWorld* World = this->GetWorld();
+
+    // On the server this is the world time the segments move on
+    const AGameStateBase* GameState = World->GetGameState();
+
+    return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+bool UConveyorSubsystem::HasSegmentAuthority() const
+{
+    return this->GetWorld()->GetNetMode() != NM_Client;
+}
+
+UConveyorComponent* UConveyorSubsystem::GetNextConveyor(const UConveyorComponent* Conveyor)
+{
+    UBuildingConnectionComponent* Output = Conveyor ? Conveyor->GetOutputConnection() : nullptr;
+
+    UBuildingConnectionComponent* Connected = Output ? Output->GetConnectedComponent() : nullptr;
+
+    if (!Connected || Connected->GetDirection() != EBuildingConnectionDirection::Input || !Connected->GetOwner())
+    {
+        return nullptr;
+    }
+
+    return Connected->GetOwner()->FindComponentByClass<UConveyorComponent>();
+}
+
+UConveyorComponent* UConveyorSubsystem::GetPreviousConveyor(const UConveyorComponent* Conveyor)
+{
+    UBuildingConnectionComponent* Input = Conveyor ? Conveyor->GetInputConnection() : nullptr;
+
+    UBuildingConnectionComponent* Connected = Input ? Input->GetConnectedComponent() : nullptr;
+
+    if (!Connected || Connected->GetDirection() != EBuildingConnectionDirection::Output || !Connected->GetOwner())
+    {
+        return nullptr;
+    }
+
+    UConveyorComponent* PreviousConveyor = Connected->GetOwner()->FindComponentByClass<UConveyorComponent>();
+
+    return PreviousConveyor && PreviousConveyor->IsTransporting() ? PreviousConveyor : nullptr;
+}
+
+UInventoryComponent* UConveyorSubsystem::GetConnectedInventory(UBuildingConnectionComponent* Connection)
+{
+    UBuildingConnectionComponent* Connected = Connection ? Connection->GetConnectedComponent() : nullptr;
+
+    AActor* ConnectedOwner = Connected ? Connected->GetOwner() : nullptr;
+
+    // Another conveyor is part of the segment, not an endpoint
+    if (!ConnectedOwner || ConnectedOwner->FindComponentByClass<UConveyorComponent>())
+    {
+        return nullptr;
+    }
+
+    return ConnectedOwner->FindComponentByClass<UInventoryComponent>();
+}
@@ -0,0 +1,153 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/NetworkPartition.h"
+
+#include "Building/BuildingConnectionComponent.h"
+#include "Graph/GraphBase.h"
+#include "Graph/GraphNodeComponent.h"
+#include "Graph/GraphSubsystem.h"
+
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+void FNetworkPartition::Build(const TArray<AActor*>& Actors, TFunctionRef<void(const AActor*, TArray<AActor*>&)> GetNeighbors)
+{
+    this->Reset();
+
+    TMap<const AActor*, int32> ActorIndices;
+    ActorIndices.Reserve(Actors.Num());
+
+    for (const AActor* Actor : Actors)
+    {
+        if (Actor && !ActorIndices.Contains(Actor))
+        {
+            ActorIndices.Add(Actor, ActorIndices.Num());
+        }
+    }
+
+    TArray<int32> Parents;
+    Parents.SetNumUninitialized(ActorIndices.Num());
+
+    for (int32 Index = 0; Index < Parents.Num(); Index++)
+    {
+        Parents[Index] = Index;
+    }
+
+    TArray<AActor*> Neighbors;
+
+    for (const TPair<const AActor*, int32>& ActorIndex : ActorIndices)
+    {
+        Neighbors.Reset();
+        GetNeighbors(ActorIndex.Key, Neighbors);
+
+        for (const AActor* Neighbor : Neighbors)
+        {
+            const int32* NeighborIndex = ActorIndices.Find(Neighbor);
+
+            if (!NeighborIndex)
+            {
+                continue;
+            }
+
+            const int32 Root         = FindRoot(Parents, ActorIndex.Value);
+            const int32 NeighborRoot = FindRoot(Parents, *NeighborIndex);
+
+            if (Root != NeighborRoot)
+            {
+                Parents[FMath::Max(Root, NeighborRoot)] = FMath::Min(Root, NeighborRoot);
+            }
+        }
+    }
+
+    // Networks are numbered in the order of their first actor
+    TArray<int32> RootNetworks;
+    RootNetworks.Init(INDEX_NONE, Parents.Num());
+
+    this->NetworkIndices.Reserve(ActorIndices.Num());
+
+    for (const TPair<const AActor*, int32>& ActorIndex : ActorIndices)
+    {
+        int32& Network = RootNetworks[FindRoot(Parents, ActorIndex.Value)];
+
+        if (Network == INDEX_NONE)
+        {
+            Network = this->NumNetworks++;
+        }
+
+        this->NetworkIndices.Add(ActorIndex.Key, Network);
+    }
+}
+
+void FNetworkPartition::Reset()
+{
+    this->NetworkIndices.Reset();
+    this->NumNetworks = 0;
+}
+
+int32 FNetworkPartition::GetNetworkIndex(const AActor* Actor) const
+{
+    const int32* NetworkIndex = this->NetworkIndices.Find(Actor);
+
+    return NetworkIndex ? *NetworkIndex : INDEX_NONE;
+}
+
+void FNetworkPartition::GetConnectedActors(const AActor* Actor, TArray<AActor*>& OutActors)
+{
+    if (!Actor)
+    {
+        return;
+    }
+
+    TArray<UBuildingConnectionComponent*> Connections;
+    Actor->GetComponents<UBuildingConnectionComponent>(Connections);
+
+    for (UBuildingConnectionComponent* Connection : Connections)
+    {
+        const UBuildingConnectionComponent* ConnectedComponent = Connection ? Connection->GetConnectedComponent() : nullptr;
+
+        if (ConnectedComponent && ConnectedComponent->GetOwner())
+        {
+            OutActors.AddUnique(ConnectedComponent->GetOwner());
+        }
+    }
+}
+
+void FNetworkPartition::GetGraphNeighbors(const AActor* Actor, TArray<AActor*>& OutActors)
+{
+    const UWorld* World = Actor ? Actor->GetWorld() : nullptr;
+    const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    UGraphSubsystem* GraphSubsystem = GameInstance ? GameInstance->GetSubsystem<UGraphSubsystem>() : nullptr;
+
+    if (!GraphSubsystem || !GraphSubsystem->GetGraph())
+    {
+        return;
+    }
+
+    const UGraphNodeComponent* GraphNodeComponent = Actor->FindComponentByClass<UGraphNodeComponent>();
+
+    if (!GraphNodeComponent || !GraphNodeComponent->GetNode())
+    {
+        return;
+    }
+
+    for (const UNodeBase* Neighbor : GraphSubsystem->GetGraph()->GetNeighbors(GraphNodeComponent->GetNode()))
+    {
+        // Nodes are owned by the graph node component of their buildable
+        if (AActor* NeighborActor = Neighbor ? Neighbor->GetTypedOuter<AActor>() : nullptr)
+        {
+            OutActors.AddUnique(NeighborActor);
+        }
+    }
+}
+
+int32 FNetworkPartition::FindRoot(TArray<int32>& Parents, int32 Index)
+{
+    while (Parents[Index] != Index)
+    {
+        // Path halving keeps the trees flat
+        Parents[Index] = Parents[Parents[Index]];
+        Index = Parents[Index];
+    }
+
+    return Index;
+}
@@ -0,0 +1,110 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/PipeComponent.h"
+
+#include "Building/Buildable.h"
+#include "Building/BuildingConnectionComponent.h"
+#include "Building/PipeNetworkSubsystem.h"
+
+#include "Engine/World.h"
+
+UPipeComponent::UPipeComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UPipeComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Fluid only moves where the world has authority
+    if (!this->GetOwner() || !this->GetOwner()->HasAuthority())
+    {
+        return;
+    }
+
+    TArray<UBuildingConnectionComponent*> Connections;
+    this->GetOwner()->GetComponents<UBuildingConnectionComponent>(Connections);
+
+    for (UBuildingConnectionComponent* Connection : Connections)
+    {
+        Connection->OnConnectionConnected.AddUniqueDynamic(this, &UPipeComponent::OnConnectionConnected);
+        Connection->OnConnectionDisconnected.AddUniqueDynamic(this, &UPipeComponent::OnConnectionDisconnected);
+    }
+
+    if (UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld()))
+    {
+        PipeNetworkSubsystem->RegisterPipe(this);
+    }
+}
+
+void UPipeComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld()))
+    {
+        PipeNetworkSubsystem->UnregisterPipe(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UPipeComponent::SetCapacity(float InCapacity)
+{
+    this->Capacity = FMath::Max(InCapacity, 0.f);
+}
+
+void UPipeComponent::SetFlowRate(float InFlowRate)
+{
+    const float OldFlowRate = this->FlowRate;
+
+    this->FlowRate = InFlowRate;
+
+    if (UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld()))
+    {
+        PipeNetworkSubsystem->UpdatePipeFlow(this, OldFlowRate);
+    }
+}
+
+float UPipeComponent::GetFillRatio() const
+{
+    const UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld());
+    const FPipeNetwork* Network = PipeNetworkSubsystem ? PipeNetworkSubsystem->GetNetwork(this) : nullptr;
+
+    return Network ? Network->GetFillRatio() : 0.f;
+}
+
+float UPipeComponent::GetSatisfaction() const
+{
+    const UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld());
+    const FPipeNetwork* Network = PipeNetworkSubsystem ? PipeNetworkSubsystem->GetNetwork(this) : nullptr;
+
+    return Network ? Network->Satisfaction : 0.f;
+}
+
+bool UPipeComponent::IsConnectable() const
+{
+    const ABuildable* Buildable = Cast<ABuildable>(this->GetOwner());
+
+    return this->GetOwner() && !(Buildable && Buildable->IsPreviewing());
+}
+
+void UPipeComponent::UpdateNetwork()
+{
+    if (UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld()))
+    {
+        PipeNetworkSubsystem->ConnectPipe(this);
+    }
+}
+
+void UPipeComponent::OnConnectionConnected(UBuildingConnectionComponent* OwnConnection, UBuildingConnectionComponent* OtherConnection)
+{
+    this->UpdateNetwork();
+}
+
+void UPipeComponent::OnConnectionDisconnected(UBuildingConnectionComponent* OwnConnection)
+{
+    if (UPipeNetworkSubsystem* PipeNetworkSubsystem = UWorld::GetSubsystem<UPipeNetworkSubsystem>(this->GetWorld()))
+    {
+        PipeNetworkSubsystem->DisconnectPipe(this);
+    }
+}
@@ -0,0 +1,377 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/PipeNetworkSubsystem.h"
+
+#include "Building/PipeComponent.h"
+
+DECLARE_STATS_GROUP(TEXT("JCore Pipes"), STATGROUP_JCorePipe, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Solve Networks"), STAT_PipeSolveNetworks, STATGROUP_JCorePipe);
+DECLARE_CYCLE_STAT(TEXT("Repartition Networks"), STAT_PipeRepartitionNetworks, STATGROUP_JCorePipe);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Networks"), STAT_PipeNetworks, STATGROUP_JCorePipe);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pipes"), STAT_Pipes, STATGROUP_JCorePipe);
+
+void FPipeNetwork::AddFlow(float FlowRate, float Weight)
+{
+    if (FlowRate > 0.f)
+    {
+        this->Supply += FlowRate * Weight;
+    }
+    else
+    {
+        this->Demand -= FlowRate * Weight;
+    }
+}
+
+void UPipeNetworkSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if (this->NetworksToRepartition.Num() > 0 || this->PipesToConnect.Num() > 0)
+    {
+        this->UpdateNetworks();
+    }
+
+    SET_DWORD_STAT(STAT_PipeNetworks, this->GetNumNetworks());
+    SET_DWORD_STAT(STAT_Pipes, this->PipeNetworkIndices.Num());
+
+    this->TimeSinceSolve += DeltaTime;
+
+    if (this->TimeSinceSolve < SolveInterval)
+    {
+        return;
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_PipeSolveNetworks);
+
+    // The flow rates are constant between two solves, so a long frame is solved in one go
+    for (FPipeNetwork& Network : this->Networks)
+    {
+        // Removed networks have nothing to solve
+        if (Network.Members.Num() > 0)
+        {
+            SolveNetwork(Network, this->TimeSinceSolve);
+        }
+    }
+
+    this->TimeSinceSolve = 0.f;
+}
+
+TStatId UPipeNetworkSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UPipeNetworkSubsystem, STATGROUP_Tickables);
+}
+
+void UPipeNetworkSubsystem::RegisterPipe(UPipeComponent* Pipe)
+{
+    if (!Pipe)
+    {
+        UE_LOG(LogPipeNetworkSubsystem, Error, TEXT("%hs : Pipe is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    if (this->PipeNetworkIndices.Contains(Pipe))
+    {
+        return;
+    }
+
+    // Joins a network in the next tick, previews join once they are finished
+    this->PipeNetworkIndices.Add(Pipe, INDEX_NONE);
+
+    this->ConnectPipe(Pipe);
+}
+
+void UPipeNetworkSubsystem::UnregisterPipe(UPipeComponent* Pipe)
+{
+    int32 NetworkIndex = INDEX_NONE;
+
+    if (!this->PipeNetworkIndices.RemoveAndCopyValue(Pipe, NetworkIndex))
+    {
+        return;
+    }
+
+    this->PipesToConnect.Remove(Pipe);
+
+    if (!this->Networks.IsValidIndex(NetworkIndex))
+    {
+        return;
+    }
+
+    FPipeNetwork& Network = this->Networks[NetworkIndex];
+
+    // The fluid it held is lost with it
+    Network.Volume   = FMath::Max(Network.Volume - Network.GetFillRatio() * Pipe->GetCapacity(), 0.f);
+    Network.Capacity = FMath::Max(Network.Capacity - Pipe->GetCapacity(), 0.f);
+    Network.AddFlow(Pipe->GetFlowRate(), -1.f);
+    Network.Supply = FMath::Max(Network.Supply, 0.f);
+    Network.Demand = FMath::Max(Network.Demand, 0.f);
+    Network.Members.Remove(Pipe);
+
+    // The other members may only have been connected through it
+    this->NetworksToRepartition.Add(NetworkIndex);
+}
+
+void UPipeNetworkSubsystem::UpdatePipeFlow(const UPipeComponent* Pipe, float OldFlowRate)
+{
+    const int32* NetworkIndex = Pipe ? this->PipeNetworkIndices.Find(Pipe) : nullptr;
+
+    // A pipe joins its network with its current flow rate
+    if (!NetworkIndex || !this->Networks.IsValidIndex(*NetworkIndex))
+    {
+        return;
+    }
+
+    FPipeNetwork& Network = this->Networks[*NetworkIndex];
+
+    Network.AddFlow(OldFlowRate, -1.f);
+    Network.AddFlow(Pipe->GetFlowRate());
+
+    // Taking a rate out again can leave a sum slightly below zero
+    Network.Supply = FMath::Max(Network.Supply, 0.f);
+    Network.Demand = FMath::Max(Network.Demand, 0.f);
+}
+
+void UPipeNetworkSubsystem::ConnectPipe(UPipeComponent* Pipe)
+{
+    if (Pipe && this->PipeNetworkIndices.Contains(Pipe))
+    {
+        this->PipesToConnect.AddUnique(Pipe);
+    }
+}
+
+void UPipeNetworkSubsystem::DisconnectPipe(const UPipeComponent* Pipe)
+{
+    const int32* NetworkIndex = Pipe ? this->PipeNetworkIndices.Find(Pipe) : nullptr;
+
+    if (NetworkIndex && this->Networks.IsValidIndex(*NetworkIndex))
+    {
+        this->NetworksToRepartition.Add(*NetworkIndex);
+    }
+}
+
+const FPipeNetwork* UPipeNetworkSubsystem::GetNetwork(const UPipeComponent* Pipe) const
+{
+    const int32* NetworkIndex = Pipe ? this->PipeNetworkIndices.Find(Pipe) : nullptr;
+
+    return NetworkIndex && this->Networks.IsValidIndex(*NetworkIndex) ? &this->Networks[*NetworkIndex] : nullptr;
+}
+
+void UPipeNetworkSubsystem::UpdateNetworks()
+{
+    SCOPE_CYCLE_COUNTER(STAT_PipeRepartitionNetworks);
+
+    // Removed networks leave the set, so every index in it still holds a network
+    const TSet<int32> Repartition = MoveTemp(this->NetworksToRepartition);
+    this->NetworksToRepartition.Reset();
+
+    for (const int32 NetworkIndex : Repartition)
+    {
+        this->RepartitionNetwork(NetworkIndex);
+    }
+
+    const TArray<TWeakObjectPtr<UPipeComponent>> Pipes = MoveTemp(this->PipesToConnect);
+    this->PipesToConnect.Reset();
+
+    for (const TWeakObjectPtr<UPipeComponent>& Pipe : Pipes)
+    {
+        if (Pipe.IsValid())
+        {
+            this->JoinNetwork(Pipe.Get());
+        }
+    }
+}
+
+void UPipeNetworkSubsystem::JoinNetwork(UPipeComponent* Pipe)
+{
+    int32* PipeNetworkIndex = this->PipeNetworkIndices.Find(Pipe);
+
+    if (!PipeNetworkIndex || !Pipe->IsConnectable())
+    {
+        return;
+    }
+
+    TArray<int32> NetworkIndices;
+
+    if (this->Networks.IsValidIndex(*PipeNetworkIndex))
+    {
+        NetworkIndices.Add(*PipeNetworkIndex);
+    }
+
+    TArray<AActor*> Neighbors;
+    FNetworkPartition::GetGraphNeighbors(Pipe->GetOwner(), Neighbors);
+
+    for (const AActor* Neighbor : Neighbors)
+    {
+        const UPipeComponent* NeighborPipe = Neighbor->FindComponentByClass<UPipeComponent>();
+        const int32* NeighborNetworkIndex  = NeighborPipe ? this->PipeNetworkIndices.Find(NeighborPipe) : nullptr;
+
+        if (NeighborNetworkIndex && this->Networks.IsValidIndex(*NeighborNetworkIndex))
+        {
+            NetworkIndices.AddUnique(*NeighborNetworkIndex);
+        }
+    }
+
+    // Not connected to any network yet, it starts its own
+    if (NetworkIndices.Num() == 0)
+    {
+        NetworkIndices.Add(this->AddNetwork());
+    }
+
+    const int32 NetworkIndex = this->MergeNetworks(NetworkIndices);
+
+    if (*PipeNetworkIndex == NetworkIndex)
+    {
+        return;
+    }
+
+    // A new pipe starts empty
+    FPipeNetwork& Network = this->Networks[NetworkIndex];
+
+    Network.Capacity += Pipe->GetCapacity();
+    Network.AddFlow(Pipe->GetFlowRate());
+    Network.Members.Add(Pipe);
+
+    *PipeNetworkIndex = NetworkIndex;
+}
+
+int32 UPipeNetworkSubsystem::AddNetwork()
+{
+    return this->FreeNetworkIndices.Num() > 0 ? this->FreeNetworkIndices.Pop(false) : this->Networks.AddDefaulted();
+}
+
+void UPipeNetworkSubsystem::RemoveNetwork(int32 NetworkIndex)
+{
+    this->Networks[NetworkIndex] = FPipeNetwork();
+
+    this->FreeNetworkIndices.Add(NetworkIndex);
+    this->NetworksToRepartition.Remove(NetworkIndex);
+}
+
+int32 UPipeNetworkSubsystem::MergeNetworks(const TArray<int32>& NetworkIndices)
+{
+    // The largest network stays, so the fewest members are moved
+    int32 TargetIndex = NetworkIndices[0];
+
+    for (const int32 NetworkIndex : NetworkIndices)
+    {
+        if (this->Networks[NetworkIndex].Members.Num() > this->Networks[TargetIndex].Members.Num())
+        {
+            TargetIndex = NetworkIndex;
+        }
+    }
+
+    for (const int32 NetworkIndex : NetworkIndices)
+    {
+        if (NetworkIndex == TargetIndex)
+        {
+            continue;
+        }
+
+        FPipeNetwork& Target = this->Networks[TargetIndex];
+        FPipeNetwork& Merged = this->Networks[NetworkIndex];
+
+        Target.Volume   += Merged.Volume;
+        Target.Capacity += Merged.Capacity;
+        Target.Supply   += Merged.Supply;
+        Target.Demand   += Merged.Demand;
+
+        for (const TWeakObjectPtr<UPipeComponent>& Member : Merged.Members)
+        {
+            if (int32* MemberNetworkIndex = this->PipeNetworkIndices.Find(Member.Get()))
+            {
+                *MemberNetworkIndex = TargetIndex;
+
+                Target.Members.Add(Member);
+            }
+        }
+
+        // A merged network that was to be partitioned again is partitioned as part of the target
+        if (this->NetworksToRepartition.Contains(NetworkIndex))
+        {
+            this->NetworksToRepartition.Add(TargetIndex);
+        }
+
+        this->RemoveNetwork(NetworkIndex);
+    }
+
+    if (NetworkIndices.Num() > 1)
+    {
+        UE_LOG(LogPipeNetworkSubsystem, Verbose, TEXT("%hs : Merged %d networks into network %d"), __FUNCTION__, NetworkIndices.Num(), TargetIndex);
+    }
+
+    return TargetIndex;
+}
+
+void UPipeNetworkSubsystem::RepartitionNetwork(int32 NetworkIndex)
+{
+    TArray<TWeakObjectPtr<UPipeComponent>> Members = MoveTemp(this->Networks[NetworkIndex].Members);
+
+    Members.RemoveAll([](const TWeakObjectPtr<UPipeComponent>& Member) { return !Member.IsValid(); });
+
+    if (Members.Num() == 0)
+    {
+        this->RemoveNetwork(NetworkIndex);
+        return;
+    }
+
+    TArray<AActor*> Actors;
+
+    for (const TWeakObjectPtr<UPipeComponent>& Member : Members)
+    {
+        Actors.Add(Member->GetOwner());
+    }
+
+    FNetworkPartition Partition;
+    Partition.Build(Actors, &FNetworkPartition::GetGraphNeighbors);
+
+    const float FillRatio    = this->Networks[NetworkIndex].GetFillRatio();
+    const float Satisfaction = this->Networks[NetworkIndex].Satisfaction;
+
+    // The first part keeps the network, the other parts get new ones. Each pipe takes the fill ratio along
+    TArray<int32> PartNetworkIndices;
+    PartNetworkIndices.Init(INDEX_NONE, Partition.GetNumNetworks());
+
+    PartNetworkIndices[0] = NetworkIndex;
+
+    for (int32 PartIndex = 1; PartIndex < PartNetworkIndices.Num(); PartIndex++)
+    {
+        PartNetworkIndices[PartIndex] = this->AddNetwork();
+    }
+
+    for (const int32 PartNetworkIndex : PartNetworkIndices)
+    {
+        FPipeNetwork& PartNetwork = this->Networks[PartNetworkIndex];
+        PartNetwork = FPipeNetwork();
+        PartNetwork.Satisfaction = Satisfaction;
+    }
+
+    for (const TWeakObjectPtr<UPipeComponent>& Member : Members)
+    {
+        int32& MemberNetworkIndex = this->PipeNetworkIndices.FindChecked(Member.Get());
+
+        MemberNetworkIndex = PartNetworkIndices[Partition.GetNetworkIndex(Member->GetOwner())];
+
+        FPipeNetwork& PartNetwork = this->Networks[MemberNetworkIndex];
+
+        PartNetwork.Volume   += FillRatio * Member->GetCapacity();
+        PartNetwork.Capacity += Member->GetCapacity();
+        PartNetwork.AddFlow(Member->GetFlowRate());
+        PartNetwork.Members.Add(Member);
+    }
+
+    UE_LOG(LogPipeNetworkSubsystem, Verbose, TEXT("%hs : Partitioned network %d of %d pipes into %d networks"), __FUNCTION__, NetworkIndex, Members.Num(), PartNetworkIndices.Num());
+}
+
+void UPipeNetworkSubsystem::SolveNetwork(FPipeNetwork& Network, float Seconds)
+{
+    const float Inflow  = Network.Supply * Seconds;
+    const float Outflow = Network.Demand * Seconds;
+
+    // Consumers draw from what the network held and what was pumped in meanwhile
+    const float Available = Network.Volume + Inflow;
+
+    Network.Satisfaction = Outflow > 0.f ? FMath::Min(Available / Outflow, 1.f) : 1.f;
+
+    // Pumps stall once the network is full
+    Network.Volume = FMath::Clamp(Available - Outflow, 0.f, Network.Capacity);
+}
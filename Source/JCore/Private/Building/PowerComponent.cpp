@@ -0,0 +1,145 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/PowerComponent.h"
+
+#include "Building/Buildable.h"
+#include "Building/BuildingConnectionComponent.h"
+#include "Building/PowerSubsystem.h"
+#include "Inventory/CraftingComponent.h"
+#include "Inventory/ItemGeneratingComponent.h"
+
+#include "Engine/World.h"
+
+UPowerComponent::UPowerComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UPowerComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Throttled machines only run where the world has authority
+    if (!this->GetOwner() || !this->GetOwner()->HasAuthority())
+    {
+        return;
+    }
+
+    TArray<UBuildingConnectionComponent*> Connections;
+    this->GetOwner()->GetComponents<UBuildingConnectionComponent>(Connections);
+
+    for (UBuildingConnectionComponent* Connection : Connections)
+    {
+        Connection->OnConnectionConnected.AddUniqueDynamic(this, &UPowerComponent::OnConnectionConnected);
+        Connection->OnConnectionDisconnected.AddUniqueDynamic(this, &UPowerComponent::OnConnectionDisconnected);
+    }
+
+    if (UPowerSubsystem* PowerSubsystem = UWorld::GetSubsystem<UPowerSubsystem>(this->GetWorld()))
+    {
+        PowerSubsystem->RegisterPowerComponent(this);
+    }
+}
+
+void UPowerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UPowerSubsystem* PowerSubsystem = UWorld::GetSubsystem<UPowerSubsystem>(this->GetWorld()))
+    {
+        PowerSubsystem->UnregisterPowerComponent(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UPowerComponent::SetPowerSupply(float InPowerSupply)
+{
+    this->PowerSupply = FMath::Max(InPowerSupply, 0.f);
+
+    this->UpdateLedger();
+}
+
+void UPowerComponent::SetPowerDemand(float InPowerDemand)
+{
+    this->PowerDemand = FMath::Max(InPowerDemand, 0.f);
+
+    this->UpdateLedger();
+}
+
+void UPowerComponent::SetIsRunning(bool bInIsRunning)
+{
+    if (this->bIsRunning == bInIsRunning)
+    {
+        return;
+    }
+
+    this->bIsRunning = bInIsRunning;
+
+    this->UpdateLedger();
+}
+
+float UPowerComponent::GetSatisfaction() const
+{
+    const UPowerSubsystem* PowerSubsystem = UWorld::GetSubsystem<UPowerSubsystem>(this->GetWorld());
+    const FPowerNetwork* Network = PowerSubsystem ? PowerSubsystem->GetNetwork(this) : nullptr;
+
+    return Network ? Network->Satisfaction : 0.f;
+}
+
+void UPowerComponent::ApplySatisfaction(float Satisfaction)
+{
+    if (!this->IsConsumer() || !this->GetOwner())
+    {
+        return;
+    }
+
+    TArray<UItemGeneratingComponent*> Generators;
+    this->GetOwner()->GetComponents<UItemGeneratingComponent>(Generators);
+
+    for (UItemGeneratingComponent* Generator : Generators)
+    {
+        Generator->SetThroughputScale(Satisfaction);
+    }
+
+    TArray<UCraftingComponent*> Crafters;
+    this->GetOwner()->GetComponents<UCraftingComponent>(Crafters);
+
+    for (UCraftingComponent* Crafter : Crafters)
+    {
+        Crafter->SetThroughputScale(Satisfaction);
+    }
+}
+
+bool UPowerComponent::IsConnectable() const
+{
+    const ABuildable* Buildable = Cast<ABuildable>(this->GetOwner());
+
+    return this->GetOwner() && !(Buildable && Buildable->IsPreviewing());
+}
+
+void UPowerComponent::UpdateNetwork()
+{
+    if (UPowerSubsystem* PowerSubsystem = UWorld::GetSubsystem<UPowerSubsystem>(this->GetWorld()))
+    {
+        PowerSubsystem->ConnectPowerComponent(this);
+    }
+}
+
+void UPowerComponent::OnConnectionConnected(UBuildingConnectionComponent* OwnConnection, UBuildingConnectionComponent* OtherConnection)
+{
+    this->UpdateNetwork();
+}
+
+void UPowerComponent::OnConnectionDisconnected(UBuildingConnectionComponent* OwnConnection)
+{
+    if (UPowerSubsystem* PowerSubsystem = UWorld::GetSubsystem<UPowerSubsystem>(this->GetWorld()))
+    {
+        PowerSubsystem->DisconnectPowerComponent(this);
+    }
+}
+
+void UPowerComponent::UpdateLedger()
+{
+    if (UPowerSubsystem* PowerSubsystem = UWorld::GetSubsystem<UPowerSubsystem>(this->GetWorld()))
+    {
+        PowerSubsystem->UpdatePowerComponent(this);
+    }
+}
@@ -0,0 +1,355 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Building/PowerSubsystem.h"
+
+#include "Building/PowerComponent.h"
+
+DECLARE_STATS_GROUP(TEXT("JCore Power"), STATGROUP_JCorePower, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Balance Networks"), STAT_PowerBalanceNetworks, STATGROUP_JCorePower);
+DECLARE_CYCLE_STAT(TEXT("Repartition Networks"), STAT_PowerRepartitionNetworks, STATGROUP_JCorePower);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Networks"), STAT_PowerNetworks, STATGROUP_JCorePower);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Changed Networks"), STAT_PowerChangedNetworks, STATGROUP_JCorePower);
+
+void UPowerSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    SET_DWORD_STAT(STAT_PowerNetworks, this->GetNumNetworks());
+    SET_DWORD_STAT(STAT_PowerChangedNetworks, this->ChangedNetworks.Num());
+
+    if (this->ChangedNetworks.Num() > 0)
+    {
+        this->BalanceChangedNetworks();
+    }
+}
+
+TStatId UPowerSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UPowerSubsystem, STATGROUP_Tickables);
+}
+
+void UPowerSubsystem::RegisterPowerComponent(UPowerComponent* PowerComponent)
+{
+    if (!PowerComponent)
+    {
+        UE_LOG(LogPowerSubsystem, Error, TEXT("%hs : PowerComponent is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    if (this->LedgerEntries.Contains(PowerComponent))
+    {
+        return;
+    }
+
+    // Entered in the ledger when it joins a network, previews join once they are finished
+    this->LedgerEntries.Add(PowerComponent);
+
+    this->ConnectPowerComponent(PowerComponent);
+}
+
+void UPowerSubsystem::UnregisterPowerComponent(UPowerComponent* PowerComponent)
+{
+    FPowerLedgerEntry Entry;
+
+    if (!this->LedgerEntries.RemoveAndCopyValue(PowerComponent, Entry) || !this->Networks.IsValidIndex(Entry.NetworkIndex))
+    {
+        return;
+    }
+
+    FPowerNetwork& Network = this->Networks[Entry.NetworkIndex];
+
+    Network.Supply -= Entry.Supply;
+    Network.Demand -= Entry.Demand;
+    Network.Members.Remove(PowerComponent);
+
+    // The other members may only have been connected through it
+    this->RepartitionNetwork(Entry.NetworkIndex);
+}
+
+void UPowerSubsystem::UpdatePowerComponent(const UPowerComponent* PowerComponent)
+{
+    FPowerLedgerEntry* Entry = this->LedgerEntries.Find(PowerComponent);
+
+    if (!Entry)
+    {
+        return;
+    }
+
+    const float Supply = PowerComponent->GetCurrentSupply();
+    const float Demand = PowerComponent->GetCurrentDemand();
+
+    if (this->Networks.IsValidIndex(Entry->NetworkIndex) && (Supply != Entry->Supply || Demand != Entry->Demand))
+    {
+        FPowerNetwork& Network = this->Networks[Entry->NetworkIndex];
+
+        Network.Supply += Supply - Entry->Supply;
+        Network.Demand += Demand - Entry->Demand;
+
+        this->ChangedNetworks.Add(Entry->NetworkIndex);
+    }
+
+    Entry->Supply = Supply;
+    Entry->Demand = Demand;
+}
+
+void UPowerSubsystem::ConnectPowerComponent(UPowerComponent* PowerComponent)
+{
+    FPowerLedgerEntry* Entry = this->LedgerEntries.Find(PowerComponent);
+
+    if (!Entry || !PowerComponent->IsConnectable())
+    {
+        return;
+    }
+
+    TArray<int32> NetworkIndices;
+
+    if (this->Networks.IsValidIndex(Entry->NetworkIndex))
+    {
+        NetworkIndices.Add(Entry->NetworkIndex);
+    }
+
+    TArray<AActor*> Neighbors;
+    FNetworkPartition::GetConnectedActors(PowerComponent->GetOwner(), Neighbors);
+
+    for (const AActor* Neighbor : Neighbors)
+    {
+        const UPowerComponent* NeighborComponent = Neighbor->FindComponentByClass<UPowerComponent>();
+        const FPowerLedgerEntry* NeighborEntry   = NeighborComponent ? this->LedgerEntries.Find(NeighborComponent) : nullptr;
+
+        if (NeighborEntry && this->Networks.IsValidIndex(NeighborEntry->NetworkIndex))
+        {
+            NetworkIndices.AddUnique(NeighborEntry->NetworkIndex);
+        }
+    }
+
+    // Not connected to any network yet, it starts its own
+    if (NetworkIndices.Num() == 0)
+    {
+        NetworkIndices.Add(this->AddNetwork());
+    }
+
+    const int32 NetworkIndex = this->MergeNetworks(NetworkIndices);
+
+    if (Entry->NetworkIndex == NetworkIndex)
+    {
+        return;
+    }
+
+    FPowerNetwork& Network = this->Networks[NetworkIndex];
+
+    Entry->Supply       = PowerComponent->GetCurrentSupply();
+    Entry->Demand       = PowerComponent->GetCurrentDemand();
+    Entry->NetworkIndex = NetworkIndex;
+
+    Network.Supply += Entry->Supply;
+    Network.Demand += Entry->Demand;
+    Network.Members.Add(PowerComponent);
+
+    this->ChangedNetworks.Add(NetworkIndex);
+
+    // Runs at the network's satisfaction right away, the network only broadcasts once its satisfaction changes
+    if (Network.Satisfaction >= 0.f)
+    {
+        PowerComponent->ApplySatisfaction(Network.Satisfaction);
+    }
+}
+
+void UPowerSubsystem::DisconnectPowerComponent(const UPowerComponent* PowerComponent)
+{
+    const FPowerLedgerEntry* Entry = this->LedgerEntries.Find(PowerComponent);
+
+    if (Entry && this->Networks.IsValidIndex(Entry->NetworkIndex))
+    {
+        this->RepartitionNetwork(Entry->NetworkIndex);
+    }
+}
+
+const FPowerNetwork* UPowerSubsystem::GetNetwork(const UPowerComponent* PowerComponent) const
+{
+    const FPowerLedgerEntry* Entry = this->LedgerEntries.Find(PowerComponent);
+
+    return Entry && this->Networks.IsValidIndex(Entry->NetworkIndex) ? &this->Networks[Entry->NetworkIndex] : nullptr;
+}
+
+int32 UPowerSubsystem::AddNetwork()
+{
+    const int32 NetworkIndex = this->FreeNetworkIndices.Num() > 0 ? this->FreeNetworkIndices.Pop(false) : this->Networks.AddDefaulted();
+
+    // Its members ran at no satisfaction of it yet
+    this->Networks[NetworkIndex].Satisfaction = -1.f;
+
+    return NetworkIndex;
+}
+
+void UPowerSubsystem::RemoveNetwork(int32 NetworkIndex)
+{
+    this->Networks[NetworkIndex] = FPowerNetwork();
+
+    this->FreeNetworkIndices.Add(NetworkIndex);
+    this->ChangedNetworks.Remove(NetworkIndex);
+}
+
+int32 UPowerSubsystem::MergeNetworks(const TArray<int32>& NetworkIndices)
+{
+    SCOPE_CYCLE_COUNTER(STAT_PowerRepartitionNetworks);
+
+    // The largest network stays, so the fewest members are moved
+    int32 TargetIndex = NetworkIndices[0];
+
+    for (const int32 NetworkIndex : NetworkIndices)
+    {
+        if (this->Networks[NetworkIndex].Members.Num() > this->Networks[TargetIndex].Members.Num())
+        {
+            TargetIndex = NetworkIndex;
+        }
+    }
+
+    bool bSatisfactionDiffers = false;
+
+    for (const int32 NetworkIndex : NetworkIndices)
+    {
+        if (NetworkIndex == TargetIndex)
+        {
+            continue;
+        }
+
+        FPowerNetwork& Target = this->Networks[TargetIndex];
+        FPowerNetwork& Merged = this->Networks[NetworkIndex];
+
+        Target.Supply += Merged.Supply;
+        Target.Demand += Merged.Demand;
+
+        for (const TWeakObjectPtr<UPowerComponent>& Member : Merged.Members)
+        {
+            if (FPowerLedgerEntry* Entry = this->LedgerEntries.Find(Member.Get()))
+            {
+                Entry->NetworkIndex = TargetIndex;
+
+                Target.Members.Add(Member);
+            }
+        }
+
+        bSatisfactionDiffers |= !FMath::IsNearlyEqual(Merged.Satisfaction, Target.Satisfaction);
+
+        this->RemoveNetwork(NetworkIndex);
+    }
+
+    // The merged members ran at their own network's satisfaction, so they are throttled again even if the target's stays the same
+    if (bSatisfactionDiffers)
+    {
+        this->Networks[TargetIndex].Satisfaction = -1.f;
+    }
+
+    if (NetworkIndices.Num() > 1)
+    {
+        this->ChangedNetworks.Add(TargetIndex);
+
+        UE_LOG(LogPowerSubsystem, Verbose, TEXT("%hs : Merged %d networks into network %d"), __FUNCTION__, NetworkIndices.Num(), TargetIndex);
+    }
+
+    return TargetIndex;
+}
+
+void UPowerSubsystem::RepartitionNetwork(int32 NetworkIndex)
+{
+    SCOPE_CYCLE_COUNTER(STAT_PowerRepartitionNetworks);
+
+    TArray<TWeakObjectPtr<UPowerComponent>> Members = MoveTemp(this->Networks[NetworkIndex].Members);
+
+    Members.RemoveAll([](const TWeakObjectPtr<UPowerComponent>& Member) { return !Member.IsValid(); });
+
+    if (Members.Num() == 0)
+    {
+        this->RemoveNetwork(NetworkIndex);
+        return;
+    }
+
+    TArray<AActor*> Actors;
+
+    for (const TWeakObjectPtr<UPowerComponent>& Member : Members)
+    {
+        Actors.Add(Member->GetOwner());
+    }
+
+    FNetworkPartition Partition;
+    Partition.Build(Actors, &FNetworkPartition::GetConnectedActors);
+
+    const float Satisfaction = this->Networks[NetworkIndex].Satisfaction;
+
+    // The first part keeps the network, the other parts get new ones. All of them start from the satisfaction the members
+    // run at, so a part whose supply still covers its demand as before stays silent
+    TArray<int32> PartNetworkIndices;
+    PartNetworkIndices.Init(INDEX_NONE, Partition.GetNumNetworks());
+
+    PartNetworkIndices[0] = NetworkIndex;
+
+    for (int32 PartIndex = 1; PartIndex < PartNetworkIndices.Num(); PartIndex++)
+    {
+        PartNetworkIndices[PartIndex] = this->AddNetwork();
+    }
+
+    for (const int32 PartNetworkIndex : PartNetworkIndices)
+    {
+        FPowerNetwork& PartNetwork = this->Networks[PartNetworkIndex];
+        PartNetwork.Supply       = 0.0;
+        PartNetwork.Demand       = 0.0;
+        PartNetwork.Satisfaction = Satisfaction;
+
+        this->ChangedNetworks.Add(PartNetworkIndex);
+    }
+
+    for (const TWeakObjectPtr<UPowerComponent>& Member : Members)
+    {
+        FPowerLedgerEntry& Entry = this->LedgerEntries.FindChecked(Member.Get());
+
+        Entry.NetworkIndex = PartNetworkIndices[Partition.GetNetworkIndex(Member->GetOwner())];
+
+        FPowerNetwork& PartNetwork = this->Networks[Entry.NetworkIndex];
+
+        PartNetwork.Supply += Entry.Supply;
+        PartNetwork.Demand += Entry.Demand;
+        PartNetwork.Members.Add(Member);
+    }
+
+    UE_LOG(LogPowerSubsystem, Verbose, TEXT("%hs : Partitioned network %d of %d power components into %d networks"), __FUNCTION__, NetworkIndex, Members.Num(), PartNetworkIndices.Num());
+}
+
+void UPowerSubsystem::BalanceChangedNetworks()
+{
+    SCOPE_CYCLE_COUNTER(STAT_PowerBalanceNetworks);
+
+    // Throttled machines may change their power state and so mark networks changed again, those are balanced next tick
+    const TSet<int32> NetworksToBalance = MoveTemp(this->ChangedNetworks);
+    this->ChangedNetworks.Reset();
+
+    for (const int32 NetworkIndex : NetworksToBalance)
+    {
+        FPowerNetwork& Network = this->Networks[NetworkIndex];
+
+        // Removed networks have no members to throttle
+        if (Network.Members.Num() == 0)
+        {
+            continue;
+        }
+
+        const float Satisfaction = Network.ComputeSatisfaction();
+
+        if (FMath::IsNearlyEqual(Satisfaction, Network.Satisfaction))
+        {
+            continue;
+        }
+
+        Network.Satisfaction = Satisfaction;
+
+        for (const TWeakObjectPtr<UPowerComponent>& Member : Network.Members)
+        {
+            if (UPowerComponent* PowerComponent = Member.Get())
+            {
+                PowerComponent->ApplySatisfaction(Satisfaction);
+            }
+        }
+
+        this->OnSatisfactionChanged.Broadcast(NetworkIndex, Satisfaction);
+    }
+}
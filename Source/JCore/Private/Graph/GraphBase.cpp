@@ -63,6 +63,14 @@ bool UGraphBase::RemoveNode(UNodeBase* NodeToRemove)
         }
     }
 
+    // Drop the node from its neighbors' lists, in a directed graph the nodes with edges to it are only known from the edges
+    for (TPair<UNodeBase*, TArray<UNodeBase*>>& NodeNeighbors : this->Adjacency)
+    {
+        NodeNeighbors.Value.Remove(NodeToRemove);
+    }
+
+    this->Adjacency.Remove(NodeToRemove);
+
     this->Nodes.Remove(NodeToRemove);
     this->OnNodeRemoved.Broadcast(NodeToRemove);
 
@@ -82,6 +90,10 @@ void UGraphBase::AddEdge(UNodeBase* FromNode, UNodeBase* ToNode)
 
     Edge->Source      = FromNode;
     Edge->Destination = ToNode;
+
+    this->Edges.Add(Edge);
+
+    this->AddAdjacency(FromNode, ToNode);
 }
 
 void UGraphBase::RemoveEdge(UNodeBase* FromNode, UNodeBase* ToNode)
@@ -106,6 +118,8 @@ void UGraphBase::RemoveEdge(UNodeBase* FromNode, UNodeBase* ToNode)
     if (EdgeToRemove)
     {
         this->Edges.Remove(EdgeToRemove);
+
+        this->RemoveAdjacency(FromNode, ToNode);
     }
 }
 
@@ -147,6 +161,120 @@ bool UGraphBase::IsRootNode(UNodeBase* InNode)
     return true;
 }
 
+TArray<UNodeBase*> UGraphBase::GetNeighbors(UNodeBase* InNode) const
+{
+    const TArray<UNodeBase*>* Neighbors = this->Adjacency.Find(InNode);
+
+    return Neighbors ? *Neighbors : TArray<UNodeBase*>();
+}
+
+TArray<UNodeBase*> UGraphBase::GetNodesInTopologicalOrder() const
+{
+    TArray<UNodeBase*> OrderedNodes;
+    OrderedNodes.Reserve(this->Nodes.Num());
+
+    TSet<UNodeBase*> VisitedNodes;
+    VisitedNodes.Reserve(this->Nodes.Num());
+
+    TArray<UNodeBase*> NodeQueue;
+    NodeQueue.Reserve(this->Nodes.Num());
+
+    // Kahn's algorithm, a node is queued once every edge into it was visited
+    if (this->bIsDirectedGraph)
+    {
+        TMap<UNodeBase*, int32> InDegrees;
+
+        for (const UEdgeBase* Edge : this->Edges)
+        {
+            if (Edge && Edge->Destination)
+            {
+                InDegrees.FindOrAdd(Edge->Destination)++;
+            }
+        }
+
+        for (UNodeBase* Node : this->Nodes)
+        {
+            if (Node && InDegrees.FindRef(Node) == 0)
+            {
+                NodeQueue.Add(Node);
+                VisitedNodes.Add(Node);
+            }
+        }
+
+        for (int32 QueueIndex = 0; QueueIndex < NodeQueue.Num(); QueueIndex++)
+        {
+            UNodeBase* Node = NodeQueue[QueueIndex];
+
+            OrderedNodes.Add(Node);
+
+            for (UNodeBase* Neighbor : this->GetNeighbors(Node))
+            {
+                int32& InDegree = InDegrees.FindOrAdd(Neighbor);
+
+                if (--InDegree == 0 && !VisitedNodes.Contains(Neighbor))
+                {
+                    NodeQueue.Add(Neighbor);
+                    VisitedNodes.Add(Neighbor);
+                }
+            }
+        }
+    }
+
+    // Whatever is left is on a cycle or undirected, walk it breadth first
+    for (UNodeBase* StartNode : this->Nodes)
+    {
+        if (!StartNode || VisitedNodes.Contains(StartNode)) continue;
+
+        NodeQueue.Reset();
+        NodeQueue.Add(StartNode);
+        VisitedNodes.Add(StartNode);
+
+        for (int32 QueueIndex = 0; QueueIndex < NodeQueue.Num(); QueueIndex++)
+        {
+            UNodeBase* Node = NodeQueue[QueueIndex];
+
+            OrderedNodes.Add(Node);
+
+            for (UNodeBase* Neighbor : this->GetNeighbors(Node))
+            {
+                if (!VisitedNodes.Contains(Neighbor))
+                {
+                    NodeQueue.Add(Neighbor);
+                    VisitedNodes.Add(Neighbor);
+                }
+            }
+        }
+    }
+
+    return OrderedNodes;
+}
+
+void UGraphBase::AddAdjacency(UNodeBase* FromNode, UNodeBase* ToNode)
+{
+    this->Adjacency.FindOrAdd(FromNode).AddUnique(ToNode);
+
+    if (!this->bIsDirectedGraph)
+    {
+        this->Adjacency.FindOrAdd(ToNode).AddUnique(FromNode);
+    }
+}
+
+void UGraphBase::RemoveAdjacency(UNodeBase* FromNode, UNodeBase* ToNode)
+{
+    if (TArray<UNodeBase*>* Neighbors = this->Adjacency.Find(FromNode))
+    {
+        Neighbors->Remove(ToNode);
+    }
+
+    if (!this->bIsDirectedGraph)
+    {
+        if (TArray<UNodeBase*>* Neighbors = this->Adjacency.Find(ToNode))
+        {
+            Neighbors->Remove(FromNode);
+        }
+    }
+}
+
 /*
 bool UGraphBase::BreadthFirstSearch(UNodeBase* SourceNode, UNodeBase* TargetNode)
 {
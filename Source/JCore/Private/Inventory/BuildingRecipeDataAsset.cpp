@@ -3,4 +3,17 @@
 
 #include "Inventory/BuildingRecipeDataAsset.h"
 
+#include "Inventory/RecipeRegistrySubsystem.h"
 
+#if WITH_EDITOR
+void UBuildingRecipeDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // Keep the registry's indexes in sync with the asset
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        RecipeRegistry->RegisterBuildingRecipe(this);
+    }
+}
+#endif
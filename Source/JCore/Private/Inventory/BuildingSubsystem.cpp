@@ -1,5 +1,7 @@
 #include "Inventory/BuildingSubsystem.h"
 
+#include "Inventory/RecipeRegistrySubsystem.h"
+
 #include "AssetRegistry/IAssetRegistry.h"
 #include "Engine/AssetManager.h"
 #include "Kismet/KismetSystemLibrary.h"
@@ -10,6 +12,12 @@ UBuildingSubsystem::UBuildingSubsystem()
 
 void UBuildingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
+    // The registry loads its recipes asynchronously, so take them again whenever they change
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        RecipeRegistry->OnRecipesChanged.AddUObject(this, &UBuildingSubsystem::FindBuildingRecipeAssets);
+    }
+
     this->FindBuildingRecipeAssets();
 
     for (UBuildingRecipeDataAsset* RecipeDataAsset : this->AllBuildingRecipeDataAssets)
@@ -23,6 +31,10 @@ void UBuildingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 void UBuildingSubsystem::Deinitialize()
 {
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        RecipeRegistry->OnRecipesChanged.RemoveAll(this);
+    }
 }
 
 UBuildingRecipeDataAsset* UBuildingSubsystem::GetRecipe(const TSubclassOf<ABuildable> InBuildableClass) const
@@ -33,6 +45,11 @@ UBuildingRecipeDataAsset* UBuildingSubsystem::GetRecipe(const TSubclassOf<ABuild
         return nullptr;
     }
 
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        return RecipeRegistry->GetBuildingRecipe(InBuildableClass);
+    }
+
     for (UBuildingRecipeDataAsset* RecipeDataAsset : this->AllBuildingRecipeDataAssets)
     {
         if (!RecipeDataAsset) continue;
@@ -50,6 +67,13 @@ UBuildingRecipeDataAsset* UBuildingSubsystem::GetRecipe(const TSubclassOf<ABuild
 
 void UBuildingSubsystem::FindBuildingRecipeAssets()
 {
+    // The recipe registry already loaded them
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        this->AllBuildingRecipeDataAssets = RecipeRegistry->GetBuildingRecipes();
+        return;
+    }
+
     UAssetManager& AssetManager = UAssetManager::Get();
     IAssetRegistry& AssetRegistry = AssetManager.GetAssetRegistry();
 
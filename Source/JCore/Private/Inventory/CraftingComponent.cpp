@@ -1,15 +1,32 @@
 // Copyright Joshua Gangl. All Rights Reserved.
 
 #include "Inventory/CraftingComponent.h"
+#include "Inventory/CraftingSchedulerSubsystem.h"
 #include "Inventory/InventoryComponent.h"
+#include "Inventory/ItemRegistrySubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
 
 UCraftingComponent::UCraftingComponent()
 {
     PrimaryComponentTick.bCanEverTick = true;
 
+    this->MaxCraftsPerJob = 100;
+    this->MaxQueuedJobs   = 10;
+
     this->SetIsReplicatedByDefault(true);
 }
 
+void UCraftingComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    // Only the head of the queue replicates, clients derive the progress from its times
+    DOREPLIFETIME(UCraftingComponent, QueueHead);
+}
+
 bool UCraftingComponent::TryCraftRecipe(UItemRecipeDataAsset* Recipe,
                                         UInventoryComponent*  Inventory)
 {
@@ -38,71 +55,672 @@ bool UCraftingComponent::TryCraftRecipeToInventory(UItemRecipeDataAsset* Recipe,
         return false;
     }
 
-    if (!this->InventoryHasItemsInRecipe(Recipe, SourceInventory))
+    if (Recipe->GetInItems().Num() == 0)
     {
-        UE_LOG(LogCraftingComponent, Warning, TEXT("CraftRecipe: Crafting failed, inventory does not have necessary items"))
+        UE_LOG(LogCraftingComponent, Warning, TEXT("CraftRecipe: Crafting failed, recipe has 0 input items"))
         return false;
     }
 
-    if (Recipe->GetInItems().Num() == 0)
+    // A single craft is a batch of one, which checks the inputs and the output space in one pass each
+    return this->TryCraftRecipeBatch(Recipe, SourceInventory, TargetInventory, 1);
+}
+
+bool UCraftingComponent::TryCraftRecipeBatch(UItemRecipeDataAsset* Recipe,
+                                             UInventoryComponent*  SourceInventory,
+                                             UInventoryComponent*  TargetInventory,
+                                             int32                 Count)
+{
+    if (Count <= 0)
     {
-        UE_LOG(LogCraftingComponent, Warning, TEXT("CraftRecipe: Crafting failed, recipe has 0 input items"))
         return false;
     }
 
-    if (!SourceInventory->ContainsGivenItems(Recipe->GetInItems()))
+    if (UCraftingComponent::GetMaxCraftableCount(Recipe, SourceInventory, TargetInventory) < Count)
     {
-        UE_LOG(LogTemp, Warning, TEXT("Source inventory is missing required items"));
+        UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : Crafting failed, cannot craft %d times"), __FUNCTION__, Count);
         return false;
     }
 
-    for (const TPair<UItemDataAsset*, int32> Item : Recipe->GetOutItems())
+    const TMap<UItemDataAsset*, int32> InItems  = Recipe->GetInItems();
+    const TMap<UItemDataAsset*, int32> OutItems = Recipe->GetOutItems();
+
+    for (const TPair<UItemDataAsset*, int32>& Item : InItems)
     {
-        if (!TargetInventory->HasAvailableSpaceForItem(Item.Key, Item.Value))
+        if (!SourceInventory->TryRemoveItem(Item.Key, Item.Value * Count))
         {
-            UE_LOG(LogTemp, Warning, TEXT("Target Inventory doesn't have sufficient space available"));
+            UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : Item removal failed"), __FUNCTION__);
             return false;
         }
     }
 
-    // Remove Recipe In Items
-    bool bItemRemovalSucceeded = SourceInventory->TryRemoveItems(Recipe->GetInItems());
+    for (const TPair<UItemDataAsset*, int32>& Item : OutItems)
+    {
+        if (TargetInventory->AddItemAmount(Item.Key, Item.Value * Count) > 0)
+        {
+            UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : Item addition failed"), __FUNCTION__);
+            return false;
+        }
+    }
 
-    // Add Recipe Out Items
-    bool bItemAdditionSucceeded = TargetInventory->TryAddItems(Recipe->GetOutItems());
+    return true;
+}
 
-    if (!bItemRemovalSucceeded || !bItemAdditionSucceeded)
+void UCraftingComponent::ServerCraftRecipeBatch_Implementation(UItemRecipeDataAsset* Recipe,
+                                                               UInventoryComponent*  SourceInventory,
+                                                               UInventoryComponent*  TargetInventory,
+                                                               int32                 Count)
+{
+    if (!this->CanCraftBetween(SourceInventory, TargetInventory))
     {
-        UE_LOG(LogTemp, Warning, TEXT("Item removal or item addition failed"));
-        return false;
+        return;
     }
 
-    return true;
+    // A client can ask for any count, an unbounded batch would multiply into huge item amounts
+    const int32 MaxCount = UCraftingComponent::GetMaxCraftableCount(Recipe, SourceInventory, TargetInventory);
+
+    if (MaxCount <= 0)
+    {
+        return;
+    }
+
+    this->TryCraftRecipeBatch(Recipe, SourceInventory, TargetInventory, FMath::Clamp(Count, 1, MaxCount));
+}
+
+int32 UCraftingComponent::GetMaxCraftableCount(UItemRecipeDataAsset* Recipe,
+                                               UInventoryComponent*  SourceInventory,
+                                               UInventoryComponent*  TargetInventory)
+{
+    if (!Recipe || !SourceInventory || !TargetInventory)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("%hs : Recipe, SourceInventory or TargetInventory is nullptr"), __FUNCTION__);
+        return 0;
+    }
+
+    struct FInItemCount
+    {
+        uint16 ItemId        = UItemDataAsset::InvalidItemId;
+        int32 AmountPerCraft = 0;
+        int32 AmountHeld     = 0;
+    };
+
+    struct FOutItemSpace
+    {
+        uint16 ItemId           = UItemDataAsset::InvalidItemId;
+        int32 AmountPerCraft    = 0;
+        int32 MaxStackSize      = 0;
+        int32 PartialStackSpace = 0;
+    };
+
+    TArray<FInItemCount> InItemCounts;
+    TArray<FOutItemSpace> OutItemSpaces;
+
+    for (const TPair<UItemDataAsset*, int32>& Item : Recipe->GetInItems())
+    {
+        if (!Item.Key || Item.Value <= 0) continue;
+
+        FInItemCount& InItemCount = InItemCounts.AddDefaulted_GetRef();
+        InItemCount.ItemId         = UItemRegistrySubsystem::GetItemId(Item.Key);
+        InItemCount.AmountPerCraft = Item.Value;
+    }
+
+    for (const TPair<UItemDataAsset*, int32>& Item : Recipe->GetOutItems())
+    {
+        if (!Item.Key || Item.Value <= 0) continue;
+
+        FOutItemSpace& OutItemSpace = OutItemSpaces.AddDefaulted_GetRef();
+        OutItemSpace.ItemId         = UItemRegistrySubsystem::GetItemId(Item.Key);
+        OutItemSpace.AmountPerCraft = Item.Value;
+        OutItemSpace.MaxStackSize   = UItemRegistrySubsystem::GetMaxStackSize(OutItemSpace.ItemId);
+    }
+
+    if (InItemCounts.Num() == 0)
+    {
+        return 0;
+    }
+
+    // One pass over the source for the held amounts of all inputs
+    for (const FInventorySlot& InventorySlot : SourceInventory->GetInventorySlots())
+    {
+        for (FInItemCount& InItemCount : InItemCounts)
+        {
+            InItemCount.AmountHeld += InventorySlot.ItemId == InItemCount.ItemId ? InventorySlot.CurrentStackSize : 0;
+        }
+    }
+
+    int32 MaxCount = MAX_int32;
+
+    for (const FInItemCount& InItemCount : InItemCounts)
+    {
+        MaxCount = FMath::Min(MaxCount, InItemCount.AmountHeld / InItemCount.AmountPerCraft);
+    }
+
+    if (MaxCount == 0 || OutItemSpaces.Num() == 0)
+    {
+        return MaxCount;
+    }
+
+    // One pass over the target for the partial stack space of all outputs and the empty slots they share
+    int32 NumEmptySlots = 0;
+
+    for (const FInventorySlot& InventorySlot : TargetInventory->GetInventorySlots())
+    {
+        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+        {
+            NumEmptySlots++;
+            continue;
+        }
+
+        for (FOutItemSpace& OutItemSpace : OutItemSpaces)
+        {
+            if (InventorySlot.ItemId == OutItemSpace.ItemId)
+            {
+                OutItemSpace.PartialStackSpace += FMath::Max(OutItemSpace.MaxStackSize - InventorySlot.CurrentStackSize, 0);
+            }
+        }
+    }
+
+    auto OutputsFit = [&OutItemSpaces, NumEmptySlots](int32 Count)
+    {
+        int64 NumSlotsNeeded = 0;
+
+        for (const FOutItemSpace& OutItemSpace : OutItemSpaces)
+        {
+            if (OutItemSpace.MaxStackSize <= 0)
+            {
+                return false;
+            }
+
+            const int64 AmountLeft = FMath::Max<int64>(static_cast<int64>(OutItemSpace.AmountPerCraft) * Count - OutItemSpace.PartialStackSpace, 0);
+
+            NumSlotsNeeded += (AmountLeft + OutItemSpace.MaxStackSize - 1) / OutItemSpace.MaxStackSize;
+        }
+
+        return NumSlotsNeeded <= NumEmptySlots;
+    };
+
+    // The slots the outputs need only grow with the count, so binary search the largest count that fits
+    int32 Low  = 0;
+    int32 High = MaxCount;
+
+    while (Low < High)
+    {
+        const int32 Mid = Low + (High - Low + 1) / 2;
+
+        if (OutputsFit(Mid))
+        {
+            Low = Mid;
+        }
+        else
+        {
+            High = Mid - 1;
+        }
+    }
+
+    return Low;
 }
 
 void UCraftingComponent::ServerCraftRecipe_Implementation(UItemRecipeDataAsset* Recipe,
                                                           UInventoryComponent*  SourceInventory,
-                                                          UInventoryComponent*  TargetInventory)
+                                                          UInventoryComponent*  TargetInventory,
+                                                          int32                 PredictionKey)
 {
+    bool bCrafted = false;
+
     if (!Recipe)
     {
         UE_LOG(LogCraftingComponent, Error, TEXT("ServerCraftRecipe: Recipe is nullptr"))
+    }
+    else if (!SourceInventory)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("ServerCraftRecipe: SourceInventory is nullptr"))
+    }
+    else if (!TargetInventory)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("ServerCraftRecipe: TargetInventory is nullptr"))
+    }
+    else
+    {
+        bCrafted = this->TryCraftRecipeToInventory(Recipe, SourceInventory, TargetInventory);
+    }
+
+    if (PredictionKey != 0)
+    {
+        this->ClientResolveCraftPrediction(PredictionKey,
+                                           bCrafted,
+                                           SourceInventory ? SourceInventory->GetSlotSequence() : 0,
+                                           TargetInventory ? TargetInventory->GetSlotSequence() : 0);
+    }
+}
+
+void UCraftingComponent::CraftRecipe(UItemRecipeDataAsset* Recipe,
+                                     UInventoryComponent*  SourceInventory,
+                                     UInventoryComponent*  TargetInventory)
+{
+    int32 PredictionKey = 0;
+
+    const bool bCanPredict = Recipe
+                             && SourceInventory
+                             && TargetInventory
+                             && SourceInventory->CanPredict()
+                             && this->InventoryHasItemsInRecipe(Recipe, SourceInventory);
+
+    if (bCanPredict)
+    {
+        PredictionKey = UInventoryComponent::CreatePredictionKey();
+
+        for (const TPair<UItemDataAsset*, int32> Item : Recipe->GetInItems())
+        {
+            SourceInventory->PredictRemoveItem(PredictionKey, Item.Key, Item.Value);
+        }
+
+        for (const TPair<UItemDataAsset*, int32> Item : Recipe->GetOutItems())
+        {
+            TargetInventory->PredictAddItem(PredictionKey, Item.Key, Item.Value);
+        }
+
+        TArray<TWeakObjectPtr<UInventoryComponent>>& Inventories = this->PredictedCraftInventories.Add(PredictionKey);
+        Inventories.Add(SourceInventory);
+        Inventories.AddUnique(TargetInventory);
+    }
+
+    this->ServerCraftRecipe(Recipe, SourceInventory, TargetInventory, PredictionKey);
+}
+
+void UCraftingComponent::ClientResolveCraftPrediction_Implementation(int32 PredictionKey,
+                                                                     bool bCrafted,
+                                                                     int32 SourceSequence,
+                                                                     int32 TargetSequence)
+{
+    TArray<TWeakObjectPtr<UInventoryComponent>> Inventories;
+
+    if (!this->PredictedCraftInventories.RemoveAndCopyValue(PredictionKey, Inventories))
+    {
         return;
     }
 
-    if (!SourceInventory)
+    // The source inventory was added first, see CraftRecipe
+    for (int32 i = 0; i < Inventories.Num(); i++)
+    {
+        if (Inventories[i].IsValid())
+        {
+            Inventories[i]->ResolvePrediction(PredictionKey, bCrafted, i == 0 ? SourceSequence : TargetSequence);
+        }
+    }
+}
+
+int32 UCraftingComponent::QueueCraft(UItemRecipeDataAsset* Recipe,
+                                     UInventoryComponent*  SourceInventory,
+                                     UInventoryComponent*  TargetInventory,
+                                     int32                 NumCrafts)
+{
+    if (!Recipe || !SourceInventory || !TargetInventory)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("%hs : Recipe, SourceInventory or TargetInventory is nullptr"), __FUNCTION__);
+        return 0;
+    }
+
+    if (NumCrafts <= 0 || Recipe->GetInItems().Num() == 0)
+    {
+        UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : Nothing to craft"), __FUNCTION__);
+        return 0;
+    }
+
+    FCraftingJob& Job = this->CraftingQueue.AddDefaulted_GetRef();
+    Job.JobId           = this->NextJobId++;
+    Job.Recipe          = Recipe;
+    Job.NumCrafts       = NumCrafts;
+    Job.SourceInventory = SourceInventory;
+    Job.TargetInventory = TargetInventory;
+
+    const int32 JobId = Job.JobId;
+
+    if (this->CraftingQueue.Num() == 1)
+    {
+        this->StartQueueHead(this->GetServerWorldTime());
+    }
+    else
+    {
+        this->UpdateQueueHead(this->QueueHead.StartTime, this->QueueHead.CompletionTime);
+    }
+
+    return JobId;
+}
+
+void UCraftingComponent::ServerQueueCraft_Implementation(UItemRecipeDataAsset* Recipe,
+                                                         UInventoryComponent*  SourceInventory,
+                                                         UInventoryComponent*  TargetInventory,
+                                                         int32                 NumCrafts)
+{
+    if (!this->CanCraftBetween(SourceInventory, TargetInventory))
     {
-        UE_LOG(LogCraftingComponent, Error, TEXT("ServerCraftRecipe: SourceInventory is nullptr"))
         return;
     }
 
-    if (!TargetInventory)
+    // Every queued job is checked again on completion, a client could otherwise grow the queue without bound
+    if (this->CraftingQueue.Num() >= this->MaxQueuedJobs)
     {
-        UE_LOG(LogCraftingComponent, Error, TEXT("ServerCraftRecipe: TargetInventory is nullptr"))
+        UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : %s already has %d jobs queued"), __FUNCTION__, *GetName(), this->CraftingQueue.Num());
+        return;
+    }
+
+    this->QueueCraft(Recipe, SourceInventory, TargetInventory, FMath::Min(NumCrafts, this->MaxCraftsPerJob));
+}
+
+bool UCraftingComponent::CancelCraft(int32 JobId)
+{
+    const int32 JobIndex = this->CraftingQueue.IndexOfByPredicate([JobId](const FCraftingJob& Job) { return Job.JobId == JobId; });
+
+    if (JobIndex == INDEX_NONE)
+    {
+        return false;
+    }
+
+    this->CraftingQueue.RemoveAt(JobIndex);
+
+    // The scheduled completion of a cancelled head job no longer matches the head and is skipped
+    if (JobIndex == 0)
+    {
+        this->StartQueueHead(this->GetServerWorldTime());
+    }
+    else
+    {
+        this->UpdateQueueHead(this->QueueHead.StartTime, this->QueueHead.CompletionTime);
+    }
+
+    return true;
+}
+
+void UCraftingComponent::ServerCancelCraft_Implementation(int32 JobId)
+{
+    this->CancelCraft(JobId);
+}
+
+void UCraftingComponent::CompleteCraft(int32 JobId, double CompletionTime)
+{
+    if (this->CraftingQueue.Num() == 0 || this->CraftingQueue[0].JobId != JobId || this->QueueHead.CompletionTime != CompletionTime)
+    {
+        return;
+    }
+
+    this->CraftQueueHead();
+
+    // The next craft starts when this one completed, not when the scheduler got to it
+    this->StartQueueHead(CompletionTime);
+}
+
+void UCraftingComponent::SetThroughputScale(float InThroughputScale)
+{
+    InThroughputScale = FMath::Max(InThroughputScale, 0.f);
+
+    if (InThroughputScale == this->ThroughputScale)
+    {
+        return;
+    }
+
+    const double Now = this->GetServerWorldTime();
+
+    const double RemainingCraftTime = this->ThroughputScale > 0.f
+                                      ? FMath::Max(this->QueueHead.CompletionTime - Now, 0.0) * this->ThroughputScale
+                                      : this->PausedCraftTime;
+
+    this->ThroughputScale = InThroughputScale;
+
+    if (this->CraftingQueue.Num() > 0)
+    {
+        this->ScheduleQueueHead(Now, RemainingCraftTime);
+    }
+}
+
+void UCraftingComponent::FastForwardQueue(double Seconds)
+{
+    // A paused queue does not progress
+    if (Seconds <= 0.0 || this->CraftingQueue.Num() == 0 || this->ThroughputScale <= 0.f)
+    {
+        return;
+    }
+
+    // Times of the craft in progress, advanced as if Seconds had passed already
+    const double EndTime = this->GetServerWorldTime() + Seconds;
+
+    double StartTime      = this->QueueHead.StartTime;
+    double CompletionTime = this->QueueHead.CompletionTime;
+
+    while (this->CraftingQueue.Num() > 0)
+    {
+        FCraftingJob& Job = this->CraftingQueue[0];
+
+        const double CraftTime = Job.Recipe->GetCraftTime() / this->ThroughputScale;
+
+        // Zero time jobs only come up behind a finished job, they craft right away as in StartQueueHead
+        if (CraftTime <= 0.0)
+        {
+            this->CraftQueueHead();
+
+            if (this->CraftingQueue.Num() > 0)
+            {
+                CompletionTime = StartTime + this->CraftingQueue[0].Recipe->GetCraftTime() / this->ThroughputScale;
+            }
+
+            continue;
+        }
+
+        if (CompletionTime > EndTime)
+        {
+            break;
+        }
+
+        UInventoryComponent* SourceInventory = Job.SourceInventory.Get();
+        UInventoryComponent* TargetInventory = Job.TargetInventory.Get();
+
+        // The craft in progress completes, and every further one that fits before the end
+        const int64 NumTimedCrafts = FMath::Min<int64>(Job.NumCrafts, 1 + FMath::FloorToInt64((EndTime - CompletionTime) / CraftTime));
+
+        const int32 NumCrafts = SourceInventory && TargetInventory
+                                ? FMath::Min<int32>(static_cast<int32>(NumTimedCrafts), UCraftingComponent::GetMaxCraftableCount(Job.Recipe, SourceInventory, TargetInventory))
+                                : 0;
+
+        if (NumCrafts > 0 && !this->TryCraftRecipeBatch(Job.Recipe, SourceInventory, TargetInventory, NumCrafts))
+        {
+            break;
+        }
+
+        // The craft after the batch fails where it would have completed, and the next job starts there
+        if (NumCrafts < NumTimedCrafts)
+        {
+            UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : Craft of %s failed, dropping its job"), __FUNCTION__, *Job.Recipe->GetName());
+
+            StartTime = CompletionTime + NumCrafts * CraftTime;
+
+            this->CraftingQueue.RemoveAt(0);
+        }
+        else
+        {
+            StartTime = CompletionTime + (NumCrafts - 1) * CraftTime;
+
+            Job.NumCrafts -= NumCrafts;
+
+            if (Job.NumCrafts <= 0)
+            {
+                this->CraftingQueue.RemoveAt(0);
+            }
+        }
+
+        if (this->CraftingQueue.Num() > 0)
+        {
+            CompletionTime = StartTime + this->CraftingQueue[0].Recipe->GetCraftTime() / this->ThroughputScale;
+        }
+    }
+
+    if (this->CraftingQueue.Num() == 0)
+    {
+        this->UpdateQueueHead(0.0, 0.0);
+        return;
+    }
+
+    // Back to world time, the scheduled completion of the old head no longer matches and is skipped
+    StartTime      -= Seconds;
+    CompletionTime -= Seconds;
+
+    UCraftingSchedulerSubsystem* Scheduler = this->GetWorld()->GetSubsystem<UCraftingSchedulerSubsystem>();
+
+    if (!Scheduler)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("%hs : No UCraftingSchedulerSubsystem in this world"), __FUNCTION__);
+        this->CraftingQueue.Reset();
+        this->UpdateQueueHead(0.0, 0.0);
+        return;
+    }
+
+    Scheduler->ScheduleCraft(this, this->CraftingQueue[0].JobId, CompletionTime);
+
+    this->UpdateQueueHead(StartTime, CompletionTime);
+}
+
+float UCraftingComponent::GetCraftProgress() const
+{
+    // No completion time while the queue is paused
+    if (!this->QueueHead.Recipe || this->QueueHead.CompletionTime <= 0.0)
+    {
+        return 0.f;
+    }
+
+    const double Duration = this->QueueHead.CompletionTime - this->QueueHead.StartTime;
+
+    if (Duration <= 0.0)
+    {
+        return 1.f;
+    }
+
+    return FMath::Clamp(static_cast<float>((this->GetServerWorldTime() - this->QueueHead.StartTime) / Duration), 0.f, 1.f);
+}
+
+void UCraftingComponent::StartQueueHead(double StartTime)
+{
+    while (this->CraftingQueue.Num() > 0)
+    {
+        const FCraftingJob& Job = this->CraftingQueue[0];
+
+        const float CraftTime = Job.Recipe->GetCraftTime();
+
+        if (CraftTime > 0.f)
+        {
+            this->ScheduleQueueHead(StartTime, CraftTime);
+            return;
+        }
+
+        this->CraftQueueHead();
+    }
+
+    this->UpdateQueueHead(0.0, 0.0);
+}
+
+void UCraftingComponent::ScheduleQueueHead(double Now, double RemainingCraftTime)
+{
+    // The head shows no craft in progress while paused, scheduled completions no longer match it and are skipped
+    if (this->ThroughputScale <= 0.f)
+    {
+        this->PausedCraftTime = RemainingCraftTime;
+        this->UpdateQueueHead(0.0, 0.0);
+        return;
+    }
+
+    UCraftingSchedulerSubsystem* Scheduler = this->GetWorld()->GetSubsystem<UCraftingSchedulerSubsystem>();
+
+    if (!Scheduler)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("%hs : No UCraftingSchedulerSubsystem in this world"), __FUNCTION__);
+        this->CraftingQueue.Reset();
+        this->UpdateQueueHead(0.0, 0.0);
         return;
     }
 
-    this->TryCraftRecipeToInventory(Recipe, SourceInventory, TargetInventory);
+    const double CompletionTime = Now + RemainingCraftTime / this->ThroughputScale;
+
+    // Started as if the whole craft had run at the current throughput, so the progress carries over
+    const double StartTime = CompletionTime - this->CraftingQueue[0].Recipe->GetCraftTime() / this->ThroughputScale;
+
+    Scheduler->ScheduleCraft(this, this->CraftingQueue[0].JobId, CompletionTime);
+
+    this->UpdateQueueHead(StartTime, CompletionTime);
+}
+
+void UCraftingComponent::CraftQueueHead()
+{
+    FCraftingJob& Job = this->CraftingQueue[0];
+
+    if (this->TryCraftRecipeToInventory(Job.Recipe, Job.SourceInventory.Get(), Job.TargetInventory.Get()))
+    {
+        Job.NumCrafts--;
+    }
+    else
+    {
+        UE_LOG(LogCraftingComponent, Warning, TEXT("%hs : Craft of %s failed, dropping its job"), __FUNCTION__, *Job.Recipe->GetName());
+        Job.NumCrafts = 0;
+    }
+
+    if (Job.NumCrafts <= 0)
+    {
+        this->CraftingQueue.RemoveAt(0);
+    }
+}
+
+void UCraftingComponent::UpdateQueueHead(double StartTime, double CompletionTime)
+{
+    FCraftingQueueHead NewQueueHead;
+
+    if (this->CraftingQueue.Num() > 0)
+    {
+        NewQueueHead.JobId          = this->CraftingQueue[0].JobId;
+        NewQueueHead.Recipe         = this->CraftingQueue[0].Recipe;
+        NewQueueHead.NumCrafts      = this->CraftingQueue[0].NumCrafts;
+        NewQueueHead.NumQueuedJobs  = this->CraftingQueue.Num();
+        NewQueueHead.StartTime      = StartTime;
+        NewQueueHead.CompletionTime = CompletionTime;
+    }
+
+    this->QueueHead = NewQueueHead;
+
+    this->OnCraftingQueueChanged.Broadcast();
+}
+
+void UCraftingComponent::OnRep_QueueHead()
+{
+    this->OnCraftingQueueChanged.Broadcast();
+}
+
+bool UCraftingComponent::CanCraftBetween(const UInventoryComponent* SourceInventory, const UInventoryComponent* TargetInventory) const
+{
+    if (!SourceInventory || !TargetInventory)
+    {
+        UE_LOG(LogCraftingComponent, Error, TEXT("%hs : SourceInventory or TargetInventory is nullptr"), __FUNCTION__);
+        return false;
+    }
+
+    for (const UInventoryComponent* Inventory : {SourceInventory, TargetInventory})
+    {
+        if (!Inventory->CanBeModifiedBy(this))
+        {
+            UE_LOG(LogCraftingComponent, Error, TEXT("%hs : %s may not change %s"), __FUNCTION__, *GetName(), *Inventory->GetName());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double UCraftingComponent::GetServerWorldTime() const
+{
+    const UWorld* World = this->GetWorld();
+
+    if (!World)
+    {
+        return 0.0;
+    }
+
+    // On the server this is the world time the scheduler runs on
+    const AGameStateBase* GameState = World->GetGameState();
+
+    return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
 }
 
 bool UCraftingComponent::InventoryHasItemsInRecipe(UItemRecipeDataAsset* Recipe,
@@ -0,0 +1,438 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/CraftingPlannerSubsystem.h"
+
+#include "Inventory/InventoryComponent.h"
+#include "Inventory/ItemRegistrySubsystem.h"
+#include "Inventory/RecipeRegistrySubsystem.h"
+
+int32 FCraftingPlannerRecipe::GetOutAmount(uint16 ItemId) const
+{
+    for (const TPair<uint16, int32>& OutItem : this->OutItems)
+    {
+        if (OutItem.Key == ItemId)
+        {
+            return OutItem.Value;
+        }
+    }
+
+    return 0;
+}
+
+void UCraftingPlannerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        RecipeRegistry->OnRecipesChanged.AddUObject(this, &UCraftingPlannerSubsystem::HandleRecipesChanged);
+    }
+
+    if (UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get())
+    {
+        ItemRegistry->OnItemsScanned.AddUObject(this, &UCraftingPlannerSubsystem::HandleRecipesChanged);
+    }
+
+    this->HandleRecipesChanged();
+}
+
+void UCraftingPlannerSubsystem::Deinitialize()
+{
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        RecipeRegistry->OnRecipesChanged.RemoveAll(this);
+    }
+
+    if (UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get())
+    {
+        ItemRegistry->OnItemsScanned.RemoveAll(this);
+    }
+
+    this->SetRecipes({});
+
+    Super::Deinitialize();
+}
+
+void UCraftingPlannerSubsystem::SetRecipes(const TArray<UItemRecipeDataAsset*>& InRecipes)
+{
+    this->AllItemRecipeDataAssets = InRecipes;
+
+    this->Recipes.Reset();
+    this->RecipeIndices.Reset();
+    this->ProducingRecipes.Reset();
+    this->CycleEdges.Reset();
+    this->RawMaterials.Reset();
+    this->ItemsWithByproducts.Reset();
+
+    for (UItemRecipeDataAsset* RecipeDataAsset : this->AllItemRecipeDataAssets)
+    {
+        if (!RecipeDataAsset || this->RecipeIndices.Contains(RecipeDataAsset)) continue;
+
+        FCraftingPlannerRecipe PlannerRecipe;
+        PlannerRecipe.Recipe = RecipeDataAsset;
+
+        for (const TPair<UItemDataAsset*, int32> Item : RecipeDataAsset->GetInItems())
+        {
+            if (Item.Key && Item.Value > 0)
+            {
+                PlannerRecipe.InItems.Emplace(UItemRegistrySubsystem::GetItemId(Item.Key), Item.Value);
+            }
+        }
+
+        for (const TPair<UItemDataAsset*, int32> Item : RecipeDataAsset->GetOutItems())
+        {
+            if (Item.Key && Item.Value > 0)
+            {
+                PlannerRecipe.OutItems.Emplace(UItemRegistrySubsystem::GetItemId(Item.Key), Item.Value);
+
+                PlannerRecipe.TotalOutAmount += Item.Value;
+            }
+        }
+
+        const int32 RecipeIndex = this->Recipes.Add(MoveTemp(PlannerRecipe));
+
+        this->RecipeIndices.Add(RecipeDataAsset, RecipeIndex);
+
+        for (const TPair<uint16, int32>& OutItem : this->Recipes[RecipeIndex].OutItems)
+        {
+            if (!this->ProducingRecipes.Contains(OutItem.Key))
+            {
+                this->ProducingRecipes.Add(OutItem.Key, RecipeIndex);
+            }
+        }
+    }
+
+    // Cut every cycle once, in recipe order, so the memoized expansions never depend on where a cycle was entered
+    TSet<uint16> VisitedItems;
+
+    for (const FCraftingPlannerRecipe& PlannerRecipe : this->Recipes)
+    {
+        for (const TPair<uint16, int32>& OutItem : PlannerRecipe.OutItems)
+        {
+            this->FindCycleEdges(OutItem.Key, VisitedItems);
+        }
+    }
+}
+
+void UCraftingPlannerSubsystem::FindCycleEdges(uint16 ItemId, TSet<uint16>& VisitedItems)
+{
+    const int32* RecipeIndex = this->ProducingRecipes.Find(ItemId);
+
+    if (!RecipeIndex || VisitedItems.Contains(ItemId))
+    {
+        return;
+    }
+
+    VisitedItems.Add(ItemId);
+    this->VisitingItems.Add(ItemId);
+
+    for (const TPair<uint16, int32>& InItem : this->Recipes[*RecipeIndex].InItems)
+    {
+        if (this->VisitingItems.Contains(InItem.Key))
+        {
+            this->CycleEdges.Add(MakeCycleEdge(ItemId, InItem.Key));
+            continue;
+        }
+
+        this->FindCycleEdges(InItem.Key, VisitedItems);
+    }
+
+    this->VisitingItems.Remove(ItemId);
+}
+
+bool UCraftingPlannerSubsystem::BuildCraftPlan(UItemRecipeDataAsset* Recipe,
+                                               int32 NumCrafts,
+                                               UInventoryComponent* Inventory,
+                                               FCraftingPlan& OutPlan)
+{
+    OutPlan = FCraftingPlan();
+
+    if (!Recipe)
+    {
+        UE_LOG(LogCraftingPlanner, Error, TEXT("%hs : Recipe is nullptr"), __FUNCTION__);
+        return false;
+    }
+
+    if (!Inventory)
+    {
+        UE_LOG(LogCraftingPlanner, Error, TEXT("%hs : Inventory is nullptr"), __FUNCTION__);
+        return false;
+    }
+
+    const int32* RecipeIndex = this->RecipeIndices.Find(Recipe);
+
+    if (!RecipeIndex)
+    {
+        UE_LOG(LogCraftingPlanner, Warning, TEXT("%hs : %s is not a known recipe"), __FUNCTION__, *Recipe->GetName());
+        return false;
+    }
+
+    if (NumCrafts <= 0)
+    {
+        return true;
+    }
+
+    TMap<uint16, int32> Available = UCraftingPlannerSubsystem::CountInventoryItems(Inventory);
+    TMap<uint16, int32> Missing;
+
+    this->PlanRecipe(*RecipeIndex, NumCrafts, Available, Missing, OutPlan);
+
+    UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get();
+
+    for (const TPair<uint16, int32>& MissingItem : Missing)
+    {
+        OutPlan.MissingItems.Add(ItemRegistry ? ItemRegistry->GetItem(MissingItem.Key) : nullptr, MissingItem.Value);
+    }
+
+    return OutPlan.IsComplete();
+}
+
+int32 UCraftingPlannerSubsystem::GetMaxPlannedCrafts(UItemRecipeDataAsset* Recipe, UInventoryComponent* Inventory)
+{
+    if (!Recipe || !Inventory)
+    {
+        UE_LOG(LogCraftingPlanner, Error, TEXT("%hs : Recipe or Inventory is nullptr"), __FUNCTION__);
+        return 0;
+    }
+
+    const int32* RecipeIndex = this->RecipeIndices.Find(Recipe);
+
+    if (!RecipeIndex || this->Recipes[*RecipeIndex].InItems.Num() == 0)
+    {
+        return 0;
+    }
+
+    const TMap<uint16, int32> Held = UCraftingPlannerSubsystem::CountInventoryItems(Inventory);
+
+    auto CanPlan = [this, RecipeIndex, &Held](int32 NumCrafts)
+    {
+        TMap<uint16, int32> Available = Held;
+        TMap<uint16, int32> Missing;
+        FCraftingPlan Plan;
+
+        this->PlanRecipe(*RecipeIndex, NumCrafts, Available, Missing, Plan);
+
+        return Missing.Num() == 0;
+    };
+
+    // Raw materials of one craft
+    TMap<uint16, double> RawPerCraft;
+
+    bool bHasByproducts = false;
+
+    for (const TPair<uint16, int32>& InItem : this->Recipes[*RecipeIndex].InItems)
+    {
+        for (const TPair<uint16, double>& RawMaterial : this->GetRawMaterials(InItem.Key))
+        {
+            RawPerCraft.FindOrAdd(RawMaterial.Key) += RawMaterial.Value * InItem.Value;
+        }
+
+        bHasByproducts |= this->ItemsWithByproducts.Contains(InItem.Key);
+    }
+
+    int32 Low  = 0;
+    int32 High = 0;
+
+    if (bHasByproducts)
+    {
+        // A byproduct may be worth more to a plan than its share of the inputs, so the raw materials do not bound
+        // the crafts. Double the count until a plan fails instead
+        High = 1;
+
+        while (High < MAX_int32 / 2 && CanPlan(High))
+        {
+            Low  = High;
+            High = High * 2;
+        }
+
+        High--;
+    }
+    else
+    {
+        // Every recipe below is single output, so an item is worth exactly the raw materials spent on it. Batching can only
+        // make a craft cost more than its fractional expansion, so the ratio to what is held is an upper bound of the crafts
+        TMap<uint16, double> RawHeld;
+
+        for (const TPair<uint16, int32>& HeldItem : Held)
+        {
+            for (const TPair<uint16, double>& RawMaterial : this->GetRawMaterials(HeldItem.Key))
+            {
+                RawHeld.FindOrAdd(RawMaterial.Key) += RawMaterial.Value * HeldItem.Value;
+            }
+        }
+
+        High = MAX_int32;
+
+        for (const TPair<uint16, double>& RawMaterial : RawPerCraft)
+        {
+            const double Crafts = RawHeld.FindRef(RawMaterial.Key) / RawMaterial.Value;
+
+            High = FMath::Min(High, FMath::FloorToInt(Crafts + UE_KINDA_SMALL_NUMBER));
+        }
+    }
+
+    // Binary search the exact count below the bound, each probe is one plan over the recipe tree
+    while (Low < High)
+    {
+        const int32 Mid = Low + (High - Low + 1) / 2;
+
+        if (CanPlan(Mid))
+        {
+            Low = Mid;
+        }
+        else
+        {
+            High = Mid - 1;
+        }
+    }
+
+    return Low;
+}
+
+const TMap<uint16, double>& UCraftingPlannerSubsystem::GetRawMaterials(uint16 ItemId)
+{
+    if (const TMap<uint16, double>* Memoized = this->RawMaterials.Find(ItemId))
+    {
+        return *Memoized;
+    }
+
+    TMap<uint16, double> Expansion;
+
+    const int32* RecipeIndex = this->ProducingRecipes.Find(ItemId);
+
+    if (!RecipeIndex)
+    {
+        Expansion.Add(ItemId, 1.0);
+    }
+    else
+    {
+        const FCraftingPlannerRecipe& PlannerRecipe = this->Recipes[*RecipeIndex];
+
+        // Byproducts take their share of the inputs, charging everything to this item would overstate its cost
+        const double OutAmount = PlannerRecipe.TotalOutAmount;
+
+        bool bHasByproducts = PlannerRecipe.OutItems.Num() > 1;
+
+        for (const TPair<uint16, int32>& InItem : PlannerRecipe.InItems)
+        {
+            // The input leads back to this item, recursing would never end
+            if (this->CycleEdges.Contains(MakeCycleEdge(ItemId, InItem.Key)))
+            {
+                Expansion.FindOrAdd(InItem.Key) += static_cast<double>(InItem.Value) / OutAmount;
+                continue;
+            }
+
+            // Nothing is added to RawMaterials between this call returning and the loop below, so the reference stays valid
+            const TMap<uint16, double>& InRawMaterials = this->GetRawMaterials(InItem.Key);
+
+            for (const TPair<uint16, double>& RawMaterial : InRawMaterials)
+            {
+                Expansion.FindOrAdd(RawMaterial.Key) += RawMaterial.Value * InItem.Value / OutAmount;
+            }
+
+            bHasByproducts |= this->ItemsWithByproducts.Contains(InItem.Key);
+        }
+
+        if (bHasByproducts)
+        {
+            this->ItemsWithByproducts.Add(ItemId);
+        }
+    }
+
+    return this->RawMaterials.Add(ItemId, MoveTemp(Expansion));
+}
+
+void UCraftingPlannerSubsystem::HandleRecipesChanged()
+{
+    // The memoized expansions depend on every recipe below an item, so an edited recipe drops all of them
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        this->SetRecipes(RecipeRegistry->GetItemRecipes());
+    }
+}
+
+TMap<uint16, int32> UCraftingPlannerSubsystem::CountInventoryItems(UInventoryComponent* Inventory)
+{
+    TMap<uint16, int32> ItemCounts;
+
+    for (const FInventorySlot& InventorySlot : Inventory->GetInventorySlots())
+    {
+        if (!FInventorySlot::IsSlotEmpty(InventorySlot))
+        {
+            ItemCounts.FindOrAdd(InventorySlot.ItemId) += InventorySlot.CurrentStackSize;
+        }
+    }
+
+    return ItemCounts;
+}
+
+void UCraftingPlannerSubsystem::PlanItem(uint16 ItemId,
+                                         int32 Amount,
+                                         TMap<uint16, int32>& Available,
+                                         TMap<uint16, int32>& Missing,
+                                         FCraftingPlan& OutPlan)
+{
+    int32& AvailableAmount = Available.FindOrAdd(ItemId);
+
+    const int32 AmountTaken = FMath::Min(AvailableAmount, Amount);
+
+    AvailableAmount -= AmountTaken;
+
+    const int32 AmountLeft = Amount - AmountTaken;
+
+    if (AmountLeft <= 0)
+    {
+        return;
+    }
+
+    const int32* RecipeIndex = this->ProducingRecipes.Find(ItemId);
+
+    if (!RecipeIndex || this->VisitingItems.Contains(ItemId))
+    {
+        Missing.FindOrAdd(ItemId) += AmountLeft;
+        return;
+    }
+
+    const int32 OutAmount = this->Recipes[*RecipeIndex].GetOutAmount(ItemId);
+    const int32 NumCrafts = FMath::DivideAndRoundUp(AmountLeft, OutAmount);
+
+    this->VisitingItems.Add(ItemId);
+
+    this->PlanRecipe(*RecipeIndex, NumCrafts, Available, Missing, OutPlan);
+
+    this->VisitingItems.Remove(ItemId);
+
+    // The crafts added their whole output, keep only the surplus
+    Available.FindOrAdd(ItemId) -= AmountLeft;
+}
+
+void UCraftingPlannerSubsystem::PlanRecipe(int32 RecipeIndex,
+                                           int32 NumCrafts,
+                                           TMap<uint16, int32>& Available,
+                                           TMap<uint16, int32>& Missing,
+                                           FCraftingPlan& OutPlan)
+{
+    const FCraftingPlannerRecipe& PlannerRecipe = this->Recipes[RecipeIndex];
+
+    for (const TPair<uint16, int32>& InItem : PlannerRecipe.InItems)
+    {
+        this->PlanItem(InItem.Key, InItem.Value * NumCrafts, Available, Missing, OutPlan);
+    }
+
+    // Repeated crafts of the same recipe in a row run as one step
+    if (OutPlan.Steps.Num() > 0 && OutPlan.Steps.Last().Recipe == PlannerRecipe.Recipe)
+    {
+        OutPlan.Steps.Last().NumCrafts += NumCrafts;
+    }
+    else
+    {
+        FCraftingPlanStep& Step = OutPlan.Steps.AddDefaulted_GetRef();
+        Step.Recipe    = PlannerRecipe.Recipe;
+        Step.NumCrafts = NumCrafts;
+    }
+
+    for (const TPair<uint16, int32>& OutItem : PlannerRecipe.OutItems)
+    {
+        Available.FindOrAdd(OutItem.Key) += OutItem.Value * NumCrafts;
+    }
+}
@@ -0,0 +1,64 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/CraftingSchedulerSubsystem.h"
+
+#include "Inventory/CraftingComponent.h"
+
+#include "Engine/World.h"
+
+void UCraftingSchedulerSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    // Completing a craft schedules the crafter's next one from the completion time, after a long frame it may be due as well
+    while (this->ScheduledCrafts.Num() > 0 && this->ScheduledCrafts.HeapTop().CompletionTime <= Now)
+    {
+        FScheduledCraft ScheduledCraft;
+        this->ScheduledCrafts.HeapPop(ScheduledCraft);
+
+        if (UCraftingComponent* Crafter = ScheduledCraft.Crafter.Get())
+        {
+            Crafter->CompleteCraft(ScheduledCraft.JobId, ScheduledCraft.CompletionTime);
+        }
+    }
+}
+
+TStatId UCraftingSchedulerSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCraftingSchedulerSubsystem, STATGROUP_Tickables);
+}
+
+void UCraftingSchedulerSubsystem::ScheduleCraft(UCraftingComponent* Crafter, int32 JobId, double CompletionTime)
+{
+    if (!Crafter)
+    {
+        UE_LOG(LogCraftingScheduler, Error, TEXT("%hs : Crafter is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    FScheduledCraft ScheduledCraft;
+    ScheduledCraft.CompletionTime = CompletionTime;
+    ScheduledCraft.Crafter        = Crafter;
+    ScheduledCraft.JobId          = JobId;
+
+    this->ScheduledCrafts.HeapPush(ScheduledCraft);
+}
+
+TArray<UCraftingComponent*> UCraftingSchedulerSubsystem::GetScheduledCrafters() const
+{
+    TArray<UCraftingComponent*> Crafters;
+
+    for (const FScheduledCraft& ScheduledCraft : this->ScheduledCrafts)
+    {
+        UCraftingComponent* Crafter = ScheduledCraft.Crafter.Get();
+
+        if (Crafter && Crafter->HasQueuedCrafts())
+        {
+            Crafters.AddUnique(Crafter);
+        }
+    }
+
+    return Crafters;
+}
@@ -0,0 +1,227 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/FactorySimulation.h"
+
+void FFactorySimulation::Reset()
+{
+    this->Step = 0;
+
+    this->SlotItemIds.Reset();
+    this->SlotStackSizes.Reset();
+    this->SlotMaxStackSizes.Reset();
+    this->InventorySlotStarts.Reset();
+    this->ChangedSlots.Empty();
+
+    this->ResetMachines();
+}
+
+void FFactorySimulation::ResetMachines()
+{
+    this->Machines.Reset();
+    this->FireQueue.Reset();
+    this->DueMachines.Reset();
+}
+
+int32 FFactorySimulation::AddInventory(const TArray<FInventorySlot>& InSlots)
+{
+    if (this->InventorySlotStarts.Num() == 0)
+    {
+        this->InventorySlotStarts.Add(0);
+    }
+
+    const int32 InventoryIndex = this->InventorySlotStarts.Num() - 1;
+
+    this->SlotItemIds.AddUninitialized(InSlots.Num());
+    this->SlotStackSizes.AddUninitialized(InSlots.Num());
+    this->SlotMaxStackSizes.AddUninitialized(InSlots.Num());
+    this->ChangedSlots.Add(false, InSlots.Num());
+
+    this->InventorySlotStarts.Add(this->SlotItemIds.Num());
+
+    for (int32 SlotIndex = 0; SlotIndex < InSlots.Num(); SlotIndex++)
+    {
+        this->SetSlot(InventoryIndex, SlotIndex, InSlots[SlotIndex]);
+    }
+
+    return InventoryIndex;
+}
+
+void FFactorySimulation::SetSlot(int32 InventoryIndex, int32 SlotIndex, const FInventorySlot& InSlot)
+{
+    const int32 Index = this->InventorySlotStarts[InventoryIndex] + SlotIndex;
+
+    const bool bIsEmpty = FInventorySlot::IsSlotEmpty(InSlot);
+
+    this->SlotItemIds[Index]       = bIsEmpty ? UItemDataAsset::InvalidItemId : InSlot.ItemId;
+    this->SlotStackSizes[Index]    = bIsEmpty ? 0 : InSlot.CurrentStackSize;
+    this->SlotMaxStackSizes[Index] = bIsEmpty ? 0 : InSlot.MaxStackSize;
+}
+
+void FFactorySimulation::GetChangedSlots(int32 InventoryIndex, TArray<int32>& OutSlotIndices) const
+{
+    const int32 FirstSlot = this->InventorySlotStarts[InventoryIndex];
+
+    for (int32 Index = FirstSlot; Index < this->InventorySlotStarts[InventoryIndex + 1]; Index++)
+    {
+        if (this->ChangedSlots[Index])
+        {
+            OutSlotIndices.Add(Index - FirstSlot);
+        }
+    }
+}
+
+int32 FFactorySimulation::AddMachine(const FFactorySimMachine& Machine)
+{
+    return this->Machines.Add(Machine);
+}
+
+void FFactorySimulation::AdvanceTo(int64 TargetStep)
+{
+    auto FireOrder = [](const TPair<int64, int32>& A, const TPair<int64, int32>& B)
+    {
+        return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+    };
+
+    this->FireQueue.Reset();
+
+    this->ChangedSlots.SetRange(0, this->ChangedSlots.Num(), false);
+
+    for (int32 MachineIndex = 0; MachineIndex < this->Machines.Num(); MachineIndex++)
+    {
+        FFactorySimMachine& Machine = this->Machines[MachineIndex];
+
+        Machine.AmountGenerated = 0;
+        Machine.AmountConsumed  = 0;
+
+        if (!Machine.bFinished)
+        {
+            this->FireQueue.Emplace(Machine.NextFireStep, MachineIndex);
+        }
+    }
+
+    this->FireQueue.Heapify(FireOrder);
+
+    while (this->FireQueue.Num() > 0 && this->FireQueue.HeapTop().Key <= TargetStep)
+    {
+        const int64 FireStep = this->FireQueue.HeapTop().Key;
+
+        // Popped in machine order, as ties are ordered by index
+        this->DueMachines.Reset();
+
+        while (this->FireQueue.Num() > 0 && this->FireQueue.HeapTop().Key == FireStep)
+        {
+            TPair<int64, int32> Fire;
+            this->FireQueue.HeapPop(Fire, FireOrder);
+
+            this->DueMachines.Add(Fire.Value);
+        }
+
+        for (const int32 MachineIndex : this->DueMachines)
+        {
+            FFactorySimMachine& Machine = this->Machines[MachineIndex];
+
+            // What does not fit is lost, as when a generator fired into a full inventory
+            if (Machine.Kind == EProductionKind::Generate && this->AddItem(Machine.InventoryIndex, Machine.ItemId, Machine.MaxStackSize))
+            {
+                Machine.AmountGenerated++;
+            }
+        }
+
+        for (const int32 MachineIndex : this->DueMachines)
+        {
+            FFactorySimMachine& Machine = this->Machines[MachineIndex];
+
+            if (Machine.Kind == EProductionKind::Consume && this->RemoveItem(Machine.InventoryIndex, Machine.ItemId))
+            {
+                Machine.AmountConsumed++;
+            }
+        }
+
+        for (const int32 MachineIndex : this->DueMachines)
+        {
+            FFactorySimMachine& Machine = this->Machines[MachineIndex];
+
+            if (!Machine.bLoop)
+            {
+                Machine.bFinished = true;
+                continue;
+            }
+
+            Machine.NextFireStep += Machine.PeriodSteps;
+
+            this->FireQueue.HeapPush(TPair<int64, int32>(Machine.NextFireStep, MachineIndex), FireOrder);
+        }
+    }
+
+    this->Step = TargetStep;
+}
+
+int64 FFactorySimulation::CountItem(int32 InventoryIndex, uint16 ItemId) const
+{
+    int64 Amount = 0;
+
+    for (int32 SlotIndex = this->InventorySlotStarts[InventoryIndex]; SlotIndex < this->InventorySlotStarts[InventoryIndex + 1]; SlotIndex++)
+    {
+        Amount += this->SlotItemIds[SlotIndex] == ItemId ? this->SlotStackSizes[SlotIndex] : 0;
+    }
+
+    return Amount;
+}
+
+bool FFactorySimulation::AddItem(int32 InventoryIndex, uint16 ItemId, int32 MaxStackSize)
+{
+    const int32 FirstSlot = this->InventorySlotStarts[InventoryIndex];
+    const int32 EndSlot   = this->InventorySlotStarts[InventoryIndex + 1];
+
+    int32 EmptySlot = INDEX_NONE;
+
+    for (int32 SlotIndex = FirstSlot; SlotIndex < EndSlot; SlotIndex++)
+    {
+        if (this->SlotItemIds[SlotIndex] == ItemId && this->SlotStackSizes[SlotIndex] < this->SlotMaxStackSizes[SlotIndex])
+        {
+            this->SlotStackSizes[SlotIndex]++;
+            this->ChangedSlots[SlotIndex] = true;
+            return true;
+        }
+
+        if (EmptySlot == INDEX_NONE && this->SlotItemIds[SlotIndex] == UItemDataAsset::InvalidItemId)
+        {
+            EmptySlot = SlotIndex;
+        }
+    }
+
+    if (EmptySlot == INDEX_NONE || MaxStackSize <= 0)
+    {
+        return false;
+    }
+
+    this->SlotItemIds[EmptySlot]       = ItemId;
+    this->SlotStackSizes[EmptySlot]    = 1;
+    this->SlotMaxStackSizes[EmptySlot] = MaxStackSize;
+    this->ChangedSlots[EmptySlot]      = true;
+
+    return true;
+}
+
+bool FFactorySimulation::RemoveItem(int32 InventoryIndex, uint16 ItemId)
+{
+    for (int32 SlotIndex = this->InventorySlotStarts[InventoryIndex + 1] - 1; SlotIndex >= this->InventorySlotStarts[InventoryIndex]; SlotIndex--)
+    {
+        if (this->SlotItemIds[SlotIndex] != ItemId || this->SlotStackSizes[SlotIndex] <= 0)
+        {
+            continue;
+        }
+
+        this->ChangedSlots[SlotIndex] = true;
+
+        if (--this->SlotStackSizes[SlotIndex] == 0)
+        {
+            this->SlotItemIds[SlotIndex]       = UItemDataAsset::InvalidItemId;
+            this->SlotMaxStackSizes[SlotIndex] = 0;
+        }
+
+        return true;
+    }
+
+    return false;
+}
@@ -2,12 +2,36 @@
 
 #include "Inventory/InventoryComponent.h"
 
+#include "Inventory/ItemRegistrySubsystem.h"
+#include "Inventory/ProductionSubsystem.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PropertyConditions/PropertyConditions.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "TimerManager.h"
+
+namespace InventoryPrediction
+{
+    // Accepted predictions whose replicated SlotSequence never arrives are dropped after this many seconds of world time
+    constexpr double AcceptedTimeout = 1.0;
+}
 
 UInventoryComponent::UInventoryComponent()
 {
     this->PrimaryComponentTick.bCanEverTick = true;
     this->NumberOfSlots = 10;
+    this->StorageMode   = EInventoryStorageMode::Slots;
+    this->SlotsPerPage  = 64;
+
+    this->MaxViewerDistance = 1000.0f;
+
+    this->CompactPolicy = EInventoryCompactPolicy::Manual;
+
+    this->ReplicationPolicy = EInventoryReplicationPolicy::Everyone;
+
+    this->bEnablePrediction = true;
 
     this->SetIsReplicatedByDefault(true);
 }
@@ -21,6 +45,8 @@ void UInventoryComponent::OnRegister()
         return;
     }
 
+    this->UpdateReplicationConditions();
+
     this->InitializeInventorySlots();
 }
 
@@ -28,24 +54,56 @@ void UInventoryComponent::SwapInventorySlots(int32 SourceIndex,
                                              UInventoryComponent* SourceInventory,
                                              int32 TargetIndex)
 {
-    this->ServerSwapInventorySlots(SourceIndex, SourceInventory, TargetIndex);
+    int32 PredictionKey = 0;
+
+    const bool bValidSwap = SourceInventory
+                            && SourceInventory->GetInventorySlots().IsValidIndex(SourceIndex)
+                            && this->GetInventorySlots().IsValidIndex(TargetIndex);
+
+    if (bValidSwap && this->CanPredict())
+    {
+        PredictionKey = UInventoryComponent::CreatePredictionKey();
+
+        const FInventorySlot SourceSlot = SourceInventory->GetInventorySlots()[SourceIndex];
+        const FInventorySlot TargetSlot = this->GetInventorySlots()[TargetIndex];
+
+        SourceInventory->PredictSetSlot(PredictionKey, SourceIndex, TargetSlot);
+        this->PredictSetSlot(PredictionKey, TargetIndex, SourceSlot);
+
+        this->AddPredictionParticipant(PredictionKey, SourceInventory);
+    }
+
+    this->ServerSwapInventorySlots(SourceIndex, SourceInventory, TargetIndex, PredictionKey);
 }
 
 void UInventoryComponent::ServerSwapInventorySlots_Implementation(int32 SourceIndex,
                                                                   UInventoryComponent* SourceInventory,
-                                                                  int32 TargetIndex)
+                                                                  int32 TargetIndex,
+                                                                  int32 PredictionKey)
+{
+    const bool bSwapped = this->TrySwapInventorySlots(SourceIndex, SourceInventory, TargetIndex);
+
+    if (PredictionKey != 0)
+    {
+        this->ClientResolvePrediction(PredictionKey, bSwapped, this->SlotSequence, SourceInventory ? SourceInventory->SlotSequence : 0);
+    }
+}
+
+bool UInventoryComponent::TrySwapInventorySlots(int32 SourceIndex,
+                                                UInventoryComponent* SourceInventory,
+                                                int32 TargetIndex)
 {
     if (!SourceInventory)
     {
         UE_LOG(LogInventoryComponent, Error, TEXT("ServerSwapInventorySlots: SourceInventory is nullptr"))
-        return;
+        return false;
     }
 
     // Invalid Index
     if (SourceIndex < 0 || SourceInventory->GetInventorySlots().Num() <= SourceIndex)
     {
         UE_LOG(LogInventoryComponent, Error, TEXT("ServerSwapInventorySlots: SourceIndex is Invalid"))
-        return;
+        return false;
     }
 
     const FInventorySlot TempSlot = SourceInventory->GetInventorySlots()[SourceIndex];
@@ -54,410 +112,666 @@ void UInventoryComponent::ServerSwapInventorySlots_Implementation(int32 SourceIn
     {
         // Invalid Index
         UE_LOG(LogInventoryComponent, Error, TEXT("ServerSwapInventorySlots: TargetIndex is Invalid"))
-        return;
+        return false;
     }
 
-    SourceInventory->InventorySlots[SourceIndex] = this->InventorySlots[TargetIndex];
+    SourceInventory->SetSlot(SourceIndex, this->InventorySlots[TargetIndex]);
 
-    this->InventorySlots[TargetIndex] = TempSlot;
+    this->SetSlot(TargetIndex, TempSlot);
 
     if (SourceInventory != this)
     {
+        SourceInventory->ApplyCompactPolicy();
         SourceInventory->OnItemChanged.Broadcast();
     }
 
+    this->ApplyCompactPolicy();
+
     this->OnItemChanged.Broadcast();
+
+    return true;
 }
 
-void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+int32 UInventoryComponent::TransferItems(UInventoryComponent* Source,
+                                         UInventoryComponent* Target,
+                                         const TArray<UItemDataAsset*>& Filter,
+                                         int32 MaxAmount)
 {
-    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+    if (!Source || !Target)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : Source or Target is nullptr"), __FUNCTION__);
+        return 0;
+    }
 
-    DOREPLIFETIME(UInventoryComponent, InventorySlots);
-    DOREPLIFETIME(UInventoryComponent, NumberOfSlots);
-}
+    Source->SettleProduction();
+    Target->SettleProduction();
 
-void UInventoryComponent::InitializeInventorySlots()
-{
-    this->InventorySlots.Init(FInventorySlot(), this->NumberOfSlots);
-    this->OnItemChanged.Broadcast();
-}
+    if (Source == Target)
+    {
+        UE_LOG(LogInventoryComponent, Warning, TEXT("%hs : Source and Target are the same inventory"), __FUNCTION__);
+        return 0;
+    }
 
-bool UInventoryComponent::TryAddItem(UItemDataAsset* ItemToAdd, const int Amount)
-{
-    if (!ItemToAdd)
+    if (MaxAmount < 0)
     {
-        UE_LOG(LogTemp, Error, TEXT("TryAddItem: ItemToAdd was null"))
-        return false;
+        MaxAmount = MAX_int32;
     }
 
-    APawn* OwningPawn = Cast<APawn>(GetOwner());
+    // Item ids to move, indexed by id
+    TBitArray<> FilterIds;
 
-    // Add item if it already exists in inventory
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    for (UItemDataAsset* FilterItem : Filter)
     {
-        FInventorySlot InventorySlot = this->InventorySlots[i];
+        const uint16 FilterItemId = UItemRegistrySubsystem::GetItemId(FilterItem);
 
-        if (FInventorySlot::IsSlotFull(InventorySlot))
-        {
-            continue;
-        }
+        if (FilterItemId == UItemDataAsset::InvalidItemId) continue;
 
-        // Item Exists in Inventory slot
-        if (ItemToAdd == InventorySlot.Item)
+        if (FilterIds.Num() <= FilterItemId)
         {
-            const int32 NewAmount       = InventorySlot.CurrentStackSize + Amount;
-            const int32 MaxStackSize    = ItemToAdd->GetMaxStackSize();
-            const int32 StackDifference = NewAmount - MaxStackSize;
+            FilterIds.Add(false, FilterItemId + 1 - FilterIds.Num());
+        }
 
-            InventorySlot.CurrentStackSize = FMath::Min(NewAmount,
-                                                        MaxStackSize);
+        FilterIds[FilterItemId] = true;
+    }
 
-            this->InventorySlots[i] = InventorySlot;
+    const bool bTransferAll = FilterIds.Num() == 0;
 
-            if (StackDifference > 0)
-            {
-                // Add Leftovers
-                this->ServerAddItem(ItemToAdd, StackDifference);
-            }
+    // One pass over the source to total up the items to move, in the order they are first found
+    TArray<uint16> ItemIds;
+    TMap<uint16, int32> SourceAmounts;
 
-            this->OnItemAdded.Broadcast(ItemToAdd, Amount);
+    for (const FInventorySlot& SourceSlot : Source->InventorySlots)
+    {
+        if (FInventorySlot::IsSlotEmpty(SourceSlot)) continue;
 
-            // Notify clients of item adding/removing
-            if (OwningPawn && !OwningPawn->IsLocallyControlled())
-            {
-                this->ClientOnAddItem(ItemToAdd, Amount);
-            }
+        if (!bTransferAll && (!FilterIds.IsValidIndex(SourceSlot.ItemId) || !FilterIds[SourceSlot.ItemId])) continue;
 
-            this->OnItemChanged.Broadcast();
+        int32& SourceAmount = SourceAmounts.FindOrAdd(SourceSlot.ItemId, 0);
 
-            return true;
+        if (SourceAmount == 0)
+        {
+            ItemIds.Add(SourceSlot.ItemId);
         }
+
+        SourceAmount += SourceSlot.CurrentStackSize;
     }
 
-    // Find first empty slot
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    if (ItemIds.Num() == 0)
     {
-        FInventorySlot InventorySlot = this->InventorySlots[i];
+        return 0;
+    }
 
-        // Slot is occupied
-        if (InventorySlot.Item != nullptr)
+    // One pass over the target to find the partial stacks of those items and the empty slots
+    TMap<uint16, TArray<int32>> TargetPartialStacks;
+    TArray<int32> TargetEmptySlots;
+
+    for (int32 i = 0; i < Target->InventorySlots.Num(); i++)
+    {
+        const FInventorySlot& TargetSlot = Target->InventorySlots[i];
+
+        if (FInventorySlot::IsSlotEmpty(TargetSlot))
         {
-            continue;
+            TargetEmptySlots.Add(i);
         }
+        else if (SourceAmounts.Contains(TargetSlot.ItemId) && !FInventorySlot::IsSlotFull(TargetSlot))
+        {
+            TargetPartialStacks.FindOrAdd(TargetSlot.ItemId).Add(i);
+        }
+    }
+
+    TArray<uint16> MovedItemIds;
+    TArray<int32> MovedAmounts;
 
-        InventorySlot.Item = ItemToAdd;
-        InventorySlot.CurrentStackSize = FMath::Min(Amount, ItemToAdd->GetMaxStackSize());
+    int32 NextEmptySlot = 0;
+    int32 TotalMoved    = 0;
 
-        this->InventorySlots[i] = InventorySlot;
+    for (const uint16 ItemId : ItemIds)
+    {
+        if (TotalMoved >= MaxAmount) break;
 
-        this->OnItemAdded.Broadcast(ItemToAdd, Amount);
+        const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
 
-        // Notify clients of item adding/removing
-        if (OwningPawn && !OwningPawn->IsLocallyControlled())
+        int32 AmountToMove = FMath::Min(SourceAmounts[ItemId], MaxAmount - TotalMoved);
+        int32 AmountMoved  = 0;
+
+        // Merge into existing partial stacks first
+        if (const TArray<int32>* PartialStacks = TargetPartialStacks.Find(ItemId))
         {
-            this->ClientOnAddItem(ItemToAdd, Amount);
+            for (const int32 SlotIndex : *PartialStacks)
+            {
+                if (AmountMoved == AmountToMove) break;
+
+                FInventorySlot TargetSlot = Target->InventorySlots[SlotIndex];
+
+                const int32 AmountToStack = FMath::Min(MaxStackSize - TargetSlot.CurrentStackSize, AmountToMove - AmountMoved);
+
+                TargetSlot.CurrentStackSize += AmountToStack;
+                AmountMoved                 += AmountToStack;
+
+                Target->SetSlot(SlotIndex, TargetSlot);
+            }
         }
 
-        this->OnItemChanged.Broadcast();
+        // Then fill empty slots
+        while (AmountMoved < AmountToMove && TargetEmptySlots.IsValidIndex(NextEmptySlot) && MaxStackSize > 0)
+        {
+            const int32 AmountToStack = FMath::Min(MaxStackSize, AmountToMove - AmountMoved);
 
-        return true;
-    }
+            FInventorySlot TargetSlot;
+            TargetSlot.ItemId           = ItemId;
+            TargetSlot.Item             = Source->GetItemFromId(ItemId);
+            TargetSlot.CurrentStackSize = AmountToStack;
+            TargetSlot.MaxStackSize     = MaxStackSize;
 
-    UE_LOG(LogTemp, Warning, TEXT("TryAddItem: Inventory Full"))
+            Target->SetSlot(TargetEmptySlots[NextEmptySlot++], TargetSlot);
 
-    return false;
-}
+            AmountMoved += AmountToStack;
+        }
 
-bool UInventoryComponent::TryAddItems(const TMap<UItemDataAsset*, int32>& ItemsToAdd)
-{
-    for (const TTuple<UItemDataAsset*, int> ItemToAdd : ItemsToAdd)
-    {
-        if (!this->TryAddItem(ItemToAdd.Key, ItemToAdd.Value))
+        if (AmountMoved == 0) continue;
+
+        // Take the moved amount out of the source, emptying its last stacks first
+        int32 AmountToTake = AmountMoved;
+
+        for (int32 i = Source->InventorySlots.Num() - 1; i >= 0 && AmountToTake > 0; i--)
         {
-            return false;
+            FInventorySlot SourceSlot = Source->InventorySlots[i];
+
+            if (SourceSlot.ItemId != ItemId) continue;
+
+            const int32 AmountTaken = FMath::Min(SourceSlot.CurrentStackSize, AmountToTake);
+
+            SourceSlot.CurrentStackSize -= AmountTaken;
+            AmountToTake                -= AmountTaken;
+
+            Source->SetSlot(i, SourceSlot.CurrentStackSize > 0 ? SourceSlot : FInventorySlot());
         }
-    }
 
-    return true;
-}
+        MovedItemIds.Add(ItemId);
+        MovedAmounts.Add(AmountMoved);
 
-void UInventoryComponent::ServerAddItem_Implementation(UItemDataAsset* ItemToAdd, const int Amount)
-{
-    if (!ItemToAdd)
-    {
-        UE_LOG(LogTemp, Error, TEXT("ServerAddItem: ItemToAdd was nullptr"))
-        return;
+        TotalMoved += AmountMoved;
     }
 
-    if (!this->TryAddItem(ItemToAdd, Amount))
+    if (TotalMoved > 0)
     {
-        UE_LOG(LogTemp, Error, TEXT("ServerAddItem: TryAddItem failed"))
+        Source->ApplyCompactPolicy();
+        Target->ApplyCompactPolicy();
+
+        Source->NotifyItemsRemoved(MovedItemIds, MovedAmounts);
+        Target->NotifyItemsAdded(MovedItemIds, MovedAmounts);
     }
-}
 
-void UInventoryComponent::ClientOnAddItem_Implementation(UItemDataAsset* ItemToAdd, const int Amount)
-{
-    // Broadcast on clients to handle UI
-    this->OnItemAdded.Broadcast(ItemToAdd, Amount);
+    return TotalMoved;
 }
 
-bool UInventoryComponent::TryRemoveItem(UItemDataAsset* ItemToRemove, int Amount)
+void UInventoryComponent::ServerTransferItems_Implementation(UInventoryComponent* Source,
+                                                             UInventoryComponent* Target,
+                                                             const TArray<UItemDataAsset*>& Filter,
+                                                             int32 MaxAmount)
 {
-    if (!ItemToRemove)
+    if (!Source)
     {
-        UE_LOG(LogTemp, Error, TEXT("TryRemoveItem: ItemToRemove was null"))
-        return false;
+        UE_LOG(LogInventoryComponent, Error, TEXT("ServerTransferItems: Source is nullptr"))
+        return;
     }
 
-    if (this->ContainsItem(ItemToRemove) < Amount)
+    if (!Target)
     {
-        // Not enough of the item
-        return false;
+        UE_LOG(LogInventoryComponent, Error, TEXT("ServerTransferItems: Target is nullptr"))
+        return;
     }
 
-    int32 NumItemsRemoved = 0;
-
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    // The client only names inventories, it may move items in or out of its own one and no others
+    if (Source != this && Target != this)
     {
-        FInventorySlot InventorySlot = this->InventorySlots[i];
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : %s is neither the source nor the target"), __FUNCTION__, *GetName());
+        return;
+    }
 
-        // Ignore empty slots and items that don't match the given item
-        if (FInventorySlot::IsSlotEmpty(InventorySlot) || InventorySlot.Item != ItemToRemove) continue;
+    const UInventoryComponent* OtherInventory = Source == this ? Target : Source;
 
-        const int32 NumItemsRemovedAttempted = NumItemsRemoved + InventorySlot.CurrentStackSize;
+    if (!OtherInventory->CanBeModifiedBy(this))
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : %s may not change %s"), __FUNCTION__, *GetName(), *OtherInventory->GetName());
+        return;
+    }
 
-        if (NumItemsRemovedAttempted > Amount)
-        {
-            // Remove partial stack
-            const int32 TempNumItemsToRemove = Amount - NumItemsRemoved;
-            NumItemsRemoved += TempNumItemsToRemove;
+    UInventoryComponent::TransferItems(Source, Target, Filter, MaxAmount);
+}
 
-            InventorySlot.CurrentStackSize -= TempNumItemsToRemove;
-            this->InventorySlots[i] = InventorySlot;
-        }
-        else
-        {
-            // Remove entire stack
-            NumItemsRemoved += InventorySlot.CurrentStackSize;
+void UInventoryComponent::NotifyItemsAdded(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts)
+{
+    for (int32 i = 0; i < ItemIds.Num(); i++)
+    {
+        this->OnItemAdded.Broadcast(this->GetItemFromId(ItemIds[i]), Amounts[i]);
+    }
 
-            this->InventorySlots[i] = FInventorySlot();
-        }
+    APawn* OwningPawn = Cast<APawn>(GetOwner());
 
-        if (NumItemsRemoved == Amount)
-        {
-            break;
-        }
+    // Notify clients of item adding/removing
+    if (OwningPawn && !OwningPawn->IsLocallyControlled())
+    {
+        this->ClientOnItemsAdded(ItemIds, Amounts);
     }
 
-    this->OnItemRemoved.Broadcast(ItemToRemove, Amount);
+    this->OnItemChanged.Broadcast();
+}
+
+void UInventoryComponent::NotifyItemsRemoved(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts)
+{
+    for (int32 i = 0; i < ItemIds.Num(); i++)
+    {
+        this->OnItemRemoved.Broadcast(this->GetItemFromId(ItemIds[i]), Amounts[i]);
+    }
 
     APawn* OwningPawn = Cast<APawn>(GetOwner());
 
     // Notify clients of item adding/removing
     if (OwningPawn && !OwningPawn->IsLocallyControlled())
     {
-        this->ClientRemoveItem(ItemToRemove, Amount);
+        this->ClientOnItemsRemoved(ItemIds, Amounts);
     }
 
     this->OnItemChanged.Broadcast();
-
-    return true;
 }
 
-bool UInventoryComponent::TryRemoveItems(const TMap<UItemDataAsset*, int32>& ItemsToRemove)
+void UInventoryComponent::ClientOnItemsAdded_Implementation(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts)
 {
-    if (!this->ContainsGivenItems(ItemsToRemove))
+    for (int32 i = 0; i < ItemIds.Num() && i < Amounts.Num(); i++)
     {
-        return false;
+        this->OnItemAdded.Broadcast(this->GetItemFromId(ItemIds[i]), Amounts[i]);
     }
+}
 
-    for (const TTuple<UItemDataAsset*, int> ItemToRemove : ItemsToRemove)
+void UInventoryComponent::ClientOnItemsRemoved_Implementation(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts)
+{
+    for (int32 i = 0; i < ItemIds.Num() && i < Amounts.Num(); i++)
     {
-        if (!this->TryRemoveItem(ItemToRemove.Key, ItemToRemove.Value))
-        {
-            return false;
-        }
+        this->OnItemRemoved.Broadcast(this->GetItemFromId(ItemIds[i]), Amounts[i]);
     }
+}
 
-    return true;
+void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    // Conditions follow the ReplicationPolicy of each inventory, see UpdateReplicationConditions
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    Params.Condition    = COND_Dynamic;
+
+    DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, InventorySlots, Params);
+    DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, NumberOfSlots, Params);
+    DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, Summary, Params);
+    DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, SlotSequence, Params);
 }
 
-bool UInventoryComponent::TryRemoveItemAtIndex(int32 IndexToRemove, const int Amount)
+void UInventoryComponent::InitializeInventorySlots()
 {
-    if (!this->InventorySlots.IsValidIndex(IndexToRemove))
+    this->InventorySlots.Init(FInventorySlot(), this->NumberOfSlots);
+    this->RebuildSlotStorage();
+
+    if (this->IsInventoryAuthority())
     {
-        UE_LOG(LogTemp, Error, TEXT("TryRemoveItemAtIndex: IndexToRemove is invalid"))
-        return false;
-    }
+        // Every slot was replaced without SetSlot
+        MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, InventorySlots, this);
 
-    FInventorySlot TempSlot = this->InventorySlots[IndexToRemove];
+        this->SlotSequence++;
 
-    // Not enough amount
-    if (TempSlot.CurrentStackSize < Amount)
-    {
-        return false;
+        MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, SlotSequence, this);
+
+        this->RecalculateSummary();
+
+        for (int32 i = 0; i < this->InventorySlots.Num(); i++)
+        {
+            this->QueueViewerUpdate(i);
+        }
+
+        this->OnSlotChanged.Broadcast(INDEX_NONE);
     }
 
-    if (TempSlot.CurrentStackSize > Amount)
-    {
-        TempSlot.CurrentStackSize -= Amount;
+    this->OnItemChanged.Broadcast();
+}
 
-        this->InventorySlots[IndexToRemove] = TempSlot;
+void UInventoryComponent::RebuildSlotStorage()
+{
+    if (this->UsesSlotStorage())
+    {
+        this->SlotStorage.CopyFrom(this->GetSlotView());
     }
     else
     {
-        this->InventorySlots[IndexToRemove] = FInventorySlot();
+        this->SlotStorage.Reset();
     }
 
+    this->RebuildPartialStackIndex();
+    this->RebuildTagIndex();
+}
 
-    this->OnItemRemoved.Broadcast(TempSlot.Item, Amount);
-
-    APawn* OwningPawn = Cast<APawn>(GetOwner());
+void UInventoryComponent::SetStorageMode(EInventoryStorageMode InStorageMode)
+{
+    this->StorageMode = InStorageMode;
 
-    // Notify clients of item adding/removing
-    if (OwningPawn && !OwningPawn->IsLocallyControlled())
+    if (this->IsInventoryAuthority())
     {
-        this->ClientRemoveItem(TempSlot.Item, Amount);
+        this->UpdateReplicationConditions();
     }
 
-    this->OnItemChanged.Broadcast();
-
-    return true;
+    this->RebuildSlotStorage();
 }
 
-void UInventoryComponent::ServerRemoveItem_Implementation(UItemDataAsset* ItemToRemove, const int Amount)
+bool UInventoryComponent::TryAddItem(UItemDataAsset* ItemToAdd, const int Amount)
 {
-    if (!ItemToRemove)
+    if (!ItemToAdd)
     {
-        UE_LOG(LogTemp, Error, TEXT("ServerRemoveItem: ItemToRemove was null"))
-        return;
+        UE_LOG(LogTemp, Error, TEXT("TryAddItem: ItemToAdd was null"))
+        return false;
     }
 
-    if (!this->TryRemoveItem(ItemToRemove, Amount))
+    // All or nothing, a partial add would leave the caller holding a remainder it does not know about
+    if (this->AddItemToSlots(ItemToAdd, Amount, true) > 0)
     {
-        UE_LOG(LogTemp, Error, TEXT("ServerRemoveItem: Failed to remove %d %s"), Amount, *ItemToRemove->GetName())
+        UE_LOG(LogTemp, Warning, TEXT("TryAddItem: Inventory Full"))
+        return false;
     }
+
+    return true;
 }
 
-void UInventoryComponent::ClientRemoveItem_Implementation(UItemDataAsset* ItemToRemove, const int Amount)
+int32 UInventoryComponent::AddItemAmount(UItemDataAsset* ItemToAdd, int32 Amount)
 {
-    this->OnItemRemoved.Broadcast(ItemToRemove, Amount);
+    if (!ItemToAdd)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : ItemToAdd is nullptr"), __FUNCTION__);
+        return Amount;
+    }
+
+    return this->AddItemToSlots(ItemToAdd, Amount, false);
 }
 
-bool UInventoryComponent::ContainsItemAmount(UItemDataAsset* ItemToCheck, const int Amount) const
+int32 UInventoryComponent::AddItemToSlots(UItemDataAsset* ItemToAdd, int32 Amount, bool bAllOrNothing)
 {
-    if (!ItemToCheck)
+    this->SettleProduction();
+
+    const uint16 ItemId      = UItemRegistrySubsystem::GetItemId(ItemToAdd);
+    const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+
+    if (Amount <= 0 || MaxStackSize <= 0)
     {
-        UE_LOG(LogTemp, Error, TEXT("ContainsItemAmount: ItemToCheck was null"))
-        return false;
+        return FMath::Max(Amount, 0);
     }
 
-    // TODO: Handle checking for split stacks adding up to the correct amount
-    // Currently this will only check each slot individually and not add up totals
+    TArray<int32, TInlineAllocator<8>> SlotIndices;
 
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    const int32 AmountNotFitting = this->FindSlotsToAdd(ItemId, Amount, SlotIndices);
+
+    if (bAllOrNothing && AmountNotFitting > 0)
+    {
+        return Amount;
+    }
+
+    int32 AmountLeft = Amount - AmountNotFitting;
+
+    for (const int32 SlotIndex : SlotIndices)
     {
-        const FInventorySlot InventorySlot = this->InventorySlots[i];
+        const FInventorySlot& InventorySlot = this->InventorySlots[SlotIndex];
 
         if (FInventorySlot::IsSlotEmpty(InventorySlot))
         {
+            const int32 AmountToStack = FMath::Min(MaxStackSize, AmountLeft);
+
+            this->SetSlot(SlotIndex, FInventorySlot(ItemToAdd, AmountToStack));
+
+            AmountLeft -= AmountToStack;
             continue;
         }
 
-        const bool bHasItem = ItemToCheck == InventorySlot.Item;
-        const bool bHasAmount = Amount <= InventorySlot.CurrentStackSize;
+        FInventorySlot PartialSlot = InventorySlot;
 
-        if (bHasItem && bHasAmount)
+        const int32 AmountToStack = FMath::Min(MaxStackSize - PartialSlot.CurrentStackSize, AmountLeft);
+
+        PartialSlot.CurrentStackSize += AmountToStack;
+        AmountLeft                   -= AmountToStack;
+
+        this->SetSlot(SlotIndex, PartialSlot);
+    }
+
+    const int32 AmountAdded = Amount - AmountNotFitting;
+
+    if (AmountAdded > 0)
+    {
+        this->ApplyCompactPolicy();
+
+        this->OnItemAdded.Broadcast(ItemToAdd, AmountAdded);
+
+        APawn* OwningPawn = Cast<APawn>(GetOwner());
+
+        // Notify clients of item adding/removing
+        if (OwningPawn && !OwningPawn->IsLocallyControlled())
         {
-            return true;
+            this->ClientOnAddItem(ItemId, AmountAdded);
         }
+
+        this->OnItemChanged.Broadcast();
     }
 
-    return false;
+    return AmountNotFitting;
 }
 
-bool UInventoryComponent::HasAvailableSpaceForItem(UItemDataAsset* ItemToCheck, const int Amount) const
+int32 UInventoryComponent::FindSlotsToAdd(uint16 ItemId, int32 Amount, TArray<int32, TInlineAllocator<8>>& OutSlotIndices) const
 {
-    if (!ItemToCheck)
+    const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+
+    if (Amount <= 0 || MaxStackSize <= 0)
     {
-        UE_LOG(LogTemp, Error, TEXT("%hs : ItemToCheck is nullptr"), __FUNCTION__);
-        return false;
+        return FMath::Max(Amount, 0);
     }
 
-    const int32 MaxStackSize = ItemToCheck->GetMaxStackSize();
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
 
-    int32 NumAvailableSpots = 0;
+    TArray<int32, TInlineAllocator<8>> EmptySlotIndices;
 
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    int32 AmountLeft    = Amount;
+    int64 EmptyCapacity = 0;
+
+    for (int32 i = 0; i < Slots.Num() && AmountLeft > 0; i++)
     {
-        const FInventorySlot& InventorySlot = this->InventorySlots[i];
+        const FInventorySlot& InventorySlot = Slots[i];
 
-        if (FInventorySlot::IsSlotFull(InventorySlot))
+        // Only as many empty slots as the amount the partial stacks have not taken yet
+        if (FInventorySlot::IsSlotEmpty(InventorySlot))
         {
+            if (EmptyCapacity < AmountLeft)
+            {
+                EmptySlotIndices.Add(i);
+                EmptyCapacity += MaxStackSize;
+            }
+
             continue;
         }
 
-        // Item Exists in Inventory slot
-        if (ItemToCheck == InventorySlot.Item)
+        if (InventorySlot.ItemId != ItemId || InventorySlot.CurrentStackSize >= MaxStackSize) continue;
+
+        OutSlotIndices.Add(i);
+        AmountLeft -= FMath::Min(MaxStackSize - InventorySlot.CurrentStackSize, AmountLeft);
+    }
+
+    // Then start new stacks, only the last of them can end up partial
+    for (const int32 EmptySlotIndex : EmptySlotIndices)
+    {
+        if (AmountLeft <= 0) break;
+
+        OutSlotIndices.Add(EmptySlotIndex);
+        AmountLeft -= FMath::Min(MaxStackSize, AmountLeft);
+    }
+
+    return AmountLeft;
+}
+
+bool UInventoryComponent::TryAddItems(const TMap<UItemDataAsset*, int32>& ItemsToAdd)
+{
+    for (const TTuple<UItemDataAsset*, int> ItemToAdd : ItemsToAdd)
+    {
+        if (!this->TryAddItem(ItemToAdd.Key, ItemToAdd.Value))
         {
-            NumAvailableSpots += MaxStackSize - InventorySlot.CurrentStackSize;
+            return false;
         }
+    }
 
-        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+    return true;
+}
+
+void UInventoryComponent::ServerAddItem_Implementation(UItemDataAsset* ItemToAdd, const int Amount, int32 PredictionKey)
+{
+    bool bAdded = false;
+
+    if (!ItemToAdd)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ServerAddItem: ItemToAdd was nullptr"))
+    }
+    else
+    {
+        bAdded = this->TryAddItem(ItemToAdd, Amount);
+
+        if (!bAdded)
         {
-            NumAvailableSpots += MaxStackSize;
+            UE_LOG(LogTemp, Error, TEXT("ServerAddItem: TryAddItem failed"))
         }
     }
 
-    if (NumAvailableSpots < Amount)
+    if (PredictionKey != 0)
     {
-        return false;
+        this->ClientResolvePrediction(PredictionKey, bAdded, this->SlotSequence);
     }
+}
 
-    return true;
+void UInventoryComponent::RequestAddItem(UItemDataAsset* ItemToAdd, const int Amount)
+{
+    int32 PredictionKey = 0;
+
+    // The server refuses adds that do not fit completely, so only predict the ones it can accept
+    if (ItemToAdd && this->CanPredict() && this->HasAvailableSpaceForItem(ItemToAdd, Amount))
+    {
+        PredictionKey = UInventoryComponent::CreatePredictionKey();
+
+        this->PredictAddItem(PredictionKey, ItemToAdd, Amount);
+    }
+
+    this->ServerAddItem(ItemToAdd, Amount, PredictionKey);
 }
 
-bool UInventoryComponent::HasAvailableSpaceForItems(const TMap<UItemDataAsset*, int32>& InItems) const
+void UInventoryComponent::ClientOnAddItem_Implementation(uint16 ItemIdAdded, const int Amount)
 {
-    // TODO: Implement
-    UE_LOG(LogInventoryComponent, Error, TEXT("UNIMPLEMENTED"));
-    return false;
+    UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get();
+
+    if (!ItemRegistry)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : ItemRegistry is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    // Broadcast on clients to handle UI
+    this->OnItemAdded.Broadcast(ItemRegistry->GetItem(ItemIdAdded), Amount);
 }
 
-int32 UInventoryComponent::ContainsItem(UItemDataAsset* ItemToCheck)
+bool UInventoryComponent::TryRemoveItem(UItemDataAsset* ItemToRemove, int Amount)
 {
-    if (!ItemToCheck)
+    this->SettleProduction();
+
+    if (!ItemToRemove)
     {
-        UE_LOG(LogTemp, Error, TEXT("ContainsItem: ItemToCheck was null"))
-        return 0;
+        UE_LOG(LogTemp, Error, TEXT("TryRemoveItem: ItemToRemove was null"))
+        return false;
     }
 
-    int32 NumItems = 0;
+    if (this->ContainsItem(ItemToRemove) < Amount)
+    {
+        // Not enough of the item
+        return false;
+    }
+
+    const uint16 ItemId = UItemRegistrySubsystem::GetItemId(ItemToRemove);
 
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    int32 NumItemsRemoved = 0;
+
+    // Take from the partial stack first, so removing does not leave a second partial stack behind
+    if (this->UsesPartialStackIndex())
     {
-        const FInventorySlot InventorySlot = this->InventorySlots[i];
+        const int32 PartialStackIndex = this->FindPartialStackIndex(ItemId);
 
-        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+        if (PartialStackIndex != INDEX_NONE)
         {
-            continue;
+            FInventorySlot PartialSlot = this->InventorySlots[PartialStackIndex];
+
+            const int32 AmountTaken = FMath::Min(PartialSlot.CurrentStackSize, Amount);
+
+            PartialSlot.CurrentStackSize -= AmountTaken;
+            NumItemsRemoved              += AmountTaken;
+
+            this->SetSlot(PartialStackIndex, PartialSlot.CurrentStackSize > 0 ? PartialSlot : FInventorySlot());
+        }
+    }
+
+    for (int i = 0; i < this->InventorySlots.Num() && NumItemsRemoved < Amount; i++)
+    {
+        FInventorySlot InventorySlot = this->InventorySlots[i];
+
+        // Ignore empty slots and items that don't match the given item
+        if (FInventorySlot::IsSlotEmpty(InventorySlot) || InventorySlot.ItemId != ItemId) continue;
+
+        const int32 NumItemsRemovedAttempted = NumItemsRemoved + InventorySlot.CurrentStackSize;
+
+        if (NumItemsRemovedAttempted > Amount)
+        {
+            // Remove partial stack
+            const int32 TempNumItemsToRemove = Amount - NumItemsRemoved;
+            NumItemsRemoved += TempNumItemsToRemove;
+
+            InventorySlot.CurrentStackSize -= TempNumItemsToRemove;
+            this->SetSlot(i, InventorySlot);
         }
+        else
+        {
+            // Remove entire stack
+            NumItemsRemoved += InventorySlot.CurrentStackSize;
 
-        if (ItemToCheck == InventorySlot.Item)
+            this->SetSlot(i, FInventorySlot());
+        }
+
+        if (NumItemsRemoved == Amount)
         {
-            NumItems += InventorySlot.CurrentStackSize;
+            break;
         }
     }
 
-    return NumItems;
+    this->ApplyCompactPolicy();
+
+    this->OnItemRemoved.Broadcast(ItemToRemove, Amount);
+
+    APawn* OwningPawn = Cast<APawn>(GetOwner());
+
+    // Notify clients of item adding/removing
+    if (OwningPawn && !OwningPawn->IsLocallyControlled())
+    {
+        this->ClientRemoveItem(ItemId, Amount);
+    }
+
+    this->OnItemChanged.Broadcast();
+
+    return true;
 }
 
-bool UInventoryComponent::ContainsGivenItems(const TMap<UItemDataAsset*, int32>& Items) const
+bool UInventoryComponent::TryRemoveItems(const TMap<UItemDataAsset*, int32>& ItemsToRemove)
 {
-    for (const TTuple<UItemDataAsset*, int> Item : Items)
+    if (!this->ContainsGivenItems(ItemsToRemove))
     {
-        if (!this->ContainsItemAmount(Item.Key, Item.Value))
+        return false;
+    }
+
+    for (const TTuple<UItemDataAsset*, int> ItemToRemove : ItemsToRemove)
+    {
+        if (!this->TryRemoveItem(ItemToRemove.Key, ItemToRemove.Value))
         {
             return false;
         }
@@ -466,73 +780,1829 @@ bool UInventoryComponent::ContainsGivenItems(const TMap<UItemDataAsset*, int32>&
     return true;
 }
 
-int32 UInventoryComponent::ContainsPartialStack(UItemDataAsset* ItemToCheck)
+bool UInventoryComponent::TryRemoveItemAtIndex(int32 IndexToRemove, const int Amount)
 {
-    if (!ItemToCheck)
+    this->SettleProduction();
+
+    if (!this->InventorySlots.IsValidIndex(IndexToRemove))
     {
-        UE_LOG(LogTemp, Error, TEXT("ContainsItem: ItemToCheck was null"))
-        return -1;
+        UE_LOG(LogTemp, Error, TEXT("TryRemoveItemAtIndex: IndexToRemove is invalid"))
+        return false;
     }
 
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    FInventorySlot TempSlot = this->InventorySlots[IndexToRemove];
+
+    // Not enough amount
+    if (TempSlot.CurrentStackSize < Amount)
     {
-        const FInventorySlot InventorySlot = this->InventorySlots[i];
+        return false;
+    }
 
-        if (FInventorySlot::IsSlotEmpty(InventorySlot)) continue;
+    if (TempSlot.CurrentStackSize > Amount)
+    {
+        TempSlot.CurrentStackSize -= Amount;
 
-        if (ItemToCheck == InventorySlot.Item && !FInventorySlot::IsSlotFull(InventorySlot))
-        {
-            return i;
-        }
+        this->SetSlot(IndexToRemove, TempSlot);
     }
+    else
+    {
+        this->SetSlot(IndexToRemove, FInventorySlot());
+    }
+
+    this->ApplyCompactPolicy();
+
+    this->OnItemRemoved.Broadcast(TempSlot.Item, Amount);
+
+    APawn* OwningPawn = Cast<APawn>(GetOwner());
 
-    return -1;
+    // Notify clients of item adding/removing
+    if (OwningPawn && !OwningPawn->IsLocallyControlled())
+    {
+        this->ClientRemoveItem(TempSlot.ItemId, Amount);
+    }
+
+    this->OnItemChanged.Broadcast();
+
+    return true;
 }
 
-// TODO: Should track in bool whenever adding/removing item
-bool UInventoryComponent::HasAnyEmptySlots()
+void UInventoryComponent::ServerRemoveItem_Implementation(UItemDataAsset* ItemToRemove, const int Amount, int32 PredictionKey)
 {
-    bool bFull = true;
+    bool bRemoved = false;
 
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    if (!ItemToRemove)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ServerRemoveItem: ItemToRemove was null"))
+    }
+    else
     {
-        const FInventorySlot InventorySlot = this->InventorySlots[i];
+        bRemoved = this->TryRemoveItem(ItemToRemove, Amount);
 
-        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+        if (!bRemoved)
         {
-            bFull = false;
-            break;
+            UE_LOG(LogTemp, Error, TEXT("ServerRemoveItem: Failed to remove %d %s"), Amount, *ItemToRemove->GetName())
         }
     }
 
-    return bFull;
+    if (PredictionKey != 0)
+    {
+        this->ClientResolvePrediction(PredictionKey, bRemoved, this->SlotSequence);
+    }
 }
 
-bool UInventoryComponent::IsInventoryEmpty()
+void UInventoryComponent::RequestRemoveItem(UItemDataAsset* ItemToRemove, const int Amount)
 {
-    bool bEmpty = true;
+    int32 PredictionKey = 0;
 
-    for (int i = 0; i < this->InventorySlots.Num(); i++)
+    // The server refuses removals of items that are not there, so only predict the ones it can accept
+    if (ItemToRemove && this->CanPredict() && this->ContainsItem(ItemToRemove) >= Amount)
     {
-        const FInventorySlot InventorySlot = this->InventorySlots[i];
+        PredictionKey = UInventoryComponent::CreatePredictionKey();
 
-        if (!FInventorySlot::IsSlotEmpty(InventorySlot))
+        this->PredictRemoveItem(PredictionKey, ItemToRemove, Amount);
+    }
+
+    this->ServerRemoveItem(ItemToRemove, Amount, PredictionKey);
+}
+
+void UInventoryComponent::ClientRemoveItem_Implementation(uint16 ItemIdRemoved, const int Amount)
+{
+    UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get();
+
+    if (!ItemRegistry)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : ItemRegistry is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    this->OnItemRemoved.Broadcast(ItemRegistry->GetItem(ItemIdRemoved), Amount);
+}
+
+bool UInventoryComponent::ContainsItemAmount(UItemDataAsset* ItemToCheck, const int Amount) const
+{
+    if (!ItemToCheck)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ContainsItemAmount: ItemToCheck was null"))
+        return false;
+    }
+
+    // TODO: Handle checking for split stacks adding up to the correct amount
+    // Currently this will only check each slot individually and not add up totals
+
+    const uint16 ItemId = UItemRegistrySubsystem::GetItemId(ItemToCheck);
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int i = 0; i < Slots.Num(); i++)
+    {
+        const FInventorySlot& InventorySlot = Slots[i];
+
+        if (FInventorySlot::IsSlotEmpty(InventorySlot))
         {
-            bEmpty = false;
-            break;
+            continue;
+        }
+
+        const bool bHasItem = ItemId == InventorySlot.ItemId;
+        const bool bHasAmount = Amount <= InventorySlot.CurrentStackSize;
+
+        if (bHasItem && bHasAmount)
+        {
+            return true;
         }
     }
 
-    return bEmpty;
+    return false;
 }
 
-void UInventoryComponent::SetNumberOfSlots(int InNumberOfSlots)
+bool UInventoryComponent::HasAvailableSpaceForItem(UItemDataAsset* ItemToCheck, const int Amount) const
 {
-    this->NumberOfSlots = InNumberOfSlots;
-}
+    if (!ItemToCheck)
+    {
+        UE_LOG(LogTemp, Error, TEXT("%hs : ItemToCheck is nullptr"), __FUNCTION__);
+        return false;
+    }
 
+    const uint16 ItemId      = UItemRegistrySubsystem::GetItemId(ItemToCheck);
+    const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
 
-void UInventoryComponent::OnRep_InventorySlots()
+    if (this->UsesSlotStorage())
+    {
+        return this->SlotStorage.GetAvailableSpace(ItemId) >= Amount;
+    }
+
+    int32 NumAvailableSpots = 0;
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int i = 0; i < Slots.Num(); i++)
+    {
+        const FInventorySlot& InventorySlot = Slots[i];
+
+        if (FInventorySlot::IsSlotFull(InventorySlot))
+        {
+            continue;
+        }
+
+        // Item Exists in Inventory slot
+        if (ItemId == InventorySlot.ItemId)
+        {
+            NumAvailableSpots += MaxStackSize - InventorySlot.CurrentStackSize;
+        }
+
+        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+        {
+            NumAvailableSpots += MaxStackSize;
+        }
+    }
+
+    if (NumAvailableSpots < Amount)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool UInventoryComponent::HasAvailableSpaceForItems(const TMap<UItemDataAsset*, int32>& InItems) const
+{
+    // TODO: Implement
+    UE_LOG(LogInventoryComponent, Error, TEXT("UNIMPLEMENTED"));
+    return false;
+}
+
+int32 UInventoryComponent::ContainsItem(UItemDataAsset* ItemToCheck)
+{
+    if (!ItemToCheck)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ContainsItem: ItemToCheck was null"))
+        return 0;
+    }
+
+    const uint16 ItemId = UItemRegistrySubsystem::GetItemId(ItemToCheck);
+
+    if (this->UsesSlotStorage())
+    {
+        return this->SlotStorage.SumItemCount(ItemId);
+    }
+
+    int32 NumItems = 0;
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int i = 0; i < Slots.Num(); i++)
+    {
+        const FInventorySlot& InventorySlot = Slots[i];
+
+        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+        {
+            continue;
+        }
+
+        if (ItemId == InventorySlot.ItemId)
+        {
+            NumItems += InventorySlot.CurrentStackSize;
+        }
+    }
+
+    return NumItems;
+}
+
+bool UInventoryComponent::ContainsGivenItems(const TMap<UItemDataAsset*, int32>& Items) const
+{
+    for (const TTuple<UItemDataAsset*, int> Item : Items)
+    {
+        if (!this->ContainsItemAmount(Item.Key, Item.Value))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int32 UInventoryComponent::ContainsPartialStack(UItemDataAsset* ItemToCheck)
+{
+    if (!ItemToCheck)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ContainsItem: ItemToCheck was null"))
+        return -1;
+    }
+
+    return this->FindPartialStackIndex(UItemRegistrySubsystem::GetItemId(ItemToCheck));
+}
+
+// TODO: Should track in bool whenever adding/removing item
+bool UInventoryComponent::HasAnyEmptySlots()
+{
+    return this->FindEmptySlotIndex() != INDEX_NONE;
+}
+
+bool UInventoryComponent::IsInventoryEmpty()
+{
+    if (this->UsesSlotStorage())
+    {
+        return this->SlotStorage.GetNumEmptySlots() == this->SlotStorage.Num();
+    }
+
+    bool bEmpty = true;
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int i = 0; i < Slots.Num(); i++)
+    {
+        const FInventorySlot InventorySlot = Slots[i];
+
+        if (!FInventorySlot::IsSlotEmpty(InventorySlot))
+        {
+            bEmpty = false;
+            break;
+        }
+    }
+
+    return bEmpty;
+}
+
+void UInventoryComponent::SetNumberOfSlots(int InNumberOfSlots)
+{
+    this->SettleProduction();
+
+    this->NumberOfSlots = InNumberOfSlots;
+
+    MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, NumberOfSlots, this);
+}
+
+FInventorySlot UInventoryComponent::GetInventorySlot(int32 Index) const
+{
+    if (this->IsPagedClient())
+    {
+        return this->PagedSlots.FindRef(Index);
+    }
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    return Slots.IsValidIndex(Index) ? Slots[Index] : FInventorySlot();
+}
+
+void UInventoryComponent::SetInventorySlot(int32 Index, const FInventorySlot& NewSlot)
+{
+    this->SettleProduction();
+
+    if (!this->IsInventoryAuthority())
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : Must be called on the server"), __FUNCTION__);
+        return;
+    }
+
+    if (!this->InventorySlots.IsValidIndex(Index))
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : Index %d is invalid"), __FUNCTION__, Index);
+        return;
+    }
+
+    // Slots made in Blueprints only set the item, every other path goes by its id
+    FInventorySlot ResolvedSlot = NewSlot;
+    ResolvedSlot.ResolveItemId();
+
+    this->SetSlot(Index, ResolvedSlot);
+
+    this->OnItemChanged.Broadcast();
+}
+
+bool UInventoryComponent::UsesSlotStorage() const
+{
+    // Paged inventories are the largest ones, so the server scans them through the storage as well
+    return this->StorageMode == EInventoryStorageMode::StructOfArrays || this->StorageMode == EInventoryStorageMode::Paged;
+}
+
+void UInventoryComponent::SetSlot(int32 Index, const FInventorySlot& NewSlot)
+{
+    const FInventorySlot& OldSlot = this->InventorySlots[Index];
+
+    this->UpdateSlotIndices(Index, OldSlot, NewSlot);
+
+    const bool bOldSlotEmpty = FInventorySlot::IsSlotEmpty(OldSlot);
+    const bool bNewSlotEmpty = FInventorySlot::IsSlotEmpty(NewSlot);
+
+    const int32 UsedSlotsDelta = (bNewSlotEmpty ? 0 : 1) - (bOldSlotEmpty ? 0 : 1);
+    const int32 NumItemsDelta  = (bNewSlotEmpty ? 0 : NewSlot.CurrentStackSize) - (bOldSlotEmpty ? 0 : OldSlot.CurrentStackSize);
+
+    if (UsedSlotsDelta != 0 || NumItemsDelta != 0)
+    {
+        this->Summary.NumUsedSlots += UsedSlotsDelta;
+        this->Summary.NumItems     += NumItemsDelta;
+
+        MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, Summary, this);
+    }
+
+    this->InventorySlots[Index] = NewSlot;
+
+    this->MarkSlotDirty(Index);
+}
+
+void UInventoryComponent::UpdateSlotIndices(int32 Index, const FInventorySlot& OldSlot, const FInventorySlot& NewSlot)
+{
+    if (this->UsesPartialStackIndex())
+    {
+        this->UpdatePartialStackIndex(Index, OldSlot, NewSlot);
+    }
+
+    this->UpdateTagIndex(Index, OldSlot, NewSlot);
+
+    if (this->UsesSlotStorage())
+    {
+        this->SlotStorage.SetSlot(Index, NewSlot);
+    }
+}
+
+UItemDataAsset* UInventoryComponent::GetItemFromId(uint16 ItemId) const
+{
+    UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get();
+
+    return ItemRegistry ? ItemRegistry->GetItem(ItemId) : nullptr;
+}
+
+int32 UInventoryComponent::FindPartialStackIndex(uint16 ItemId) const
+{
+    if (this->UsesPartialStackIndex())
+    {
+        return this->PartialStackIndices.IsValidIndex(ItemId) ? this->PartialStackIndices[ItemId] : INDEX_NONE;
+    }
+
+    if (this->UsesSlotStorage())
+    {
+        return this->SlotStorage.FindFirstPartialStack(ItemId);
+    }
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int i = 0; i < Slots.Num(); i++)
+    {
+        const FInventorySlot& InventorySlot = Slots[i];
+
+        if (FInventorySlot::IsSlotEmpty(InventorySlot)) continue;
+
+        if (ItemId == InventorySlot.ItemId && !FInventorySlot::IsSlotFull(InventorySlot))
+        {
+            return i;
+        }
+    }
+
+    return INDEX_NONE;
+}
+
+int32 UInventoryComponent::FindEmptySlotIndex() const
+{
+    if (this->UsesSlotStorage())
+    {
+        return this->SlotStorage.FindFirstEmptySlot();
+    }
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int i = 0; i < Slots.Num(); i++)
+    {
+        if (FInventorySlot::IsSlotEmpty(Slots[i]))
+        {
+            return i;
+        }
+    }
+
+    return INDEX_NONE;
+}
+
+bool UInventoryComponent::UsesPartialStackIndex() const
+{
+    return this->CompactPolicy != EInventoryCompactPolicy::Manual;
+}
+
+void UInventoryComponent::SetCompactPolicy(EInventoryCompactPolicy InCompactPolicy)
+{
+    this->CompactPolicy = InCompactPolicy;
+
+    this->RebuildPartialStackIndex();
+
+    if (this->IsInventoryAuthority() && this->UsesPartialStackIndex())
+    {
+        this->CompactInventory();
+    }
+}
+
+void UInventoryComponent::RebuildPartialStackIndex()
+{
+    this->PartialStackIndices.Reset();
+    this->ItemsToMerge.Reset();
+
+    if (!this->UsesPartialStackIndex())
+    {
+        return;
+    }
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int32 i = 0; i < Slots.Num(); i++)
+    {
+        const FInventorySlot& InventorySlot = Slots[i];
+
+        if (FInventorySlot::IsSlotEmpty(InventorySlot) || FInventorySlot::IsSlotFull(InventorySlot)) continue;
+
+        int32& PartialStackIndex = this->GetPartialStackIndexRef(InventorySlot.ItemId);
+
+        // Clients only mirror the server, which merges any further partial stacks
+        if (PartialStackIndex == INDEX_NONE)
+        {
+            PartialStackIndex = i;
+        }
+    }
+}
+
+int32& UInventoryComponent::GetPartialStackIndexRef(uint16 ItemId)
+{
+    if (this->PartialStackIndices.Num() <= ItemId)
+    {
+        const int32 OldNum = this->PartialStackIndices.Num();
+
+        this->PartialStackIndices.SetNumUninitialized(ItemId + 1);
+
+        for (int32 i = OldNum; i < this->PartialStackIndices.Num(); i++)
+        {
+            this->PartialStackIndices[i] = INDEX_NONE;
+        }
+    }
+
+    return this->PartialStackIndices[ItemId];
+}
+
+void UInventoryComponent::UpdatePartialStackIndex(int32 Index, const FInventorySlot& OldSlot, const FInventorySlot& NewSlot)
+{
+    if (this->PartialStackIndices.IsValidIndex(OldSlot.ItemId) && this->PartialStackIndices[OldSlot.ItemId] == Index)
+    {
+        this->PartialStackIndices[OldSlot.ItemId] = INDEX_NONE;
+    }
+
+    if (FInventorySlot::IsSlotEmpty(NewSlot) || FInventorySlot::IsSlotFull(NewSlot))
+    {
+        return;
+    }
+
+    int32& PartialStackIndex = this->GetPartialStackIndexRef(NewSlot.ItemId);
+
+    if (PartialStackIndex == INDEX_NONE)
+    {
+        PartialStackIndex = Index;
+    }
+    else if (PartialStackIndex != Index && !this->bMergingStacks)
+    {
+        this->ItemsToMerge.AddUnique(NewSlot.ItemId);
+    }
+}
+
+void UInventoryComponent::MergeItemStacks(uint16 ItemId)
+{
+    const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+
+    if (MaxStackSize <= 0)
+    {
+        return;
+    }
+
+    TArray<int32, TInlineAllocator<16>> StackIndices;
+
+    int32 TotalAmount = 0;
+
+    for (int32 i = 0; i < this->InventorySlots.Num(); i++)
+    {
+        if (this->InventorySlots[i].ItemId != ItemId) continue;
+
+        StackIndices.Add(i);
+        TotalAmount += this->InventorySlots[i].CurrentStackSize;
+    }
+
+    if (StackIndices.Num() == 0)
+    {
+        return;
+    }
+
+    UItemDataAsset* Item = this->InventorySlots[StackIndices[0]].Item;
+
+    TGuardValue<bool> MergingGuard(this->bMergingStacks, true);
+
+    this->GetPartialStackIndexRef(ItemId) = INDEX_NONE;
+
+    // Refill the item's slots in order with full stacks, the remainder ends up in the last one used
+    for (const int32 StackIndex : StackIndices)
+    {
+        const int32 StackSize = FMath::Min(MaxStackSize, TotalAmount);
+
+        FInventorySlot NewSlot;
+
+        if (StackSize > 0)
+        {
+            NewSlot.Item             = Item;
+            NewSlot.ItemId           = ItemId;
+            NewSlot.CurrentStackSize = StackSize;
+            NewSlot.MaxStackSize     = MaxStackSize;
+        }
+
+        this->SetSlot(StackIndex, NewSlot);
+
+        TotalAmount -= StackSize;
+    }
+}
+
+bool UInventoryComponent::CompactSlots()
+{
+    struct FStack
+    {
+        uint16 ItemId;
+        int32 StackSize;
+        UItemDataAsset* Item;
+    };
+
+    TArray<FStack> Stacks;
+    Stacks.Reserve(this->InventorySlots.Num());
+
+    for (const FInventorySlot& InventorySlot : this->InventorySlots)
+    {
+        if (FInventorySlot::IsSlotEmpty(InventorySlot)) continue;
+
+        Stacks.Add({InventorySlot.ItemId, InventorySlot.CurrentStackSize, InventorySlot.Item});
+    }
+
+    Stacks.Sort([](const FStack& A, const FStack& B)
+    {
+        if (A.ItemId != B.ItemId)
+        {
+            return A.ItemId < B.ItemId;
+        }
+
+        return A.StackSize > B.StackSize;
+    });
+
+    TArray<FInventorySlot> CompactedSlots;
+    CompactedSlots.Reserve(this->InventorySlots.Num());
+
+    // Re-stack the totals of each item as full stacks followed by at most one partial stack
+    for (int32 i = 0; i < Stacks.Num();)
+    {
+        const uint16 ItemId      = Stacks[i].ItemId;
+        UItemDataAsset* Item     = Stacks[i].Item;
+        const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+
+        int32 TotalAmount = 0;
+        int32 NumStacks   = 0;
+
+        for (; i < Stacks.Num() && Stacks[i].ItemId == ItemId; i++)
+        {
+            TotalAmount += Stacks[i].StackSize;
+            NumStacks++;
+        }
+
+        if (MaxStackSize <= 0)
+        {
+            // Unknown stack size, keep the stacks as they are
+            for (int32 j = i - NumStacks; j < i; j++)
+            {
+                CompactedSlots.Add(FInventorySlot(Stacks[j].Item, Stacks[j].StackSize));
+            }
+
+            continue;
+        }
+
+        while (TotalAmount > 0)
+        {
+            const int32 StackSize = FMath::Min(MaxStackSize, TotalAmount);
+
+            FInventorySlot NewSlot;
+            NewSlot.Item             = Item;
+            NewSlot.ItemId           = ItemId;
+            NewSlot.CurrentStackSize = StackSize;
+            NewSlot.MaxStackSize     = MaxStackSize;
+
+            CompactedSlots.Add(NewSlot);
+
+            TotalAmount -= StackSize;
+        }
+    }
+
+    CompactedSlots.SetNum(this->InventorySlots.Num());
+
+    bool bChanged = false;
+
+    {
+        TGuardValue<bool> MergingGuard(this->bMergingStacks, true);
+
+        // Only write the slots that moved, everything happens in this frame so it replicates as one update
+        for (int32 i = 0; i < CompactedSlots.Num(); i++)
+        {
+            if (CompactedSlots[i] == this->InventorySlots[i]) continue;
+
+            this->SetSlot(i, CompactedSlots[i]);
+
+            bChanged = true;
+        }
+    }
+
+    this->RebuildPartialStackIndex();
+
+    return bChanged;
+}
+
+bool UInventoryComponent::CompactInventory()
+{
+    this->SettleProduction();
+
+    const bool bChanged = this->CompactSlots();
+
+    if (bChanged)
+    {
+        this->OnItemChanged.Broadcast();
+    }
+
+    return bChanged;
+}
+
+void UInventoryComponent::ServerCompactInventory_Implementation()
+{
+    this->CompactInventory();
+}
+
+void UInventoryComponent::ApplyCompactPolicy()
+{
+    switch (this->CompactPolicy)
+    {
+    case EInventoryCompactPolicy::Manual:
+        break;
+    case EInventoryCompactPolicy::Always:
+        {
+            for (int32 i = 0; i < this->ItemsToMerge.Num(); i++)
+            {
+                this->MergeItemStacks(this->ItemsToMerge[i]);
+            }
+
+            this->ItemsToMerge.Reset();
+
+            break;
+        }
+    case EInventoryCompactPolicy::Sorted:
+        {
+            this->CompactSlots();
+
+            break;
+        }
+    }
+}
+
+int32 UInventoryComponent::CountItemsWithTag(FGameplayTag Tag) const
+{
+    return this->TagItemCounts.FindRef(Tag);
+}
+
+TArray<int32> UInventoryComponent::FindSlotsWithTag(FGameplayTag Tag) const
+{
+    TArray<int32> SlotIndices;
+
+    if (const TSet<int32>* TaggedSlots = this->TagSlotIndices.Find(Tag))
+    {
+        SlotIndices = TaggedSlots->Array();
+        SlotIndices.Sort();
+    }
+
+    return SlotIndices;
+}
+
+int32 UInventoryComponent::RemoveItemsWithTag(FGameplayTag Tag, int32 Amount)
+{
+    this->SettleProduction();
+
+    if (!this->IsInventoryAuthority())
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : Must be called on the server"), __FUNCTION__);
+        return 0;
+    }
+
+    // Removing empties slots out of the set, so iterate a copy
+    const TArray<int32> SlotIndices = this->FindSlotsWithTag(Tag);
+
+    TArray<uint16> RemovedItemIds;
+    TArray<int32> RemovedAmounts;
+
+    int32 NumItemsRemoved = 0;
+
+    for (const int32 SlotIndex : SlotIndices)
+    {
+        if (Amount >= 0 && NumItemsRemoved >= Amount)
+        {
+            break;
+        }
+
+        FInventorySlot InventorySlot = this->InventorySlots[SlotIndex];
+
+        const int32 AmountTaken = Amount >= 0
+                                      ? FMath::Min(InventorySlot.CurrentStackSize, Amount - NumItemsRemoved)
+                                      : InventorySlot.CurrentStackSize;
+
+        InventorySlot.CurrentStackSize -= AmountTaken;
+        NumItemsRemoved                += AmountTaken;
+
+        this->SetSlot(SlotIndex, InventorySlot.CurrentStackSize > 0 ? InventorySlot : FInventorySlot());
+
+        const int32 RemovedIndex = RemovedItemIds.Find(InventorySlot.ItemId);
+
+        if (RemovedIndex == INDEX_NONE)
+        {
+            RemovedItemIds.Add(InventorySlot.ItemId);
+            RemovedAmounts.Add(AmountTaken);
+        }
+        else
+        {
+            RemovedAmounts[RemovedIndex] += AmountTaken;
+        }
+    }
+
+    if (NumItemsRemoved > 0)
+    {
+        this->ApplyCompactPolicy();
+        this->NotifyItemsRemoved(RemovedItemIds, RemovedAmounts);
+    }
+
+    return NumItemsRemoved;
+}
+
+void UInventoryComponent::RebuildTagIndex()
+{
+    this->TagItemCounts.Reset();
+    this->TagSlotIndices.Reset();
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    for (int32 i = 0; i < Slots.Num(); i++)
+    {
+        this->UpdateTagIndex(i, FInventorySlot(), Slots[i]);
+    }
+}
+
+void UInventoryComponent::UpdateTagIndex(int32 Index, const FInventorySlot& OldSlot, const FInventorySlot& NewSlot)
+{
+    const bool bOldSlotEmpty = FInventorySlot::IsSlotEmpty(OldSlot);
+    const bool bNewSlotEmpty = FInventorySlot::IsSlotEmpty(NewSlot);
+
+    // Same item in the slot, only the counts change
+    if (!bOldSlotEmpty && !bNewSlotEmpty && OldSlot.ItemId == NewSlot.ItemId)
+    {
+        const int32 NumItemsDelta = NewSlot.CurrentStackSize - OldSlot.CurrentStackSize;
+
+        if (NumItemsDelta != 0)
+        {
+            for (const FGameplayTag& Tag : UItemRegistrySubsystem::GetItemTags(NewSlot.ItemId))
+            {
+                this->TagItemCounts.FindOrAdd(Tag) += NumItemsDelta;
+            }
+        }
+
+        return;
+    }
+
+    if (!bOldSlotEmpty)
+    {
+        for (const FGameplayTag& Tag : UItemRegistrySubsystem::GetItemTags(OldSlot.ItemId))
+        {
+            int32& TagItemCount = this->TagItemCounts.FindOrAdd(Tag);
+            TagItemCount -= OldSlot.CurrentStackSize;
+
+            if (TagItemCount <= 0)
+            {
+                this->TagItemCounts.Remove(Tag);
+            }
+
+            if (TSet<int32>* TaggedSlots = this->TagSlotIndices.Find(Tag))
+            {
+                TaggedSlots->Remove(Index);
+
+                if (TaggedSlots->Num() == 0)
+                {
+                    this->TagSlotIndices.Remove(Tag);
+                }
+            }
+        }
+    }
+
+    if (!bNewSlotEmpty)
+    {
+        for (const FGameplayTag& Tag : UItemRegistrySubsystem::GetItemTags(NewSlot.ItemId))
+        {
+            this->TagItemCounts.FindOrAdd(Tag) += NewSlot.CurrentStackSize;
+            this->TagSlotIndices.FindOrAdd(Tag).Add(Index);
+        }
+    }
+}
+
+bool UInventoryComponent::IsInventoryAuthority() const
+{
+    return !GetOwner() || GetOwner()->HasAuthority();
+}
+
+void UInventoryComponent::SetReplicationPolicy(EInventoryReplicationPolicy InReplicationPolicy)
+{
+    this->ReplicationPolicy = InReplicationPolicy;
+
+    if (this->ReplicationPolicy != EInventoryReplicationPolicy::OwnerAndViewers)
+    {
+        this->Viewers.Reset();
+        this->PendingSnapshotViewers.Reset();
+        this->ViewerDirtySlots.Reset();
+    }
+
+    this->UpdateReplicationConditions();
+}
+
+void UInventoryComponent::UpdateReplicationConditions()
+{
+    // Paged slots only go to the pages' viewers through ClientReceiveInventoryPages
+    if (this->StorageMode == EInventoryStorageMode::Paged)
+    {
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, InventorySlots, COND_Never);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, SlotSequence, COND_Never);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, NumberOfSlots, COND_None);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, Summary, COND_None);
+        return;
+    }
+
+    switch (this->ReplicationPolicy)
+    {
+    case EInventoryReplicationPolicy::Everyone:
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, InventorySlots, COND_None);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, SlotSequence, COND_None);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, NumberOfSlots, COND_None);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, Summary, COND_Never);
+        break;
+    case EInventoryReplicationPolicy::OwnerOnly:
+    case EInventoryReplicationPolicy::OwnerAndViewers:
+        // Viewers get their slots through ClientReceiveViewedSlots
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, InventorySlots, COND_OwnerOnly);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, SlotSequence, COND_OwnerOnly);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, NumberOfSlots, COND_OwnerOnly);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, Summary, COND_Never);
+        break;
+    case EInventoryReplicationPolicy::Summary:
+        // The summary follows the owning actor's relevancy, so only nearby players get it
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, InventorySlots, COND_OwnerOnly);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, SlotSequence, COND_OwnerOnly);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, NumberOfSlots, COND_OwnerOnly);
+        DOREPDYNAMICCONDITION_SETCONDITION_FAST(UInventoryComponent, Summary, COND_SkipOwner);
+        break;
+    }
+}
+
+void UInventoryComponent::MarkSlotDirty(int32 Index)
+{
+    MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, InventorySlots, this);
+
+    this->SlotSequence++;
+
+    MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, SlotSequence, this);
+
+    this->QueueViewerUpdate(Index);
+
+    this->OnSlotChanged.Broadcast(Index);
+}
+
+void UInventoryComponent::QueueViewerUpdate(int32 Index)
+{
+    if (this->Viewers.Num() == 0 && this->PageViewers.Num() == 0)
+    {
+        return;
+    }
+
+    this->ViewerDirtySlots.Add(Index);
+
+    // Batch every change of this frame into one update per viewer
+    if (!this->bViewerUpdatePending)
+    {
+        if (UWorld* World = GetWorld())
+        {
+            this->bViewerUpdatePending = true;
+
+            World->GetTimerManager().SetTimerForNextTick(this, &UInventoryComponent::FlushViewerUpdates);
+        }
+    }
+}
+
+void UInventoryComponent::RecalculateSummary()
+{
+    FInventorySummary NewSummary;
+
+    for (const FInventorySlot& InventorySlot : this->InventorySlots)
+    {
+        if (FInventorySlot::IsSlotEmpty(InventorySlot)) continue;
+
+        NewSummary.NumUsedSlots++;
+        NewSummary.NumItems += InventorySlot.CurrentStackSize;
+    }
+
+    if (NewSummary.NumUsedSlots != this->Summary.NumUsedSlots || NewSummary.NumItems != this->Summary.NumItems)
+    {
+        this->Summary = NewSummary;
+
+        MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, Summary, this);
+    }
+}
+
+void UInventoryComponent::FlushViewerUpdates()
+{
+    this->bViewerUpdatePending = false;
+
+    // Viewers that walked out of range since opening the inventory stop receiving it
+    this->Viewers.RemoveAll([this](const TWeakObjectPtr<UInventoryComponent>& Viewer)
+    {
+        return !Viewer.IsValid() || !this->CanBeViewedBy(Viewer.Get());
+    });
+
+    this->PageViewers.RemoveAll([this](const FInventoryPageViewer& PageViewer)
+    {
+        return !PageViewer.Viewer.IsValid() || !this->CanBeViewedBy(PageViewer.Viewer.Get());
+    });
+
+    if (this->ViewerDirtySlots.Num() == 0 || (this->Viewers.Num() == 0 && this->PageViewers.Num() == 0))
+    {
+        this->ViewerDirtySlots.Reset();
+        return;
+    }
+
+    TArray<int32> SlotIndices = this->ViewerDirtySlots.Array();
+    SlotIndices.Sort();
+
+    this->ViewerDirtySlots.Reset();
+
+    SlotIndices.RemoveAll([this](const int32 SlotIndex)
+    {
+        return !this->InventorySlots.IsValidIndex(SlotIndex);
+    });
+
+    TArray<FInventorySlot> Slots;
+    Slots.Reserve(SlotIndices.Num());
+
+    for (const int32 SlotIndex : SlotIndices)
+    {
+        Slots.Add(this->InventorySlots[SlotIndex]);
+    }
+
+    for (const TWeakObjectPtr<UInventoryComponent>& Viewer : this->Viewers)
+    {
+        // Its client could not apply the changes yet, the snapshot it waits for contains them
+        if (this->PendingSnapshotViewers.Contains(Viewer)) continue;
+
+        Viewer->ClientReceiveViewedSlots(this, this->InventorySlots.Num(), SlotIndices, Slots, this->SlotSequence);
+    }
+
+    // Page viewers only get the changes to the pages they view
+    for (const FInventoryPageViewer& PageViewer : this->PageViewers)
+    {
+        TArray<int32> ViewedSlotIndices;
+        TArray<FInventorySlot> ViewedSlots;
+
+        for (int32 i = 0; i < SlotIndices.Num(); i++)
+        {
+            if (PageViewer.Pages.Contains(SlotIndices[i] / this->SlotsPerPage))
+            {
+                ViewedSlotIndices.Add(SlotIndices[i]);
+                ViewedSlots.Add(Slots[i]);
+            }
+        }
+
+        if (ViewedSlotIndices.Num() > 0)
+        {
+            PageViewer.Viewer->ClientReceiveViewedSlots(this, this->InventorySlots.Num(), ViewedSlotIndices, ViewedSlots, this->SlotSequence);
+        }
+    }
+}
+
+void UInventoryComponent::SendAllSlotsToViewer(UInventoryComponent* Viewer)
+{
+    // The client would drop the snapshot without being able to tell which inventory it was for
+    if (!this->IsNetRelevantToViewer(Viewer))
+    {
+        this->PendingSnapshotViewers.AddUnique(Viewer);
+        return;
+    }
+
+    TArray<int32> SlotIndices;
+    SlotIndices.Reserve(this->InventorySlots.Num());
+
+    for (int32 i = 0; i < this->InventorySlots.Num(); i++)
+    {
+        SlotIndices.Add(i);
+    }
+
+    Viewer->ClientReceiveViewedSlots(this, this->InventorySlots.Num(), SlotIndices, this->InventorySlots, this->SlotSequence);
+}
+
+bool UInventoryComponent::IsNetRelevantToViewer(const UInventoryComponent* Viewer) const
+{
+    AActor* Owner             = GetOwner();
+    const AActor* ViewerOwner = Viewer ? Viewer->GetOwner() : nullptr;
+
+    if (!Owner || !ViewerOwner)
+    {
+        return false;
+    }
+
+    // Local viewers and games without networking resolve the inventory right away
+    const UNetConnection* Connection = ViewerOwner->GetNetConnection();
+
+    if (!Connection || Owner->GetNetMode() == NM_Standalone)
+    {
+        return true;
+    }
+
+    return Connection->FindActorChannelRef(Owner) != nullptr;
+}
+
+void UInventoryComponent::SendPendingSnapshots()
+{
+    TArray<TWeakObjectPtr<UInventoryComponent>> ViewersToSend = MoveTemp(this->PendingSnapshotViewers);
+
+    this->PendingSnapshotViewers.Reset();
+
+    for (const TWeakObjectPtr<UInventoryComponent>& Viewer : ViewersToSend)
+    {
+        // Closed or out of range while waiting
+        if (!Viewer.IsValid() || !this->CanBeViewedBy(Viewer.Get()))
+        {
+            this->Viewers.Remove(Viewer);
+            continue;
+        }
+
+        if (this->Viewers.Contains(Viewer))
+        {
+            this->SendAllSlotsToViewer(Viewer.Get());
+        }
+    }
+}
+
+bool UInventoryComponent::CanBeViewedBy(const UInventoryComponent* Viewer) const
+{
+    if (!Viewer || Viewer == this)
+    {
+        return false;
+    }
+
+    const AActor* ViewerOwner = Viewer->GetOwner();
+    const AActor* Owner       = GetOwner();
+
+    // Only an inventory owned by a player, remote or local, has someone to send the slots to
+    if (!ViewerOwner || !Owner || !ViewerOwner->GetNetOwningPlayer())
+    {
+        return false;
+    }
+
+    return this->IsWithinViewerDistance(ViewerOwner);
+}
+
+bool UInventoryComponent::IsWithinViewerDistance(const AActor* ViewerOwner) const
+{
+    const AActor* Owner = GetOwner();
+
+    if (!ViewerOwner || !Owner)
+    {
+        return false;
+    }
+
+    if (this->MaxViewerDistance <= 0.0f)
+    {
+        return true;
+    }
+
+    return FVector::DistSquared(ViewerOwner->GetActorLocation(), Owner->GetActorLocation()) <= FMath::Square(this->MaxViewerDistance);
+}
+
+bool UInventoryComponent::CanBeModifiedBy(const UActorComponent* Caller) const
+{
+    const AActor* CallerOwner = Caller ? Caller->GetOwner() : nullptr;
+    const AActor* Owner       = GetOwner();
+
+    if (!CallerOwner || !Owner)
+    {
+        return false;
+    }
+
+    if (CallerOwner == Owner)
+    {
+        return true;
+    }
+
+    const UPlayer* CallerPlayer = CallerOwner->GetNetOwningPlayer();
+
+    if (!CallerPlayer)
+    {
+        return false;
+    }
+
+    // Another actor of the same player, e.g. a vehicle it drives
+    if (Owner->GetNetOwningPlayer() == CallerPlayer)
+    {
+        return true;
+    }
+
+    return this->IsWithinViewerDistance(CallerOwner);
+}
+
+void UInventoryComponent::ServerOpenInventory_Implementation(UInventoryComponent* InventoryToView)
+{
+    if (!InventoryToView)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : InventoryToView is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    if (!InventoryToView->CanBeViewedBy(this))
+    {
+        UE_LOG(LogInventoryComponent, Warning, TEXT("%hs : %s may not view %s"), __FUNCTION__, *GetName(), *InventoryToView->GetName());
+        return;
+    }
+
+    if (InventoryToView->GetStorageMode() == EInventoryStorageMode::Paged)
+    {
+        UE_LOG(LogInventoryComponent, Warning, TEXT("%hs : %s is paged, use ServerViewInventoryPages"), __FUNCTION__, *InventoryToView->GetName());
+        return;
+    }
+
+    switch (InventoryToView->GetReplicationPolicy())
+    {
+    case EInventoryReplicationPolicy::Everyone:
+        // Already replicated to everyone
+        return;
+    case EInventoryReplicationPolicy::OwnerOnly:
+    case EInventoryReplicationPolicy::Summary:
+        UE_LOG(LogInventoryComponent, Warning, TEXT("%hs : %s does not accept viewers"), __FUNCTION__, *InventoryToView->GetName());
+        return;
+    case EInventoryReplicationPolicy::OwnerAndViewers:
+        break;
+    }
+
+    InventoryToView->Viewers.AddUnique(this);
+    InventoryToView->SendAllSlotsToViewer(this);
+}
+
+void UInventoryComponent::ServerCloseInventory_Implementation(UInventoryComponent* InventoryToView)
+{
+    if (!InventoryToView)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : InventoryToView is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    InventoryToView->Viewers.Remove(this);
+    InventoryToView->PendingSnapshotViewers.Remove(this);
+}
+
+void UInventoryComponent::ClientReceiveViewedSlots_Implementation(UInventoryComponent* ViewedInventory,
+                                                                 int32 NumSlots,
+                                                                 const TArray<int32>& SlotIndices,
+                                                                 const TArray<FInventorySlot>& Slots,
+                                                                 int32 InSlotSequence)
+{
+    // Not relevant to this client (yet), or a listen server viewing its own copy
+    if (!ViewedInventory || ViewedInventory->IsInventoryAuthority())
+    {
+        return;
+    }
+
+    ViewedInventory->ApplyViewedSlots(NumSlots, SlotIndices, Slots, InSlotSequence);
+}
+
+void UInventoryComponent::ApplyViewedSlots(int32 NumSlots,
+                                           const TArray<int32>& SlotIndices,
+                                           const TArray<FInventorySlot>& Slots,
+                                           int32 InSlotSequence)
+{
+    this->SlotSequence = FMath::Max(this->SlotSequence, InSlotSequence);
+
+    if (this->IsPagedClient())
+    {
+        this->ApplyInventoryPages(NumSlots, {}, SlotIndices, Slots);
+        return;
+    }
+
+    if (this->InventorySlots.Num() != NumSlots)
+    {
+        this->InventorySlots.SetNum(NumSlots);
+    }
+
+    for (int32 i = 0; i < SlotIndices.Num() && i < Slots.Num(); i++)
+    {
+        if (this->InventorySlots.IsValidIndex(SlotIndices[i]))
+        {
+            this->InventorySlots[SlotIndices[i]] = Slots[i];
+        }
+    }
+
+    this->HandleAuthoritativeSlotsChanged();
+}
+
+bool UInventoryComponent::IsPagedClient() const
+{
+    return this->StorageMode == EInventoryStorageMode::Paged && !this->IsInventoryAuthority();
+}
+
+void UInventoryComponent::ServerViewInventoryPages_Implementation(UInventoryComponent* InventoryToView, const TArray<int32>& Pages)
+{
+    if (!InventoryToView)
+    {
+        UE_LOG(LogInventoryComponent, Error, TEXT("%hs : InventoryToView is nullptr"), __FUNCTION__);
+        return;
+    }
+
+    if (InventoryToView->GetStorageMode() != EInventoryStorageMode::Paged)
+    {
+        UE_LOG(LogInventoryComponent, Warning, TEXT("%hs : %s is not paged"), __FUNCTION__, *InventoryToView->GetName());
+        return;
+    }
+
+    // Dropping pages is always allowed, so a viewer that moved away can still stop viewing
+    if (Pages.Num() > 0 && !InventoryToView->CanBeViewedBy(this))
+    {
+        UE_LOG(LogInventoryComponent, Warning, TEXT("%hs : %s may not view %s"), __FUNCTION__, *GetName(), *InventoryToView->GetName());
+        return;
+    }
+
+    const int32 NumPages = FMath::DivideAndRoundUp(InventoryToView->InventorySlots.Num(), InventoryToView->SlotsPerPage);
+
+    TSet<int32> NewPages;
+
+    for (const int32 Page : Pages)
+    {
+        if (Page >= 0 && Page < NumPages)
+        {
+            NewPages.Add(Page);
+        }
+    }
+
+    const int32 ViewerIndex = InventoryToView->PageViewers.IndexOfByPredicate([this](const FInventoryPageViewer& PageViewer)
+    {
+        return PageViewer.Viewer == this;
+    });
+
+    const TSet<int32> OldPages = ViewerIndex != INDEX_NONE ? InventoryToView->PageViewers[ViewerIndex].Pages : TSet<int32>();
+
+    const TArray<int32> PagesToSend = NewPages.Difference(OldPages).Array();
+    const TArray<int32> PagesToDrop = OldPages.Difference(NewPages).Array();
+
+    if (NewPages.Num() == 0)
+    {
+        if (ViewerIndex != INDEX_NONE)
+        {
+            InventoryToView->PageViewers.RemoveAtSwap(ViewerIndex);
+        }
+    }
+    else if (ViewerIndex != INDEX_NONE)
+    {
+        InventoryToView->PageViewers[ViewerIndex].Pages = MoveTemp(NewPages);
+    }
+    else
+    {
+        InventoryToView->PageViewers.Add({this, MoveTemp(NewPages)});
+    }
+
+    if (PagesToSend.Num() > 0 || PagesToDrop.Num() > 0)
+    {
+        InventoryToView->SendPagesToViewer(this, PagesToSend, PagesToDrop);
+    }
+}
+
+void UInventoryComponent::SendPagesToViewer(UInventoryComponent* Viewer, const TArray<int32>& PagesToSend, const TArray<int32>& PagesToDrop)
+{
+    TArray<int32> SlotIndices;
+    TArray<FInventorySlot> Slots;
+
+    // Only occupied slots are sent, the client treats everything else in these pages as empty
+    for (const int32 Page : PagesToSend)
+    {
+        const int32 PageStart = Page * this->SlotsPerPage;
+        const int32 PageEnd   = FMath::Min(PageStart + this->SlotsPerPage, this->InventorySlots.Num());
+
+        for (int32 i = PageStart; i < PageEnd; i++)
+        {
+            if (!FInventorySlot::IsSlotEmpty(this->InventorySlots[i]))
+            {
+                SlotIndices.Add(i);
+                Slots.Add(this->InventorySlots[i]);
+            }
+        }
+    }
+
+    TArray<int32> Pages = PagesToSend;
+    Pages.Append(PagesToDrop);
+
+    Viewer->ClientReceiveInventoryPages(this, this->InventorySlots.Num(), Pages, SlotIndices, Slots);
+}
+
+void UInventoryComponent::ClientReceiveInventoryPages_Implementation(UInventoryComponent* ViewedInventory,
+                                                                    int32 NumSlots,
+                                                                    const TArray<int32>& Pages,
+                                                                    const TArray<int32>& SlotIndices,
+                                                                    const TArray<FInventorySlot>& Slots)
+{
+    // Not relevant to this client (yet), or a listen server viewing its own copy
+    if (!ViewedInventory || !ViewedInventory->IsPagedClient())
+    {
+        return;
+    }
+
+    ViewedInventory->ApplyInventoryPages(NumSlots, Pages, SlotIndices, Slots);
+}
+
+void UInventoryComponent::ApplyInventoryPages(int32 NumSlots,
+                                              const TArray<int32>& Pages,
+                                              const TArray<int32>& SlotIndices,
+                                              const TArray<FInventorySlot>& Slots)
+{
+    this->NumberOfSlots = NumSlots;
+
+    if (Pages.Num() > 0)
+    {
+        const TSet<int32> PagesToClear(Pages);
+
+        for (auto It = this->PagedSlots.CreateIterator(); It; ++It)
+        {
+            if (PagesToClear.Contains(It.Key() / this->SlotsPerPage))
+            {
+                It.RemoveCurrent();
+            }
+        }
+    }
+
+    for (int32 i = 0; i < SlotIndices.Num() && i < Slots.Num(); i++)
+    {
+        if (SlotIndices[i] < 0 || SlotIndices[i] >= NumSlots) continue;
+
+        if (FInventorySlot::IsSlotEmpty(Slots[i]))
+        {
+            this->PagedSlots.Remove(SlotIndices[i]);
+            continue;
+        }
+
+        FInventorySlot& PagedSlot = this->PagedSlots.Add(SlotIndices[i], Slots[i]);
+
+        // Only item ids are sent, resolve the item data assets and their stack sizes
+        PagedSlot.SetItemId(PagedSlot.ItemId);
+    }
+
+    this->OnItemChanged.Broadcast();
+}
+
+void UInventoryComponent::SettleProduction()
+{
+    if (!this->AnalyticProduction || this->bSettlingProduction)
+    {
+        return;
+    }
+
+    // Settling adds and removes items through the regular operations, which must not settle again
+    TGuardValue<bool> SettlingGuard(this->bSettlingProduction, true);
+
+    this->AnalyticProduction->SettleInventory(this);
+}
+
+void UInventoryComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+    // Clients see the analytically produced items at the net update rate, not only after the server read them
+    this->SettleProduction();
+
+    // Channels open while replicating, so a viewer whose snapshot was held back can resolve this inventory by the next net update
+    if (this->PendingSnapshotViewers.Num() > 0)
+    {
+        this->SendPendingSnapshots();
+    }
+
+    Super::PreReplication(ChangedPropertyTracker);
+}
+
+const TArray<FInventorySlot>& UInventoryComponent::GetSlotView() const
+{
+    return this->PendingPredictions.Num() > 0 ? this->PredictedSlots : this->InventorySlots;
+}
+
+bool UInventoryComponent::CanPredict() const
+{
+    // Paged clients do not hold the slots to predict on
+    return this->bEnablePrediction && this->StorageMode != EInventoryStorageMode::Paged && GetOwner() && GetOwner()->GetLocalRole() != ROLE_Authority;
+}
+
+int32 UInventoryComponent::CreatePredictionKey()
+{
+    static int32 LastPredictionKey = 0;
+
+    // 0 means 'not predicted'
+    LastPredictionKey = LastPredictionKey == MAX_int32 ? 1 : LastPredictionKey + 1;
+
+    return LastPredictionKey;
+}
+
+void UInventoryComponent::PredictAddItem(int32 PredictionKey, UItemDataAsset* ItemToAdd, int32 Amount)
+{
+    FInventoryPrediction Prediction;
+    Prediction.PredictionKey = PredictionKey;
+    Prediction.Op            = EInventoryPredictionOp::AddItem;
+    Prediction.ItemId        = UItemRegistrySubsystem::GetItemId(ItemToAdd);
+    Prediction.Amount        = Amount;
+
+    this->AddPrediction(Prediction);
+}
+
+void UInventoryComponent::PredictRemoveItem(int32 PredictionKey, UItemDataAsset* ItemToRemove, int32 Amount)
+{
+    FInventoryPrediction Prediction;
+    Prediction.PredictionKey = PredictionKey;
+    Prediction.Op            = EInventoryPredictionOp::RemoveItem;
+    Prediction.ItemId        = UItemRegistrySubsystem::GetItemId(ItemToRemove);
+    Prediction.Amount        = Amount;
+
+    this->AddPrediction(Prediction);
+}
+
+void UInventoryComponent::PredictSetSlot(int32 PredictionKey, int32 Index, const FInventorySlot& NewSlot)
+{
+    FInventoryPrediction Prediction;
+    Prediction.PredictionKey = PredictionKey;
+    Prediction.Op            = EInventoryPredictionOp::SetSlot;
+    Prediction.SlotIndex     = Index;
+    Prediction.Slot          = NewSlot;
+
+    this->AddPrediction(Prediction);
+}
+
+void UInventoryComponent::AddPrediction(const FInventoryPrediction& Prediction)
+{
+    this->DropStaleAcceptedPredictions();
+
+    if (this->PendingPredictions.Num() == 0)
+    {
+        this->PredictedSlots = this->InventorySlots;
+    }
+
+    const bool bNewKey = !this->PendingPredictions.ContainsByPredicate([&Prediction](const FInventoryPrediction& Pending)
+    {
+        return Pending.PredictionKey == Prediction.PredictionKey;
+    });
+
+    if (bNewKey)
+    {
+        this->PredictionStats.NumPredicted++;
+    }
+
+    this->PendingPredictions.Add(Prediction);
+
+    // The indices were of the same slots before the operation, only the slots it wrote change
+    TArray<TPair<int32, FInventorySlot>> OldSlots;
+
+    this->ApplyPrediction(this->PredictedSlots, Prediction, &OldSlots);
+
+    for (const TPair<int32, FInventorySlot>& OldSlot : OldSlots)
+    {
+        this->UpdateSlotIndices(OldSlot.Key, OldSlot.Value, this->PredictedSlots[OldSlot.Key]);
+    }
+
+    this->OnItemChanged.Broadcast();
+}
+
+void UInventoryComponent::ApplyPrediction(TArray<FInventorySlot>&               Slots,
+                                          const FInventoryPrediction&           Prediction,
+                                          TArray<TPair<int32, FInventorySlot>>* OutOldSlots) const
+{
+    auto RecordOldSlot = [&Slots, OutOldSlots](const FInventorySlot& Slot)
+    {
+        if (OutOldSlots)
+        {
+            OutOldSlots->Emplace(static_cast<int32>(&Slot - Slots.GetData()), Slot);
+        }
+    };
+
+    switch (Prediction.Op)
+    {
+    case EInventoryPredictionOp::AddItem:
+        {
+            const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(Prediction.ItemId);
+
+            int32 AmountLeft = Prediction.Amount;
+
+            // Same order as the server, partial stacks first, then empty slots
+            for (FInventorySlot& Slot : Slots)
+            {
+                if (AmountLeft <= 0) break;
+
+                if (Slot.ItemId != Prediction.ItemId || Slot.CurrentStackSize >= MaxStackSize) continue;
+
+                const int32 AmountToStack = FMath::Min(MaxStackSize - Slot.CurrentStackSize, AmountLeft);
+
+                RecordOldSlot(Slot);
+
+                Slot.CurrentStackSize += AmountToStack;
+                AmountLeft            -= AmountToStack;
+            }
+
+            for (FInventorySlot& Slot : Slots)
+            {
+                if (AmountLeft <= 0 || MaxStackSize <= 0) break;
+
+                if (!FInventorySlot::IsSlotEmpty(Slot)) continue;
+
+                RecordOldSlot(Slot);
+
+                Slot.ItemId           = Prediction.ItemId;
+                Slot.Item             = this->GetItemFromId(Prediction.ItemId);
+                Slot.CurrentStackSize = FMath::Min(MaxStackSize, AmountLeft);
+                Slot.MaxStackSize     = MaxStackSize;
+
+                AmountLeft -= Slot.CurrentStackSize;
+            }
+
+            break;
+        }
+    case EInventoryPredictionOp::RemoveItem:
+        {
+            int32 AmountLeft = Prediction.Amount;
+
+            for (FInventorySlot& Slot : Slots)
+            {
+                if (AmountLeft <= 0) break;
+
+                if (Slot.ItemId != Prediction.ItemId) continue;
+
+                const int32 AmountTaken = FMath::Min(Slot.CurrentStackSize, AmountLeft);
+
+                RecordOldSlot(Slot);
+
+                Slot.CurrentStackSize -= AmountTaken;
+                AmountLeft            -= AmountTaken;
+
+                if (Slot.CurrentStackSize <= 0)
+                {
+                    Slot.Clear();
+                }
+            }
+
+            break;
+        }
+    case EInventoryPredictionOp::SetSlot:
+        {
+            if (Slots.IsValidIndex(Prediction.SlotIndex))
+            {
+                RecordOldSlot(Slots[Prediction.SlotIndex]);
+
+                Slots[Prediction.SlotIndex] = Prediction.Slot;
+            }
+
+            break;
+        }
+    }
+}
+
+void UInventoryComponent::RebuildPredictedSlots()
+{
+    // The indices are of the previous predicted slots. Without any, InventorySlots may have been replaced under them
+    const TArray<FInventorySlot> PreviousSlots = MoveTemp(this->PredictedSlots);
+
+    this->PredictedSlots.Reset();
+
+    if (this->PendingPredictions.Num() > 0)
+    {
+        this->PredictedSlots = this->InventorySlots;
+
+        for (const FInventoryPrediction& Prediction : this->PendingPredictions)
+        {
+            this->ApplyPrediction(this->PredictedSlots, Prediction);
+        }
+    }
+
+    const TArray<FInventorySlot>& Slots = this->GetSlotView();
+
+    if (PreviousSlots.Num() == 0 || PreviousSlots.Num() != Slots.Num())
+    {
+        this->RebuildSlotStorage();
+        return;
+    }
+
+    for (int32 i = 0; i < Slots.Num(); i++)
+    {
+        if (PreviousSlots[i] != Slots[i])
+        {
+            this->UpdateSlotIndices(i, PreviousSlots[i], Slots[i]);
+        }
+    }
+}
+
+void UInventoryComponent::ResolvePrediction(int32 PredictionKey, bool bAccepted, int32 AppliedSequence, int32 ParticipantSequence)
+{
+    if (bAccepted)
+    {
+        const double Now = this->GetPredictionTime();
+
+        for (FInventoryPrediction& Prediction : this->PendingPredictions)
+        {
+            if (Prediction.PredictionKey != PredictionKey) continue;
+
+            Prediction.bAccepted       = true;
+            Prediction.AppliedSequence = AppliedSequence;
+            Prediction.AcceptedTime    = Now;
+        }
+
+        // The replicated slots may have arrived before the acceptance
+        if (this->ReconcilePredictions())
+        {
+            this->OnItemChanged.Broadcast();
+        }
+    }
+    else
+    {
+        const int32 NumRolledBack = this->PendingPredictions.RemoveAll([PredictionKey](const FInventoryPrediction& Prediction)
+        {
+            return Prediction.PredictionKey == PredictionKey;
+        });
+
+        if (NumRolledBack > 0)
+        {
+            UE_LOG(LogInventoryComponent, Verbose, TEXT("%hs : Server rejected prediction %d, rolled back %d operations"), __FUNCTION__, PredictionKey, NumRolledBack);
+
+            this->PredictionStats.NumRejected++;
+
+            this->RebuildPredictedSlots();
+
+            this->OnItemChanged.Broadcast();
+        }
+    }
+
+    TArray<TWeakObjectPtr<UInventoryComponent>> Participants;
+
+    if (this->PredictionParticipants.RemoveAndCopyValue(PredictionKey, Participants))
+    {
+        for (const TWeakObjectPtr<UInventoryComponent>& Participant : Participants)
+        {
+            if (Participant.IsValid())
+            {
+                Participant->ResolvePrediction(PredictionKey, bAccepted, ParticipantSequence);
+            }
+        }
+    }
+
+    this->DropStaleAcceptedPredictions();
+}
+
+void UInventoryComponent::ClientResolvePrediction_Implementation(int32 PredictionKey,
+                                                                 bool bAccepted,
+                                                                 int32 AppliedSequence,
+                                                                 int32 ParticipantSequence)
+{
+    this->ResolvePrediction(PredictionKey, bAccepted, AppliedSequence, ParticipantSequence);
+}
+
+void UInventoryComponent::AddPredictionParticipant(int32 PredictionKey, UInventoryComponent* Participant)
+{
+    if (!Participant || Participant == this)
+    {
+        return;
+    }
+
+    this->PredictionParticipants.FindOrAdd(PredictionKey).AddUnique(Participant);
+}
+
+void UInventoryComponent::DropStaleAcceptedPredictions()
+{
+    const double Now = this->GetPredictionTime();
+
+    const int32 NumDropped = this->PendingPredictions.RemoveAll([Now](const FInventoryPrediction& Prediction)
+    {
+        return Prediction.bAccepted && Now - Prediction.AcceptedTime > InventoryPrediction::AcceptedTimeout;
+    });
+
+    if (NumDropped > 0)
+    {
+        this->RebuildPredictedSlots();
+
+        this->OnItemChanged.Broadcast();
+    }
+}
+
+double UInventoryComponent::GetPredictionTime() const
+{
+    const UWorld* World = GetWorld();
+
+    return World ? World->GetTimeSeconds() : 0.0;
+}
+
+float UInventoryComponent::GetMispredictionRate() const
+{
+    if (this->PredictionStats.NumPredicted == 0)
+    {
+        return 0.0f;
+    }
+
+    const int32 NumMispredicted = this->PredictionStats.NumRejected + this->PredictionStats.NumCorrected;
+
+    return static_cast<float>(NumMispredicted) / this->PredictionStats.NumPredicted;
+}
+
+void UInventoryComponent::HandleAuthoritativeSlotsChanged()
+{
+    // Only item ids are replicated, resolve the item data assets and their stack sizes
+    for (FInventorySlot& InventorySlot : this->InventorySlots)
+    {
+        InventorySlot.SetItemId(InventorySlot.ItemId);
+    }
+
+    // Predictions the new slots do not contain yet are replayed on top of them
+    if (!this->ReconcilePredictions())
+    {
+        this->RebuildPredictedSlots();
+    }
+
+    this->OnItemChanged.Broadcast();
+}
+
+bool UInventoryComponent::ReconcilePredictions()
+{
+    if (this->PendingPredictions.Num() == 0)
+    {
+        return false;
+    }
+
+    const TArray<FInventorySlot> PreviousSlots = this->PredictedSlots;
+
+    // Only accepted operations the replicated sequence has caught up with are in the authoritative slots
+    const int32 NumApplied = this->PendingPredictions.RemoveAll([this](const FInventoryPrediction& Prediction)
+    {
+        return Prediction.bAccepted && Prediction.AppliedSequence <= this->SlotSequence;
+    });
+
+    if (NumApplied == 0)
+    {
+        return false;
+    }
+
+    this->RebuildPredictedSlots();
+
+    if (PreviousSlots != this->GetSlotView())
+    {
+        this->PredictionStats.NumCorrected++;
+    }
+
+    return true;
+}
+
+void UInventoryComponent::OnRep_InventorySlots()
+{
+    this->HandleAuthoritativeSlotsChanged();
+}
+
+void UInventoryComponent::OnRep_SlotSequence()
+{
+    // The slots may not have changed, e.g. the server's result matched the old slots
+    if (this->ReconcilePredictions())
+    {
+        this->OnItemChanged.Broadcast();
+    }
+}
+
+void UInventoryComponent::OnRep_Summary()
 {
     this->OnItemChanged.Broadcast();
 }
@@ -0,0 +1,184 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/InventorySlotStorage.h"
+
+#include "Inventory/ItemRegistrySubsystem.h"
+
+namespace InventorySlotStorage
+{
+    // Scans test a whole chunk without branching and only look for the exact index once a chunk matched
+    constexpr int32 ChunkSize = 64;
+}
+
+void FInventorySlotStorage::Init(int32 NumSlots)
+{
+    this->ItemIds.Init(UItemDataAsset::InvalidItemId, NumSlots);
+    this->StackSizes.Init(0, NumSlots);
+}
+
+void FInventorySlotStorage::Reset()
+{
+    this->ItemIds.Reset();
+    this->StackSizes.Reset();
+}
+
+void FInventorySlotStorage::SetSlot(int32 Index, const FInventorySlot& InSlot)
+{
+    this->SetSlot(Index, InSlot.ItemId, InSlot.CurrentStackSize);
+}
+
+void FInventorySlotStorage::SetSlot(int32 Index, uint16 ItemId, int32 StackSize)
+{
+    if (!this->ItemIds.IsValidIndex(Index))
+    {
+        return;
+    }
+
+    this->ItemIds[Index]    = ItemId;
+    this->StackSizes[Index] = ItemId != UItemDataAsset::InvalidItemId ? StackSize : 0;
+}
+
+void FInventorySlotStorage::CopyFrom(const TArray<FInventorySlot>& InSlots)
+{
+    this->Init(InSlots.Num());
+
+    for (int32 i = 0; i < InSlots.Num(); i++)
+    {
+        this->SetSlot(i, InSlots[i]);
+    }
+}
+
+int32 FInventorySlotStorage::FindFirstPartialStack(uint16 ItemId) const
+{
+    if (ItemId == UItemDataAsset::InvalidItemId)
+    {
+        return INDEX_NONE;
+    }
+
+    const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+    const int32 NumSlots     = this->ItemIds.Num();
+    const uint16* Ids        = this->ItemIds.GetData();
+    const int32* Stacks      = this->StackSizes.GetData();
+
+    for (int32 ChunkStart = 0; ChunkStart < NumSlots; ChunkStart += InventorySlotStorage::ChunkSize)
+    {
+        const int32 ChunkEnd = FMath::Min(ChunkStart + InventorySlotStorage::ChunkSize, NumSlots);
+
+        uint32 bChunkMatches = 0;
+
+        for (int32 i = ChunkStart; i < ChunkEnd; i++)
+        {
+            bChunkMatches |= static_cast<uint32>(Ids[i] == ItemId) & static_cast<uint32>(Stacks[i] < MaxStackSize);
+        }
+
+        if (!bChunkMatches)
+        {
+            continue;
+        }
+
+        for (int32 i = ChunkStart; i < ChunkEnd; i++)
+        {
+            if (Ids[i] == ItemId && Stacks[i] < MaxStackSize)
+            {
+                return i;
+            }
+        }
+    }
+
+    return INDEX_NONE;
+}
+
+int32 FInventorySlotStorage::FindFirstEmptySlot() const
+{
+    const int32 NumSlots = this->ItemIds.Num();
+    const uint16* Ids    = this->ItemIds.GetData();
+
+    for (int32 ChunkStart = 0; ChunkStart < NumSlots; ChunkStart += InventorySlotStorage::ChunkSize)
+    {
+        const int32 ChunkEnd = FMath::Min(ChunkStart + InventorySlotStorage::ChunkSize, NumSlots);
+
+        uint32 bChunkMatches = 0;
+
+        for (int32 i = ChunkStart; i < ChunkEnd; i++)
+        {
+            bChunkMatches |= static_cast<uint32>(Ids[i] == UItemDataAsset::InvalidItemId);
+        }
+
+        if (!bChunkMatches)
+        {
+            continue;
+        }
+
+        for (int32 i = ChunkStart; i < ChunkEnd; i++)
+        {
+            if (Ids[i] == UItemDataAsset::InvalidItemId)
+            {
+                return i;
+            }
+        }
+    }
+
+    return INDEX_NONE;
+}
+
+int32 FInventorySlotStorage::SumItemCount(uint16 ItemId) const
+{
+    if (ItemId == UItemDataAsset::InvalidItemId)
+    {
+        return 0;
+    }
+
+    const int32 NumSlots = this->ItemIds.Num();
+    const uint16* Ids    = this->ItemIds.GetData();
+    const int32* Stacks  = this->StackSizes.GetData();
+
+    int32 Total = 0;
+
+    for (int32 i = 0; i < NumSlots; i++)
+    {
+        Total += Ids[i] == ItemId ? Stacks[i] : 0;
+    }
+
+    return Total;
+}
+
+int32 FInventorySlotStorage::GetAvailableSpace(uint16 ItemId) const
+{
+    if (ItemId == UItemDataAsset::InvalidItemId)
+    {
+        return 0;
+    }
+
+    const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+    const int32 NumSlots     = this->ItemIds.Num();
+    const uint16* Ids        = this->ItemIds.GetData();
+    const int32* Stacks      = this->StackSizes.GetData();
+
+    int32 AvailableSpace = 0;
+
+    for (int32 i = 0; i < NumSlots; i++)
+    {
+        const bool bSameItem = Ids[i] == ItemId;
+        const bool bEmpty    = Ids[i] == UItemDataAsset::InvalidItemId;
+
+        AvailableSpace += bSameItem ? FMath::Max(MaxStackSize - Stacks[i], 0) : 0;
+        AvailableSpace += bEmpty ? MaxStackSize : 0;
+    }
+
+    return AvailableSpace;
+}
+
+int32 FInventorySlotStorage::GetNumEmptySlots() const
+{
+    const int32 NumSlots = this->ItemIds.Num();
+    const uint16* Ids    = this->ItemIds.GetData();
+
+    int32 NumEmptySlots = 0;
+
+    for (int32 i = 0; i < NumSlots; i++)
+    {
+        NumEmptySlots += Ids[i] == UItemDataAsset::InvalidItemId ? 1 : 0;
+    }
+
+    return NumEmptySlots;
+}
@@ -2,6 +2,10 @@
 
 #include "Inventory/ItemConsumingComponent.h"
 
+#include "Inventory/ProductionSubsystem.h"
+
+#include "Engine/World.h"
+
 UItemConsumingComponent::UItemConsumingComponent()
 {
     this->TimeToConsume      = 1.0f;
@@ -10,48 +14,67 @@ UItemConsumingComponent::UItemConsumingComponent()
     this->InventoryComponent = nullptr;
 }
 
-void UItemConsumingComponent::StartConsuming()
+void UItemConsumingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    const UWorld* World = GetWorld();
+    this->StopConsuming();
 
-    if (!World)
+    Super::EndPlay(EndPlayReason);
+}
+
+void UItemConsumingComponent::SetInventoryComponent(UInventoryComponent* InInventoryComponent)
+{
+    this->InventoryComponent = InInventoryComponent;
+
+    if (UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld()))
     {
-        UE_LOG(LogItemConsumingComponent, Error, TEXT("StartConsuming: World is nullptr"))
-        return;
+        ProductionSubsystem->UpdateMachine(this, this->InventoryComponent, this->ItemToConsume);
     }
-
-    World->GetTimerManager().SetTimer(this->ConsumingTimerHandle,
-                                      this,
-                                      &UItemConsumingComponent::OnConsumingTimerEnded,
-                                      this->TimeToConsume,
-                                      this->bLoop);
 }
 
-void UItemConsumingComponent::StopConsuming()
+void UItemConsumingComponent::SetItemToConsume(UItemDataAsset* InItemToConsume)
 {
-    const UWorld* World = GetWorld();
+    this->ItemToConsume = InItemToConsume;
 
-    if (!World)
+    if (UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld()))
     {
-        UE_LOG(LogItemConsumingComponent, Error, TEXT("StartConsuming: World is nullptr"))
-        return;
+        ProductionSubsystem->UpdateMachine(this, this->InventoryComponent, this->ItemToConsume);
     }
+}
 
-    World->GetTimerManager().ClearTimer(this->ConsumingTimerHandle);
+void UItemConsumingComponent::SetTimeToConsume(float InTimeToConsume)
+{
+    this->TimeToConsume = FMath::Max(InTimeToConsume, 0.f);
+}
+
+void UItemConsumingComponent::SetProductionMode(EProductionMode InProductionMode)
+{
+    this->ProductionMode = InProductionMode;
 }
 
-void UItemConsumingComponent::OnConsumingTimerEnded()
+void UItemConsumingComponent::StartConsuming()
 {
-    if (!this->InventoryComponent)
+    UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld());
+
+    if (!ProductionSubsystem)
     {
-        UE_LOG(LogItemConsumingComponent, Error, TEXT("OnConsumingTimerEnded: InventoryComponent is nullptr"))
+        UE_LOG(LogItemConsumingComponent, Error, TEXT("%hs : No UProductionSubsystem, World is nullptr"), __FUNCTION__);
         return;
     }
 
-    const int32 AmountToConsume = 1;
+    // The subsystem removes the item and broadcasts OnItemConsumed for every fire
+    ProductionSubsystem->RegisterMachine(this,
+                                         EProductionKind::Consume,
+                                         this->InventoryComponent,
+                                         this->ItemToConsume,
+                                         this->TimeToConsume,
+                                         this->bLoop,
+                                         this->ProductionMode);
+}
 
-    if (this->InventoryComponent->TryRemoveItem(this->ItemToConsume, AmountToConsume))
+void UItemConsumingComponent::StopConsuming()
+{
+    if (UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld()))
     {
-        this->OnItemConsumed.Broadcast(this->ItemToConsume, AmountToConsume);
+        ProductionSubsystem->UnregisterMachine(this);
     }
 }
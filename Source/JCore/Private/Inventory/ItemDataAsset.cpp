@@ -0,0 +1,18 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/ItemDataAsset.h"
+
+#include "Inventory/ItemRegistrySubsystem.h"
+
+#if WITH_EDITOR
+void UItemDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // Keep the registry's cached fields in sync with the asset
+    if (UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get())
+    {
+        ItemRegistry->RegisterItem(this);
+    }
+}
+#endif
@@ -2,6 +2,10 @@
 
 #include "Inventory/ItemGeneratingComponent.h"
 
+#include "Inventory/ProductionSubsystem.h"
+
+#include "Engine/World.h"
+
 UItemGeneratingComponent::UItemGeneratingComponent()
 {
     this->TimeToGenerate     = 1.0f;
@@ -10,57 +14,129 @@ UItemGeneratingComponent::UItemGeneratingComponent()
     this->InventoryComponent = nullptr;
 }
 
+void UItemGeneratingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    this->StopGenerating();
+
+    Super::EndPlay(EndPlayReason);
+}
+
 void UItemGeneratingComponent::SetInventoryComponent(UInventoryComponent* InInventoryComponent)
 {
     this->InventoryComponent = InInventoryComponent;
+
+    if (UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld()))
+    {
+        ProductionSubsystem->UpdateMachine(this, this->InventoryComponent, this->ItemToGenerate);
+    }
 }
 
 void UItemGeneratingComponent::SetItemToGenerate(UItemDataAsset* InItemToGenerate)
 {
     this->ItemToGenerate = InItemToGenerate;
+
+    if (UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld()))
+    {
+        ProductionSubsystem->UpdateMachine(this, this->InventoryComponent, this->ItemToGenerate);
+    }
+}
+
+void UItemGeneratingComponent::SetTimeToGenerate(float InTimeToGenerate)
+{
+    this->TimeToGenerate = FMath::Max(InTimeToGenerate, 0.f);
+}
+
+void UItemGeneratingComponent::SetProductionMode(EProductionMode InProductionMode)
+{
+    this->ProductionMode = InProductionMode;
 }
 
 void UItemGeneratingComponent::StartGenerating()
 {
-    const UWorld* World = GetWorld();
+    this->bGenerating        = true;
+    this->PausedGenerateTime = this->TimeToGenerate;
+
+    UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld());
+
+    if (!ProductionSubsystem)
+    {
+        UE_LOG(LogItemGeneratingComponent, Error, TEXT("%hs : No UProductionSubsystem, World is nullptr"), __FUNCTION__);
+        return;
+    }
 
-    if (!World)
+    if (this->ThroughputScale <= 0.f)
     {
-        UE_LOG(LogItemGeneratingComponent, Error, TEXT("StartGenerating: World is nullptr"))
+        ProductionSubsystem->UnregisterMachine(this);
         return;
     }
 
-    World->GetTimerManager().SetTimer(this->GeneratingTimerHandle,
-                                      this,
-                                      &UItemGeneratingComponent::OnGeneratingTimerEnded,
-                                      this->TimeToGenerate,
-                                      this->bLoop);
+    ProductionSubsystem->RegisterMachine(this,
+                                         EProductionKind::Generate,
+                                         this->InventoryComponent,
+                                         this->ItemToGenerate,
+                                         this->TimeToGenerate / this->ThroughputScale,
+                                         this->bLoop,
+                                         this->ProductionMode);
 }
 
 void UItemGeneratingComponent::StopGenerating()
 {
-    const UWorld* World = GetWorld();
+    this->bGenerating = false;
 
-    if (!World)
+    if (UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld()))
     {
-        UE_LOG(LogItemGeneratingComponent, Error, TEXT("StartGenerating: World is nullptr"))
-        return;
+        ProductionSubsystem->UnregisterMachine(this);
     }
-
-    World->GetTimerManager().ClearTimer(this->GeneratingTimerHandle);
 }
 
-void UItemGeneratingComponent::OnGeneratingTimerEnded()
+void UItemGeneratingComponent::SetThroughputScale(float InThroughputScale)
 {
-    if (!this->InventoryComponent)
+    InThroughputScale = FMath::Max(InThroughputScale, 0.f);
+
+    if (InThroughputScale == this->ThroughputScale)
+    {
+        return;
+    }
+
+    UProductionSubsystem* ProductionSubsystem = UWorld::GetSubsystem<UProductionSubsystem>(GetWorld());
+
+    const bool bWasPaused = this->ThroughputScale <= 0.f;
+
+    double RemainingGenerateTime = this->PausedGenerateTime;
+
+    if (!bWasPaused && this->bGenerating && ProductionSubsystem)
+    {
+        const double TimeToNextFire = ProductionSubsystem->GetTimeToNextFire(this);
+
+        // Not registered any more, e.g. it does not loop and generated its item already
+        if (TimeToNextFire < 0.0)
+        {
+            this->ThroughputScale = InThroughputScale;
+            return;
+        }
+
+        RemainingGenerateTime = TimeToNextFire * this->ThroughputScale;
+    }
+
+    this->ThroughputScale = InThroughputScale;
+
+    if (!this->bGenerating || !ProductionSubsystem)
     {
-        UE_LOG(LogItemGeneratingComponent, Error, TEXT("OnGeneratingTimerEnded: InventoryComponent is nullptr"))
         return;
     }
 
-    if (!this->InventoryComponent->HasAnyEmptySlots() ||
-        this->InventoryComponent->ContainsPartialStack(this->ItemToGenerate) >= 0)
+    if (this->ThroughputScale <= 0.f)
     {
-        this->InventoryComponent->TryAddItem(this->ItemToGenerate, 1);
+        this->PausedGenerateTime = RemainingGenerateTime;
+        ProductionSubsystem->UnregisterMachine(this);
+        return;
     }
+
+    if (bWasPaused)
+    {
+        this->StartGenerating();
+    }
+
+    // The item in progress keeps its progress, only the rest of it runs at the new scale
+    ProductionSubsystem->RescheduleMachine(this, this->TimeToGenerate / this->ThroughputScale, RemainingGenerateTime / this->ThroughputScale);
 }
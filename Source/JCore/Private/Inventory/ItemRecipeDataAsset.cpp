@@ -1,3 +1,29 @@
 // Copyright Joshua Gangl. All Rights Reserved.
 
 #include "Inventory/ItemRecipeDataAsset.h"
+
+#include "Inventory/RecipeRegistrySubsystem.h"
+
+void UItemRecipeDataAsset::SetItems(const TMap<UItemDataAsset*, int32>& InInItems, const TMap<UItemDataAsset*, int32>& InOutItems)
+{
+    this->InItems  = InInItems;
+    this->OutItems = InOutItems;
+}
+
+void UItemRecipeDataAsset::SetCraftTime(float InCraftTime)
+{
+    this->CraftTime = FMath::Max(InCraftTime, 0.f);
+}
+
+#if WITH_EDITOR
+void UItemRecipeDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // Keep the registry's indexes in sync with the asset
+    if (URecipeRegistrySubsystem* RecipeRegistry = URecipeRegistrySubsystem::Get())
+    {
+        RecipeRegistry->RegisterItemRecipe(this);
+    }
+}
+#endif
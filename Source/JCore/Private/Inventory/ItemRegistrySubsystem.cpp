@@ -0,0 +1,230 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/ItemRegistrySubsystem.h"
+
+#include "AssetRegistry/IAssetRegistry.h"
+
+UItemRegistrySubsystem* UItemRegistrySubsystem::Instance = nullptr;
+
+UItemRegistrySubsystem::UItemRegistrySubsystem()
+{
+    this->bScannedItemAssets = false;
+}
+
+void UItemRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    Instance = this;
+
+    // Id 0 is reserved for 'no item'
+    this->bScannedItemAssets = false;
+
+    this->ItemPaths.Reset();
+    this->ItemIdsByPath.Reset();
+    this->Items.Reset();
+    this->MaxStackSizes.Reset();
+    this->StackableFlags.Reset();
+    this->ItemTags.Reset();
+
+    this->ItemPaths.Add(FSoftObjectPath());
+    this->Items.Add(nullptr);
+    this->MaxStackSizes.Add(0);
+    this->StackableFlags.Add(false);
+    this->ItemTags.AddDefaulted();
+
+    IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+
+    // In the editor the asset registry is still gathering on startup
+    if (AssetRegistry.IsLoadingAssets())
+    {
+        AssetRegistry.OnFilesLoaded().AddUObject(this, &UItemRegistrySubsystem::ScanItemAssets);
+    }
+    else
+    {
+        this->ScanItemAssets();
+    }
+}
+
+void UItemRegistrySubsystem::Deinitialize()
+{
+    if (IAssetRegistry* AssetRegistry = IAssetRegistry::Get())
+    {
+        AssetRegistry->OnFilesLoaded().RemoveAll(this);
+    }
+
+    if (Instance == this)
+    {
+        Instance = nullptr;
+    }
+
+    Super::Deinitialize();
+}
+
+UItemDataAsset* UItemRegistrySubsystem::GetItem(uint16 ItemId)
+{
+    if (ItemId == UItemDataAsset::InvalidItemId || !this->Items.IsValidIndex(ItemId))
+    {
+        return nullptr;
+    }
+
+    if (!this->Items[ItemId])
+    {
+        UItemDataAsset* LoadedItem = Cast<UItemDataAsset>(this->ItemPaths[ItemId].TryLoad());
+
+        if (!LoadedItem)
+        {
+            UE_LOG(LogItemRegistry, Error, TEXT("%hs : Failed to load item '%s'"), __FUNCTION__, *this->ItemPaths[ItemId].ToString());
+            return nullptr;
+        }
+
+        this->CacheItem(ItemId, LoadedItem);
+    }
+
+    return this->Items[ItemId];
+}
+
+uint16 UItemRegistrySubsystem::RegisterItem(UItemDataAsset* Item)
+{
+    if (!Item)
+    {
+        return UItemDataAsset::InvalidItemId;
+    }
+
+    // Content items must get their ids in path order before anything is registered lazily
+    if (!this->bScannedItemAssets)
+    {
+        this->ScanItemAssets();
+    }
+
+    const FSoftObjectPath ItemPath(Item);
+
+    uint16 ItemId = UItemDataAsset::InvalidItemId;
+
+    if (const uint16* FoundItemId = this->ItemIdsByPath.Find(ItemPath))
+    {
+        ItemId = *FoundItemId;
+    }
+    else
+    {
+        ItemId = this->AddItemPath(ItemPath);
+    }
+
+    if (ItemId != UItemDataAsset::InvalidItemId)
+    {
+        this->CacheItem(ItemId, Item);
+    }
+
+    return ItemId;
+}
+
+uint16 UItemRegistrySubsystem::AddItemPath(const FSoftObjectPath& ItemPath)
+{
+    if (this->ItemPaths.Num() > MAX_uint16)
+    {
+        UE_LOG(LogItemRegistry, Error, TEXT("%hs : Out of item ids, '%s' was not registered"), __FUNCTION__, *ItemPath.ToString());
+        return UItemDataAsset::InvalidItemId;
+    }
+
+    const uint16 ItemId = static_cast<uint16>(this->ItemPaths.Add(ItemPath));
+
+    this->ItemIdsByPath.Add(ItemPath, ItemId);
+    this->Items.Add(nullptr);
+    this->MaxStackSizes.Add(0);
+    this->StackableFlags.Add(false);
+    this->ItemTags.AddDefaulted();
+
+    return ItemId;
+}
+
+void UItemRegistrySubsystem::CacheItem(uint16 ItemId, UItemDataAsset* Item)
+{
+    Item->ItemId = ItemId;
+
+    this->Items[ItemId]          = Item;
+    this->MaxStackSizes[ItemId]  = Item->GetMaxStackSize();
+    this->StackableFlags[ItemId] = Item->IsStackable();
+    this->ItemTags[ItemId]       = Item->GetTags().GetGameplayTagParents();
+}
+
+void UItemRegistrySubsystem::CacheItemAssetData(uint16 ItemId, const FAssetData& Asset)
+{
+    int32 MaxStackSize = 0;
+    Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(UItemDataAsset, MaxStackSize), MaxStackSize);
+
+    bool bStackable = false;
+    Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(UItemDataAsset, bStackable), bStackable);
+
+    FString TagsString;
+
+    if (Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(UItemDataAsset, Tags), TagsString))
+    {
+        this->ItemTags[ItemId] = FGameplayTagContainer::FromExportString(TagsString).GetGameplayTagParents();
+    }
+
+    this->MaxStackSizes[ItemId]  = MaxStackSize;
+    this->StackableFlags[ItemId] = bStackable;
+}
+
+void UItemRegistrySubsystem::ScanItemAssets()
+{
+    if (this->bScannedItemAssets)
+    {
+        return;
+    }
+
+    this->bScannedItemAssets = true;
+
+    IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+
+    AssetRegistry.OnFilesLoaded().RemoveAll(this);
+
+    // Registered before OnFilesLoaded, a partial scan would hand out ids in a different order than other processes
+    if (AssetRegistry.IsLoadingAssets())
+    {
+        AssetRegistry.WaitForCompletion();
+    }
+
+    const FName PackageName   = TEXT("/Script/JCore");
+    const FName ItemAssetName = TEXT("ItemDataAsset");
+
+    const FTopLevelAssetPath TopLevelAssetPath(PackageName, ItemAssetName);
+
+    TArray<FAssetData> AssetData;
+
+    AssetRegistry.GetAssetsByClass(TopLevelAssetPath, AssetData, true);
+
+    // Sort by path so every process hands out the same ids for the same content
+    AssetData.Sort([](const FAssetData& A, const FAssetData& B)
+    {
+        if (A.PackageName != B.PackageName)
+        {
+            return A.PackageName.LexicalLess(B.PackageName);
+        }
+
+        return A.AssetName.LexicalLess(B.AssetName);
+    });
+
+    for (const FAssetData& Asset : AssetData)
+    {
+        const FSoftObjectPath ItemPath = Asset.GetSoftObjectPath();
+
+        const uint16 ItemId = this->AddItemPath(ItemPath);
+
+        if (ItemId == UItemDataAsset::InvalidItemId) continue;
+
+        // Fill the lookup tables right away, from the item if it is already loaded and from its tags otherwise
+        if (UItemDataAsset* LoadedItem = Cast<UItemDataAsset>(ItemPath.ResolveObject()))
+        {
+            this->CacheItem(ItemId, LoadedItem);
+        }
+        else
+        {
+            this->CacheItemAssetData(ItemId, Asset);
+        }
+    }
+
+    UE_LOG(LogItemRegistry, Log, TEXT("%hs : Registered %d items"), __FUNCTION__, this->ItemPaths.Num() - 1);
+
+    this->OnItemsScanned.Broadcast();
+}
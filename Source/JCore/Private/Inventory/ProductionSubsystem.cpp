@@ -0,0 +1,1726 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/ProductionSubsystem.h"
+
+#include "Graph/GraphNodeComponent.h"
+#include "Graph/GraphSubsystem.h"
+#include "Inventory/CraftingComponent.h"
+#include "Inventory/CraftingSchedulerSubsystem.h"
+#include "Inventory/FactorySimulation.h"
+#include "Inventory/InventoryComponent.h"
+#include "Inventory/ItemConsumingComponent.h"
+#include "Inventory/ItemRegistrySubsystem.h"
+
+#include "Algo/StableSort.h"
+#include "Async/Async.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+DECLARE_STATS_GROUP(TEXT("JCore Production"), STATGROUP_JCoreProduction, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Advance Machines"), STAT_ProductionAdvanceMachines, STATGROUP_JCoreProduction);
+DECLARE_CYCLE_STAT(TEXT("Apply Deltas"), STAT_ProductionApplyDeltas, STATGROUP_JCoreProduction);
+DECLARE_CYCLE_STAT(TEXT("Fast-Forward"), STAT_ProductionFastForward, STATGROUP_JCoreProduction);
+DECLARE_CYCLE_STAT(TEXT("Simulation"), STAT_ProductionSimulation, STATGROUP_JCoreProduction);
+DECLARE_CYCLE_STAT(TEXT("Publish Simulation"), STAT_ProductionPublishSimulation, STATGROUP_JCoreProduction);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Machine Fires"), STAT_ProductionMachineFires, STATGROUP_JCoreProduction);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Inventory Deltas"), STAT_ProductionInventoryDeltas, STATGROUP_JCoreProduction);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Analytic Settles"), STAT_ProductionAnalyticSettles, STATGROUP_JCoreProduction);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Machines"), STAT_ProductionMachines, STATGROUP_JCoreProduction);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Analytic Machines"), STAT_ProductionAnalyticMachines, STATGROUP_JCoreProduction);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Simulated Machines"), STAT_ProductionSimulatedMachines, STATGROUP_JCoreProduction);
+
+int64 FAnalyticMachine::GetNumFires(double Time) const
+{
+    const int64 NumFires = UProductionSubsystem::GetNumFiresAt(this->StartTime, this->Period, Time);
+
+    return this->bLoop ? NumFires : FMath::Min<int64>(NumFires, 1);
+}
+
+void UProductionSubsystem::Deinitialize()
+{
+    // The worker may still be running on the simulation
+    if (this->SimulationTask.IsValid())
+    {
+        this->SimulationTask.Wait();
+        this->SimulationTask = TFuture<void>();
+    }
+
+    this->SimulatedMachines.Reset();
+    this->SimulatedMachineIndices.Reset();
+    for (const TPair<const UInventoryComponent*, FSimulatedInventory>& SimulatedInventory : this->SimulatedInventories)
+    {
+        if (UInventoryComponent* Inventory = SimulatedInventory.Value.Inventory.Get())
+        {
+            Inventory->OnSlotChanged.RemoveAll(this);
+        }
+    }
+
+    this->SimulatedInventories.Reset();
+    this->SimulationInventories.Reset();
+    this->SimulationMachines.Reset();
+
+    for (TPair<const UInventoryComponent*, FAnalyticInventory>& AnalyticInventory : this->AnalyticInventories)
+    {
+        if (UInventoryComponent* Inventory = AnalyticInventory.Value.Inventory.Get())
+        {
+            Inventory->SetAnalyticProduction(nullptr);
+        }
+    }
+
+    this->AnalyticInventories.Reset();
+    this->AnalyticMachineInventories.Reset();
+    this->IdleAnalyticMachines.Reset();
+    this->WakeUps.Reset();
+    this->SettledInventories.Reset();
+
+    Super::Deinitialize();
+}
+
+void UProductionSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    SET_DWORD_STAT(STAT_ProductionMachines, this->MachineBuckets.Num());
+    SET_DWORD_STAT(STAT_ProductionAnalyticMachines, this->AnalyticMachineInventories.Num());
+    SET_DWORD_STAT(STAT_ProductionSimulatedMachines, this->SimulatedMachines.Num());
+
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    // The inventories settled last frame may have changed after settling, so their next fill is only known now
+    if (this->SettledInventories.Num() > 0)
+    {
+        const TSet<const UInventoryComponent*> InventoriesToSchedule = MoveTemp(this->SettledInventories);
+
+        this->SettledInventories.Reset();
+
+        for (const UInventoryComponent* Inventory : InventoriesToSchedule)
+        {
+            FAnalyticInventory* AnalyticInventory = this->AnalyticInventories.Find(Inventory);
+
+            if (!AnalyticInventory)
+            {
+                continue;
+            }
+
+            UInventoryComponent* AnalyticInventoryComponent = AnalyticInventory->Inventory.Get();
+
+            // Inventories are only dropped here, outside of any settle that could still be using them
+            if (!AnalyticInventoryComponent || AnalyticInventory->Machines.Num() == 0)
+            {
+                if (AnalyticInventoryComponent)
+                {
+                    AnalyticInventoryComponent->SetAnalyticProduction(nullptr);
+                }
+
+                this->AnalyticInventories.Remove(Inventory);
+                continue;
+            }
+
+            this->ScheduleWakeUp(AnalyticInventoryComponent, *AnalyticInventory);
+        }
+    }
+
+    while (this->WakeUps.Num() > 0 && this->WakeUps.HeapTop().Time <= Now)
+    {
+        FProductionWakeUp WakeUp;
+        this->WakeUps.HeapPop(WakeUp);
+
+        FAnalyticInventory* AnalyticInventory = this->AnalyticInventories.Find(WakeUp.Inventory);
+
+        if (!AnalyticInventory)
+        {
+            continue;
+        }
+
+        if (AnalyticInventory->WakeUpTime == WakeUp.Time)
+        {
+            AnalyticInventory->WakeUpTime = MAX_dbl;
+        }
+
+        if (UInventoryComponent* Inventory = AnalyticInventory->Inventory.Get())
+        {
+            Inventory->SettleProduction();
+        }
+    }
+
+    // Mirrors outlive their machines while they have items left to publish
+    const bool bHasSimulation = this->SimulatedMachines.Num() > 0 || this->SimulatedInventories.Num() > 0;
+
+    // A run still going is picked up in a later tick, the simulation runs at its own rate
+    if (this->SimulationTask.IsValid() ? this->SimulationTask.IsReady() : bHasSimulation)
+    {
+        this->PublishSimulation();
+
+        const int64 TargetStep = this->GetSimulationStepAt(Now);
+
+        if (TargetStep > this->SimulationStep && bHasSimulation)
+        {
+            this->LaunchSimulation(TargetStep);
+        }
+    }
+
+    if (this->MachineBuckets.Num() == 0)
+    {
+        return;
+    }
+
+    {
+        SCOPE_CYCLE_COUNTER(STAT_ProductionAdvanceMachines);
+
+        for (FProductionBucket& Bucket : this->Buckets)
+        {
+            this->AdvanceBucket(Bucket, Now);
+        }
+
+        // Machines that do not loop leave the pass once they fired
+        this->PruneEmptyBuckets();
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_ProductionApplyDeltas);
+
+    this->ApplyDeltas();
+}
+
+TStatId UProductionSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UProductionSubsystem, STATGROUP_Tickables);
+}
+
+bool UProductionSubsystem::RegisterMachine(UActorComponent*     Machine,
+                                           EProductionKind      Kind,
+                                           UInventoryComponent* Inventory,
+                                           UItemDataAsset*      Item,
+                                           double               Period,
+                                           bool                 bLoop,
+                                           EProductionMode      Mode)
+{
+    if (!Machine)
+    {
+        UE_LOG(LogProductionSubsystem, Error, TEXT("%hs : Machine is nullptr"), __FUNCTION__);
+        return false;
+    }
+
+    if (Period <= 0.0)
+    {
+        UE_LOG(LogProductionSubsystem, Error, TEXT("%hs : %s has a period of %f"), __FUNCTION__, *Machine->GetName(), Period);
+        return false;
+    }
+
+    this->UnregisterMachine(Machine);
+
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    if (Mode == EProductionMode::Analytic)
+    {
+        FAnalyticMachine AnalyticMachine;
+        AnalyticMachine.Machine   = Machine;
+        AnalyticMachine.Item      = Item;
+        AnalyticMachine.Kind      = Kind;
+        AnalyticMachine.StartTime = Now;
+        AnalyticMachine.Period    = Period;
+        AnalyticMachine.bLoop     = bLoop;
+        AnalyticMachine.Order     = this->NextMachineOrder++;
+
+        if (!Inventory || !Item)
+        {
+            this->IdleAnalyticMachines.Add(Machine, AnalyticMachine);
+            return true;
+        }
+
+        return this->RegisterAnalyticMachine(Machine, AnalyticMachine, Inventory);
+    }
+
+    if (Mode == EProductionMode::Simulated)
+    {
+        FSimulatedMachine SimulatedMachine;
+        SimulatedMachine.Machine   = Machine;
+        SimulatedMachine.Inventory = Inventory;
+        SimulatedMachine.Item      = Item;
+        SimulatedMachine.Kind      = Kind;
+        SimulatedMachine.bLoop     = bLoop;
+
+        return this->RegisterSimulatedMachine(SimulatedMachine, Period);
+    }
+
+    const int32 BucketIndex = this->FindOrAddBucket(Period);
+
+    FProductionBucket& Bucket = this->Buckets[BucketIndex];
+
+    FProductionMachine NewMachine;
+    NewMachine.StartTime    = Now;
+    NewMachine.NextFireTime = UProductionSubsystem::GetFireTime(Now, Period, 1);
+    NewMachine.Machine      = Machine;
+    NewMachine.Inventory    = Inventory;
+    NewMachine.Item         = Item;
+    NewMachine.Kind         = Kind;
+    NewMachine.bLoop        = bLoop;
+    NewMachine.Order        = this->NextMachineOrder++;
+
+    // Every machine of the bucket fires within one period from now, so the new one goes last, right before the cursor
+    Bucket.Machines.Insert(NewMachine, Bucket.Cursor);
+    Bucket.Cursor = (Bucket.Cursor + 1) % Bucket.Machines.Num();
+
+    this->MachineBuckets.Add(Machine, BucketIndex);
+
+    return true;
+}
+
+void UProductionSubsystem::UpdateMachine(UActorComponent* Machine, UInventoryComponent* Inventory, UItemDataAsset* Item)
+{
+    if (FProductionMachine* ProductionMachine = this->FindMachine(Machine))
+    {
+        ProductionMachine->Inventory = Inventory;
+        ProductionMachine->Item      = Item;
+        return;
+    }
+
+    if (const int32* SimulatedMachineIndex = this->SimulatedMachineIndices.Find(Machine))
+    {
+        FSimulatedMachine& SimulatedMachine = this->SimulatedMachines[*SimulatedMachineIndex];
+
+        const bool bWasIdle = !SimulatedMachine.Inventory.IsValid() || !SimulatedMachine.Item;
+
+        SimulatedMachine.Inventory = Inventory;
+        SimulatedMachine.Item      = Item;
+
+        // The runs skipped the idle machine, so its next fire may be behind them. Move it past them on its phase, the missed fires did nothing
+        if (bWasIdle && SimulatedMachine.NextFireStep <= this->SimulationStep)
+        {
+            SimulatedMachine.NextFireStep += ((this->SimulationStep - SimulatedMachine.NextFireStep) / SimulatedMachine.PeriodSteps + 1) * SimulatedMachine.PeriodSteps;
+        }
+
+        return;
+    }
+
+    if (FAnalyticMachine* IdleAnalyticMachine = this->IdleAnalyticMachines.Find(Machine))
+    {
+        IdleAnalyticMachine->Item = Item;
+
+        if (!Inventory || !Item)
+        {
+            return;
+        }
+
+        // The fires while it was idle did nothing, the machine starts counting from its next one
+        FAnalyticMachine AnalyticMachine = *IdleAnalyticMachine;
+        AnalyticMachine.NumSettledFires  = AnalyticMachine.GetNumFires(this->GetWorld()->GetTimeSeconds());
+
+        this->IdleAnalyticMachines.Remove(Machine);
+        this->RegisterAnalyticMachine(Machine, AnalyticMachine, Inventory);
+        return;
+    }
+
+    const UInventoryComponent* const* InventoryKey = this->AnalyticMachineInventories.Find(Machine);
+
+    if (!InventoryKey)
+    {
+        return;
+    }
+
+    // Fires up to now belong to the old inventory and item, the machine keeps its start time and count
+    if (UInventoryComponent* OldInventory = this->AnalyticInventories.FindChecked(*InventoryKey).Inventory.Get())
+    {
+        OldInventory->SettleProduction();
+    }
+
+    // Settling may have finished a machine that does not loop
+    InventoryKey = this->AnalyticMachineInventories.Find(Machine);
+
+    if (!InventoryKey)
+    {
+        return;
+    }
+
+    const FAnalyticInventory& OldAnalyticInventory = this->AnalyticInventories.FindChecked(*InventoryKey);
+
+    const FAnalyticMachine* OldAnalyticMachine = OldAnalyticInventory.Machines.FindByPredicate([Machine](const FAnalyticMachine& AnalyticMachine)
+    {
+        return AnalyticMachine.Machine.Get() == Machine;
+    });
+
+    if (!OldAnalyticMachine)
+    {
+        return;
+    }
+
+    FAnalyticMachine AnalyticMachine = *OldAnalyticMachine;
+    AnalyticMachine.Item = Item;
+
+    this->UnregisterAnalyticMachine(Machine);
+
+    // Without an inventory or item it waits with its phase until it gets both
+    if (!Inventory || !Item)
+    {
+        this->IdleAnalyticMachines.Add(Machine, AnalyticMachine);
+        return;
+    }
+
+    this->RegisterAnalyticMachine(Machine, AnalyticMachine, Inventory);
+}
+
+void UProductionSubsystem::RescheduleMachine(UActorComponent* Machine, double Period, double TimeToNextFire)
+{
+    if (Period <= 0.0)
+    {
+        UE_LOG(LogProductionSubsystem, Error, TEXT("%hs : %s has a period of %f"), __FUNCTION__, *GetNameSafe(Machine), Period);
+        return;
+    }
+
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    // A bucket expects each of its machines to fire within one period from now
+    TimeToNextFire = FMath::Clamp(TimeToNextFire, 0.0, Period);
+
+    int32 MachineIndex = INDEX_NONE;
+
+    if (const FProductionMachine* ProductionMachine = this->FindMachine(Machine, &MachineIndex))
+    {
+        // The fires so far keep their indices, the start time moves so the next one is at the given time
+        FProductionMachine RescheduledMachine = *ProductionMachine;
+        RescheduledMachine.StartTime    = Now + TimeToNextFire - (RescheduledMachine.NumFires + 1) * Period;
+        RescheduledMachine.NextFireTime = UProductionSubsystem::GetFireTime(RescheduledMachine.StartTime, Period, RescheduledMachine.NumFires + 1);
+
+        this->RemoveMachineAt(this->Buckets[this->MachineBuckets.FindAndRemoveChecked(Machine)], MachineIndex);
+
+        this->PruneEmptyBuckets();
+
+        const int32 BucketIndex = this->FindOrAddBucket(Period);
+
+        this->InsertMachine(this->Buckets[BucketIndex], RescheduledMachine);
+        this->MachineBuckets.Add(Machine, BucketIndex);
+        return;
+    }
+
+    if (this->SimulatedMachineIndices.Contains(Machine))
+    {
+        // The running simulation writes the machine's next fire back when it is published
+        this->PublishSimulation();
+
+        const int32* SimulatedMachineIndex = this->SimulatedMachineIndices.Find(Machine);
+
+        if (!SimulatedMachineIndex)
+        {
+            return;
+        }
+
+        FSimulatedMachine& SimulatedMachine = this->SimulatedMachines[*SimulatedMachineIndex];
+        SimulatedMachine.PeriodSteps        = FMath::Max<int64>(FMath::RoundToInt64(Period / this->SimulationStepSeconds), 1);
+        SimulatedMachine.NextFireStep       = FMath::Max(this->GetSimulationStepAt(Now), this->SimulationStep)
+                                              + FMath::Max<int64>(FMath::RoundToInt64(TimeToNextFire / this->SimulationStepSeconds), 1);
+        return;
+    }
+
+    if (FAnalyticMachine* IdleAnalyticMachine = this->IdleAnalyticMachines.Find(Machine))
+    {
+        const int64 NumFires = IdleAnalyticMachine->GetNumFires(Now);
+
+        IdleAnalyticMachine->Period    = Period;
+        IdleAnalyticMachine->StartTime = Now + TimeToNextFire - (NumFires + 1) * Period;
+        return;
+    }
+
+    const UInventoryComponent* const* InventoryKey = this->AnalyticMachineInventories.Find(Machine);
+
+    if (!InventoryKey)
+    {
+        return;
+    }
+
+    // Fires up to now happened at the old period
+    if (UInventoryComponent* Inventory = this->AnalyticInventories.FindChecked(*InventoryKey).Inventory.Get())
+    {
+        Inventory->SettleProduction();
+    }
+
+    // Settling may have finished a machine that does not loop
+    InventoryKey = this->AnalyticMachineInventories.Find(Machine);
+
+    if (!InventoryKey)
+    {
+        return;
+    }
+
+    FAnalyticMachine* AnalyticMachine = this->AnalyticInventories.FindChecked(*InventoryKey).Machines.FindByPredicate([Machine](const FAnalyticMachine& InAnalyticMachine)
+    {
+        return InAnalyticMachine.Machine.Get() == Machine;
+    });
+
+    if (!AnalyticMachine)
+    {
+        return;
+    }
+
+    AnalyticMachine->Period    = Period;
+    AnalyticMachine->StartTime = Now + TimeToNextFire - (AnalyticMachine->NumSettledFires + 1) * Period;
+
+    // Its next fill is scheduled at the new period in the next tick
+    this->SettledInventories.Add(*InventoryKey);
+}
+
+double UProductionSubsystem::GetTimeToNextFire(const UActorComponent* Machine) const
+{
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    if (const int32* BucketIndex = this->MachineBuckets.Find(Machine))
+    {
+        const FProductionMachine* ProductionMachine = this->Buckets[*BucketIndex].Machines.FindByPredicate([Machine](const FProductionMachine& InProductionMachine)
+        {
+            return InProductionMachine.Machine.Get() == Machine;
+        });
+
+        return ProductionMachine ? FMath::Max(ProductionMachine->NextFireTime - Now, 0.0) : -1.0;
+    }
+
+    if (const int32* SimulatedMachineIndex = this->SimulatedMachineIndices.Find(Machine))
+    {
+        const FSimulatedMachine& SimulatedMachine = this->SimulatedMachines[*SimulatedMachineIndex];
+
+        const int64 CurrentStep = FMath::Max(this->GetSimulationStepAt(Now), this->SimulationStep);
+
+        // A run still going has fires the machine does not have yet, its next one is on the same phase past them
+        int64 NextFireStep = SimulatedMachine.NextFireStep;
+
+        if (NextFireStep <= CurrentStep)
+        {
+            NextFireStep += ((CurrentStep - NextFireStep) / SimulatedMachine.PeriodSteps + 1) * SimulatedMachine.PeriodSteps;
+        }
+
+        return FMath::Max(this->SimulationStartTime + NextFireStep * this->SimulationStepSeconds - Now, 0.0);
+    }
+
+    const FAnalyticMachine* AnalyticMachine = this->IdleAnalyticMachines.Find(Machine);
+
+    if (!AnalyticMachine)
+    {
+        const UInventoryComponent* const* InventoryKey = this->AnalyticMachineInventories.Find(Machine);
+
+        if (!InventoryKey)
+        {
+            return -1.0;
+        }
+
+        AnalyticMachine = this->AnalyticInventories.FindChecked(*InventoryKey).Machines.FindByPredicate([Machine](const FAnalyticMachine& InAnalyticMachine)
+        {
+            return InAnalyticMachine.Machine.Get() == Machine;
+        });
+
+        if (!AnalyticMachine)
+        {
+            return -1.0;
+        }
+    }
+
+    const double NextFireTime = UProductionSubsystem::GetFireTime(AnalyticMachine->StartTime, AnalyticMachine->Period, AnalyticMachine->GetNumFires(Now) + 1);
+
+    return FMath::Max(NextFireTime - Now, 0.0);
+}
+
+void UProductionSubsystem::UnregisterMachine(UActorComponent* Machine)
+{
+    if (this->IdleAnalyticMachines.Remove(Machine) > 0)
+    {
+        return;
+    }
+
+    if (this->AnalyticMachineInventories.Contains(Machine))
+    {
+        this->UnregisterAnalyticMachine(Machine);
+        return;
+    }
+
+    if (this->SimulatedMachineIndices.Contains(Machine))
+    {
+        this->UnregisterSimulatedMachine(Machine);
+        return;
+    }
+
+    int32 MachineIndex = INDEX_NONE;
+
+    if (!this->FindMachine(Machine, &MachineIndex))
+    {
+        return;
+    }
+
+    this->RemoveMachineAt(this->Buckets[this->MachineBuckets.FindAndRemoveChecked(Machine)], MachineIndex);
+
+    this->PruneEmptyBuckets();
+}
+
+void UProductionSubsystem::AdvanceBucket(FProductionBucket& Bucket, double Now)
+{
+    int32 NumFires = 0;
+
+    // A machine with a period shorter than the frame fires several times, like a looping timer would
+    while (Bucket.Machines.Num() > 0 && Bucket.Machines[Bucket.Cursor].NextFireTime <= Now)
+    {
+        FProductionMachine& Machine = Bucket.Machines[Bucket.Cursor];
+
+        UInventoryComponent* Inventory = Machine.Inventory.Get();
+
+        if (Inventory && Machine.Machine.IsValid() && Machine.Item)
+        {
+            this->AddDelta(Inventory, Machine, Bucket.Period, Machine.NumFires + 1, 1);
+
+            NumFires++;
+        }
+
+        if (!Machine.bLoop)
+        {
+            this->MachineBuckets.Remove(Machine.Machine.Get());
+            this->RemoveMachineAt(Bucket, Bucket.Cursor);
+            continue;
+        }
+
+        Machine.NumFires++;
+        Machine.NextFireTime = UProductionSubsystem::GetFireTime(Machine.StartTime, Bucket.Period, Machine.NumFires + 1);
+
+        Bucket.Cursor = (Bucket.Cursor + 1) % Bucket.Machines.Num();
+    }
+
+    INC_DWORD_STAT_BY(STAT_ProductionMachineFires, NumFires);
+}
+
+void UProductionSubsystem::AddDelta(UInventoryComponent*       Inventory,
+                                    const FProductionMachine&  Machine,
+                                    double                     Period,
+                                    int64                      FirstFire,
+                                    int64                      NumFires)
+{
+    int32* DeltaIndex = this->DeltaIndices.Find(Inventory);
+
+    if (!DeltaIndex)
+    {
+        FProductionDelta& NewDelta = this->Deltas.AddDefaulted_GetRef();
+        NewDelta.Inventory = Inventory;
+
+        DeltaIndex = &this->DeltaIndices.Add(Inventory, this->Deltas.Num() - 1);
+    }
+
+    FProductionDelta& Delta = this->Deltas[*DeltaIndex];
+
+    // A machine firing several times in a row extends its fires
+    if (Delta.Fires.Num() > 0)
+    {
+        FProductionFires& LastFires = Delta.Fires.Last();
+
+        if (LastFires.Machine == Machine.Machine && LastFires.NextFire + LastFires.NumFires == FirstFire)
+        {
+            LastFires.NumFires += NumFires;
+            return;
+        }
+    }
+
+    FProductionFires& Fires = Delta.Fires.AddDefaulted_GetRef();
+    Fires.Machine   = Machine.Machine;
+    Fires.Item      = Machine.Item;
+    Fires.Kind      = Machine.Kind;
+    Fires.StartTime = Machine.StartTime;
+    Fires.Period    = Period;
+    Fires.NextFire  = FirstFire;
+    Fires.NumFires  = NumFires;
+    Fires.Order     = Machine.Order;
+}
+
+void UProductionSubsystem::ApplyDeltas()
+{
+    INC_DWORD_STAT_BY(STAT_ProductionInventoryDeltas, this->Deltas.Num());
+
+    // Consumers broadcasting may register machines, which only touches the buckets
+    TArray<FProductionDelta> FrameDeltas = MoveTemp(this->Deltas);
+
+    this->Deltas.Reset();
+    this->DeltaIndices.Reset();
+
+    for (FProductionDelta& Delta : FrameDeltas)
+    {
+        UInventoryComponent* Inventory = Delta.Inventory.Get();
+
+        if (!Inventory)
+        {
+            continue;
+        }
+
+        // The frame's fires apply on top of the analytic ones up to now
+        Inventory->SettleProduction();
+
+        this->ApplyFires(Inventory, Delta.Fires);
+    }
+}
+
+void UProductionSubsystem::ApplyFires(UInventoryComponent* Inventory, TArrayView<FProductionFires> Fires)
+{
+    /** What the fires do to one item, and what the inventory holds of it */
+    struct FItemBudget
+    {
+        UItemDataAsset* Item = nullptr;
+        int64 AmountGenerated = 0;
+        int64 AmountConsumed  = 0;
+        int64 AmountHeld      = 0;
+        int64 PartialSpace    = 0;
+        int32 MaxStackSize    = 0;
+    };
+
+    TMap<uint16, FItemBudget> ItemBudgets;
+
+    for (const FProductionFires& MachineFires : Fires)
+    {
+        const uint16 ItemId = UItemRegistrySubsystem::GetItemId(MachineFires.Item);
+
+        FItemBudget& ItemBudget = ItemBudgets.FindOrAdd(ItemId);
+        ItemBudget.Item         = MachineFires.Item;
+        ItemBudget.MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+
+        if (MachineFires.Kind == EProductionKind::Generate)
+        {
+            ItemBudget.AmountGenerated += MachineFires.NumFires;
+        }
+        else
+        {
+            ItemBudget.AmountConsumed += MachineFires.NumFires;
+        }
+    }
+
+    int64 NumEmptySlots = 0;
+
+    for (const FInventorySlot& InventorySlot : Inventory->GetSlotView())
+    {
+        if (FInventorySlot::IsSlotEmpty(InventorySlot))
+        {
+            NumEmptySlots++;
+        }
+        else if (FItemBudget* ItemBudget = ItemBudgets.Find(InventorySlot.ItemId))
+        {
+            ItemBudget->AmountHeld   += InventorySlot.CurrentStackSize;
+            ItemBudget->PartialSpace += FMath::Max(ItemBudget->MaxStackSize - InventorySlot.CurrentStackSize, 0);
+        }
+    }
+
+    // Consumes never take space and generates never take items, so if the consumers have their items without any generates
+    // and the generates fit without any consumes, every order of the fires ends with the same slots
+    bool bOrderIndependent = true;
+    bool bHasConsumers     = false;
+    int64 NumSlotsNeeded   = 0;
+
+    for (const TPair<uint16, FItemBudget>& ItemBudget : ItemBudgets)
+    {
+        bHasConsumers |= ItemBudget.Value.AmountConsumed > 0;
+
+        if (ItemBudget.Value.AmountConsumed > ItemBudget.Value.AmountHeld || ItemBudget.Value.MaxStackSize <= 0)
+        {
+            bOrderIndependent = false;
+            continue;
+        }
+
+        const int64 AmountLeft = FMath::Max<int64>(ItemBudget.Value.AmountGenerated - ItemBudget.Value.PartialSpace, 0);
+
+        NumSlotsNeeded += (AmountLeft + ItemBudget.Value.MaxStackSize - 1) / ItemBudget.Value.MaxStackSize;
+    }
+
+    if (bOrderIndependent && NumSlotsNeeded <= NumEmptySlots)
+    {
+        for (const TPair<uint16, FItemBudget>& ItemBudget : ItemBudgets)
+        {
+            if (ItemBudget.Value.AmountGenerated > 0)
+            {
+                Inventory->AddItemAmount(ItemBudget.Value.Item, static_cast<int32>(FMath::Min<int64>(ItemBudget.Value.AmountGenerated, MAX_int32)));
+            }
+
+            if (ItemBudget.Value.AmountConsumed > 0)
+            {
+                Inventory->TryRemoveItem(ItemBudget.Value.Item, static_cast<int32>(FMath::Min<int64>(ItemBudget.Value.AmountConsumed, MAX_int32)));
+            }
+        }
+
+        for (FProductionFires& MachineFires : Fires)
+        {
+            MachineFires.AmountConsumed = MachineFires.Kind == EProductionKind::Consume ? static_cast<int32>(MachineFires.NumFires) : 0;
+        }
+    }
+    else
+    {
+        // The inventory fills or runs dry on the way, apply the fires one by one by fire time, ties in registration order
+        TArray<TPair<double, int32>, TInlineAllocator<8>> FireHeap;
+
+        auto FireOrder = [&Fires](const TPair<double, int32>& A, const TPair<double, int32>& B)
+        {
+            return A.Key < B.Key || (A.Key == B.Key && Fires[A.Value].Order < Fires[B.Value].Order);
+        };
+
+        for (int32 FiresIndex = 0; FiresIndex < Fires.Num(); FiresIndex++)
+        {
+            const FProductionFires& MachineFires = Fires[FiresIndex];
+
+            FireHeap.HeapPush(TPair<double, int32>(GetFireTime(MachineFires.StartTime, MachineFires.Period, MachineFires.NextFire), FiresIndex), FireOrder);
+        }
+
+        while (FireHeap.Num() > 0)
+        {
+            TPair<double, int32> Fire;
+            FireHeap.HeapPop(Fire, FireOrder);
+
+            FProductionFires& MachineFires = Fires[Fire.Value];
+
+            bool bCanFireAgain = true;
+
+            if (MachineFires.Kind == EProductionKind::Generate)
+            {
+                // Only a consume can make room again, without consumers the rest of the fires are lost as well
+                bCanFireAgain = Inventory->AddItemAmount(MachineFires.Item, 1) == 0 || bHasConsumers;
+            }
+            else if (Inventory->ContainsItem(MachineFires.Item) > 0 && Inventory->TryRemoveItem(MachineFires.Item, 1))
+            {
+                MachineFires.AmountConsumed++;
+            }
+            else
+            {
+                // Only a generate of the item can make it available again
+                bCanFireAgain = ItemBudgets.FindChecked(UItemRegistrySubsystem::GetItemId(MachineFires.Item)).AmountGenerated > 0;
+            }
+
+            MachineFires.NextFire++;
+            MachineFires.NumFires--;
+
+            if (MachineFires.NumFires > 0 && bCanFireAgain)
+            {
+                FireHeap.HeapPush(TPair<double, int32>(GetFireTime(MachineFires.StartTime, MachineFires.Period, MachineFires.NextFire), Fire.Value), FireOrder);
+            }
+        }
+    }
+
+    // One broadcast per consumer and item, however many runs of fires it had
+    for (int32 FiresIndex = 0; FiresIndex < Fires.Num(); FiresIndex++)
+    {
+        const FProductionFires& MachineFires = Fires[FiresIndex];
+
+        int32 AmountConsumed = MachineFires.AmountConsumed;
+
+        if (AmountConsumed <= 0)
+        {
+            continue;
+        }
+
+        bool bBroadcast = false;
+
+        for (int32 OtherIndex = 0; OtherIndex < FiresIndex && !bBroadcast; OtherIndex++)
+        {
+            bBroadcast = Fires[OtherIndex].Machine == MachineFires.Machine && Fires[OtherIndex].Item == MachineFires.Item;
+        }
+
+        if (bBroadcast)
+        {
+            continue;
+        }
+
+        for (int32 OtherIndex = FiresIndex + 1; OtherIndex < Fires.Num(); OtherIndex++)
+        {
+            if (Fires[OtherIndex].Machine == MachineFires.Machine && Fires[OtherIndex].Item == MachineFires.Item)
+            {
+                AmountConsumed += Fires[OtherIndex].AmountConsumed;
+            }
+        }
+
+        if (UItemConsumingComponent* Consumer = Cast<UItemConsumingComponent>(MachineFires.Machine.Get()))
+        {
+            Consumer->OnItemConsumed.Broadcast(MachineFires.Item, AmountConsumed);
+        }
+    }
+}
+
+void UProductionSubsystem::FastForward(double ElapsedSeconds)
+{
+    if (ElapsedSeconds <= 0.0)
+    {
+        return;
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_ProductionFastForward);
+
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    // Apply what is due by now first, so the steps only hold the elapsed time's fires
+    for (FProductionBucket& Bucket : this->Buckets)
+    {
+        this->AdvanceBucket(Bucket, Now);
+    }
+
+    this->ApplyDeltas();
+
+    TArray<TWeakObjectPtr<UInventoryComponent>> Inventories;
+    Inventories.Reserve(this->AnalyticInventories.Num());
+
+    for (const TPair<const UInventoryComponent*, FAnalyticInventory>& AnalyticInventory : this->AnalyticInventories)
+    {
+        Inventories.Add(AnalyticInventory.Value.Inventory);
+    }
+
+    // Simulated machines run the elapsed steps on the worker, starting with the next tick's run
+    this->PublishSimulation();
+
+    this->SimulationStartTime -= ElapsedSeconds;
+
+    TArray<UCraftingComponent*> Crafters;
+
+    if (const UCraftingSchedulerSubsystem* CraftingScheduler = this->GetWorld()->GetSubsystem<UCraftingSchedulerSubsystem>())
+    {
+        Crafters = CraftingScheduler->GetScheduledCrafters();
+    }
+
+    this->SortByProductionGraph(Crafters);
+
+    const int32 NumSteps     = FMath::Clamp(FMath::CeilToInt(ElapsedSeconds / UProductionSubsystem::FastForwardStepSeconds), 1, UProductionSubsystem::MaxFastForwardSteps);
+    const double StepSeconds = ElapsedSeconds / NumSteps;
+
+    for (int32 Step = 0; Step < NumSteps; Step++)
+    {
+        for (FProductionBucket& Bucket : this->Buckets)
+        {
+            this->FastForwardBucket(Bucket, StepSeconds, Now);
+        }
+
+        // Moving an analytic machine's start back makes the step's fires pending, the next settle applies them
+        for (TPair<const UInventoryComponent*, FAnalyticInventory>& AnalyticInventory : this->AnalyticInventories)
+        {
+            for (FAnalyticMachine& AnalyticMachine : AnalyticInventory.Value.Machines)
+            {
+                AnalyticMachine.StartTime -= StepSeconds;
+            }
+        }
+
+        this->ApplyDeltas();
+
+        for (const TWeakObjectPtr<UInventoryComponent>& Inventory : Inventories)
+        {
+            if (Inventory.IsValid())
+            {
+                Inventory->SettleProduction();
+            }
+        }
+
+        for (UCraftingComponent* Crafter : Crafters)
+        {
+            if (IsValid(Crafter))
+            {
+                Crafter->FastForwardQueue(StepSeconds);
+            }
+        }
+    }
+
+    this->PruneEmptyBuckets();
+
+    // The wake-ups in the heap are from before the shift, every analytic inventory is rescheduled in the next tick
+    for (TPair<const UInventoryComponent*, FAnalyticInventory>& AnalyticInventory : this->AnalyticInventories)
+    {
+        AnalyticInventory.Value.WakeUpTime = MAX_dbl;
+
+        this->SettledInventories.Add(AnalyticInventory.Key);
+    }
+}
+
+void UProductionSubsystem::FastForwardBucket(FProductionBucket& Bucket, double Seconds, double Now)
+{
+    int64 NumFires = 0;
+
+    // Every machine moves by the same time, so they keep their cyclic order and only the cursor has to be found again
+    for (int32 MachineIndex = Bucket.Machines.Num() - 1; MachineIndex >= 0; MachineIndex--)
+    {
+        FProductionMachine& Machine = Bucket.Machines[MachineIndex];
+
+        Machine.StartTime -= Seconds;
+
+        int64 MachineFires = UProductionSubsystem::GetNumFiresAt(Machine.StartTime, Bucket.Period, Now) - Machine.NumFires;
+
+        if (!Machine.bLoop)
+        {
+            MachineFires = FMath::Min<int64>(MachineFires, 1);
+        }
+
+        UInventoryComponent* Inventory = Machine.Inventory.Get();
+
+        if (MachineFires > 0 && Inventory && Machine.Machine.IsValid() && Machine.Item)
+        {
+            this->AddDelta(Inventory, Machine, Bucket.Period, Machine.NumFires + 1, MachineFires);
+
+            NumFires += MachineFires;
+        }
+
+        if (!Machine.bLoop && MachineFires > 0)
+        {
+            this->MachineBuckets.Remove(Machine.Machine.Get());
+            this->RemoveMachineAt(Bucket, MachineIndex);
+            continue;
+        }
+
+        Machine.NumFires     += MachineFires;
+        Machine.NextFireTime  = UProductionSubsystem::GetFireTime(Machine.StartTime, Bucket.Period, Machine.NumFires + 1);
+    }
+
+    // The machine that fires next, the first one from the old cursor on if several tie
+    for (int32 Offset = 1; Offset < Bucket.Machines.Num(); Offset++)
+    {
+        const int32 MachineIndex = (Bucket.Cursor + Offset) % Bucket.Machines.Num();
+
+        if (Bucket.Machines[MachineIndex].NextFireTime < Bucket.Machines[Bucket.Cursor].NextFireTime)
+        {
+            Bucket.Cursor = MachineIndex;
+        }
+    }
+
+    INC_DWORD_STAT_BY(STAT_ProductionMachineFires, NumFires);
+}
+
+bool UProductionSubsystem::SetSimulationStepSeconds(double StepSeconds)
+{
+    if (StepSeconds <= 0.0)
+    {
+        UE_LOG(LogProductionSubsystem, Error, TEXT("%hs : Step of %f seconds"), __FUNCTION__, StepSeconds);
+        return false;
+    }
+
+    // The machines' periods and fire steps are counted in the old step
+    if (this->SimulatedMachines.Num() > 0 || this->SimulationTask.IsValid())
+    {
+        UE_LOG(LogProductionSubsystem, Warning, TEXT("%hs : Simulated machines are registered"), __FUNCTION__);
+        return false;
+    }
+
+    this->SimulationStepSeconds = StepSeconds;
+
+    return true;
+}
+
+bool UProductionSubsystem::RegisterSimulatedMachine(const FSimulatedMachine& SimulatedMachine, double Period)
+{
+    const double Now = this->GetWorld()->GetTimeSeconds();
+
+    // With nothing simulated the steps restart from now, which keeps the step counts small
+    if (this->SimulatedMachines.Num() == 0 && !this->SimulationTask.IsValid())
+    {
+        this->SimulationStartTime = Now;
+        this->SimulationStep      = 0;
+    }
+
+    FSimulatedMachine NewMachine = SimulatedMachine;
+    NewMachine.PeriodSteps       = FMath::Max<int64>(FMath::RoundToInt64(Period / this->SimulationStepSeconds), 1);
+    NewMachine.NextFireStep      = FMath::Max(this->GetSimulationStepAt(Now), this->SimulationStep) + NewMachine.PeriodSteps;
+
+    this->SimulatedMachineIndices.Add(SimulatedMachine.Machine.Get(), this->SimulatedMachines.Add(NewMachine));
+
+    return true;
+}
+
+void UProductionSubsystem::UnregisterSimulatedMachine(const UActorComponent* Machine)
+{
+    int32 MachineIndex = INDEX_NONE;
+
+    if (!this->SimulatedMachineIndices.RemoveAndCopyValue(Machine, MachineIndex))
+    {
+        return;
+    }
+
+    // Removed in place, the machines keep firing in registration order
+    this->SimulatedMachines.RemoveAt(MachineIndex);
+
+    for (TPair<const UActorComponent*, int32>& SimulatedMachineIndex : this->SimulatedMachineIndices)
+    {
+        if (SimulatedMachineIndex.Value > MachineIndex)
+        {
+            SimulatedMachineIndex.Value--;
+        }
+    }
+}
+
+int64 UProductionSubsystem::GetSimulationStepAt(double Time) const
+{
+    return FMath::FloorToInt64((Time - this->SimulationStartTime) / this->SimulationStepSeconds);
+}
+
+void UProductionSubsystem::LaunchSimulation(int64 TargetStep)
+{
+    if (!this->Simulation.IsValid())
+    {
+        this->Simulation = MakeShared<FFactorySimulation>();
+    }
+
+    this->Simulation->ResetMachines();
+    this->Simulation->SetStep(this->SimulationStep);
+
+    this->SimulationMachines.Reset();
+
+    TSet<const UInventoryComponent*> UsedInventories;
+
+    for (const FSimulatedMachine& SimulatedMachine : this->SimulatedMachines)
+    {
+        if (SimulatedMachine.Inventory.IsValid() && SimulatedMachine.Machine.IsValid() && SimulatedMachine.Item)
+        {
+            UsedInventories.Add(SimulatedMachine.Inventory.Get());
+        }
+    }
+
+    bool bRebuild      = false;
+    bool bIsPublishing = false;
+
+    for (auto It = this->SimulatedInventories.CreateIterator(); It; ++It)
+    {
+        FSimulatedInventory& SimulatedInventory = It.Value();
+
+        UInventoryComponent* Inventory = SimulatedInventory.Inventory.Get();
+
+        // Dropped once nothing is left to publish to it, its mirror stays in the simulation unused until the next rebuild
+        if (!Inventory || (!UsedInventories.Contains(It.Key()) && SimulatedInventory.UnpublishedAmounts.Num() == 0))
+        {
+            if (Inventory)
+            {
+                Inventory->OnSlotChanged.RemoveAll(this);
+            }
+
+            It.RemoveCurrent();
+            continue;
+        }
+
+        bIsPublishing |= SimulatedInventory.UnpublishedAmounts.Num() > 0;
+
+        const TArray<FInventorySlot>& Slots = Inventory->GetInventorySlots();
+
+        if (SimulatedInventory.bAllSlotsDirty)
+        {
+            if (Slots.Num() != this->Simulation->GetNumSlots(SimulatedInventory.SimulationIndex))
+            {
+                bRebuild = true;
+                continue;
+            }
+
+            for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); SlotIndex++)
+            {
+                this->Simulation->SetSlot(SimulatedInventory.SimulationIndex, SlotIndex, Slots[SlotIndex]);
+            }
+        }
+        else
+        {
+            for (const int32 SlotIndex : SimulatedInventory.DirtySlots)
+            {
+                if (Slots.IsValidIndex(SlotIndex))
+                {
+                    this->Simulation->SetSlot(SimulatedInventory.SimulationIndex, SlotIndex, Slots[SlotIndex]);
+                }
+            }
+        }
+
+        SimulatedInventory.DirtySlots.Reset();
+        SimulatedInventory.bAllSlotsDirty = false;
+    }
+
+    // Unused mirrors are only dropped by a rebuild, which copies every inventory in full
+    if (bRebuild || this->SimulationInventories.Num() > 2 * this->SimulatedInventories.Num() + 8)
+    {
+        this->RebuildSimulatedInventories();
+    }
+
+    for (const FSimulatedMachine& SimulatedMachine : this->SimulatedMachines)
+    {
+        UInventoryComponent* Inventory = SimulatedMachine.Inventory.Get();
+
+        if (!Inventory || !SimulatedMachine.Machine.IsValid() || !SimulatedMachine.Item)
+        {
+            continue;
+        }
+
+        FFactorySimMachine SimMachine;
+        SimMachine.InventoryIndex = this->FindOrAddSimulatedInventory(Inventory).SimulationIndex;
+        SimMachine.ItemId         = UItemRegistrySubsystem::GetItemId(SimulatedMachine.Item);
+        SimMachine.MaxStackSize   = UItemRegistrySubsystem::GetMaxStackSize(SimMachine.ItemId);
+        SimMachine.Kind           = SimulatedMachine.Kind;
+        SimMachine.bLoop          = SimulatedMachine.bLoop;
+        SimMachine.PeriodSteps    = SimulatedMachine.PeriodSteps;
+        SimMachine.NextFireStep   = SimulatedMachine.NextFireStep;
+
+        this->Simulation->AddMachine(SimMachine);
+        this->SimulationMachines.Add(SimulatedMachine);
+    }
+
+    this->SimulationStep = TargetStep;
+
+    // Still launched without machines while items wait to be published, so the next tick retries them
+    if (this->SimulationMachines.Num() == 0 && !bIsPublishing)
+    {
+        return;
+    }
+
+    TSharedPtr<FFactorySimulation> RunningSimulation = this->Simulation;
+
+    this->SimulationTask = Async(EAsyncExecution::TaskGraph, [RunningSimulation, TargetStep]()
+    {
+        SCOPE_CYCLE_COUNTER(STAT_ProductionSimulation);
+
+        RunningSimulation->AdvanceTo(TargetStep);
+    });
+}
+
+FSimulatedInventory& UProductionSubsystem::FindOrAddSimulatedInventory(UInventoryComponent* Inventory)
+{
+    if (FSimulatedInventory* SimulatedInventory = this->SimulatedInventories.Find(Inventory))
+    {
+        return *SimulatedInventory;
+    }
+
+    FSimulatedInventory& SimulatedInventory = this->SimulatedInventories.Add(Inventory);
+    SimulatedInventory.Inventory       = Inventory;
+    SimulatedInventory.SimulationIndex = this->Simulation->AddInventory(Inventory->GetInventorySlots());
+
+    this->SimulationInventories.Add(Inventory);
+
+    Inventory->OnSlotChanged.AddUObject(this, &UProductionSubsystem::HandleSimulatedSlotChanged, static_cast<const UInventoryComponent*>(Inventory));
+
+    return SimulatedInventory;
+}
+
+void UProductionSubsystem::RebuildSimulatedInventories()
+{
+    this->Simulation->Reset();
+    this->SimulationInventories.Reset();
+
+    for (TPair<const UInventoryComponent*, FSimulatedInventory>& SimulatedInventory : this->SimulatedInventories)
+    {
+        UInventoryComponent* Inventory = SimulatedInventory.Value.Inventory.Get();
+
+        // Invalid ones were dropped before the rebuild
+        check(Inventory);
+
+        SimulatedInventory.Value.SimulationIndex = this->Simulation->AddInventory(Inventory->GetInventorySlots());
+        SimulatedInventory.Value.DirtySlots.Reset();
+        SimulatedInventory.Value.bAllSlotsDirty = false;
+
+        this->SimulationInventories.Add(Inventory);
+    }
+}
+
+void UProductionSubsystem::HandleSimulatedSlotChanged(int32 SlotIndex, const UInventoryComponent* Inventory)
+{
+    FSimulatedInventory* SimulatedInventory = this->SimulatedInventories.Find(Inventory);
+
+    if (!SimulatedInventory)
+    {
+        return;
+    }
+
+    if (SlotIndex == INDEX_NONE)
+    {
+        SimulatedInventory->bAllSlotsDirty = true;
+        SimulatedInventory->DirtySlots.Reset();
+    }
+    else if (!SimulatedInventory->bAllSlotsDirty)
+    {
+        SimulatedInventory->DirtySlots.Add(SlotIndex);
+    }
+}
+
+void UProductionSubsystem::PublishSimulation()
+{
+    if (!this->SimulationTask.IsValid())
+    {
+        return;
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_ProductionPublishSimulation);
+
+    this->SimulationTask.Wait();
+    this->SimulationTask = TFuture<void>();
+
+    const TArray<FFactorySimMachine>& SimMachines = this->Simulation->GetMachines();
+
+    // The run's change per inventory and item, on top of what earlier runs could not publish
+    for (int32 MachineIndex = 0; MachineIndex < SimMachines.Num(); MachineIndex++)
+    {
+        const FFactorySimMachine& SimMachine = SimMachines[MachineIndex];
+
+        const int64 AmountChanged = SimMachine.AmountGenerated - SimMachine.AmountConsumed;
+
+        if (AmountChanged == 0)
+        {
+            continue;
+        }
+
+        const UInventoryComponent* Inventory = this->SimulationInventories[SimMachine.InventoryIndex].Get();
+
+        if (FSimulatedInventory* SimulatedInventory = Inventory ? this->SimulatedInventories.Find(Inventory) : nullptr)
+        {
+            SimulatedInventory->UnpublishedAmounts.FindOrAdd(this->SimulationMachines[MachineIndex].Item) += AmountChanged;
+        }
+    }
+
+    // Only the run's change is applied, so changes the game thread made to the inventories meanwhile are kept.
+    // The mirror's changed slots are synced from the inventory before the next run, in case the change landed elsewhere
+    for (TPair<const UInventoryComponent*, FSimulatedInventory>& SimulatedInventoryPair : this->SimulatedInventories)
+    {
+        FSimulatedInventory& SimulatedInventory = SimulatedInventoryPair.Value;
+
+        UInventoryComponent* Inventory = SimulatedInventory.Inventory.Get();
+
+        if (!Inventory)
+        {
+            continue;
+        }
+
+        TArray<int32> ChangedSlots;
+        this->Simulation->GetChangedSlots(SimulatedInventory.SimulationIndex, ChangedSlots);
+
+        if (!SimulatedInventory.bAllSlotsDirty)
+        {
+            SimulatedInventory.DirtySlots.Append(ChangedSlots);
+        }
+
+        if (SimulatedInventory.UnpublishedAmounts.Num() == 0)
+        {
+            continue;
+        }
+
+        // Added first, so a run that moved items between its machines does not remove what it also added
+        for (auto It = SimulatedInventory.UnpublishedAmounts.CreateIterator(); It; ++It)
+        {
+            if (It.Value() > 0)
+            {
+                // The inventory may have filled up during the run, what does not fit waits for the next publish
+                It.Value() = Inventory->AddItemAmount(It.Key(), static_cast<int32>(FMath::Min<int64>(It.Value(), MAX_int32)))
+                             + FMath::Max<int64>(It.Value() - MAX_int32, 0);
+            }
+        }
+
+        for (auto It = SimulatedInventory.UnpublishedAmounts.CreateIterator(); It; ++It)
+        {
+            if (It.Value() < 0)
+            {
+                Inventory->SettleProduction();
+
+                // Items the game thread took meanwhile can't be consumed again, the consumers still had them in the run
+                const int32 AmountRemoved = static_cast<int32>(FMath::Min<int64>(-It.Value(), Inventory->ContainsItem(It.Key())));
+
+                if (AmountRemoved > 0)
+                {
+                    Inventory->TryRemoveItem(It.Key(), AmountRemoved);
+                }
+
+                It.Value() = 0;
+            }
+
+            if (It.Value() == 0)
+            {
+                It.RemoveCurrent();
+            }
+        }
+    }
+
+    TArray<const UActorComponent*> FinishedMachines;
+
+    for (int32 MachineIndex = 0; MachineIndex < SimMachines.Num(); MachineIndex++)
+    {
+        const FFactorySimMachine& SimMachine = SimMachines[MachineIndex];
+
+        const FSimulatedMachine& SimulationMachine = this->SimulationMachines[MachineIndex];
+
+        UActorComponent* Machine = SimulationMachine.Machine.Get();
+
+        // Machines unregistered during the run keep what they did in it, but not their state
+        if (const int32* SimulatedMachineIndex = this->SimulatedMachineIndices.Find(Machine))
+        {
+            this->SimulatedMachines[*SimulatedMachineIndex].NextFireStep = SimMachine.NextFireStep;
+
+            if (SimMachine.bFinished)
+            {
+                FinishedMachines.Add(Machine);
+            }
+        }
+
+        if (SimMachine.AmountConsumed <= 0)
+        {
+            continue;
+        }
+
+        if (UItemConsumingComponent* Consumer = Cast<UItemConsumingComponent>(Machine))
+        {
+            Consumer->OnItemConsumed.Broadcast(SimulationMachine.Item, static_cast<int32>(SimMachine.AmountConsumed));
+        }
+    }
+
+    for (const UActorComponent* FinishedMachine : FinishedMachines)
+    {
+        this->UnregisterSimulatedMachine(FinishedMachine);
+    }
+}
+
+void UProductionSubsystem::SortByProductionGraph(TArray<UCraftingComponent*>& Crafters) const
+{
+    const UGameInstance* GameInstance = this->GetWorld()->GetGameInstance();
+
+    UGraphSubsystem* GraphSubsystem = GameInstance ? GameInstance->GetSubsystem<UGraphSubsystem>() : nullptr;
+
+    if (!GraphSubsystem || GraphSubsystem->Graphs.Num() == 0 || Crafters.Num() < 2)
+    {
+        return;
+    }
+
+    const UGraphBase* Graph = GraphSubsystem->GetGraph();
+
+    if (!Graph)
+    {
+        return;
+    }
+
+    TMap<const UNodeBase*, int32> NodeOrder;
+
+    const TArray<UNodeBase*> OrderedNodes = Graph->GetNodesInTopologicalOrder();
+
+    for (int32 NodeIndex = 0; NodeIndex < OrderedNodes.Num(); NodeIndex++)
+    {
+        NodeOrder.Add(OrderedNodes[NodeIndex], NodeIndex);
+    }
+
+    // Crafters on actors without a node go last
+    auto GetOrder = [&NodeOrder](const UCraftingComponent* Crafter)
+    {
+        const AActor* Owner = Crafter ? Crafter->GetOwner() : nullptr;
+
+        const UGraphNodeComponent* GraphNode = Owner ? Owner->FindComponentByClass<UGraphNodeComponent>() : nullptr;
+
+        const int32* Order = GraphNode ? NodeOrder.Find(GraphNode->GetNode()) : nullptr;
+
+        return Order ? *Order : MAX_int32;
+    };
+
+    Algo::StableSortBy(Crafters, GetOrder);
+}
+
+bool UProductionSubsystem::IsMachineRegistered(const UActorComponent* Machine) const
+{
+    return this->MachineBuckets.Contains(Machine)
+           || this->AnalyticMachineInventories.Contains(Machine)
+           || this->IdleAnalyticMachines.Contains(Machine)
+           || this->SimulatedMachineIndices.Contains(Machine);
+}
+
+int64 UProductionSubsystem::GetNumFiresAt(double StartTime, double Period, double Time)
+{
+    if (Time < StartTime || Period <= 0.0)
+    {
+        return 0;
+    }
+
+    int64 NumFires = FMath::FloorToInt64((Time - StartTime) / Period);
+
+    // The division rounds differently than GetFireTime's multiplication, correct by the fire times themselves
+    while (UProductionSubsystem::GetFireTime(StartTime, Period, NumFires + 1) <= Time)
+    {
+        NumFires++;
+    }
+
+    while (NumFires > 0 && UProductionSubsystem::GetFireTime(StartTime, Period, NumFires) > Time)
+    {
+        NumFires--;
+    }
+
+    return NumFires;
+}
+
+void UProductionSubsystem::SettleInventory(UInventoryComponent* Inventory)
+{
+    FAnalyticInventory* AnalyticInventory = this->AnalyticInventories.Find(Inventory);
+
+    if (!AnalyticInventory)
+    {
+        return;
+    }
+
+    // Reads with nothing to settle keep the scheduled wake-up, it only changes with applied fires or other changes that settled first
+    if (this->ApplyAnalyticFires(Inventory, *AnalyticInventory, this->GetWorld()->GetTimeSeconds()))
+    {
+        this->SettledInventories.Add(Inventory);
+    }
+}
+
+bool UProductionSubsystem::RegisterAnalyticMachine(UActorComponent*        Machine,
+                                                   const FAnalyticMachine& AnalyticMachine,
+                                                   UInventoryComponent*    Inventory)
+{
+    if (!Inventory)
+    {
+        UE_LOG(LogProductionSubsystem, Error, TEXT("%hs : Inventory is nullptr"), __FUNCTION__);
+        return false;
+    }
+
+    FAnalyticInventory& AnalyticInventory = this->AnalyticInventories.FindOrAdd(Inventory);
+
+    if (!AnalyticInventory.Inventory.IsValid())
+    {
+        AnalyticInventory.Inventory = Inventory;
+        Inventory->SetAnalyticProduction(this);
+    }
+
+    AnalyticInventory.Machines.Add(AnalyticMachine);
+
+    this->AnalyticMachineInventories.Add(Machine, Inventory);
+
+    // Its first fill is scheduled with the inventory's other wake-ups in the next tick
+    this->SettledInventories.Add(Inventory);
+
+    return true;
+}
+
+void UProductionSubsystem::UnregisterAnalyticMachine(UActorComponent* Machine)
+{
+    const UInventoryComponent* InventoryKey = nullptr;
+
+    if (!this->AnalyticMachineInventories.RemoveAndCopyValue(Machine, InventoryKey))
+    {
+        return;
+    }
+
+    // A discrete machine would have fired up to now before it stopped
+    if (const FAnalyticInventory* AnalyticInventory = this->AnalyticInventories.Find(InventoryKey))
+    {
+        if (UInventoryComponent* Inventory = AnalyticInventory->Inventory.Get())
+        {
+            Inventory->SettleProduction();
+        }
+    }
+
+    FAnalyticInventory* AnalyticInventory = this->AnalyticInventories.Find(InventoryKey);
+
+    if (!AnalyticInventory)
+    {
+        return;
+    }
+
+    AnalyticInventory->Machines.RemoveAll([Machine](const FAnalyticMachine& AnalyticMachine)
+    {
+        return AnalyticMachine.Machine.Get() == Machine;
+    });
+
+    // Left in the map while empty, a settle of the inventory may still be running further up the stack
+    this->SettledInventories.Add(InventoryKey);
+}
+
+bool UProductionSubsystem::ApplyAnalyticFires(UInventoryComponent* Inventory, FAnalyticInventory& AnalyticInventory, double Now)
+{
+    TArray<FProductionFires, TInlineAllocator<8>> PendingFires;
+
+    // Count the pending fires and mark them settled before anything is applied
+    for (int32 MachineIndex = 0; MachineIndex < AnalyticInventory.Machines.Num();)
+    {
+        FAnalyticMachine& AnalyticMachine = AnalyticInventory.Machines[MachineIndex];
+
+        const int64 NumFires = AnalyticMachine.GetNumFires(Now);
+
+        if (NumFires > AnalyticMachine.NumSettledFires && AnalyticMachine.Machine.IsValid() && AnalyticMachine.Item)
+        {
+            FProductionFires& Pending = PendingFires.AddDefaulted_GetRef();
+            Pending.Machine   = AnalyticMachine.Machine;
+            Pending.Item      = AnalyticMachine.Item;
+            Pending.Kind      = AnalyticMachine.Kind;
+            Pending.StartTime = AnalyticMachine.StartTime;
+            Pending.Period    = AnalyticMachine.Period;
+            Pending.NextFire  = AnalyticMachine.NumSettledFires + 1;
+            Pending.NumFires  = NumFires - AnalyticMachine.NumSettledFires;
+            Pending.Order     = AnalyticMachine.Order;
+        }
+
+        AnalyticMachine.NumSettledFires = NumFires;
+
+        if (!AnalyticMachine.bLoop && NumFires > 0)
+        {
+            this->AnalyticMachineInventories.Remove(AnalyticMachine.Machine.Get());
+            AnalyticInventory.Machines.RemoveAt(MachineIndex);
+            continue;
+        }
+
+        MachineIndex++;
+    }
+
+    if (PendingFires.Num() == 0)
+    {
+        return false;
+    }
+
+    INC_DWORD_STAT(STAT_ProductionAnalyticSettles);
+
+    this->ApplyFires(Inventory, PendingFires);
+
+    return true;
+}
+
+void UProductionSubsystem::ScheduleWakeUp(UInventoryComponent* Inventory, FAnalyticInventory& AnalyticInventory)
+{
+    double WakeUpTime = MAX_dbl;
+
+    // Space per generated item, from one pass over the slots
+    TMap<uint16, int64> ItemSpaces;
+
+    for (const FAnalyticMachine& AnalyticMachine : AnalyticInventory.Machines)
+    {
+        if (AnalyticMachine.Kind == EProductionKind::Generate && AnalyticMachine.Item)
+        {
+            ItemSpaces.Add(UItemRegistrySubsystem::GetItemId(AnalyticMachine.Item), 0);
+        }
+    }
+
+    int64 NumEmptySlots = 0;
+
+    if (ItemSpaces.Num() > 0)
+    {
+        for (const FInventorySlot& InventorySlot : Inventory->GetSlotView())
+        {
+            if (FInventorySlot::IsSlotEmpty(InventorySlot))
+            {
+                NumEmptySlots++;
+            }
+            else if (int64* ItemSpace = ItemSpaces.Find(InventorySlot.ItemId))
+            {
+                *ItemSpace += FMath::Max(InventorySlot.MaxStackSize - InventorySlot.CurrentStackSize, 0);
+            }
+        }
+    }
+
+    for (const FAnalyticMachine& AnalyticMachine : AnalyticInventory.Machines)
+    {
+        if (!AnalyticMachine.bLoop)
+        {
+            WakeUpTime = FMath::Min(WakeUpTime, GetFireTime(AnalyticMachine.StartTime, AnalyticMachine.Period, 1));
+            continue;
+        }
+
+        if (AnalyticMachine.Kind != EProductionKind::Generate || !AnalyticMachine.Item)
+        {
+            continue;
+        }
+
+        const uint16 ItemId = UItemRegistrySubsystem::GetItemId(AnalyticMachine.Item);
+
+        const int64 Space = ItemSpaces.FindRef(ItemId) + NumEmptySlots * UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+
+        // The fire that fills the last space, a full inventory has nothing to wake up for until it changes
+        if (Space > 0)
+        {
+            WakeUpTime = FMath::Min(WakeUpTime, GetFireTime(AnalyticMachine.StartTime, AnalyticMachine.Period, AnalyticMachine.NumSettledFires + Space));
+        }
+    }
+
+    if (WakeUpTime < AnalyticInventory.WakeUpTime)
+    {
+        AnalyticInventory.WakeUpTime = WakeUpTime;
+
+        FProductionWakeUp WakeUp;
+        WakeUp.Time      = WakeUpTime;
+        WakeUp.Inventory = Inventory;
+
+        this->WakeUps.HeapPush(WakeUp);
+    }
+}
+
+FProductionMachine* UProductionSubsystem::FindMachine(const UActorComponent* Machine, int32* OutMachineIndex)
+{
+    const int32* BucketIndex = this->MachineBuckets.Find(Machine);
+
+    if (!BucketIndex)
+    {
+        return nullptr;
+    }
+
+    TArray<FProductionMachine>& Machines = this->Buckets[*BucketIndex].Machines;
+
+    const int32 MachineIndex = Machines.IndexOfByPredicate([Machine](const FProductionMachine& ProductionMachine)
+    {
+        return ProductionMachine.Machine.Get() == Machine;
+    });
+
+    if (OutMachineIndex)
+    {
+        *OutMachineIndex = MachineIndex;
+    }
+
+    return MachineIndex != INDEX_NONE ? &Machines[MachineIndex] : nullptr;
+}
+
+int32 UProductionSubsystem::FindOrAddBucket(double Period)
+{
+    int32 BucketIndex = this->Buckets.IndexOfByPredicate([Period](const FProductionBucket& Bucket) { return Bucket.Period == Period; });
+
+    if (BucketIndex == INDEX_NONE)
+    {
+        BucketIndex = this->Buckets.AddDefaulted();
+        this->Buckets[BucketIndex].Period = Period;
+    }
+
+    return BucketIndex;
+}
+
+void UProductionSubsystem::InsertMachine(FProductionBucket& Bucket, const FProductionMachine& Machine)
+{
+    const int32 NumMachines = Bucket.Machines.Num();
+
+    // Read from the cursor on, the first machine firing after the new one, ties keep theirs first
+    int32 Offset = 0;
+
+    while (Offset < NumMachines && Bucket.Machines[(Bucket.Cursor + Offset) % NumMachines].NextFireTime <= Machine.NextFireTime)
+    {
+        Offset++;
+    }
+
+    // Firing first it becomes the cursor, otherwise it goes right before the machine that fires after it
+    if (Offset == 0)
+    {
+        Bucket.Machines.Insert(Machine, Bucket.Cursor);
+        return;
+    }
+
+    const int32 MachineIndex = Offset == NumMachines ? Bucket.Cursor : (Bucket.Cursor + Offset) % NumMachines;
+
+    Bucket.Machines.Insert(Machine, MachineIndex);
+
+    if (MachineIndex <= Bucket.Cursor)
+    {
+        Bucket.Cursor++;
+    }
+}
+
+void UProductionSubsystem::PruneEmptyBuckets()
+{
+    for (int32 BucketIndex = this->Buckets.Num() - 1; BucketIndex >= 0; BucketIndex--)
+    {
+        if (this->Buckets[BucketIndex].Machines.Num() > 0)
+        {
+            continue;
+        }
+
+        const int32 LastBucketIndex = this->Buckets.Num() - 1;
+
+        this->Buckets.RemoveAtSwap(BucketIndex);
+
+        if (BucketIndex == LastBucketIndex)
+        {
+            continue;
+        }
+
+        // The last bucket moved into the removed one's place, its machines follow it
+        for (TPair<const UActorComponent*, int32>& MachineBucket : this->MachineBuckets)
+        {
+            if (MachineBucket.Value == LastBucketIndex)
+            {
+                MachineBucket.Value = BucketIndex;
+            }
+        }
+    }
+}
+
+void UProductionSubsystem::RemoveMachineAt(FProductionBucket& Bucket, int32 MachineIndex)
+{
+    // Removing keeps the cyclic order, the cursor only moves with the machines behind it
+    Bucket.Machines.RemoveAt(MachineIndex);
+
+    if (MachineIndex < Bucket.Cursor)
+    {
+        Bucket.Cursor--;
+    }
+
+    if (Bucket.Cursor >= Bucket.Machines.Num())
+    {
+        Bucket.Cursor = 0;
+    }
+}
@@ -0,0 +1,401 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Inventory/RecipeRegistrySubsystem.h"
+
+#include "Inventory/ItemRegistrySubsystem.h"
+
+#include "AssetRegistry/IAssetRegistry.h"
+
+URecipeRegistrySubsystem* URecipeRegistrySubsystem::Instance = nullptr;
+
+namespace RecipeRegistry
+{
+    template <typename RecipeType>
+    void AddToIndex(TMap<uint16, TArray<RecipeType*>>& Index, uint16 ItemId, RecipeType* Recipe)
+    {
+        Index.FindOrAdd(ItemId).AddUnique(Recipe);
+    }
+
+    template <typename RecipeType>
+    void RemoveFromIndex(TMap<uint16, TArray<RecipeType*>>& Index, uint16 ItemId, RecipeType* Recipe)
+    {
+        if (TArray<RecipeType*>* Recipes = Index.Find(ItemId))
+        {
+            Recipes->Remove(Recipe);
+
+            if (Recipes->Num() == 0)
+            {
+                Index.Remove(ItemId);
+            }
+        }
+    }
+
+    template <typename RecipeType>
+    TArray<RecipeType*> FindInIndex(const TMap<uint16, TArray<RecipeType*>>& Index, UItemDataAsset* Item)
+    {
+        const TArray<RecipeType*>* Recipes = Index.Find(UItemRegistrySubsystem::GetItemId(Item));
+
+        return Recipes ? *Recipes : TArray<RecipeType*>();
+    }
+}
+
+void URecipeRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    Instance = this;
+
+    IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+
+    // In the editor the asset registry is still gathering on startup
+    if (AssetRegistry.IsLoadingAssets())
+    {
+        AssetRegistry.OnFilesLoaded().AddUObject(this, &URecipeRegistrySubsystem::ScanRecipeAssets);
+    }
+    else
+    {
+        this->ScanRecipeAssets();
+    }
+}
+
+void URecipeRegistrySubsystem::Deinitialize()
+{
+    if (IAssetRegistry* AssetRegistry = IAssetRegistry::Get())
+    {
+        AssetRegistry->OnFilesLoaded().RemoveAll(this);
+        AssetRegistry->OnAssetAdded().RemoveAll(this);
+        AssetRegistry->OnAssetRemoved().RemoveAll(this);
+        AssetRegistry->OnAssetRenamed().RemoveAll(this);
+    }
+
+    if (Instance == this)
+    {
+        Instance = nullptr;
+    }
+
+    Super::Deinitialize();
+}
+
+UBuildingRecipeDataAsset* URecipeRegistrySubsystem::GetBuildingRecipe(TSubclassOf<ABuildable> BuildableClass) const
+{
+    if (!BuildableClass)
+    {
+        UE_LOG(LogRecipeRegistry, Error, TEXT("%hs : BuildableClass is nullptr"), __FUNCTION__);
+        return nullptr;
+    }
+
+    return this->BuildingRecipesByClass.FindRef(BuildableClass->GetClassPathName());
+}
+
+TArray<UItemRecipeDataAsset*> URecipeRegistrySubsystem::GetRecipesConsuming(UItemDataAsset* Item) const
+{
+    return RecipeRegistry::FindInIndex(this->ItemRecipesByInput, Item);
+}
+
+TArray<UItemRecipeDataAsset*> URecipeRegistrySubsystem::GetRecipesProducing(UItemDataAsset* Item) const
+{
+    return RecipeRegistry::FindInIndex(this->ItemRecipesByOutput, Item);
+}
+
+TArray<UBuildingRecipeDataAsset*> URecipeRegistrySubsystem::GetBuildingRecipesConsuming(UItemDataAsset* Item) const
+{
+    return RecipeRegistry::FindInIndex(this->BuildingRecipesByInput, Item);
+}
+
+void URecipeRegistrySubsystem::RegisterItemRecipe(UItemRecipeDataAsset* Recipe)
+{
+    if (!Recipe)
+    {
+        return;
+    }
+
+    this->ItemRecipes.AddUnique(Recipe);
+
+    // The recipe's items may have changed since it was indexed, so drop it by the keys it was indexed with
+    this->UnindexItemRecipe(Recipe);
+    this->IndexItemRecipe(Recipe);
+
+    this->OnRecipesChanged.Broadcast();
+}
+
+void URecipeRegistrySubsystem::RegisterBuildingRecipe(UBuildingRecipeDataAsset* Recipe)
+{
+    if (!Recipe)
+    {
+        return;
+    }
+
+    this->BuildingRecipes.AddUnique(Recipe);
+
+    this->UnindexBuildingRecipe(Recipe);
+    this->IndexBuildingRecipe(Recipe);
+
+    this->OnRecipesChanged.Broadcast();
+}
+
+void URecipeRegistrySubsystem::UnregisterRecipe(UObject* Recipe)
+{
+    if (UItemRecipeDataAsset* ItemRecipe = Cast<UItemRecipeDataAsset>(Recipe))
+    {
+        this->UnindexItemRecipe(ItemRecipe);
+        this->ItemRecipes.Remove(ItemRecipe);
+    }
+    else if (UBuildingRecipeDataAsset* BuildingRecipe = Cast<UBuildingRecipeDataAsset>(Recipe))
+    {
+        this->UnindexBuildingRecipe(BuildingRecipe);
+        this->BuildingRecipes.Remove(BuildingRecipe);
+    }
+    else
+    {
+        return;
+    }
+
+    this->OnRecipesChanged.Broadcast();
+}
+
+void URecipeRegistrySubsystem::ScanRecipeAssets()
+{
+    IAssetRegistry& AssetRegistry = IAssetRegistry::GetChecked();
+
+    AssetRegistry.OnFilesLoaded().RemoveAll(this);
+
+    const FName PackageName             = TEXT("/Script/JCore");
+    const FName ItemRecipeAssetName     = TEXT("ItemRecipeDataAsset");
+    const FName BuildingRecipeAssetName = TEXT("BuildingRecipeDataAsset");
+
+    TArray<FAssetData> AssetData;
+
+    AssetRegistry.GetAssetsByClass(FTopLevelAssetPath(PackageName, ItemRecipeAssetName), AssetData, true);
+    AssetRegistry.GetAssetsByClass(FTopLevelAssetPath(PackageName, BuildingRecipeAssetName), AssetData, true);
+
+    TArray<FSoftObjectPath> RecipePaths;
+    RecipePaths.Reserve(AssetData.Num());
+
+    for (const FAssetData& Asset : AssetData)
+    {
+        RecipePaths.Add(Asset.GetSoftObjectPath());
+    }
+
+    this->LoadRecipeAssets(RecipePaths);
+
+    // Everything found so far is covered by the scan, from here on follow the registry
+    AssetRegistry.OnAssetAdded().AddUObject(this, &URecipeRegistrySubsystem::HandleAssetAdded);
+    AssetRegistry.OnAssetRemoved().AddUObject(this, &URecipeRegistrySubsystem::HandleAssetRemoved);
+    AssetRegistry.OnAssetRenamed().AddUObject(this, &URecipeRegistrySubsystem::HandleAssetRenamed);
+}
+
+void URecipeRegistrySubsystem::LoadRecipeAssets(const TArray<FSoftObjectPath>& RecipePaths)
+{
+    if (RecipePaths.Num() == 0)
+    {
+        return;
+    }
+
+    this->StreamableManager.RequestAsyncLoad(
+        RecipePaths,
+        FStreamableDelegate::CreateUObject(this, &URecipeRegistrySubsystem::HandleRecipeAssetsLoaded, RecipePaths));
+}
+
+void URecipeRegistrySubsystem::HandleRecipeAssetsLoaded(TArray<FSoftObjectPath> RecipePaths)
+{
+    int32 NumRegistered = 0;
+
+    for (const FSoftObjectPath& RecipePath : RecipePaths)
+    {
+        if (this->AddRecipe(RecipePath.ResolveObject()))
+        {
+            NumRegistered++;
+        }
+        else
+        {
+            UE_LOG(LogRecipeRegistry, Warning, TEXT("%hs : Failed to load recipe '%s'"), __FUNCTION__, *RecipePath.ToString());
+        }
+    }
+
+    UE_LOG(LogRecipeRegistry, Log, TEXT("%hs : Registered %d recipes, %d item recipes and %d building recipes in total"),
+           __FUNCTION__, NumRegistered, this->ItemRecipes.Num(), this->BuildingRecipes.Num());
+
+    this->OnRecipesChanged.Broadcast();
+}
+
+bool URecipeRegistrySubsystem::AddRecipe(UObject* RecipeAsset)
+{
+    if (UItemRecipeDataAsset* ItemRecipe = Cast<UItemRecipeDataAsset>(RecipeAsset))
+    {
+        this->ItemRecipes.AddUnique(ItemRecipe);
+        this->UnindexItemRecipe(ItemRecipe);
+        this->IndexItemRecipe(ItemRecipe);
+        return true;
+    }
+
+    if (UBuildingRecipeDataAsset* BuildingRecipe = Cast<UBuildingRecipeDataAsset>(RecipeAsset))
+    {
+        this->BuildingRecipes.AddUnique(BuildingRecipe);
+        this->UnindexBuildingRecipe(BuildingRecipe);
+        this->IndexBuildingRecipe(BuildingRecipe);
+        return true;
+    }
+
+    return false;
+}
+
+void URecipeRegistrySubsystem::HandleAssetAdded(const FAssetData& AssetData)
+{
+    if (!AssetData.IsInstanceOf(UItemRecipeDataAsset::StaticClass()) && !AssetData.IsInstanceOf(UBuildingRecipeDataAsset::StaticClass()))
+    {
+        return;
+    }
+
+    this->LoadRecipeAssets({ AssetData.GetSoftObjectPath() });
+}
+
+void URecipeRegistrySubsystem::HandleAssetRemoved(const FAssetData& AssetData)
+{
+    // Don't load the asset just to drop it, a recipe that isn't loaded was never registered
+    this->UnregisterRecipe(AssetData.GetSoftObjectPath().ResolveObject());
+}
+
+void URecipeRegistrySubsystem::HandleAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath)
+{
+    // Recipes are indexed by object, so only a renamed buildable class leaves a stale key behind
+    const FName OldPackageName = FSoftObjectPath(OldObjectPath).GetLongPackageFName();
+
+    TArray<UBuildingRecipeDataAsset*> StaleRecipes;
+
+    for (UBuildingRecipeDataAsset* Recipe : this->BuildingRecipes)
+    {
+        const FRegisteredRecipeKeys* Keys = this->RegisteredKeys.Find(Recipe);
+
+        if (Keys && Keys->OutBuildableClass.IsValid() && Keys->OutBuildableClass.GetPackageName() == OldPackageName)
+        {
+            StaleRecipes.Add(Recipe);
+        }
+    }
+
+    if (StaleRecipes.Num() == 0)
+    {
+        return;
+    }
+
+    // Drop all of them before re-indexing, so none gets promoted under the old key
+    for (UBuildingRecipeDataAsset* Recipe : StaleRecipes)
+    {
+        this->UnindexBuildingRecipe(Recipe);
+    }
+
+    for (UBuildingRecipeDataAsset* Recipe : StaleRecipes)
+    {
+        this->IndexBuildingRecipe(Recipe);
+    }
+
+    this->OnRecipesChanged.Broadcast();
+}
+
+void URecipeRegistrySubsystem::IndexItemRecipe(UItemRecipeDataAsset* Recipe)
+{
+    FRegisteredRecipeKeys& Keys = this->RegisteredKeys.Add(Recipe);
+
+    for (const TPair<UItemDataAsset*, int32> Item : Recipe->GetInItems())
+    {
+        if (!Item.Key) continue;
+
+        const uint16 ItemId = UItemRegistrySubsystem::GetItemId(Item.Key);
+
+        RecipeRegistry::AddToIndex(this->ItemRecipesByInput, ItemId, Recipe);
+        Keys.InItemIds.Add(ItemId);
+    }
+
+    for (const TPair<UItemDataAsset*, int32> Item : Recipe->GetOutItems())
+    {
+        if (!Item.Key) continue;
+
+        const uint16 ItemId = UItemRegistrySubsystem::GetItemId(Item.Key);
+
+        RecipeRegistry::AddToIndex(this->ItemRecipesByOutput, ItemId, Recipe);
+        Keys.OutItemIds.Add(ItemId);
+    }
+}
+
+void URecipeRegistrySubsystem::UnindexItemRecipe(UItemRecipeDataAsset* Recipe)
+{
+    FRegisteredRecipeKeys Keys;
+
+    if (!this->RegisteredKeys.RemoveAndCopyValue(Recipe, Keys))
+    {
+        return;
+    }
+
+    for (const uint16 ItemId : Keys.InItemIds)
+    {
+        RecipeRegistry::RemoveFromIndex(this->ItemRecipesByInput, ItemId, Recipe);
+    }
+
+    for (const uint16 ItemId : Keys.OutItemIds)
+    {
+        RecipeRegistry::RemoveFromIndex(this->ItemRecipesByOutput, ItemId, Recipe);
+    }
+}
+
+void URecipeRegistrySubsystem::IndexBuildingRecipe(UBuildingRecipeDataAsset* Recipe)
+{
+    FRegisteredRecipeKeys& Keys = this->RegisteredKeys.Add(Recipe);
+
+    for (const TPair<UItemDataAsset*, int32>& Item : Recipe->GetInItems())
+    {
+        if (!Item.Key) continue;
+
+        const uint16 ItemId = UItemRegistrySubsystem::GetItemId(Item.Key);
+
+        RecipeRegistry::AddToIndex(this->BuildingRecipesByInput, ItemId, Recipe);
+        Keys.InItemIds.Add(ItemId);
+    }
+
+    if (Recipe->GetOutBuilding() && Recipe->GetOutBuilding()->GetBuildableClass())
+    {
+        const FTopLevelAssetPath BuildableClass = Recipe->GetOutBuilding()->GetBuildableClass()->GetClassPathName();
+
+        // Like the old scan, the first recipe found for a class wins
+        if (!this->BuildingRecipesByClass.Contains(BuildableClass))
+        {
+            this->BuildingRecipesByClass.Add(BuildableClass, Recipe);
+        }
+
+        Keys.OutBuildableClass = BuildableClass;
+    }
+}
+
+void URecipeRegistrySubsystem::UnindexBuildingRecipe(UBuildingRecipeDataAsset* Recipe)
+{
+    FRegisteredRecipeKeys Keys;
+
+    if (!this->RegisteredKeys.RemoveAndCopyValue(Recipe, Keys))
+    {
+        return;
+    }
+
+    for (const uint16 ItemId : Keys.InItemIds)
+    {
+        RecipeRegistry::RemoveFromIndex(this->BuildingRecipesByInput, ItemId, Recipe);
+    }
+
+    if (!Keys.OutBuildableClass.IsValid() || this->BuildingRecipesByClass.FindRef(Keys.OutBuildableClass) != Recipe)
+    {
+        return;
+    }
+
+    this->BuildingRecipesByClass.Remove(Keys.OutBuildableClass);
+
+    // Promote the next recipe building the same class, in registration order like the scan
+    for (UBuildingRecipeDataAsset* OtherRecipe : this->BuildingRecipes)
+    {
+        if (OtherRecipe == Recipe) continue;
+
+        const FRegisteredRecipeKeys* OtherKeys = this->RegisteredKeys.Find(OtherRecipe);
+
+        if (OtherKeys && OtherKeys->OutBuildableClass == Keys.OutBuildableClass)
+        {
+            this->BuildingRecipesByClass.Add(Keys.OutBuildableClass, OtherRecipe);
+            break;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Building/Buildable.h"
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Engine/World.h"
+
+BEGIN_DEFINE_SPEC(FBuildableSpec, "JCore.Building.Buildable",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UWorld* World;
+ABuildable* Buildable;
+
+END_DEFINE_SPEC(FBuildableSpec)
+
+void FBuildableSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        World = FJCoreSpecUtils::CreateWorld();
+
+        Buildable = World->SpawnActor<ABuildable>(FVector::ZeroVector, FRotator::ZeroRotator);
+        Buildable->SetSnapTransformsOfType(EBuildingSnapType::Floor, {FTransform(FVector(100.0, 0.0, 0.0))});
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::DestroyWorld(World);
+    });
+
+    Describe("GetWorldSnapTransformsOfType", [this]()
+    {
+        It("Transform the snap transforms to world space", [this]()
+        {
+            Buildable->SetActorLocationAndRotation(FVector(0.0, 500.0, 0.0), FRotator(0.0, 90.0, 0.0));
+
+            const TArrayView<const FTransform> SnapTransforms = Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor);
+
+            TestEqual(TEXT("One snap transform"), SnapTransforms.Num(), 1);
+            TestTrue(TEXT("Turned and moved with the buildable"), SnapTransforms[0].GetLocation().Equals(FVector(0.0, 600.0, 0.0), 0.01));
+        });
+
+        It("Follow the buildable when it moves", [this]()
+        {
+            TestTrue(TEXT("At the first location"), Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor)[0].GetLocation().Equals(FVector(100.0, 0.0, 0.0), 0.01));
+
+            Buildable->SetActorLocation(FVector(0.0, 0.0, 300.0));
+
+            TestTrue(TEXT("At the moved location"), Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor)[0].GetLocation().Equals(FVector(100.0, 0.0, 300.0), 0.01));
+        });
+
+        It("Follow the snap transforms when they are set", [this]()
+        {
+            TestEqual(TEXT("One snap transform"), Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor).Num(), 1);
+
+            Buildable->SetSnapTransformsOfType(EBuildingSnapType::Floor, {FTransform(FVector(0.0, 100.0, 0.0)), FTransform(FVector(0.0, -100.0, 0.0))});
+
+            const TArrayView<const FTransform> SnapTransforms = Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor);
+
+            TestEqual(TEXT("Two snap transforms"), SnapTransforms.Num(), 2);
+            TestTrue(TEXT("The new snap transform"), SnapTransforms[0].GetLocation().Equals(FVector(0.0, 100.0, 0.0), 0.01));
+        });
+
+        It("Reuse the cached array when it is rebuilt", [this]()
+        {
+            const FTransform* CachedData = Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor).GetData();
+
+            Buildable->SetActorLocation(FVector(0.0, 0.0, 300.0));
+
+            TestTrue(TEXT("Same storage after the move"), Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor).GetData() == CachedData);
+        });
+
+        It("Match the copies of GetSnapTransformsOfType", [this]()
+        {
+            Buildable->SetActorLocation(FVector(0.0, 0.0, 300.0));
+
+            TArray<FTransform> CopiedSnapTransforms;
+            Buildable->GetSnapTransformsOfType(EBuildingSnapType::Floor, CopiedSnapTransforms);
+
+            const TArrayView<const FTransform> SnapTransforms = Buildable->GetWorldSnapTransformsOfType(EBuildingSnapType::Floor);
+
+            TestEqual(TEXT("Same number"), CopiedSnapTransforms.Num(), SnapTransforms.Num());
+            TestTrue(TEXT("Same location"), CopiedSnapTransforms[0].GetLocation().Equals(SnapTransforms[0].GetLocation()));
+        });
+    });
+}
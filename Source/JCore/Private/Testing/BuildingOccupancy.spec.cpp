@@ -0,0 +1,98 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Building/Buildable.h"
+#include "Building/BuildingOccupancySubsystem.h"
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Engine/World.h"
+
+BEGIN_DEFINE_SPEC(FBuildingOccupancySpec, "JCore.Building.Occupancy",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UWorld* World;
+UBuildingOccupancySubsystem* Occupancy;
+
+/** Spawns a finished buildable and adds its footprint, which is stored at the full given size */
+ABuildable* CreateBuildable(const FVector& Location, double Yaw, const FVector& Size);
+
+END_DEFINE_SPEC(FBuildingOccupancySpec)
+
+ABuildable* FBuildingOccupancySpec::CreateBuildable(const FVector& Location, double Yaw, const FVector& Size)
+{
+    ABuildable* Buildable = World->SpawnActor<ABuildable>(Location, FRotator(0.0, Yaw, 0.0));
+
+    Buildable->SetSize(Size);
+
+    return Buildable;
+}
+
+void FBuildingOccupancySpec::Define()
+{
+    BeforeEach([this]()
+    {
+        World = FJCoreSpecUtils::CreateWorld();
+
+        Occupancy = World->GetSubsystem<UBuildingOccupancySubsystem>();
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::DestroyWorld(World);
+    });
+
+    Describe("QueryFootprint", [this]()
+    {
+        It("Answer aligned footprints exactly", [this]()
+        {
+            // Footprint of 100 x 100 x 100 around the origin
+            ABuildable* Buildable = CreateBuildable(FVector::ZeroVector, 0.0, FVector(100.0));
+
+            const FVector HalfExtents(10.0);
+
+            TestEqual(TEXT("Occupied over it"), Occupancy->QueryFootprint(FVector(30.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Occupied);
+            TestEqual(TEXT("Free next to it in the same cell"), Occupancy->QueryFootprint(FVector(62.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Free);
+            TestEqual(TEXT("Free in another cell"), Occupancy->QueryFootprint(FVector(300.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Free);
+            TestEqual(TEXT("Free for the buildable itself"), Occupancy->QueryFootprint(FVector::ZeroVector, FQuat::Identity, HalfExtents, Buildable), EBuildingOccupancy::Free);
+        });
+
+        It("Answer footprints rotated by quarter turns exactly", [this]()
+        {
+            // Footprint of 200 x 100 x 100 turned to lie along the Y axis
+            CreateBuildable(FVector::ZeroVector, 90.0, FVector(200.0, 100.0, 100.0));
+
+            const FVector HalfExtents(10.0);
+
+            TestEqual(TEXT("Occupied along its turned length"), Occupancy->QueryFootprint(FVector(0.0, 60.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Occupied);
+            TestEqual(TEXT("Free along its unturned length"), Occupancy->QueryFootprint(FVector(70.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Free);
+
+            // Turned a quarter, the query reaches from 60 to 140 on the Y axis and 10 on either side on the X axis
+            const FQuat QuarterTurn(FRotator(0.0, -90.0, 0.0));
+
+            TestEqual(TEXT("Occupied by a turned query"), Occupancy->QueryFootprint(FVector(0.0, 100.0, 0.0), QuarterTurn, FVector(40.0, 10.0, 10.0)), EBuildingOccupancy::Occupied);
+            TestEqual(TEXT("Free for a turned query beside it"), Occupancy->QueryFootprint(FVector(70.0, 100.0, 0.0), QuarterTurn, FVector(40.0, 10.0, 10.0)), EBuildingOccupancy::Free);
+        });
+
+        It("Cushion only the querying footprint", [this]()
+        {
+            ABuildable* Buildable = CreateBuildable(FVector::ZeroVector, 0.0, FVector(100.0));
+
+            // A neighbor of the same size checks with 3/8 of the size, so it overlaps until it is 7/8 of the size away
+            const FVector HalfExtents = Buildable->GetOverlapHalfExtents();
+
+            TestEqual(TEXT("Occupied between 3/4 and 7/8 of the size away"), Occupancy->QueryFootprint(FVector(80.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Occupied);
+            TestEqual(TEXT("Free past 7/8 of the size away"), Occupancy->QueryFootprint(FVector(90.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Free);
+            TestEqual(TEXT("Free for a neighbor sharing an edge"), Occupancy->QueryFootprint(FVector(100.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Free);
+        });
+
+        It("Leave footprints that are not aligned to a physics overlap", [this]()
+        {
+            CreateBuildable(FVector::ZeroVector, 45.0, FVector(100.0));
+
+            const FVector HalfExtents(10.0);
+
+            TestEqual(TEXT("Unknown over an unaligned footprint"), Occupancy->QueryFootprint(FVector(30.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Unknown);
+            TestEqual(TEXT("Free away from an unaligned footprint"), Occupancy->QueryFootprint(FVector(300.0, 0.0, 0.0), FQuat::Identity, HalfExtents), EBuildingOccupancy::Free);
+            TestEqual(TEXT("Unknown for an unaligned query"), Occupancy->QueryFootprint(FVector(300.0, 0.0, 0.0), FQuat(FRotator(0.0, 30.0, 0.0)), HalfExtents), EBuildingOccupancy::Unknown);
+        });
+    });
+}
@@ -0,0 +1,135 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Building/ConveyorComponent.h"
+#include "Building/ConveyorSubsystem.h"
+
+BEGIN_DEFINE_SPEC(FConveyorSegmentSpec, "JCore.Building.ConveyorSegment",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+FConveyorSegment Segment;
+
+END_DEFINE_SPEC(FConveyorSegmentSpec)
+
+void FConveyorSegmentSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Segment = FConveyorSegment();
+        Segment.Length      = 100.f;
+        Segment.Speed       = 10.f;
+        Segment.ItemSpacing = 10.f;
+        Segment.TailGap     = Segment.Length;
+    });
+
+    Describe("Advance", [this]()
+    {
+        It("Move an item towards the end by the distance", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(30.f);
+
+            TestEqual(TEXT("Gap to the end"), Segment.Gaps[Segment.FrontIndex], 70.f);
+            TestEqual(TEXT("Tail gap"), Segment.TailGap, 30.f);
+            TestFalse(TEXT("Not at the end"), Segment.IsFrontAtEnd());
+        });
+
+        It("Queue the items at the end, each the spacing behind the one ahead", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(30.f);
+            Segment.PushBack(2);
+            Segment.Advance(100.f);
+
+            TestTrue(TEXT("Front at the end"), Segment.IsFrontAtEnd());
+            TestEqual(TEXT("Second item at the spacing"), Segment.Gaps[Segment.FrontIndex + 1], 10.f);
+            TestEqual(TEXT("Tail gap"), Segment.TailGap, 90.f);
+        });
+
+        It("Not move queued items further", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(100.f);
+            Segment.PushBack(2);
+            Segment.Advance(200.f);
+            Segment.Advance(50.f);
+
+            TestEqual(TEXT("Front gap"), Segment.Gaps[Segment.FrontIndex], 0.f);
+            TestEqual(TEXT("Second gap"), Segment.Gaps[Segment.FrontIndex + 1], 10.f);
+            TestEqual(TEXT("Tail gap"), Segment.TailGap, 90.f);
+        });
+    });
+
+    Describe("PopFront", [this]()
+    {
+        It("Return the front item and give its gap to the next item", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(30.f);
+            Segment.PushBack(2);
+            Segment.Advance(60.f);
+
+            TestEqual(TEXT("Return the front item"), Segment.PopFront(), static_cast<uint16>(1));
+            TestEqual(TEXT("One item left"), Segment.GetNumItems(), 1);
+            TestEqual(TEXT("Gap to the end"), Segment.Gaps[Segment.FrontIndex], 40.f);
+        });
+
+        It("Let the items queued behind it move up", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(30.f);
+            Segment.PushBack(2);
+            Segment.Advance(100.f);
+            Segment.PopFront();
+            Segment.Advance(5.f);
+
+            TestEqual(TEXT("Gap to the end"), Segment.Gaps[Segment.FrontIndex], 5.f);
+            TestEqual(TEXT("Tail gap"), Segment.TailGap, 95.f);
+        });
+
+        It("Give the last item's gap back to the tail", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(60.f);
+            Segment.PopFront();
+
+            TestEqual(TEXT("No items left"), Segment.GetNumItems(), 0);
+            TestEqual(TEXT("Tail gap is the length"), Segment.TailGap, 100.f);
+            TestTrue(TEXT("Can push back"), Segment.CanPushBack());
+        });
+    });
+
+    Describe("ApplyEventItems", [this]()
+    {
+        It("Pop and push the items of an event in order", [this]()
+        {
+            Segment.PushBack(1);
+            Segment.Advance(100.f);
+            Segment.PushBack(2);
+            Segment.Advance(20.f);
+
+            FConveyorSegmentEvent Event;
+            Event.NumPopped     = 1;
+            Event.PushedItemIds = {3, 4};
+
+            Segment.ApplyEventItems(Event);
+
+            TestEqual(TEXT("Three items"), Segment.GetNumItems(), 3);
+            TestEqual(TEXT("Second item at the front"), Segment.ItemIds[Segment.FrontIndex], static_cast<uint16>(2));
+            TestEqual(TEXT("Pushed items last"), Segment.ItemIds.Last(), static_cast<uint16>(4));
+            TestEqual(TEXT("Tail gap"), Segment.TailGap, 0.f);
+        });
+
+        It("Not pop more items than the belt has", [this]()
+        {
+            Segment.PushBack(1);
+
+            FConveyorSegmentEvent Event;
+            Event.NumPopped = 3;
+
+            Segment.ApplyEventItems(Event);
+
+            TestEqual(TEXT("No items left"), Segment.GetNumItems(), 0);
+            TestEqual(TEXT("Tail gap is the length"), Segment.TailGap, 100.f);
+        });
+    });
+}
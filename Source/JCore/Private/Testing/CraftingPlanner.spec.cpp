@@ -0,0 +1,136 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Inventory/CraftingPlannerSubsystem.h"
+#include "Inventory/InventoryComponent.h"
+#include "Inventory/ItemRegistrySubsystem.h"
+#include "Testing/JCoreSpecUtils.h"
+
+BEGIN_DEFINE_SPEC(FCraftingPlannerSpec, "JCore.Inventory.CraftingPlanner",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UItemDataAsset* Ore;
+UItemDataAsset* Plate;
+UItemDataAsset* Slag;
+UItemDataAsset* Gear;
+UInventoryComponent* TestInventoryComponent;
+UCraftingPlannerSubsystem* Planner;
+
+END_DEFINE_SPEC(FCraftingPlannerSpec)
+
+void FCraftingPlannerSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Ore   = FJCoreSpecUtils::CreateItem();
+        Plate = FJCoreSpecUtils::CreateItem();
+        Slag  = FJCoreSpecUtils::CreateItem();
+        Gear  = FJCoreSpecUtils::CreateItem();
+
+        TestInventoryComponent = NewObject<UInventoryComponent>();
+        TestInventoryComponent->SetNumberOfSlots(10);
+        TestInventoryComponent->InitializeInventorySlots();
+
+        Planner = NewObject<UCraftingPlannerSubsystem>();
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::ReleaseItems({Ore, Plate, Slag, Gear});
+    });
+
+    Describe("BuildCraftPlan", [this]()
+    {
+        It("Craft the intermediates first", [this]()
+        {
+            UItemRecipeDataAsset* PlateRecipe = FJCoreSpecUtils::CreateRecipe({{Ore, 2}}, {{Plate, 1}});
+            UItemRecipeDataAsset* GearRecipe  = FJCoreSpecUtils::CreateRecipe({{Plate, 2}}, {{Gear, 1}});
+
+            Planner->SetRecipes({PlateRecipe, GearRecipe});
+
+            TestInventoryComponent->AddItemAmount(Ore, 4);
+
+            FCraftingPlan Plan;
+
+            bool ReturnVal = Planner->BuildCraftPlan(GearRecipe, 1, TestInventoryComponent, Plan);
+
+            TestTrue(TEXT("Return true"), ReturnVal);
+            TestEqual(TEXT("Two steps"), Plan.Steps.Num(), 2);
+            TestTrue(TEXT("Plates first"), Plan.Steps[0].Recipe == PlateRecipe && Plan.Steps[0].NumCrafts == 2);
+            TestTrue(TEXT("Gear last"), Plan.Steps[1].Recipe == GearRecipe && Plan.Steps[1].NumCrafts == 1);
+        });
+
+        It("Output the raw items that are missing", [this]()
+        {
+            UItemRecipeDataAsset* PlateRecipe = FJCoreSpecUtils::CreateRecipe({{Ore, 2}}, {{Plate, 1}});
+            UItemRecipeDataAsset* GearRecipe  = FJCoreSpecUtils::CreateRecipe({{Plate, 2}}, {{Gear, 1}});
+
+            Planner->SetRecipes({PlateRecipe, GearRecipe});
+
+            TestInventoryComponent->AddItemAmount(Ore, 1);
+
+            FCraftingPlan Plan;
+
+            bool ReturnVal = Planner->BuildCraftPlan(GearRecipe, 1, TestInventoryComponent, Plan);
+
+            TestFalse(TEXT("Return false"), ReturnVal);
+            TestEqual(TEXT("Missing ore"), Plan.MissingItems.FindRef(Ore), 3);
+        });
+    });
+
+    Describe("GetMaxPlannedCrafts", [this]()
+    {
+        It("Count the crafts the held raw items allow", [this]()
+        {
+            UItemRecipeDataAsset* PlateRecipe = FJCoreSpecUtils::CreateRecipe({{Ore, 2}}, {{Plate, 1}});
+            UItemRecipeDataAsset* GearRecipe  = FJCoreSpecUtils::CreateRecipe({{Plate, 2}}, {{Gear, 1}});
+
+            Planner->SetRecipes({PlateRecipe, GearRecipe});
+
+            TestInventoryComponent->AddItemAmount(Ore, 9);
+            TestInventoryComponent->AddItemAmount(Plate, 1);
+
+            TestEqual(TEXT("Return max crafts"), Planner->GetMaxPlannedCrafts(GearRecipe, TestInventoryComponent), 2);
+        });
+
+        It("Count byproducts of a recipe with several outputs", [this]()
+        {
+            UItemRecipeDataAsset* SplitRecipe = FJCoreSpecUtils::CreateRecipe({{Ore, 1}}, {{Plate, 2}, {Slag, 1}});
+            UItemRecipeDataAsset* GearRecipe  = FJCoreSpecUtils::CreateRecipe({{Plate, 1}, {Slag, 1}}, {{Gear, 1}});
+
+            Planner->SetRecipes({SplitRecipe, GearRecipe});
+
+            TestInventoryComponent->AddItemAmount(Ore, 3);
+
+            TestEqual(TEXT("Return max crafts"), Planner->GetMaxPlannedCrafts(GearRecipe, TestInventoryComponent), 3);
+        });
+    });
+
+    Describe("GetRawMaterials", [this]()
+    {
+        It("Expand a recipe cycle the same whichever item is expanded first", [this]()
+        {
+            UItemRecipeDataAsset* PlateRecipe = FJCoreSpecUtils::CreateRecipe({{Ore, 1}, {Slag, 1}}, {{Plate, 1}});
+            UItemRecipeDataAsset* SlagRecipe  = FJCoreSpecUtils::CreateRecipe({{Plate, 1}}, {{Slag, 2}});
+
+            const uint16 PlateId = UItemRegistrySubsystem::GetItemId(Plate);
+            const uint16 SlagId  = UItemRegistrySubsystem::GetItemId(Slag);
+
+            Planner->SetRecipes({PlateRecipe, SlagRecipe});
+
+            Planner->GetRawMaterials(PlateId);
+            const TMap<uint16, double> SlagAfterPlate = Planner->GetRawMaterials(SlagId);
+
+            UCraftingPlannerSubsystem* OtherPlanner = NewObject<UCraftingPlannerSubsystem>();
+            OtherPlanner->SetRecipes({PlateRecipe, SlagRecipe});
+
+            const TMap<uint16, double> SlagFirst = OtherPlanner->GetRawMaterials(SlagId);
+
+            TestEqual(TEXT("Same raw items"), SlagFirst.Num(), SlagAfterPlate.Num());
+
+            for (const TPair<uint16, double>& RawMaterial : SlagFirst)
+            {
+                TestEqual(TEXT("Same amount of each raw item"), SlagAfterPlate.FindRef(RawMaterial.Key), RawMaterial.Value);
+            }
+        });
+    });
+}
@@ -0,0 +1,287 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Inventory/CraftingComponent.h"
+#include "Inventory/CraftingSchedulerSubsystem.h"
+#include "Inventory/InventoryComponent.h"
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Engine/World.h"
+
+BEGIN_DEFINE_SPEC(FCraftingSchedulerSpec, "JCore.Inventory.CraftingScheduler",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UItemDataAsset* Ore;
+UItemDataAsset* Plate;
+UWorld* World;
+UCraftingSchedulerSubsystem* Scheduler;
+UCraftingComponent* Crafter;
+UInventoryComponent* SourceInventory;
+UInventoryComponent* TargetInventory;
+
+UItemRecipeDataAsset* CreateRecipe(float CraftTime);
+
+/** Creates an inventory with ten slots, owned by the crafter's owner when bOwnedByCrafter */
+UInventoryComponent* CreateInventory(bool bOwnedByCrafter);
+
+/** Sets the world time and runs the scheduler on it, like a frame ending at Seconds */
+void AdvanceTo(double Seconds);
+
+END_DEFINE_SPEC(FCraftingSchedulerSpec)
+
+UItemRecipeDataAsset* FCraftingSchedulerSpec::CreateRecipe(float CraftTime)
+{
+    return FJCoreSpecUtils::CreateRecipe({{Ore, 1}}, {{Plate, 1}}, CraftTime);
+}
+
+UInventoryComponent* FCraftingSchedulerSpec::CreateInventory(bool bOwnedByCrafter)
+{
+    UInventoryComponent* Inventory = bOwnedByCrafter ? NewObject<UInventoryComponent>(Crafter->GetOwner()) : NewObject<UInventoryComponent>();
+    Inventory->SetNumberOfSlots(10);
+    Inventory->InitializeInventorySlots();
+
+    return Inventory;
+}
+
+void FCraftingSchedulerSpec::AdvanceTo(double Seconds)
+{
+    World->TimeSeconds = Seconds;
+
+    Scheduler->Tick(0.f);
+}
+
+void FCraftingSchedulerSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        Ore   = FJCoreSpecUtils::CreateItem();
+        Plate = FJCoreSpecUtils::CreateItem();
+
+        World = FJCoreSpecUtils::CreateWorld();
+
+        Scheduler = World->GetSubsystem<UCraftingSchedulerSubsystem>();
+
+        AActor* Owner = World->SpawnActor<AActor>();
+
+        Crafter = NewObject<UCraftingComponent>(Owner);
+        Crafter->RegisterComponent();
+
+        SourceInventory = CreateInventory(false);
+        SourceInventory->AddItemAmount(Ore, 10);
+
+        TargetInventory = CreateInventory(false);
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::DestroyWorld(World);
+        FJCoreSpecUtils::ReleaseItems({Ore, Plate});
+    });
+
+    Describe("Ordering", [this]()
+    {
+        It("Complete crafts when their time is reached", [this]()
+        {
+            Crafter->QueueCraft(CreateRecipe(2.f), SourceInventory, TargetInventory, 1);
+
+            AdvanceTo(1.9);
+
+            TestEqual(TEXT("Nothing crafted before the completion time"), TargetInventory->ContainsItem(Plate), 0);
+
+            AdvanceTo(2.0);
+
+            TestEqual(TEXT("Crafted at the completion time"), TargetInventory->ContainsItem(Plate), 1);
+            TestFalse(TEXT("Queue is empty"), Crafter->HasQueuedCrafts());
+        });
+
+        It("Complete the crafts of different crafters by completion time", [this]()
+        {
+            UCraftingComponent* OtherCrafter = NewObject<UCraftingComponent>(Crafter->GetOwner());
+            OtherCrafter->RegisterComponent();
+
+            UInventoryComponent* OtherTargetInventory = NewObject<UInventoryComponent>();
+            OtherTargetInventory->SetNumberOfSlots(10);
+            OtherTargetInventory->InitializeInventorySlots();
+
+            Crafter->QueueCraft(CreateRecipe(2.f), SourceInventory, TargetInventory, 1);
+            OtherCrafter->QueueCraft(CreateRecipe(1.f), SourceInventory, OtherTargetInventory, 1);
+
+            AdvanceTo(1.0);
+
+            TestEqual(TEXT("Later craft not completed"), TargetInventory->ContainsItem(Plate), 0);
+            TestEqual(TEXT("Earlier craft completed"), OtherTargetInventory->ContainsItem(Plate), 1);
+
+            AdvanceTo(2.0);
+
+            TestEqual(TEXT("Later craft completed"), TargetInventory->ContainsItem(Plate), 1);
+        });
+
+        It("Complete every craft that is due after a long frame", [this]()
+        {
+            Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 5);
+
+            AdvanceTo(3.5);
+
+            TestEqual(TEXT("Three crafts completed"), TargetInventory->ContainsItem(Plate), 3);
+            TestEqual(TEXT("Next craft continues from the last completion"), Crafter->GetQueueHead().CompletionTime, 4.0);
+            TestEqual(TEXT("One completion scheduled"), Scheduler->GetNumScheduledCrafts(), 1);
+        });
+
+        It("Start the next job when the previous one completed", [this]()
+        {
+            Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+            const int32 SecondJobId = Crafter->QueueCraft(CreateRecipe(2.f), SourceInventory, TargetInventory, 1);
+
+            AdvanceTo(1.0);
+
+            TestEqual(TEXT("First job crafted"), TargetInventory->ContainsItem(Plate), 1);
+            TestEqual(TEXT("Second job is the head"), Crafter->GetQueueHead().JobId, SecondJobId);
+            TestEqual(TEXT("Second job completes after its craft time"), Crafter->GetQueueHead().CompletionTime, 3.0);
+        });
+    });
+
+    Describe("CancelCraft", [this]()
+    {
+        It("Skip the scheduled completion of a cancelled head job", [this]()
+        {
+            const int32 JobId = Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 2);
+
+            AdvanceTo(0.5);
+
+            TestTrue(TEXT("Return true"), Crafter->CancelCraft(JobId));
+
+            AdvanceTo(3.0);
+
+            TestEqual(TEXT("Nothing crafted"), TargetInventory->ContainsItem(Plate), 0);
+            TestEqual(TEXT("Inputs kept"), SourceInventory->ContainsItem(Ore), 10);
+            TestEqual(TEXT("Stale completion popped"), Scheduler->GetNumScheduledCrafts(), 0);
+        });
+
+        It("Keep the head job when a queued job is cancelled", [this]()
+        {
+            Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+            const int32 SecondJobId = Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+
+            TestTrue(TEXT("Return true"), Crafter->CancelCraft(SecondJobId));
+
+            AdvanceTo(3.0);
+
+            TestEqual(TEXT("Only the head job crafted"), TargetInventory->ContainsItem(Plate), 1);
+        });
+
+        It("Return false for a job that is not queued", [this]()
+        {
+            TestFalse(TEXT("Return false"), Crafter->CancelCraft(42));
+        });
+    });
+
+    Describe("SetThroughputScale", [this]()
+    {
+        It("Pause the craft in progress at 0", [this]()
+        {
+            Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+
+            AdvanceTo(0.5);
+
+            Crafter->SetThroughputScale(0.f);
+
+            AdvanceTo(5.0);
+
+            TestEqual(TEXT("Nothing crafted while paused"), TargetInventory->ContainsItem(Plate), 0);
+            TestEqual(TEXT("Head shows no progress"), Crafter->GetCraftProgress(), 0.f);
+
+            Crafter->SetThroughputScale(1.f);
+
+            AdvanceTo(5.4);
+
+            TestEqual(TEXT("Remaining time not run yet"), TargetInventory->ContainsItem(Plate), 0);
+
+            AdvanceTo(5.5);
+
+            TestEqual(TEXT("Crafted after the remaining time"), TargetInventory->ContainsItem(Plate), 1);
+        });
+
+        It("Stretch the remaining time at a lower throughput", [this]()
+        {
+            Crafter->QueueCraft(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+
+            AdvanceTo(0.5);
+
+            Crafter->SetThroughputScale(0.5f);
+
+            TestEqual(TEXT("Completion moved out"), Crafter->GetQueueHead().CompletionTime, 1.5);
+            TestEqual(TEXT("Progress kept"), Crafter->GetCraftProgress(), 0.5f);
+
+            AdvanceTo(1.0);
+
+            TestEqual(TEXT("Not crafted at the old completion"), TargetInventory->ContainsItem(Plate), 0);
+
+            AdvanceTo(1.5);
+
+            TestEqual(TEXT("Crafted at the new completion"), TargetInventory->ContainsItem(Plate), 1);
+        });
+    });
+    Describe("ServerCraftRecipeBatch", [this]()
+    {
+        It("Refuse inventories the crafter may not change", [this]()
+        {
+            AddExpectedError(TEXT("may not change"), EAutomationExpectedErrorFlags::Contains, 1);
+
+            Crafter->ServerCraftRecipeBatch_Implementation(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+
+            TestEqual(TEXT("Nothing crafted"), TargetInventory->ContainsItem(Plate), 0);
+            TestEqual(TEXT("Inputs kept"), SourceInventory->ContainsItem(Ore), 10);
+        });
+
+        It("Clamp the count to the crafts the inventories allow", [this]()
+        {
+            UInventoryComponent* OwnedSourceInventory = CreateInventory(true);
+            UInventoryComponent* OwnedTargetInventory = CreateInventory(true);
+
+            OwnedSourceInventory->AddItemAmount(Ore, 10);
+
+            Crafter->ServerCraftRecipeBatch_Implementation(CreateRecipe(1.f), OwnedSourceInventory, OwnedTargetInventory, 1000);
+
+            TestEqual(TEXT("Crafted as often as the inputs allow"), OwnedTargetInventory->ContainsItem(Plate), 10);
+            TestEqual(TEXT("Inputs used up"), OwnedSourceInventory->ContainsItem(Ore), 0);
+        });
+    });
+    Describe("ServerQueueCraft", [this]()
+    {
+        It("Refuse inventories the crafter may not change", [this]()
+        {
+            AddExpectedError(TEXT("may not change"), EAutomationExpectedErrorFlags::Contains, 1);
+
+            Crafter->ServerQueueCraft_Implementation(CreateRecipe(1.f), SourceInventory, TargetInventory, 1);
+
+            TestFalse(TEXT("Nothing queued"), Crafter->HasQueuedCrafts());
+        });
+
+        It("Clamp the crafts of a job", [this]()
+        {
+            UInventoryComponent* OwnedSourceInventory = CreateInventory(true);
+            UInventoryComponent* OwnedTargetInventory = CreateInventory(true);
+
+            Crafter->ServerQueueCraft_Implementation(CreateRecipe(1.f), OwnedSourceInventory, OwnedTargetInventory, MAX_int32);
+
+            TestTrue(TEXT("Job queued"), Crafter->HasQueuedCrafts());
+            TestTrue(TEXT("Crafts clamped"), Crafter->GetQueueHead().NumCrafts < MAX_int32);
+        });
+
+        It("Queue no more jobs than allowed", [this]()
+        {
+            UInventoryComponent* OwnedSourceInventory = CreateInventory(true);
+            UInventoryComponent* OwnedTargetInventory = CreateInventory(true);
+
+            UItemRecipeDataAsset* Recipe = CreateRecipe(1.f);
+
+            AddExpectedError(TEXT("jobs queued"), EAutomationExpectedErrorFlags::Contains, 0);
+
+            for (int32 i = 0; i < 1000; i++)
+            {
+                Crafter->ServerQueueCraft_Implementation(Recipe, OwnedSourceInventory, OwnedTargetInventory, 1);
+            }
+
+            TestTrue(TEXT("Queue capped"), Crafter->GetQueueHead().NumQueuedJobs < 1000);
+        });
+    });
+}
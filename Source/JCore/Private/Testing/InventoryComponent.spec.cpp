@@ -1,5 +1,6 @@
 ﻿#include "Misc/AutomationTest.h"
 
+#include "Inventory/FactorySimulation.h"
 #include "Inventory/InventoryComponent.h"
 
 BEGIN_DEFINE_SPEC(FInventoryComponentSpec, "JCore.Inventory",
@@ -37,12 +38,25 @@ void FInventoryComponentSpec::Define()
 
         It("Output number of items in 1 stack", [this]()
         {
-            TestInventoryComponent->GetInventorySlots()[5] = FInventorySlot(TestItemAsset, 4);
+            TestInventoryComponent->SetInventorySlot(5, FInventorySlot(TestItemAsset, 4));
 
             int32 ReturnVal = TestInventoryComponent->ContainsItem(TestItemAsset);
 
             TestEqual(TEXT("Return correct amount"), ReturnVal, 4);
         });
+
+        It("Count a slot that only sets the item", [this]()
+        {
+            // As the Blueprint Make node leaves it
+            FInventorySlot MadeSlot;
+            MadeSlot.Item             = TestItemAsset;
+            MadeSlot.CurrentStackSize = 3;
+
+            TestInventoryComponent->SetInventorySlot(2, MadeSlot);
+
+            TestEqual(TEXT("Return correct amount"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+            TestFalse(TEXT("Slot not empty"), FInventorySlot::IsSlotEmpty(TestInventoryComponent->GetInventorySlot(2)));
+        });
     });
 
     Describe("HasAvailableSpaceForItem", [this]()
@@ -60,7 +74,7 @@ void FInventoryComponentSpec::Define()
         {
             TestInventoryComponent->SetNumberOfSlots(1);
             TestInventoryComponent->InitializeInventorySlots();
-            TestInventoryComponent->GetInventorySlots()[0] = FInventorySlot(TestItemAsset, TestItemAsset->GetMaxStackSize());
+            TestInventoryComponent->SetInventorySlot(0, FInventorySlot(TestItemAsset, TestItemAsset->GetMaxStackSize()));
 
             bool ReturnVal = TestInventoryComponent->HasAvailableSpaceForItem(TestItemAsset);
 
@@ -92,11 +106,259 @@ void FInventoryComponentSpec::Define()
             TestInventoryComponent->SetNumberOfSlots(1);
             TestInventoryComponent->InitializeInventorySlots();
 
-            TestInventoryComponent->GetInventorySlots()[0] = FInventorySlot(TestItemAsset, 2);
+            TestInventoryComponent->SetInventorySlot(0, FInventorySlot(TestItemAsset, 2));
 
             bool ReturnVal = TestInventoryComponent->HasAvailableSpaceForItem(TestItemAsset, TestItemAsset->GetMaxStackSize() - 2);
 
             TestTrue(TEXT("Return true"), ReturnVal);
         });
     });
+
+    Describe("AddItemAmount", [this]()
+    {
+        It("Spread an amount over several stacks", [this]()
+        {
+            const int32 Amount = TestItemAsset->GetMaxStackSize() * 2 + 1;
+
+            int32 ReturnVal = TestInventoryComponent->AddItemAmount(TestItemAsset, Amount);
+
+            TestEqual(TEXT("Return no leftover"), ReturnVal, 0);
+            TestEqual(TEXT("All items were added"), TestInventoryComponent->ContainsItem(TestItemAsset), Amount);
+        });
+
+        It("Return the amount that did not fit", [this]()
+        {
+            TestInventoryComponent->SetNumberOfSlots(1);
+            TestInventoryComponent->InitializeInventorySlots();
+
+            int32 ReturnVal = TestInventoryComponent->AddItemAmount(TestItemAsset, TestItemAsset->GetMaxStackSize() + 3);
+
+            TestEqual(TEXT("Return leftover"), ReturnVal, 3);
+        });
+    });
+
+    Describe("TryAddItem", [this]()
+    {
+        It("Return False and add nothing when not all of the amount fits", [this]()
+        {
+            TestInventoryComponent->SetNumberOfSlots(1);
+            TestInventoryComponent->InitializeInventorySlots();
+
+            bool ReturnVal = TestInventoryComponent->TryAddItem(TestItemAsset, TestItemAsset->GetMaxStackSize() + 1);
+
+            TestFalse(TEXT("Return false"), ReturnVal);
+            TestTrue(TEXT("Nothing was added"), TestInventoryComponent->IsInventoryEmpty());
+        });
+    });
+
+    Describe("CompactInventory", [this]()
+    {
+        It("Merge partial stacks into the first slot", [this]()
+        {
+            TestInventoryComponent->SetInventorySlot(3, FInventorySlot(TestItemAsset, 1));
+            TestInventoryComponent->SetInventorySlot(7, FInventorySlot(TestItemAsset, 2));
+
+            bool ReturnVal = TestInventoryComponent->CompactInventory();
+
+            TestTrue(TEXT("Return true"), ReturnVal);
+            TestEqual(TEXT("Stacks were merged"), TestInventoryComponent->GetInventorySlots()[0].CurrentStackSize, 3);
+            TestTrue(TEXT("Old slot is empty"), FInventorySlot::IsSlotEmpty(TestInventoryComponent->GetInventorySlots()[7]));
+        });
+
+        It("Keep one partial stack when compacting always", [this]()
+        {
+            TestInventoryComponent->SetCompactPolicy(EInventoryCompactPolicy::Always);
+
+            TestInventoryComponent->AddItemAmount(TestItemAsset, TestItemAsset->GetMaxStackSize() * 2);
+            TestInventoryComponent->TryRemoveItem(TestItemAsset, 1);
+            TestInventoryComponent->AddItemAmount(TestItemAsset, 1);
+            TestInventoryComponent->TryRemoveItem(TestItemAsset, 2);
+
+            int32 NumPartialStacks = 0;
+
+            for (const FInventorySlot& InventorySlot : TestInventoryComponent->GetInventorySlots())
+            {
+                NumPartialStacks += !FInventorySlot::IsSlotEmpty(InventorySlot) && !FInventorySlot::IsSlotFull(InventorySlot) ? 1 : 0;
+            }
+
+            TestEqual(TEXT("One partial stack"), NumPartialStacks, 1);
+            TestTrue(TEXT("Partial stack is indexed"), TestInventoryComponent->ContainsPartialStack(TestItemAsset) != INDEX_NONE);
+        });
+    });
+
+    Describe("TransferItems", [this]()
+    {
+        It("Merge into the target's partial stack first", [this]()
+        {
+            UInventoryComponent* TargetInventoryComponent = NewObject<UInventoryComponent>();
+            TargetInventoryComponent->SetNumberOfSlots(10);
+            TargetInventoryComponent->InitializeInventorySlots();
+            TargetInventoryComponent->SetInventorySlot(3, FInventorySlot(TestItemAsset, 1));
+
+            TestInventoryComponent->SetInventorySlot(0, FInventorySlot(TestItemAsset, 2));
+
+            int32 ReturnVal = UInventoryComponent::TransferItems(TestInventoryComponent, TargetInventoryComponent, {});
+
+            TestEqual(TEXT("Return moved amount"), ReturnVal, 2);
+            TestEqual(TEXT("Partial stack was filled"), TargetInventoryComponent->GetInventorySlots()[3].CurrentStackSize, 3);
+            TestTrue(TEXT("Source is empty"), TestInventoryComponent->IsInventoryEmpty());
+        });
+
+        It("Reject a server transfer between two other inventories", [this]()
+        {
+            UInventoryComponent* SourceInventoryComponent = NewObject<UInventoryComponent>();
+            SourceInventoryComponent->SetNumberOfSlots(10);
+            SourceInventoryComponent->InitializeInventorySlots();
+            SourceInventoryComponent->SetInventorySlot(0, FInventorySlot(TestItemAsset, 2));
+
+            UInventoryComponent* TargetInventoryComponent = NewObject<UInventoryComponent>();
+            TargetInventoryComponent->SetNumberOfSlots(10);
+            TargetInventoryComponent->InitializeInventorySlots();
+
+            AddExpectedError(TEXT("is neither the source nor the target"), EAutomationExpectedErrorFlags::Contains, 1);
+
+            TestInventoryComponent->ServerTransferItems_Implementation(SourceInventoryComponent, TargetInventoryComponent, {}, -1);
+
+            TestEqual(TEXT("Nothing moved"), SourceInventoryComponent->ContainsItem(TestItemAsset), 2);
+        });
+
+        It("Reject a server transfer with an inventory the caller may not change", [this]()
+        {
+            UInventoryComponent* SourceInventoryComponent = NewObject<UInventoryComponent>();
+            SourceInventoryComponent->SetNumberOfSlots(10);
+            SourceInventoryComponent->InitializeInventorySlots();
+            SourceInventoryComponent->SetInventorySlot(0, FInventorySlot(TestItemAsset, 2));
+
+            AddExpectedError(TEXT("may not change"), EAutomationExpectedErrorFlags::Contains, 1);
+
+            // Neither has an owner, so they are not the same player's and not in view of each other
+            TestInventoryComponent->ServerTransferItems_Implementation(SourceInventoryComponent, TestInventoryComponent, {}, -1);
+
+            TestEqual(TEXT("Nothing moved"), SourceInventoryComponent->ContainsItem(TestItemAsset), 2);
+        });
+    });
+
+    Describe("Prediction", [this]()
+    {
+        It("Show predicted items until the server resolves them", [this]()
+        {
+            const int32 PredictionKey = UInventoryComponent::CreatePredictionKey();
+
+            TestInventoryComponent->PredictAddItem(PredictionKey, TestItemAsset, 3);
+
+            TestEqual(TEXT("Predicted amount is visible"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+
+            TestInventoryComponent->ResolvePrediction(PredictionKey, false);
+
+            TestTrue(TEXT("Rejected prediction was rolled back"), TestInventoryComponent->IsInventoryEmpty());
+            TestEqual(TEXT("Rejection is counted"), TestInventoryComponent->GetPredictionStats().NumRejected, 1);
+            TestEqual(TEXT("Misprediction rate"), TestInventoryComponent->GetMispredictionRate(), 1.0f);
+        });
+
+        It("Keep accepted items until the replicated sequence contains them", [this]()
+        {
+            const int32 PredictionKey = UInventoryComponent::CreatePredictionKey();
+
+            TestInventoryComponent->PredictAddItem(PredictionKey, TestItemAsset, 3);
+
+            TestInventoryComponent->ResolvePrediction(PredictionKey, true, TestInventoryComponent->GetSlotSequence() + 1);
+
+            TestEqual(TEXT("Accepted amount is still visible"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+            TestEqual(TEXT("Acceptance is not a rejection"), TestInventoryComponent->GetPredictionStats().NumRejected, 0);
+        });
+
+        It("Reconcile once the authoritative slots arrived before the acceptance", [this]()
+        {
+            const int32 PredictionKey = UInventoryComponent::CreatePredictionKey();
+
+            TestInventoryComponent->PredictAddItem(PredictionKey, TestItemAsset, 3);
+
+            // The server's write, as the replicated slots and sequence
+            TestInventoryComponent->SetInventorySlot(0, FInventorySlot(TestItemAsset, 3));
+
+            TestInventoryComponent->ResolvePrediction(PredictionKey, true, TestInventoryComponent->GetSlotSequence());
+
+            TestEqual(TEXT("Replicated amount is visible once"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+            TestEqual(TEXT("Matching result is not a correction"), TestInventoryComponent->GetPredictionStats().NumCorrected, 0);
+            TestEqual(TEXT("Misprediction rate"), TestInventoryComponent->GetMispredictionRate(), 0.0f);
+        });
+    });
+
+    Describe("StructOfArrays storage", [this]()
+    {
+        It("Output the same item count as slot storage", [this]()
+        {
+            TestInventoryComponent->SetInventorySlot(2, FInventorySlot(TestItemAsset, 3));
+            TestInventoryComponent->SetInventorySlot(7, FInventorySlot(TestItemAsset, 4));
+
+            TestInventoryComponent->SetStorageMode(EInventoryStorageMode::StructOfArrays);
+
+            int32 ReturnVal = TestInventoryComponent->ContainsItem(TestItemAsset);
+
+            TestEqual(TEXT("Return correct amount"), ReturnVal, 7);
+        });
+
+        It("Return index of first partial stack", [this]()
+        {
+            TestInventoryComponent->SetStorageMode(EInventoryStorageMode::StructOfArrays);
+
+            TestInventoryComponent->SetInventorySlot(1, FInventorySlot(TestItemAsset, TestItemAsset->GetMaxStackSize()));
+            TestInventoryComponent->SetInventorySlot(4, FInventorySlot(TestItemAsset, 1));
+
+            int32 ReturnVal = TestInventoryComponent->ContainsPartialStack(TestItemAsset);
+
+            TestEqual(TEXT("Return partial stack index"), ReturnVal, 4);
+        });
+    });
+
+    Describe("Paged storage", [this]()
+    {
+        It("Output the same slots by index on the server", [this]()
+        {
+            TestInventoryComponent->SetStorageMode(EInventoryStorageMode::Paged);
+
+            TestInventoryComponent->AddItemAmount(TestItemAsset, 3);
+
+            TestEqual(TEXT("Return the slot"), TestInventoryComponent->GetInventorySlot(0).CurrentStackSize, 3);
+            TestTrue(TEXT("Return empty slot out of range"), FInventorySlot::IsSlotEmpty(TestInventoryComponent->GetInventorySlot(10)));
+        });
+    });
+
+    Describe("FactorySimulation", [this]()
+    {
+        It("End in the same slots when run twice", [this]()
+        {
+            TestInventoryComponent->AddItemAmount(TestItemAsset, 2);
+
+            auto RunSimulation = [this]()
+            {
+                FFactorySimulation Simulation;
+
+                const int32 InventoryIndex = Simulation.AddInventory(TestInventoryComponent->GetInventorySlots());
+
+                FFactorySimMachine Generator;
+                Generator.InventoryIndex = InventoryIndex;
+                Generator.ItemId         = UItemRegistrySubsystem::GetItemId(TestItemAsset);
+                Generator.MaxStackSize   = TestItemAsset->GetMaxStackSize();
+                Generator.PeriodSteps    = 2;
+                Generator.NextFireStep   = 2;
+
+                FFactorySimMachine Consumer = Generator;
+                Consumer.Kind         = EProductionKind::Consume;
+                Consumer.PeriodSteps  = 3;
+                Consumer.NextFireStep = 1;
+
+                Simulation.AddMachine(Generator);
+                Simulation.AddMachine(Consumer);
+                Simulation.AdvanceTo(100);
+
+                return Simulation.CountItem(InventoryIndex, Generator.ItemId);
+            };
+
+            const int64 FirstAmount = RunSimulation();
+
+            TestTrue(TEXT("Generated more than consumed"), FirstAmount > 2);
+            TestEqual(TEXT("Return the same amount again"), RunSimulation(), FirstAmount);
+        });
+    });
 };
@@ -0,0 +1,576 @@
+#include "Misc/AutomationTest.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/MemoryBase.h"
+#include "Inventory/CraftingComponent.h"
+#include "Inventory/InventoryComponent.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Testing/JCoreSpecUtils.h"
+
+/**
+ *  Inventory performance suite, runs headless with:
+ *
+ *      UnrealEditor-Cmd <Project>.uproject -nullrhi -unattended -ExecCmds="Automation RunTests JCore.Perf.Inventory; Quit"
+ *
+ *  Every scenario reports ns/op, the allocations/op made on the game thread and an estimate of the replicated bytes/op, and is compared against
+ *  Saved/Automation/JCore/InventoryPerfBaseline.json. The baseline is written on the first run, pass -JCorePerfUpdateBaseline to replace it.
+ */
+namespace InventoryPerf
+{
+    constexpr int32 NumOps   = 2000;
+    constexpr int32 NumItems = 8;
+    constexpr int32 Seed     = 1337;
+
+    // Timings are noisy, only warn once a scenario is this much slower than the baseline
+    constexpr double TimeTolerance = 1.25;
+
+    // Scan scenarios write their result here so the loops are not optimized away
+    volatile int32 ScanResult = 0;
+
+    struct FResult
+    {
+        double NsPerOp     = 0.0;
+        double AllocsPerOp = 0.0;
+        double BytesPerOp  = 0.0;
+    };
+
+    /**
+     *  Forwards to the allocator it replaces and counts the allocations made on the game thread while it is installed as GMalloc.
+     *  Other threads keep allocating through it but are not counted, so the count only covers the measured ops.
+     */
+    class FCountingMalloc final : public FMalloc
+    {
+    public:
+        explicit FCountingMalloc(FMalloc* InInnerMalloc) : InnerMalloc(InInnerMalloc) {}
+
+        int64 GetNumAllocations() const { return this->NumAllocations; }
+
+        virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+        {
+            this->CountAllocation();
+
+            return this->InnerMalloc->Malloc(Count, Alignment);
+        }
+
+        virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+        {
+            this->CountAllocation();
+
+            return this->InnerMalloc->TryMalloc(Count, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            // Shrinking to nothing is a free, anything else may move the allocation
+            if (Count > 0)
+            {
+                this->CountAllocation();
+            }
+
+            return this->InnerMalloc->Realloc(Original, Count, Alignment);
+        }
+
+        virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+        {
+            if (Count > 0)
+            {
+                this->CountAllocation();
+            }
+
+            return this->InnerMalloc->TryRealloc(Original, Count, Alignment);
+        }
+
+        virtual void Free(void* Original) override { this->InnerMalloc->Free(Original); }
+
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return this->InnerMalloc->QuantizeSize(Count, Alignment); }
+        virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return this->InnerMalloc->GetAllocationSize(Original, SizeOut); }
+        virtual void Trim(bool bTrimThreadCaches) override { this->InnerMalloc->Trim(bTrimThreadCaches); }
+        virtual void SetupTLSCachesOnCurrentThread() override { this->InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+        virtual void ClearAndDisableTLSCachesOnCurrentThread() override { this->InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+        virtual void UpdateStats() override { this->InnerMalloc->UpdateStats(); }
+        virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { this->InnerMalloc->GetAllocatorStats(OutStats); }
+        virtual void DumpAllocatorStats(FOutputDevice& Ar) override { this->InnerMalloc->DumpAllocatorStats(Ar); }
+        virtual bool IsInternallyThreadSafe() const override { return this->InnerMalloc->IsInternallyThreadSafe(); }
+        virtual bool ValidateHeap() override { return this->InnerMalloc->ValidateHeap(); }
+        virtual const TCHAR* GetDescriptiveName() override { return this->InnerMalloc->GetDescriptiveName(); }
+
+    private:
+        void CountAllocation()
+        {
+            // Only the game thread writes the count, so it needs no atomics
+            if (IsInGameThread())
+            {
+                this->NumAllocations++;
+            }
+        }
+
+        FMalloc* InnerMalloc;
+        int64 NumAllocations = 0;
+    };
+
+    /** Counts the game thread allocations made while in scope by installing a FCountingMalloc over GMalloc */
+    class FScopedAllocationCounter
+    {
+    public:
+        FScopedAllocationCounter() : InnerMalloc(GMalloc), CountingMalloc(GMalloc)
+        {
+            GMalloc = &this->CountingMalloc;
+        }
+
+        ~FScopedAllocationCounter()
+        {
+            // Whatever was allocated through the proxy came from the inner allocator, so it can be freed after restoring it
+            GMalloc = this->InnerMalloc;
+        }
+
+        int64 GetNumAllocations() const { return this->CountingMalloc.GetNumAllocations(); }
+
+    private:
+        FMalloc* InnerMalloc;
+        FCountingMalloc CountingMalloc;
+    };
+
+    /**
+     *  Estimates the bytes a slot array delta costs on the wire.
+     *  Mirrors the changed handle stream of the property replication: packed index, item id and packed stack size per changed slot.
+     */
+    int64 EstimateReplicatedBytes(const TArray<FInventorySlot>& Before, const TArray<FInventorySlot>& After)
+    {
+        FBitWriter Writer(0, true);
+
+        bool bChanged = false;
+
+        if (Before.Num() != After.Num())
+        {
+            uint32 NumSlots = After.Num();
+            Writer.SerializeIntPacked(NumSlots);
+
+            bChanged = true;
+        }
+
+        for (int32 i = 0; i < After.Num(); i++)
+        {
+            if (Before.IsValidIndex(i) && Before[i] == After[i]) continue;
+
+            uint32 Handle    = i + 1;
+            uint16 ItemId    = After[i].ItemId;
+            uint32 StackSize = After[i].CurrentStackSize;
+
+            Writer.SerializeIntPacked(Handle);
+            Writer << ItemId;
+            Writer.SerializeIntPacked(StackSize);
+
+            bChanged = true;
+        }
+
+        if (!bChanged)
+        {
+            return 0;
+        }
+
+        // Terminating handle
+        uint32 EndHandle = 0;
+        Writer.SerializeIntPacked(EndHandle);
+
+        return (Writer.GetNumBits() + 7) / 8;
+    }
+
+    /**
+     *  Runs a workload three times from the same setup and seed: once timed, once counting its allocations
+     *  and once diffing the inventories after every op to estimate the replicated bytes.
+     */
+    FResult Measure(TFunctionRef<void()> Setup,
+                    TFunctionRef<void(FRandomStream&)> Op,
+                    const TArray<UInventoryComponent*>& Inventories)
+    {
+        FResult Result;
+
+        {
+            Setup();
+
+            FRandomStream Random(Seed);
+
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+
+            for (int32 i = 0; i < NumOps; i++)
+            {
+                Op(Random);
+            }
+
+            const uint64 EndCycles = FPlatformTime::Cycles64();
+
+            Result.NsPerOp = FPlatformTime::ToSeconds64(EndCycles - StartCycles) * 1.0e9 / NumOps;
+        }
+
+        {
+            Setup();
+
+            FRandomStream Random(Seed);
+
+            int64 NumAllocations = 0;
+
+            {
+                FScopedAllocationCounter AllocationCounter;
+
+                for (int32 i = 0; i < NumOps; i++)
+                {
+                    Op(Random);
+                }
+
+                NumAllocations = AllocationCounter.GetNumAllocations();
+            }
+
+            Result.AllocsPerOp = static_cast<double>(NumAllocations) / NumOps;
+        }
+
+        {
+            Setup();
+
+            FRandomStream Random(Seed);
+
+            TArray<TArray<FInventorySlot>> PreviousSlots;
+            PreviousSlots.SetNum(Inventories.Num());
+
+            int64 NumBytes = 0;
+
+            for (int32 i = 0; i < NumOps; i++)
+            {
+                for (int32 j = 0; j < Inventories.Num(); j++)
+                {
+                    PreviousSlots[j] = Inventories[j]->GetInventorySlots();
+                }
+
+                Op(Random);
+
+                for (int32 j = 0; j < Inventories.Num(); j++)
+                {
+                    NumBytes += EstimateReplicatedBytes(PreviousSlots[j], Inventories[j]->GetInventorySlots());
+                }
+            }
+
+            Result.BytesPerOp = static_cast<double>(NumBytes) / NumOps;
+        }
+
+        return Result;
+    }
+
+    UInventoryComponent* CreateInventory(int32 NumSlots, EInventoryStorageMode StorageMode)
+    {
+        UInventoryComponent* Inventory = NewObject<UInventoryComponent>();
+        Inventory->SetNumberOfSlots(NumSlots);
+        Inventory->InitializeInventorySlots();
+        Inventory->SetStorageMode(StorageMode);
+
+        return Inventory;
+    }
+
+    /** Fills about half of the slots with random stacks of the given items */
+    void FillInventory(UInventoryComponent* Inventory, const TArray<UItemDataAsset*>& Items)
+    {
+        FRandomStream Random(Seed + 1);
+
+        const int32 NumSlots = Inventory->GetInventorySlots().Num();
+
+        for (int32 i = 0; i < NumSlots / 2; i++)
+        {
+            UItemDataAsset* Item = Items[Random.RandHelper(Items.Num())];
+
+            Inventory->AddItemAmount(Item, Random.RandRange(1, Item->GetMaxStackSize()));
+        }
+    }
+
+    TSharedPtr<FJsonObject> LoadJson(const FString& Path)
+    {
+        FString JsonString;
+
+        if (!FFileHelper::LoadFileToString(JsonString, *Path))
+        {
+            return nullptr;
+        }
+
+        TSharedPtr<FJsonObject> JsonObject;
+
+        if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonString), JsonObject))
+        {
+            return nullptr;
+        }
+
+        return JsonObject;
+    }
+
+    void SaveJson(const TSharedRef<FJsonObject>& JsonObject, const FString& Path)
+    {
+        FString JsonString;
+
+        FJsonSerializer::Serialize(JsonObject, TJsonWriterFactory<>::Create(&JsonString));
+
+        FFileHelper::SaveStringToFile(JsonString, *Path);
+    }
+}
+
+BEGIN_DEFINE_SPEC(FInventoryPerformanceSpec, "JCore.Perf.Inventory",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+TArray<UItemDataAsset*> TestItems;
+TArray<UInventoryComponent*> TestInventories;
+
+TSharedPtr<FJsonObject> Baseline;
+TSharedPtr<FJsonObject> Results;
+bool bUpdateBaseline;
+
+FString GetBaselinePath() const { return FPaths::ProjectSavedDir() / TEXT("Automation/JCore/InventoryPerfBaseline.json"); }
+FString GetResultsPath() const { return FPaths::ProjectSavedDir() / TEXT("Automation/JCore/InventoryPerfResults.json"); }
+
+void Report(const FString& Scenario, const InventoryPerf::FResult& Result);
+
+END_DEFINE_SPEC(FInventoryPerformanceSpec)
+
+void FInventoryPerformanceSpec::Report(const FString& Scenario, const InventoryPerf::FResult& Result)
+{
+    AddInfo(FString::Printf(TEXT("%s: %.1f ns/op, %.2f allocs/op, %.1f replicated bytes/op"),
+                            *Scenario, Result.NsPerOp, Result.AllocsPerOp, Result.BytesPerOp));
+
+    TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+    ResultObject->SetNumberField(TEXT("NsPerOp"), Result.NsPerOp);
+    ResultObject->SetNumberField(TEXT("AllocsPerOp"), Result.AllocsPerOp);
+    ResultObject->SetNumberField(TEXT("BytesPerOp"), Result.BytesPerOp);
+
+    Results->SetObjectField(Scenario, ResultObject);
+    InventoryPerf::SaveJson(Results.ToSharedRef(), GetResultsPath());
+
+    const TSharedPtr<FJsonObject>* BaselineObject = nullptr;
+
+    if (!bUpdateBaseline && Baseline->TryGetObjectField(Scenario, BaselineObject))
+    {
+        const double BaselineNsPerOp    = (*BaselineObject)->GetNumberField(TEXT("NsPerOp"));
+        const double BaselineBytesPerOp = (*BaselineObject)->GetNumberField(TEXT("BytesPerOp"));
+
+        // Baselines written before allocations were counted do not have them
+        double BaselineAllocsPerOp = Result.AllocsPerOp;
+        (*BaselineObject)->TryGetNumberField(TEXT("AllocsPerOp"), BaselineAllocsPerOp);
+
+        if (Result.NsPerOp > BaselineNsPerOp * InventoryPerf::TimeTolerance)
+        {
+            AddWarning(FString::Printf(TEXT("%s: %.1f ns/op is slower than the baseline %.1f ns/op"), *Scenario, Result.NsPerOp, BaselineNsPerOp));
+        }
+
+        // Allocations and replicated bytes are deterministic for a given seed, any increase is a regression
+        if (Result.AllocsPerOp > BaselineAllocsPerOp + KINDA_SMALL_NUMBER)
+        {
+            AddError(FString::Printf(TEXT("%s: %.2f allocs/op is more than the baseline %.2f allocs/op"), *Scenario, Result.AllocsPerOp, BaselineAllocsPerOp));
+        }
+
+        if (Result.BytesPerOp > BaselineBytesPerOp + KINDA_SMALL_NUMBER)
+        {
+            AddError(FString::Printf(TEXT("%s: %.1f bytes/op is more than the baseline %.1f bytes/op"), *Scenario, Result.BytesPerOp, BaselineBytesPerOp));
+        }
+
+        return;
+    }
+
+    Baseline->SetObjectField(Scenario, ResultObject);
+    InventoryPerf::SaveJson(Baseline.ToSharedRef(), GetBaselinePath());
+}
+
+void FInventoryPerformanceSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        // The workloads mix several item ids
+        for (int32 i = 0; i < InventoryPerf::NumItems; i++)
+        {
+            TestItems.Add(FJCoreSpecUtils::CreateItem());
+        }
+
+        if (!Results)
+        {
+            bUpdateBaseline = FParse::Param(FCommandLine::Get(), TEXT("JCorePerfUpdateBaseline"));
+
+            Results  = MakeShared<FJsonObject>();
+            Baseline = InventoryPerf::LoadJson(GetBaselinePath());
+
+            if (!Baseline || bUpdateBaseline)
+            {
+                Baseline = MakeShared<FJsonObject>();
+            }
+        }
+
+        TestInventories.Reset();
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::ReleaseItems(TestItems);
+
+        TestItems.Reset();
+    });
+
+    Describe("Randomized add/remove/swap", [this]()
+    {
+        for (const EInventoryStorageMode StorageMode : {EInventoryStorageMode::Slots, EInventoryStorageMode::StructOfArrays, EInventoryStorageMode::Paged})
+        {
+            for (const int32 NumSlots : {10, 100, 1000, 10000})
+            {
+                const FString Scenario = FString::Printf(TEXT("Workload_%s_%d"), *StaticEnum<EInventoryStorageMode>()->GetNameStringByValue(static_cast<int64>(StorageMode)), NumSlots);
+
+                It(Scenario, [this, Scenario, StorageMode, NumSlots]()
+                {
+                    auto Setup = [this, StorageMode, NumSlots]()
+                    {
+                        TestInventories = {InventoryPerf::CreateInventory(NumSlots, StorageMode)};
+
+                        InventoryPerf::FillInventory(TestInventories[0], TestItems);
+                    };
+
+                    auto Op = [this, NumSlots](FRandomStream& Random)
+                    {
+                        UInventoryComponent* Inventory = TestInventories[0];
+                        UItemDataAsset* Item           = TestItems[Random.RandHelper(TestItems.Num())];
+
+                        const int32 Roll = Random.RandHelper(10);
+
+                        if (Roll < 4)
+                        {
+                            Inventory->AddItemAmount(Item, Random.RandRange(1, Item->GetMaxStackSize()));
+                        }
+                        else if (Roll < 8)
+                        {
+                            Inventory->TryRemoveItem(Item, Random.RandRange(1, Item->GetMaxStackSize()));
+                        }
+                        else
+                        {
+                            Inventory->SwapInventorySlots(Random.RandHelper(NumSlots), Inventory, Random.RandHelper(NumSlots));
+                        }
+                    };
+
+                    Report(Scenario, InventoryPerf::Measure(Setup, Op, TestInventories));
+                });
+            }
+        }
+    });
+
+    Describe("Crafting", [this]()
+    {
+        It("Crafting_1000", [this]()
+        {
+            UCraftingComponent* CraftingComponent = NewObject<UCraftingComponent>();
+            UItemRecipeDataAsset* Recipe          = FJCoreSpecUtils::CreateRecipe({{TestItems[0], 2}, {TestItems[1], 3}, {TestItems[2], 1}, {TestItems[3], 4}},
+                                                                                  {{TestItems[4], 1}, {TestItems[5], 2}});
+
+            auto Setup = [this]()
+            {
+                TestInventories = {InventoryPerf::CreateInventory(1000, EInventoryStorageMode::Slots)};
+            };
+
+            auto Op = [this, CraftingComponent, Recipe](FRandomStream& Random)
+            {
+                UInventoryComponent* Inventory = TestInventories[0];
+
+                if (UCraftingComponent::InventoryHasItemsInRecipe(Recipe, Inventory))
+                {
+                    CraftingComponent->TryCraftRecipe(Recipe, Inventory);
+                    return;
+                }
+
+                // Restock the inputs for a few crafts
+                for (const TPair<UItemDataAsset*, int32> Item : Recipe->GetInItems())
+                {
+                    Inventory->AddItemAmount(Item.Key, Item.Value * Random.RandRange(1, 4));
+                }
+            };
+
+            Report(TEXT("Crafting_1000"), InventoryPerf::Measure(Setup, Op, TestInventories));
+        });
+    });
+
+    Describe("Stack size scans", [this]()
+    {
+        // Same partial stack scan over 1000 slots, once reading the max stack size from the data asset as slots used to
+        // and once from the size cached on the slot
+        It("StackScan_Asset_1000", [this]()
+        {
+            auto Setup = [this]()
+            {
+                TestInventories = {InventoryPerf::CreateInventory(1000, EInventoryStorageMode::Slots)};
+
+                InventoryPerf::FillInventory(TestInventories[0], TestItems);
+            };
+
+            auto Op = [this](FRandomStream& Random)
+            {
+                int32 NumPartialStacks = 0;
+
+                for (const FInventorySlot& InventorySlot : TestInventories[0]->GetInventorySlots())
+                {
+                    NumPartialStacks += InventorySlot.Item && InventorySlot.CurrentStackSize < InventorySlot.Item->GetMaxStackSize() ? 1 : 0;
+                }
+
+                InventoryPerf::ScanResult = NumPartialStacks;
+            };
+
+            Report(TEXT("StackScan_Asset_1000"), InventoryPerf::Measure(Setup, Op, TestInventories));
+        });
+
+        It("StackScan_Cached_1000", [this]()
+        {
+            auto Setup = [this]()
+            {
+                TestInventories = {InventoryPerf::CreateInventory(1000, EInventoryStorageMode::Slots)};
+
+                InventoryPerf::FillInventory(TestInventories[0], TestItems);
+            };
+
+            auto Op = [this](FRandomStream& Random)
+            {
+                int32 NumPartialStacks = 0;
+
+                for (const FInventorySlot& InventorySlot : TestInventories[0]->GetInventorySlots())
+                {
+                    NumPartialStacks += !FInventorySlot::IsSlotEmpty(InventorySlot) && !FInventorySlot::IsSlotFull(InventorySlot) ? 1 : 0;
+                }
+
+                InventoryPerf::ScanResult = NumPartialStacks;
+            };
+
+            Report(TEXT("StackScan_Cached_1000"), InventoryPerf::Measure(Setup, Op, TestInventories));
+        });
+    });
+
+    Describe("Generator/consumer churn", [this]()
+    {
+        It("Churn_1000", [this]()
+        {
+            auto Setup = [this]()
+            {
+                TestInventories = {InventoryPerf::CreateInventory(1000, EInventoryStorageMode::Slots)};
+
+                InventoryPerf::FillInventory(TestInventories[0], TestItems);
+            };
+
+            // Same calls as UItemGeneratingComponent and UItemConsumingComponent made per fire on their own timers, four of each
+            auto Op = [this](FRandomStream& Random)
+            {
+                UInventoryComponent* Inventory = TestInventories[0];
+                UItemDataAsset* Item           = TestItems[Random.RandHelper(4)];
+
+                if (Random.RandHelper(2) == 0)
+                {
+                    if (Inventory->HasAnyEmptySlots() || Inventory->ContainsPartialStack(Item) >= 0)
+                    {
+                        Inventory->TryAddItem(Item, 1);
+                    }
+                }
+                else
+                {
+                    Inventory->TryRemoveItem(Item, 1);
+                }
+            };
+
+            Report(TEXT("Churn_1000"), InventoryPerf::Measure(Setup, Op, TestInventories));
+        });
+    });
+}
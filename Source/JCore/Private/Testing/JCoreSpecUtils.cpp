@@ -0,0 +1,72 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Inventory/ItemDataAsset.h"
+#include "Inventory/ItemRecipeDataAsset.h"
+
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+UWorld* FJCoreSpecUtils::CreateWorld()
+{
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+
+    // Game instance subsystems such as the UGraphSubsystem are found through the world
+    UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+    GameInstance->Init();
+
+    World->SetGameInstance(GameInstance);
+
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    World->InitializeActorsForPlay(FURL());
+    World->BeginPlay();
+
+    return World;
+}
+
+void FJCoreSpecUtils::DestroyWorld(UWorld* World)
+{
+    UGameInstance* GameInstance = World->GetGameInstance();
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+
+    if (GameInstance)
+    {
+        GameInstance->Shutdown();
+    }
+}
+
+UItemDataAsset* FJCoreSpecUtils::CreateItem()
+{
+    const UItemDataAsset* TestItemAsset = LoadObject<UItemDataAsset>(nullptr, TEXT("/Script/JCore.ItemDataAsset'/JCore/Testing/DA_TestingItem.DA_TestingItem'"));
+
+    UItemDataAsset* Item = DuplicateObject<UItemDataAsset>(TestItemAsset, GetTransientPackage());
+    Item->AddToRoot();
+
+    return Item;
+}
+
+void FJCoreSpecUtils::ReleaseItems(const TArray<UItemDataAsset*>& Items)
+{
+    for (UItemDataAsset* Item : Items)
+    {
+        if (Item)
+        {
+            Item->RemoveFromRoot();
+        }
+    }
+}
+
+UItemRecipeDataAsset* FJCoreSpecUtils::CreateRecipe(const TMap<UItemDataAsset*, int32>& InItems, const TMap<UItemDataAsset*, int32>& OutItems, float CraftTime)
+{
+    UItemRecipeDataAsset* Recipe = NewObject<UItemRecipeDataAsset>();
+    Recipe->SetItems(InItems, OutItems);
+    Recipe->SetCraftTime(CraftTime);
+
+    return Recipe;
+}
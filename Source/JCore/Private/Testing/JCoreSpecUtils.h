@@ -0,0 +1,29 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UItemDataAsset;
+class UItemRecipeDataAsset;
+
+/** Fixtures the specs share */
+struct FJCoreSpecUtils
+{
+    /** Creates a game world with a game instance, so both have their subsystems, and begins play in it */
+    static UWorld* CreateWorld();
+
+    /** Destroys a world made by CreateWorld along with its game instance */
+    static void DestroyWorld(UWorld* World);
+
+    /**
+     *  Copies the testing item, each copy getting an item id of its own.
+     *
+     *  Specs keep the copies in plain members, so they are rooted until they are passed to ReleaseItems.
+     */
+    static UItemDataAsset* CreateItem();
+
+    static void ReleaseItems(const TArray<UItemDataAsset*>& Items);
+
+    static UItemRecipeDataAsset* CreateRecipe(const TMap<UItemDataAsset*, int32>& InItems, const TMap<UItemDataAsset*, int32>& OutItems, float CraftTime = 0.f);
+};
@@ -0,0 +1,286 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Building/NetworkPartition.h"
+#include "Building/PipeComponent.h"
+#include "Building/PipeNetworkSubsystem.h"
+#include "Graph/GraphNodeComponent.h"
+#include "Graph/GraphSubsystem.h"
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+BEGIN_DEFINE_SPEC(FPipeNetworkSpec, "JCore.Building.PipeNetwork",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UWorld* World;
+UGraphBase* Graph;
+UPipeNetworkSubsystem* PipeNetworks;
+
+/** Spawns an actor with a graph node and a pipe, not connected to any other */
+UPipeComponent* CreatePipe(float Capacity, float FlowRate = 0.f);
+
+/** Adds an edge between the pipes' graph nodes, as finishing a buildable that snapped to another does */
+void Connect(UPipeComponent* A, const UPipeComponent* B);
+
+void Disconnect(const UPipeComponent* A, const UPipeComponent* B);
+
+END_DEFINE_SPEC(FPipeNetworkSpec)
+
+UPipeComponent* FPipeNetworkSpec::CreatePipe(float Capacity, float FlowRate)
+{
+    AActor* Owner = World->SpawnActor<AActor>();
+
+    UGraphNodeComponent* GraphNodeComponent = NewObject<UGraphNodeComponent>(Owner);
+    GraphNodeComponent->RegisterComponent();
+
+    Graph->AddNode(GraphNodeComponent->GetNode());
+
+    UPipeComponent* Pipe = NewObject<UPipeComponent>(Owner);
+
+    Pipe->SetCapacity(Capacity);
+    Pipe->SetFlowRate(FlowRate);
+
+    Pipe->RegisterComponent();
+
+    return Pipe;
+}
+
+void FPipeNetworkSpec::Connect(UPipeComponent* A, const UPipeComponent* B)
+{
+    Graph->AddEdge(A->GetOwner()->FindComponentByClass<UGraphNodeComponent>()->GetNode(),
+                   B->GetOwner()->FindComponentByClass<UGraphNodeComponent>()->GetNode());
+
+    PipeNetworks->ConnectPipe(A);
+}
+
+void FPipeNetworkSpec::Disconnect(const UPipeComponent* A, const UPipeComponent* B)
+{
+    Graph->RemoveEdge(A->GetOwner()->FindComponentByClass<UGraphNodeComponent>()->GetNode(),
+                      B->GetOwner()->FindComponentByClass<UGraphNodeComponent>()->GetNode());
+
+    PipeNetworks->DisconnectPipe(A);
+}
+
+void FPipeNetworkSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        World = FJCoreSpecUtils::CreateWorld();
+
+        Graph        = World->GetGameInstance()->GetSubsystem<UGraphSubsystem>()->GetGraph();
+        PipeNetworks = World->GetSubsystem<UPipeNetworkSubsystem>();
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::DestroyWorld(World);
+    });
+
+    Describe("FNetworkPartition", [this]()
+    {
+        It("Put directly or indirectly connected actors in one network", [this]()
+        {
+            AActor* A = World->SpawnActor<AActor>();
+            AActor* B = World->SpawnActor<AActor>();
+            AActor* C = World->SpawnActor<AActor>();
+            AActor* D = World->SpawnActor<AActor>();
+
+            TMap<const AActor*, TArray<AActor*>> Neighbors;
+            Neighbors.Add(A, {B});
+            Neighbors.Add(B, {C});
+
+            FNetworkPartition Partition;
+            Partition.Build({A, B, C, D}, [&Neighbors](const AActor* Actor, TArray<AActor*>& OutActors)
+            {
+                OutActors.Append(Neighbors.FindRef(Actor));
+            });
+
+            TestEqual(TEXT("Two networks"), Partition.GetNumNetworks(), 2);
+            TestEqual(TEXT("A and B together"), Partition.GetNetworkIndex(A), Partition.GetNetworkIndex(B));
+            TestEqual(TEXT("B and C together"), Partition.GetNetworkIndex(B), Partition.GetNetworkIndex(C));
+            TestNotEqual(TEXT("D alone"), Partition.GetNetworkIndex(D), Partition.GetNetworkIndex(A));
+        });
+
+        It("Ignore neighbors that are not partitioned", [this]()
+        {
+            AActor* A = World->SpawnActor<AActor>();
+            AActor* B = World->SpawnActor<AActor>();
+            AActor* Outside = World->SpawnActor<AActor>();
+
+            FNetworkPartition Partition;
+            Partition.Build({A, B}, [Outside](const AActor* Actor, TArray<AActor*>& OutActors)
+            {
+                OutActors.Add(Outside);
+            });
+
+            TestEqual(TEXT("Two networks"), Partition.GetNumNetworks(), 2);
+            TestEqual(TEXT("Outside in none"), Partition.GetNetworkIndex(Outside), static_cast<int32>(INDEX_NONE));
+        });
+
+        It("Replace the previous partition", [this]()
+        {
+            AActor* A = World->SpawnActor<AActor>();
+            AActor* B = World->SpawnActor<AActor>();
+
+            FNetworkPartition Partition;
+            Partition.Build({A, B}, [B](const AActor* Actor, TArray<AActor*>& OutActors)
+            {
+                OutActors.Add(B);
+            });
+
+            Partition.Build({A}, [](const AActor* Actor, TArray<AActor*>& OutActors) {});
+
+            TestEqual(TEXT("One network"), Partition.GetNumNetworks(), 1);
+            TestEqual(TEXT("B in none"), Partition.GetNetworkIndex(B), static_cast<int32>(INDEX_NONE));
+        });
+    });
+
+    Describe("UPipeNetworkSubsystem", [this]()
+    {
+        It("Put every unconnected pipe in its own network", [this]()
+        {
+            CreatePipe(100.f);
+            CreatePipe(100.f);
+
+            PipeNetworks->Tick(0.f);
+
+            TestEqual(TEXT("Two networks"), PipeNetworks->GetNumNetworks(), 2);
+        });
+
+        It("Move a changed flow rate in the ledger by the difference", [this]()
+        {
+            UPipeComponent* Pipe = CreatePipe(100.f, 10.f);
+
+            PipeNetworks->Tick(0.f);
+
+            Pipe->SetFlowRate(-4.f);
+
+            const FPipeNetwork* Network = PipeNetworks->GetNetwork(Pipe);
+
+            TestEqual(TEXT("Supply taken out"), Network->Supply, 0.f);
+            TestEqual(TEXT("Demand put in"), Network->Demand, 4.f);
+        });
+
+        It("Fill a network by its supply up to the capacity", [this]()
+        {
+            UPipeComponent* Pipe = CreatePipe(100.f, 30.f);
+
+            PipeNetworks->Tick(UPipeNetworkSubsystem::SolveInterval);
+
+            TestEqual(TEXT("Filled by one solve"), PipeNetworks->GetNetwork(Pipe)->Volume, 15.f);
+
+            PipeNetworks->Tick(10.f);
+
+            TestEqual(TEXT("Full"), Pipe->GetFillRatio(), 1.f);
+        });
+
+        It("Supply the part of the demand the network can", [this]()
+        {
+            UPipeComponent* Pipe = CreatePipe(100.f, 30.f);
+
+            PipeNetworks->Tick(UPipeNetworkSubsystem::SolveInterval);
+
+            Pipe->SetFlowRate(-60.f);
+
+            PipeNetworks->Tick(UPipeNetworkSubsystem::SolveInterval);
+
+            TestEqual(TEXT("Half the demand met"), Pipe->GetSatisfaction(), 0.5f);
+            TestEqual(TEXT("Empty"), Pipe->GetFillRatio(), 0.f);
+        });
+
+        It("Keep the fill ratio when partitioned again", [this]()
+        {
+            UPipeComponent* Pipe = CreatePipe(100.f, 30.f);
+
+            PipeNetworks->Tick(UPipeNetworkSubsystem::SolveInterval);
+
+            Pipe->SetFlowRate(0.f);
+            PipeNetworks->DisconnectPipe(Pipe);
+            PipeNetworks->Tick(0.f);
+
+            TestEqual(TEXT("Fill ratio kept"), Pipe->GetFillRatio(), 0.15f);
+        });
+    });
+
+    Describe("Graph connected pipes", [this]()
+    {
+        It("Merge pipes connected through the graph into one network", [this]()
+        {
+            UPipeComponent* A = CreatePipe(100.f);
+            UPipeComponent* B = CreatePipe(100.f);
+            UPipeComponent* C = CreatePipe(100.f);
+
+            PipeNetworks->Tick(0.f);
+
+            Connect(A, B);
+            Connect(C, B);
+
+            PipeNetworks->Tick(0.f);
+
+            TestEqual(TEXT("One network"), PipeNetworks->GetNumNetworks(), 1);
+            TestTrue(TEXT("A and C together"), PipeNetworks->GetNetwork(A) == PipeNetworks->GetNetwork(C));
+            TestEqual(TEXT("Capacity of every pipe"), PipeNetworks->GetNetwork(B)->Capacity, 300.f);
+        });
+
+        It("Keep the fluid of merged networks", [this]()
+        {
+            UPipeComponent* A = CreatePipe(100.f, 30.f);
+            UPipeComponent* B = CreatePipe(100.f);
+
+            PipeNetworks->Tick(UPipeNetworkSubsystem::SolveInterval);
+
+            A->SetFlowRate(0.f);
+            Connect(B, A);
+
+            PipeNetworks->Tick(0.f);
+
+            TestEqual(TEXT("Volume kept"), PipeNetworks->GetNetwork(B)->Volume, 15.f);
+            TestEqual(TEXT("Fill ratio spread"), B->GetFillRatio(), 0.075f);
+        });
+
+        It("Split a network whose connection is removed", [this]()
+        {
+            UPipeComponent* A = CreatePipe(100.f, 30.f);
+            UPipeComponent* B = CreatePipe(100.f);
+            UPipeComponent* C = CreatePipe(100.f);
+
+            Connect(A, B);
+            Connect(B, C);
+
+            PipeNetworks->Tick(UPipeNetworkSubsystem::SolveInterval);
+
+            A->SetFlowRate(0.f);
+            Disconnect(B, C);
+
+            PipeNetworks->Tick(0.f);
+
+            TestEqual(TEXT("Two networks"), PipeNetworks->GetNumNetworks(), 2);
+            TestTrue(TEXT("A and B together"), PipeNetworks->GetNetwork(A) == PipeNetworks->GetNetwork(B));
+            TestTrue(TEXT("C alone"), PipeNetworks->GetNetwork(A) != PipeNetworks->GetNetwork(C));
+            TestEqual(TEXT("Fill ratio kept by A and B"), A->GetFillRatio(), 0.05f);
+            TestEqual(TEXT("Fill ratio kept by C"), C->GetFillRatio(), 0.05f);
+        });
+
+        It("Split a network whose connecting pipe is removed", [this]()
+        {
+            UPipeComponent* A = CreatePipe(100.f);
+            UPipeComponent* B = CreatePipe(100.f);
+            UPipeComponent* C = CreatePipe(100.f);
+
+            Connect(A, B);
+            Connect(C, B);
+
+            PipeNetworks->Tick(0.f);
+
+            Graph->RemoveNode(B->GetOwner()->FindComponentByClass<UGraphNodeComponent>()->GetNode());
+            B->GetOwner()->Destroy();
+
+            PipeNetworks->Tick(0.f);
+
+            TestEqual(TEXT("Two networks"), PipeNetworks->GetNumNetworks(), 2);
+            TestEqual(TEXT("Capacity of A"), PipeNetworks->GetNetwork(A)->Capacity, 100.f);
+            TestTrue(TEXT("C apart from A"), PipeNetworks->GetNetwork(A) != PipeNetworks->GetNetwork(C));
+        });
+    });
+}
@@ -0,0 +1,220 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Building/BuildingConnectionComponent.h"
+#include "Building/PowerComponent.h"
+#include "Building/PowerSubsystem.h"
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Engine/World.h"
+
+BEGIN_DEFINE_SPEC(FPowerSpec, "JCore.Building.Power",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UWorld* World;
+UPowerSubsystem* Power;
+
+/** Spawns an actor with two unconnected connections and a power component */
+UPowerComponent* CreatePowerComponent(float Supply, float Demand);
+
+/** Connects a free connection of each owner, as snapping them does */
+void Connect(const UPowerComponent* A, const UPowerComponent* B);
+
+void Disconnect(const UPowerComponent* A, const UPowerComponent* B);
+
+END_DEFINE_SPEC(FPowerSpec)
+
+UPowerComponent* FPowerSpec::CreatePowerComponent(float Supply, float Demand)
+{
+    AActor* Owner = World->SpawnActor<AActor>();
+
+    // Created first, so the power component binds to them when it begins play
+    for (int32 ConnectionIndex = 0; ConnectionIndex < 2; ConnectionIndex++)
+    {
+        NewObject<UBuildingConnectionComponent>(Owner)->RegisterComponent();
+    }
+
+    UPowerComponent* PowerComponent = NewObject<UPowerComponent>(Owner);
+
+    PowerComponent->SetPowerSupply(Supply);
+    PowerComponent->SetPowerDemand(Demand);
+
+    PowerComponent->RegisterComponent();
+
+    return PowerComponent;
+}
+
+void FPowerSpec::Connect(const UPowerComponent* A, const UPowerComponent* B)
+{
+    TArray<UBuildingConnectionComponent*> ConnectionsA;
+    A->GetOwner()->GetComponents<UBuildingConnectionComponent>(ConnectionsA);
+
+    TArray<UBuildingConnectionComponent*> ConnectionsB;
+    B->GetOwner()->GetComponents<UBuildingConnectionComponent>(ConnectionsB);
+
+    UBuildingConnectionComponent* ConnectionA = *ConnectionsA.FindByPredicate([](UBuildingConnectionComponent* Connection) { return !Connection->IsConnected(); });
+    UBuildingConnectionComponent* ConnectionB = *ConnectionsB.FindByPredicate([](UBuildingConnectionComponent* Connection) { return !Connection->IsConnected(); });
+
+    ConnectionA->SetConnectedComponent(ConnectionB);
+    ConnectionB->SetConnectedComponent(ConnectionA);
+}
+
+void FPowerSpec::Disconnect(const UPowerComponent* A, const UPowerComponent* B)
+{
+    TArray<UBuildingConnectionComponent*> ConnectionsA;
+    A->GetOwner()->GetComponents<UBuildingConnectionComponent>(ConnectionsA);
+
+    for (UBuildingConnectionComponent* Connection : ConnectionsA)
+    {
+        if (Connection->GetConnectedComponent() && Connection->GetConnectedComponent()->GetOwner() == B->GetOwner())
+        {
+            Connection->DisconnectConnections();
+        }
+    }
+}
+
+void FPowerSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        World = FJCoreSpecUtils::CreateWorld();
+
+        Power = World->GetSubsystem<UPowerSubsystem>();
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::DestroyWorld(World);
+    });
+
+    Describe("Ledger", [this]()
+    {
+        It("Supply the fraction of the demand the network can", [this]()
+        {
+            UPowerComponent* Generator = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* Consumer  = CreatePowerComponent(0.f, 20.f);
+
+            Connect(Generator, Consumer);
+
+            Power->Tick(0.f);
+
+            TestEqual(TEXT("Half satisfied"), Consumer->GetSatisfaction(), 0.5f);
+            TestTrue(TEXT("Same network"), Power->GetNetwork(Generator) == Power->GetNetwork(Consumer));
+        });
+
+        It("Move the ledger by the difference when a component changes", [this]()
+        {
+            UPowerComponent* Generator = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* Consumer  = CreatePowerComponent(0.f, 20.f);
+
+            Connect(Generator, Consumer);
+
+            Consumer->SetPowerDemand(5.f);
+            Generator->SetIsRunning(false);
+
+            const FPowerNetwork* Network = Power->GetNetwork(Consumer);
+
+            TestEqual(TEXT("Supply"), Network->Supply, 0.0);
+            TestEqual(TEXT("Demand"), Network->Demand, 5.0);
+
+            Generator->SetIsRunning(true);
+
+            Power->Tick(0.f);
+
+            TestEqual(TEXT("Supply back in"), Network->Supply, 10.0);
+            TestEqual(TEXT("Satisfied"), Consumer->GetSatisfaction(), 1.f);
+        });
+
+        It("Take a removed component out of the ledger", [this]()
+        {
+            UPowerComponent* Generator = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* Consumer  = CreatePowerComponent(0.f, 20.f);
+
+            Connect(Generator, Consumer);
+
+            Power->Tick(0.f);
+
+            Generator->DestroyComponent();
+
+            Power->Tick(0.f);
+
+            TestEqual(TEXT("No supply left"), Power->GetNetwork(Consumer)->Supply, 0.0);
+            TestEqual(TEXT("Not satisfied"), Consumer->GetSatisfaction(), 0.f);
+        });
+    });
+
+    Describe("Partition", [this]()
+    {
+        It("Merge the networks a connection joins", [this]()
+        {
+            UPowerComponent* A = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* B = CreatePowerComponent(0.f, 10.f);
+            UPowerComponent* C = CreatePowerComponent(0.f, 10.f);
+
+            TestEqual(TEXT("A network each"), Power->GetNumNetworks(), 3);
+
+            Connect(A, B);
+            Connect(B, C);
+
+            TestEqual(TEXT("One network"), Power->GetNumNetworks(), 1);
+            TestEqual(TEXT("Ledger merged"), Power->GetNetwork(A)->Demand, 20.0);
+        });
+
+        It("Only split the network that lost a connection", [this]()
+        {
+            UPowerComponent* A = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* B = CreatePowerComponent(0.f, 10.f);
+            UPowerComponent* C = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* D = CreatePowerComponent(0.f, 10.f);
+
+            Connect(A, B);
+            Connect(C, D);
+
+            Disconnect(A, B);
+
+            TestEqual(TEXT("Three networks"), Power->GetNumNetworks(), 3);
+            TestTrue(TEXT("A and B apart"), Power->GetNetwork(A) != Power->GetNetwork(B));
+            TestTrue(TEXT("C and D together"), Power->GetNetwork(C) == Power->GetNetwork(D));
+            TestEqual(TEXT("Other network's members kept"), Power->GetNetwork(C)->Members.Num(), 2);
+            TestEqual(TEXT("Other network's ledger kept"), Power->GetNetwork(C)->Demand, 10.0);
+        });
+
+        It("Carry the satisfaction over to the parts of a split network", [this]()
+        {
+            UPowerComponent* A = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* B = CreatePowerComponent(0.f, 20.f);
+            UPowerComponent* C = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* D = CreatePowerComponent(0.f, 20.f);
+
+            Connect(A, B);
+            Connect(B, C);
+            Connect(C, D);
+
+            Power->Tick(0.f);
+
+            Disconnect(B, C);
+
+            TestEqual(TEXT("A's part kept the satisfaction"), A->GetSatisfaction(), 0.5f);
+            TestEqual(TEXT("C's part kept the satisfaction"), C->GetSatisfaction(), 0.5f);
+
+            Power->Tick(0.f);
+
+            TestEqual(TEXT("Still half satisfied"), D->GetSatisfaction(), 0.5f);
+        });
+
+        It("Balance a merged network whose parts ran at different satisfactions", [this]()
+        {
+            UPowerComponent* Generator = CreatePowerComponent(10.f, 0.f);
+            UPowerComponent* Consumer  = CreatePowerComponent(0.f, 20.f);
+
+            Power->Tick(0.f);
+
+            TestEqual(TEXT("Unsupplied"), Consumer->GetSatisfaction(), 0.f);
+
+            Connect(Generator, Consumer);
+
+            Power->Tick(0.f);
+
+            TestEqual(TEXT("Half satisfied"), Consumer->GetSatisfaction(), 0.5f);
+        });
+    });
+}
@@ -0,0 +1,395 @@
+﻿#include "Misc/AutomationTest.h"
+
+#include "Inventory/InventoryComponent.h"
+#include "Inventory/ItemConsumingComponent.h"
+#include "Inventory/ItemGeneratingComponent.h"
+#include "Inventory/ItemRegistrySubsystem.h"
+#include "Inventory/ProductionSubsystem.h"
+#include "Testing/JCoreSpecUtils.h"
+
+#include "Engine/World.h"
+
+BEGIN_DEFINE_SPEC(FProductionSpec, "JCore.Inventory.Production",
+                  EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+UItemDataAsset* TestItemAsset;
+UWorld* World;
+UProductionSubsystem* Production;
+AActor* Owner;
+UInventoryComponent* TestInventoryComponent;
+
+UItemGeneratingComponent* CreateGenerator(EProductionMode Mode, float Period = 1.f);
+
+UItemConsumingComponent* CreateConsumer(EProductionMode Mode, float Period = 1.f);
+
+/**
+ *  Runs a generator and two consumers that often fire at the same time on a one slot inventory, returns the items left after Seconds
+ *
+ *  @param bFastForward  Advance through UProductionSubsystem::FastForward instead of ticking every second
+ */
+int32 RunContendedProduction(EProductionMode Mode, double Seconds, float GeneratorPeriod, bool bFastForward = false);
+
+/** Runs the production subsystem once per second from the current world time up to Seconds */
+void AdvanceTo(double Seconds);
+
+END_DEFINE_SPEC(FProductionSpec)
+
+UItemGeneratingComponent* FProductionSpec::CreateGenerator(EProductionMode Mode, float Period)
+{
+    UItemGeneratingComponent* Generator = NewObject<UItemGeneratingComponent>(Owner);
+    Generator->RegisterComponent();
+
+    Generator->SetProductionMode(Mode);
+    Generator->SetTimeToGenerate(Period);
+
+    return Generator;
+}
+
+UItemConsumingComponent* FProductionSpec::CreateConsumer(EProductionMode Mode, float Period)
+{
+    UItemConsumingComponent* Consumer = NewObject<UItemConsumingComponent>(Owner);
+    Consumer->RegisterComponent();
+
+    Consumer->SetProductionMode(Mode);
+    Consumer->SetTimeToConsume(Period);
+
+    return Consumer;
+}
+
+int32 FProductionSpec::RunContendedProduction(EProductionMode Mode, double Seconds, float GeneratorPeriod, bool bFastForward)
+{
+    UInventoryComponent* Inventory = NewObject<UInventoryComponent>();
+    Inventory->SetNumberOfSlots(1);
+    Inventory->InitializeInventorySlots();
+
+    // Registered first, so it fires before the generator whenever both are due at the same time and often finds nothing
+    UItemConsumingComponent* Consumer = CreateConsumer(Mode, 1.f);
+    Consumer->SetInventoryComponent(Inventory);
+    Consumer->SetItemToConsume(TestItemAsset);
+    Consumer->StartConsuming();
+
+    UItemGeneratingComponent* Generator = CreateGenerator(Mode, GeneratorPeriod);
+    Generator->SetInventoryComponent(Inventory);
+    Generator->SetItemToGenerate(TestItemAsset);
+    Generator->StartGenerating();
+
+    UItemConsumingComponent* SlowConsumer = CreateConsumer(Mode, 1.5f);
+    SlowConsumer->SetInventoryComponent(Inventory);
+    SlowConsumer->SetItemToConsume(TestItemAsset);
+    SlowConsumer->StartConsuming();
+
+    if (bFastForward)
+    {
+        Production->FastForward(Seconds);
+    }
+    else
+    {
+        AdvanceTo(World->TimeSeconds + Seconds);
+    }
+
+    Inventory->SettleProduction();
+
+    const int32 NumItems = Inventory->ContainsItem(TestItemAsset);
+
+    Consumer->StopConsuming();
+    Generator->StopGenerating();
+    SlowConsumer->StopConsuming();
+
+    return NumItems;
+}
+
+void FProductionSpec::AdvanceTo(double Seconds)
+{
+    while (World->TimeSeconds < Seconds)
+    {
+        World->TimeSeconds = FMath::Min(World->TimeSeconds + 1.0, Seconds);
+
+        Production->Tick(0.f);
+    }
+}
+
+void FProductionSpec::Define()
+{
+    BeforeEach([this]()
+    {
+        if (!TestItemAsset)
+        {
+            TestItemAsset = LoadObject<UItemDataAsset>(nullptr, TEXT("/Script/JCore.ItemDataAsset'/JCore/Testing/DA_TestingItem.DA_TestingItem'"));
+        }
+
+        World = FJCoreSpecUtils::CreateWorld();
+
+        Production = World->GetSubsystem<UProductionSubsystem>();
+
+        Owner = World->SpawnActor<AActor>();
+
+        TestInventoryComponent = NewObject<UInventoryComponent>();
+        TestInventoryComponent->SetNumberOfSlots(10);
+        TestInventoryComponent->InitializeInventorySlots();
+    });
+
+    AfterEach([this]()
+    {
+        FJCoreSpecUtils::DestroyWorld(World);
+    });
+
+    Describe("Discrete", [this]()
+    {
+        It("Generate one item per period", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Discrete);
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+            Generator->StartGenerating();
+
+            AdvanceTo(10.0);
+
+            TestEqual(TEXT("Ten items generated"), TestInventoryComponent->ContainsItem(TestItemAsset), 10);
+        });
+
+        It("Drop the period no machine runs at any more", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Discrete, 1.f);
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+            Generator->StartGenerating();
+
+            UItemGeneratingComponent* SlowGenerator = CreateGenerator(EProductionMode::Discrete, 2.f);
+            SlowGenerator->SetInventoryComponent(TestInventoryComponent);
+            SlowGenerator->SetItemToGenerate(TestItemAsset);
+            SlowGenerator->StartGenerating();
+
+            TestEqual(TEXT("One bucket per period"), Production->GetNumBuckets(), 2);
+
+            Generator->StopGenerating();
+
+            TestEqual(TEXT("Bucket of the stopped generator dropped"), Production->GetNumBuckets(), 1);
+
+            AdvanceTo(4.0);
+
+            TestEqual(TEXT("The other generator keeps running"), TestInventoryComponent->ContainsItem(TestItemAsset), 2);
+        });
+
+        It("Keep the item in progress when the throughput scale changes", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Discrete, 2.f);
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+            Generator->StartGenerating();
+
+            // Half of the item is done, the other half takes two seconds at half the throughput
+            AdvanceTo(1.0);
+            Generator->SetThroughputScale(0.5f);
+            AdvanceTo(3.0);
+
+            TestEqual(TEXT("One item generated"), TestInventoryComponent->ContainsItem(TestItemAsset), 1);
+
+            // A quarter of the next item is done when it is paused
+            AdvanceTo(4.0);
+            Generator->SetThroughputScale(0.f);
+            AdvanceTo(10.0);
+
+            TestEqual(TEXT("Nothing generated while paused"), TestInventoryComponent->ContainsItem(TestItemAsset), 1);
+
+            Generator->SetThroughputScale(1.f);
+            AdvanceTo(12.0);
+
+            TestEqual(TEXT("The rest generated at full throughput"), TestInventoryComponent->ContainsItem(TestItemAsset), 2);
+        });
+
+        It("Consume one item per period", [this]()
+        {
+            TestInventoryComponent->AddItemAmount(TestItemAsset, 10);
+
+            UItemConsumingComponent* Consumer = CreateConsumer(EProductionMode::Discrete);
+            Consumer->SetInventoryComponent(TestInventoryComponent);
+            Consumer->SetItemToConsume(TestItemAsset);
+            Consumer->StartConsuming();
+
+            AdvanceTo(4.0);
+
+            TestEqual(TEXT("Four items consumed"), TestInventoryComponent->ContainsItem(TestItemAsset), 6);
+        });
+
+        It("Generate once the inventory and item are set after starting", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Discrete);
+            Generator->StartGenerating();
+
+            TestTrue(TEXT("Machine registered"), Production->IsMachineRegistered(Generator));
+
+            AdvanceTo(2.5);
+
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+
+            AdvanceTo(5.0);
+
+            TestEqual(TEXT("Only the fires after the setup generate"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+        });
+
+        It("Consume once the inventory and item are set after starting", [this]()
+        {
+            TestInventoryComponent->AddItemAmount(TestItemAsset, 10);
+
+            UItemConsumingComponent* Consumer = CreateConsumer(EProductionMode::Discrete);
+            Consumer->StartConsuming();
+
+            AdvanceTo(2.5);
+
+            Consumer->SetInventoryComponent(TestInventoryComponent);
+            Consumer->SetItemToConsume(TestItemAsset);
+
+            AdvanceTo(5.0);
+
+            TestEqual(TEXT("Only the fires after the setup consume"), TestInventoryComponent->ContainsItem(TestItemAsset), 7);
+        });
+    });
+
+    Describe("Analytic", [this]()
+    {
+        It("Generate once the inventory and item are set after starting", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Analytic);
+            Generator->StartGenerating();
+
+            TestTrue(TEXT("Machine registered"), Production->IsMachineRegistered(Generator));
+
+            AdvanceTo(2.5);
+
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+
+            AdvanceTo(5.0);
+
+            TestInventoryComponent->SettleProduction();
+
+            TestEqual(TEXT("Only the fires after the setup generate"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+        });
+
+        It("Not settle on reads", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Analytic);
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+            Generator->StartGenerating();
+
+            World->TimeSeconds = 3.0;
+
+            TestEqual(TEXT("Reads see the settled items"), TestInventoryComponent->ContainsItem(TestItemAsset), 0);
+
+            TestInventoryComponent->SettleProduction();
+
+            TestEqual(TEXT("Settling applies the fires up to now"), TestInventoryComponent->ContainsItem(TestItemAsset), 3);
+        });
+    });
+
+    Describe("Discrete and Analytic", [this]()
+    {
+        It("End with the same items when the machines contend for the items", [this]()
+        {
+            const int32 DiscreteItems = RunContendedProduction(EProductionMode::Discrete, 12.0, 0.5f);
+            const int32 AnalyticItems = RunContendedProduction(EProductionMode::Analytic, 12.0, 0.5f);
+
+            TestEqual(TEXT("Same items left"), AnalyticItems, DiscreteItems);
+        });
+
+        It("End with the same items when the generator fills the inventory", [this]()
+        {
+            const int32 MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(UItemRegistrySubsystem::GetItemId(TestItemAsset));
+
+            // Four generates per second against less than two consumes, so the one slot fills within MaxStackSize seconds.
+            // Only the generator fires at the end, so the slot is full then
+            const double Seconds = MaxStackSize + 4.25;
+
+            const int32 DiscreteItems = RunContendedProduction(EProductionMode::Discrete, Seconds, 0.25f);
+            const int32 AnalyticItems = RunContendedProduction(EProductionMode::Analytic, Seconds, 0.25f);
+
+            TestEqual(TEXT("Inventory filled"), DiscreteItems, MaxStackSize);
+            TestEqual(TEXT("Same items left"), AnalyticItems, DiscreteItems);
+        });
+    });
+
+    Describe("FastForward", [this]()
+    {
+        It("Match discrete stepping within one step", [this]()
+        {
+            const int32 SteppedItems       = RunContendedProduction(EProductionMode::Discrete, 12.0, 0.5f);
+            const int32 FastForwardedItems = RunContendedProduction(EProductionMode::Discrete, 12.0, 0.5f, true);
+
+            TestEqual(TEXT("Same items left"), FastForwardedItems, SteppedItems);
+        });
+
+        It("Match discrete stepping over several steps", [this]()
+        {
+            const double Seconds = 3.5 * UProductionSubsystem::FastForwardStepSeconds;
+
+            const int32 SteppedItems       = RunContendedProduction(EProductionMode::Discrete, Seconds, 0.25f);
+            const int32 FastForwardedItems = RunContendedProduction(EProductionMode::Discrete, Seconds, 0.25f, true);
+            const int32 AnalyticItems      = RunContendedProduction(EProductionMode::Analytic, Seconds, 0.25f, true);
+
+            TestEqual(TEXT("Discrete machines end with the same items"), FastForwardedItems, SteppedItems);
+            TestEqual(TEXT("Analytic machines end with the same items"), AnalyticItems, SteppedItems);
+        });
+
+        It("Generate one item per period of the elapsed time", [this]()
+        {
+            UItemGeneratingComponent* Generator = CreateGenerator(EProductionMode::Discrete);
+            Generator->SetInventoryComponent(TestInventoryComponent);
+            Generator->SetItemToGenerate(TestItemAsset);
+            Generator->StartGenerating();
+
+            Production->FastForward(5.5);
+
+            TestEqual(TEXT("Five items generated"), TestInventoryComponent->ContainsItem(TestItemAsset), 5);
+
+            AdvanceTo(1.0);
+
+            TestEqual(TEXT("Keeps the phase after the fast-forward"), TestInventoryComponent->ContainsItem(TestItemAsset), 6);
+        });
+    });
+
+    Describe("Simulated", [this]()
+    {
+        It("Publish the generates that did not fit once there is room", [this]()
+        {
+            UInventoryComponent* FilledInventory = NewObject<UInventoryComponent>();
+            FilledInventory->SetNumberOfSlots(1);
+            FilledInventory->InitializeInventorySlots();
+
+            UInventoryComponent* FreeInventory = NewObject<UInventoryComponent>();
+            FreeInventory->SetNumberOfSlots(1);
+            FreeInventory->InitializeInventorySlots();
+
+            UItemGeneratingComponent* FilledGenerator = CreateGenerator(EProductionMode::Simulated);
+            FilledGenerator->SetInventoryComponent(FilledInventory);
+            FilledGenerator->SetItemToGenerate(TestItemAsset);
+            FilledGenerator->StartGenerating();
+
+            UItemGeneratingComponent* FreeGenerator = CreateGenerator(EProductionMode::Simulated);
+            FreeGenerator->SetInventoryComponent(FreeInventory);
+            FreeGenerator->SetItemToGenerate(TestItemAsset);
+            FreeGenerator->StartGenerating();
+
+            // The second tick publishes the first run and launches one to the current time
+            AdvanceTo(2.0);
+
+            const int32 NumPublishedItems = FilledInventory->ContainsItem(TestItemAsset);
+
+            // Filled while the run is going, so what it generated no longer fits when it is published
+            FilledInventory->AddItemAmount(TestItemAsset, MAX_int32);
+
+            FilledGenerator->StopGenerating();
+            FreeGenerator->StopGenerating();
+
+            AdvanceTo(3.0);
+
+            FilledInventory->TryRemoveItem(TestItemAsset, FilledInventory->ContainsItem(TestItemAsset));
+
+            AdvanceTo(4.0);
+
+            TestTrue(TEXT("The run generated items"), FreeInventory->ContainsItem(TestItemAsset) > NumPublishedItems);
+            TestEqual(TEXT("No generated item lost"), FilledInventory->ContainsItem(TestItemAsset), FreeInventory->ContainsItem(TestItemAsset) - NumPublishedItems);
+        });
+    });
+}
@@ -39,6 +39,10 @@ public:
     UFUNCTION(BlueprintCallable)
     const FVector& GetSize() const;
 
+    /** Sets the size placement is checked with, moving a finished buildable's footprint in the occupancy index */
+    UFUNCTION(BlueprintCallable)
+    void SetSize(const FVector& InSize);
+
     UFUNCTION(BlueprintCallable)
     const FVector& GetOriginOffset() const;
 
@@ -62,6 +66,9 @@ public:
 
     const FVector& GetBuildingOffset() const;
 
+    /** Half extents of the box placement is checked with, the size less a cushion so that neighbors sharing an edge fit */
+    FVector GetOverlapHalfExtents() const;
+
     virtual void CompleteBuilding(UBuildingConnectionComponent* FromSnapConnection, UBuildingConnectionComponent* ToSnapConnection) override;
 
     virtual void GetOpenConnectionComponents(TArray<UBuildingConnectionComponent*>& OutConnectionComponents) const override;
@@ -76,6 +83,12 @@ public:
 
     void SetIsPreviewing(bool InIsPreviewing);
 
+    /** Draws the bounds every frame while set */
+    UFUNCTION(BlueprintCallable)
+    void SetDebug(bool bInDebug);
+
+    bool IsPreviewing() const { return this->bIsPreviewing; }
+
     void SetCollisionProfileName(const FName InCollisionProfileName);
 
     bool IsPlacementValid() const;
@@ -89,17 +102,33 @@ public:
     UFUNCTION(BlueprintCallable)
     virtual void GetSnapTransformsOfType(EBuildingSnapType InSnapType, TArray<FTransform>& OutSnapTransforms) const;
 
+    /** World space snap transforms of the given type, cached until the buildable moves. Valid until the next move or SetSnapTransformsOfType */
+    TArrayView<const FTransform> GetWorldSnapTransformsOfType(EBuildingSnapType InSnapType) const;
+
     virtual void OnActorLoaded_Implementation() override;
 
 protected:
     virtual void BeginPlay() override;
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     virtual void Destroyed() override;
 
+    /** Ticks only while there is per frame work, which is checking the placement while previewing and drawing the debug bounds */
+    void UpdateTickEnabled();
+
     bool RemoveGraphNode();
 
     void UpdatePreviewing();
 
+    /** Adds a finished buildable to the UBuildingOccupancySubsystem and removes a preview from it */
+    void UpdateOccupancy();
+
+    void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+    /** Transforms the snap transforms of every type to world space */
+    void UpdateWorldSnapTransforms() const;
+
     UFUNCTION()
     virtual void OnConnectionConnected(UBuildingConnectionComponent* FromConnectedConnection,
                                        UBuildingConnectionComponent* ToConnectedConnection);
@@ -155,11 +184,17 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     EBuildingSnapType SnapType;
 
+    /** Set through SetDebug at runtime, so the buildable starts ticking */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Debug")
     bool bDebug;
 
     TMap<EBuildingSnapType, TArray<FTransform>> SnapTransforms;
 
+    /** SnapTransforms in world space, rebuilt on the first read after the buildable moved */
+    mutable TMap<EBuildingSnapType, TArray<FTransform>> WorldSnapTransforms;
+
+    mutable bool bWorldSnapTransformsDirty = true;
+
     UPROPERTY(EditAnywhere)
     TArray<UBuildingConnectionComponent*> BuildingConnectionComponents;
 };
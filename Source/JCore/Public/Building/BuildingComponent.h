@@ -33,6 +33,8 @@ class JCORE_API UBuildingComponent : public UActorComponent
 public:
     UBuildingComponent();
 
+    virtual void BeginPlay() override;
+
     virtual void TickComponent(float DeltaTime, ELevelTick TickType,
                                FActorComponentTickFunction* ThisTickFunction) override;
 
@@ -13,6 +13,18 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnConnectionDisconnected, UBuilding
 
 DECLARE_LOG_CATEGORY_CLASS(LogBuildingConnectionComponent, Log, All);
 
+/** Which way items flow through a connection, for transport buildables like conveyors */
+UENUM(BlueprintType)
+enum class EBuildingConnectionDirection : uint8
+{
+    /** Nothing flows through the connection */
+    None,
+    /** Items enter the buildable here */
+    Input,
+    /** Items leave the buildable here */
+    Output
+};
+
 UCLASS(Blueprintable, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class JCORE_API UBuildingConnectionComponent: public UArrowComponent
 {
@@ -36,6 +48,9 @@ public:
 
     const FTransform& GetSnapTransform() const;
 
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    EBuildingConnectionDirection GetDirection() const { return this->Direction; }
+
     UPROPERTY(BlueprintAssignable)
     FOnConnectionConnected OnConnectionConnected;
 
@@ -45,4 +60,7 @@ public:
 private:
     UPROPERTY(EditAnywhere)
     UBuildingConnectionComponent* ConnectedComponent;
+
+    UPROPERTY(EditAnywhere)
+    EBuildingConnectionDirection Direction = EBuildingConnectionDirection::None;
 };
@@ -0,0 +1,86 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "BuildingOccupancySubsystem.generated.h"
+
+class ABuildable;
+
+DECLARE_LOG_CATEGORY_CLASS(LogBuildingOccupancySubsystem, Log, All)
+
+enum class EBuildingOccupancy : uint8
+{
+    Free,
+    Occupied,
+    /** The footprint or an occupant it may overlap is not aligned to the grid, a physics overlap has to decide */
+    Unknown
+};
+
+/**
+ *  Index of the footprints of the finished buildables of the world, hashed by the cells of the UBuildingComponent's grid.
+ *
+ *  Footprints rotated by multiples of 90 degrees around the up axis are axis aligned boxes and are checked against each other
+ *  exactly, so placement checks need no physics overlap. Anything else is answered with EBuildingOccupancy::Unknown.
+ */
+UCLASS()
+class JCORE_API UBuildingOccupancySubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    /** Sets the grid the cells are hashed by, rehashing the footprints if it changed */
+    void SetGrid(const FVector& InTileSize, const FVector& InOffset);
+
+    /** Adds the buildable's footprint or moves it to where the buildable is now */
+    void AddBuildable(ABuildable* Buildable);
+
+    void RemoveBuildable(const ABuildable* Buildable);
+
+    /**
+     *  Checks whether a footprint overlaps the footprint of a finished buildable
+     *
+     *  @param Center  Center of the footprint
+     *  @param Rotation  Rotation of the footprint
+     *  @param HalfExtents  Half extents of the footprint before rotating it, already less the overlap cushion
+     *  @param IgnoredActor  Buildable whose own footprint is not checked against
+     */
+    EBuildingOccupancy QueryFootprint(const FVector& Center, const FQuat& Rotation, const FVector& HalfExtents, const AActor* IgnoredActor = nullptr) const;
+
+    int32 GetNumBuildables() const { return this->Footprints.Num(); }
+
+protected:
+    struct FBuildingFootprint
+    {
+        /** Bounds of the footprint, the footprint itself if it is grid aligned */
+        FBox Box = FBox(ForceInit);
+
+        bool bGridAligned = false;
+    };
+
+    /**
+     *  Gets the world box of a footprint
+     *
+     *  @return True if the box is the footprint, false if it only bounds a footprint that is not grid aligned
+     */
+    static bool GetFootprintBox(const FVector& Center, const FQuat& Rotation, const FVector& HalfExtents, FBox& OutBox);
+
+    /** Calls the function with every cell the box touches */
+    void ForEachCell(const FBox& Box, TFunctionRef<void(const FIntVector&)> Function) const;
+
+    void AddToCells(const ABuildable* Buildable, const FBox& Box);
+
+    void RemoveFromCells(const ABuildable* Buildable, const FBox& Box);
+
+    FVector TileSize = FVector(100.0, 100.0, 100.0);
+
+    FVector Offset = FVector(50.0, 50.0, 0.0);
+
+    TMap<const ABuildable*, FBuildingFootprint> Footprints;
+
+    TMap<FIntVector, TArray<const ABuildable*>> Cells;
+};
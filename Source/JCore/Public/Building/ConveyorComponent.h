@@ -0,0 +1,159 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "Building/BuildingConnectionComponent.h"
+
+#include "ConveyorComponent.generated.h"
+
+class UConveyorComponent;
+
+/**
+ *  Items of the segment a conveyor starts, so clients can move and draw them without building the segments.
+ *  Sent whole when the segment is rebuilt and when the conveyor becomes relevant to a client, FConveyorSegmentEvents in between.
+ */
+USTRUCT()
+struct FConveyorSegmentState
+{
+    GENERATED_BODY()
+
+    /** Sequence of the last event this state contains */
+    UPROPERTY()
+    int32 Sequence = 0;
+
+    /** Conveyors of the segment from its start, empty if the conveyor starts none */
+    UPROPERTY()
+    TArray<UConveyorComponent*> Conveyors;
+
+    UPROPERTY()
+    bool bIsLoop = false;
+
+    /** Items front to back with the gap to the item ahead, as in FConveyorSegment */
+    UPROPERTY()
+    TArray<uint16> ItemIds;
+
+    UPROPERTY()
+    TArray<float> Gaps;
+
+    UPROPERTY()
+    float TailGap = 0.f;
+
+    /** Server world time the items were at these gaps, clients move them by the time since */
+    UPROPERTY()
+    double ServerTime = 0.0;
+};
+
+/** Items that left and entered a segment since its last update, all clients need as the belt moves the same on them */
+USTRUCT()
+struct FConveyorSegmentEvent
+{
+    GENERATED_BODY()
+
+    /** One more than the sequence of the previous event or state */
+    UPROPERTY()
+    int32 Sequence = 0;
+
+    /** Items taken off the end of the belt */
+    UPROPERTY()
+    int32 NumPopped = 0;
+
+    /** Items put on the start of the belt, in order */
+    UPROPERTY()
+    TArray<uint16> PushedItemIds;
+
+    /** Distance from the last item to the start of the belt after the event */
+    UPROPERTY()
+    float TailGap = 0.f;
+
+    /** Server world time of the event */
+    UPROPERTY()
+    double ServerTime = 0.0;
+};
+
+/**
+ *  Makes its buildable a conveyor belt from its EBuildingConnectionDirection::Input connection to its Output connection.
+ *  The UConveyorSubsystem merges connected conveyors into segments and moves the items, the component only describes the belt.
+ *  The first conveyor of a segment replicates the segment's items, clients move them on between updates.
+ *
+ *  SegmentState is pushed but never marked dirty for events, so it only goes out in full when a client opens the conveyor's channel.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class JCORE_API UConveyorComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UConveyorComponent();
+
+    virtual void BeginPlay() override;
+
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+    virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+    /** Connection of the owner items enter the belt at, nullptr if it has none */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Conveyor")
+    UBuildingConnectionComponent* GetInputConnection() const;
+
+    /** Connection of the owner items leave the belt at, nullptr if it has none */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Conveyor")
+    UBuildingConnectionComponent* GetOutputConnection() const;
+
+    /** Whether the owner is a finished buildable with an input and an output */
+    bool IsTransporting() const;
+
+    float GetSpeed() const { return this->Speed; }
+
+    float GetItemSpacing() const { return this->ItemSpacing; }
+
+    /** Has the UConveyorSubsystem rebuild the segments of this conveyor and its neighbours in its next tick */
+    void MarkSegmentsDirty();
+
+    const FConveyorSegmentState& GetSegmentState() const { return this->SegmentState; }
+
+    /** Sends the items of the segment this conveyor starts to every client, by the UConveyorSubsystem on the server when it rebuilt the segment */
+    void SendSegmentState(FConveyorSegmentState&& InSegmentState);
+
+    /** Sends the items that left and entered the segment this conveyor starts, by the UConveyorSubsystem on the server */
+    void SendSegmentEvent(const FConveyorSegmentEvent& Event);
+
+    /** Keeps the state for clients that open the conveyor's channel later without sending it to the others */
+    void SetSegmentState(FConveyorSegmentState&& InSegmentState);
+
+protected:
+    UFUNCTION()
+    void OnConnectionConnected(UBuildingConnectionComponent* OwnConnection, UBuildingConnectionComponent* OtherConnection);
+
+    UFUNCTION()
+    void OnConnectionDisconnected(UBuildingConnectionComponent* OwnConnection);
+
+    UBuildingConnectionComponent* FindConnection(EBuildingConnectionDirection Direction) const;
+
+    UFUNCTION()
+    void OnRep_SegmentState();
+
+    UFUNCTION(NetMulticast, Reliable)
+    void MulticastSegmentState(const FConveyorSegmentState& InSegmentState);
+
+    UFUNCTION(NetMulticast, Reliable)
+    void MulticastSegmentEvent(const FConveyorSegmentEvent& Event);
+
+    /** Distance an item moves per second */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Conveyor", meta=(ClampMin=0))
+    float Speed = 200.f;
+
+    /** Distance between items queued up on the belt */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Conveyor", meta=(ClampMin=1))
+    float ItemSpacing = 50.f;
+
+    UPROPERTY(ReplicatedUsing=OnRep_SegmentState)
+    FConveyorSegmentState SegmentState;
+
+    /** Events were sent since SegmentState was written, it is brought up to date before the next replication */
+    bool bSegmentStateStale = false;
+};
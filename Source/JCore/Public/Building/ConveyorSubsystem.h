@@ -0,0 +1,258 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ConveyorSubsystem.generated.h"
+
+class UBuildingConnectionComponent;
+class UConveyorComponent;
+class UInstancedStaticMeshComponent;
+class UInventoryComponent;
+
+struct FConveyorSegmentEvent;
+struct FConveyorSegmentState;
+
+DECLARE_LOG_CATEGORY_CLASS(LogConveyorSubsystem, Log, All)
+
+/** One conveyor of a segment, its belt copied out so moving and drawing the items never touches the component */
+struct FConveyorSegmentPart
+{
+    TWeakObjectPtr<UConveyorComponent> Conveyor;
+
+    FVector Start = FVector::ZeroVector;
+
+    FVector End = FVector::ZeroVector;
+
+    /** Distance from the start of the segment to the start of this conveyor */
+    float StartDistance = 0.f;
+
+    float Length = 0.f;
+};
+
+/** Range of the instances of one item a segment draws its items of that item with */
+struct FConveyorInstanceBlock
+{
+    uint16 ItemId = 0;
+
+    int32 FirstInstance = 0;
+
+    int32 NumInstances = 0;
+
+    /** Instances from the first that show an item, the rest are hidden */
+    int32 NumUsed = 0;
+};
+
+/**
+ *  Connected conveyors merged into one belt.
+ *
+ *  Items are stored front to back from FrontIndex on as an item id and the gap to the item ahead of it,
+ *  the front item's gap being its distance to the end of the belt. Moving the belt only shrinks the gap in front of the first
+ *  item that can still move, which moves every item behind it as well, so a segment advances in O(1) amortized.
+ */
+struct FConveyorSegment
+{
+    TArray<FConveyorSegmentPart> Parts;
+
+    float Length = 0.f;
+
+    /** Slowest speed of the segment's conveyors */
+    float Speed = 0.f;
+
+    /** Largest item spacing of the segment's conveyors */
+    float ItemSpacing = 0.f;
+
+    /** The end feeds back into the start */
+    bool bIsLoop = false;
+
+    TArray<uint16> ItemIds;
+
+    TArray<float> Gaps;
+
+    /** Index of the front item, the entries before it left the belt and are dropped in batches */
+    int32 FrontIndex = 0;
+
+    /** First item that can still move, the ones in front of it are queued up at the end of the belt */
+    int32 MovingIndex = 0;
+
+    /** Distance from the last item to the start of the belt, the length if the belt is empty */
+    float TailGap = 0.f;
+
+    TWeakObjectPtr<UInventoryComponent> SourceInventory;
+
+    TWeakObjectPtr<UInventoryComponent> SinkInventory;
+
+    /** Instances the segment draws its items with, one block per item it carried */
+    TArray<FConveyorInstanceBlock> InstanceBlocks;
+
+    /** Items moved since the instances were last updated */
+    bool bInstancesDirty = true;
+
+    /** The segment was rebuilt and clients need all of its items */
+    bool bStateDirty = true;
+
+    /** Sequence of the last state or event sent to or applied from the server */
+    int32 Sequence = 0;
+
+    /** Items taken off the end since the last event, moving alone is repeated by the clients */
+    int32 NumPoppedSinceEvent = 0;
+
+    /** Items put on the start since the last event */
+    TArray<uint16> PushedSinceEvent;
+
+    bool HasPendingEvent() const { return this->NumPoppedSinceEvent > 0 || this->PushedSinceEvent.Num() > 0; }
+
+    int32 GetNumItems() const { return this->ItemIds.Num() - this->FrontIndex; }
+
+    /** Moves the items towards the end by the given distance, until they queue up there */
+    void Advance(float Distance);
+
+    bool CanPushBack() const { return this->GetNumItems() == 0 || this->TailGap >= this->ItemSpacing; }
+
+    /** Puts an item at the start of the belt, check CanPushBack first */
+    void PushBack(uint16 ItemId);
+
+    bool IsFrontAtEnd() const { return this->GetNumItems() > 0 && this->Gaps[this->FrontIndex] <= KINDA_SMALL_NUMBER; }
+
+    /** Takes the front item off the belt */
+    uint16 PopFront();
+
+    /** Takes the event's popped items off the end and puts its pushed ones on the start, as the server did */
+    void ApplyEventItems(const FConveyorSegmentEvent& Event);
+};
+
+/**
+ *  Moves the items of every UConveyorComponent in the world.
+ *
+ *  Chains of connected conveyors, an Output connection snapped to the next conveyor's Input connection, are merged into
+ *  FConveyorSegments. A segment takes items from the UInventoryComponent of the buildable its start is connected to and hands
+ *  them to the one at its end. Items in transit are no actors, they are drawn with one instanced static mesh per item,
+ *  each segment updating only its own range of the instances and only when its items moved.
+ *
+ *  Segments are built where the world has authority, which is where the endpoint inventories are changed. A change to a conveyor
+ *  only rebuilds the segments it and its neighbours are on. Clients get a segment's items from its first conveyor, as a whole
+ *  FConveyorSegmentState after a rebuild or when the conveyor becomes relevant and as FConveyorSegmentEvents of the items
+ *  leaving and entering the belt in between, and move and draw them the same way.
+ */
+UCLASS()
+class JCORE_API UConveyorSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    void RegisterConveyor(UConveyorComponent* Conveyor);
+
+    /** Removes a conveyor, the items on it are lost */
+    void UnregisterConveyor(UConveyorComponent* Conveyor);
+
+    /** Replaces the segment a conveyor starts by its replicated state unless the segment is ahead of it, only used on clients */
+    void ApplySegmentState(UConveyorComponent* Conveyor);
+
+    /** Pops and pushes the items of an event on the segment a conveyor starts, only used on clients */
+    void ApplySegmentEvent(UConveyorComponent* Conveyor, const FConveyorSegmentEvent& Event);
+
+    /** Writes the current items of the segment a conveyor starts to its state, without sending it */
+    void WriteSegmentState(UConveyorComponent* Conveyor) const;
+
+    /** Rebuilds the segments of the conveyor and its neighbours in the next tick, keeping the items where they are */
+    void MarkConveyorDirty(UConveyorComponent* Conveyor);
+
+    int32 GetNumSegments() const { return this->Segments.Num(); }
+
+    int32 GetNumItemsInTransit() const;
+
+protected:
+    /** Rebuilds the dirty segments and the ones of the dirty conveyors, the others keep their items and instances */
+    void RebuildSegments();
+
+    /**
+     *  Builds the segment starting at the given conveyor, following the outputs until a conveyor that was visited already
+     *  or is on a segment that was not rebuilt
+     */
+    void BuildSegment(UConveyorComponent* FirstConveyor, TSet<const UConveyorComponent*>& VisitedConveyors);
+
+    /** Adds a conveyor to the end of a segment */
+    static void AddSegmentPart(FConveyorSegment& Segment, UConveyorComponent* Conveyor);
+
+    /** Hands the items at the end to the sink and takes the next item from the source */
+    void TransferItems(FConveyorSegment& Segment);
+
+    /** Sends the segment's items to the clients through its first conveyor, all of them after a rebuild and the event otherwise */
+    void ReplicateSegment(FConveyorSegment& Segment);
+
+    /** All items of the segment as the clients get them */
+    FConveyorSegmentState MakeSegmentState(const FConveyorSegment& Segment) const;
+
+    /** Removes the segment a conveyor starts on a client */
+    void RemoveReplicatedSegment(const UConveyorComponent* Conveyor);
+
+    /** Moves the segment's item instances to the items' positions */
+    void UpdateSegmentInstances(FConveyorSegment& Segment);
+
+    /** Hides the segment's instances and keeps their blocks for other segments */
+    void ReleaseInstanceBlocks(FConveyorSegment& Segment);
+
+    /** Gets a block of at least the given number of hidden instances of an item, nullptr if the item has no mesh */
+    FConveyorInstanceBlock* AllocateInstanceBlock(FConveyorSegment& Segment, uint16 ItemId, int32 NumInstances);
+
+    /** Writes the transforms to the block's instances and hides the rest of the ones it used */
+    void WriteInstanceBlock(FConveyorInstanceBlock& Block, TArray<FTransform>& Transforms);
+
+    UInstancedStaticMeshComponent* GetItemInstances(uint16 ItemId);
+
+    /** World time on the server, segment states are stamped with it */
+    double GetServerWorldTime() const;
+
+    /** Whether segments are built here from the connections, instead of replicated */
+    bool HasSegmentAuthority() const;
+
+    /** Conveyor the given conveyor's output is connected to the input of, nullptr if none */
+    static UConveyorComponent* GetNextConveyor(const UConveyorComponent* Conveyor);
+
+    /** Conveyor whose output is connected to the given conveyor's input, nullptr if none */
+    static UConveyorComponent* GetPreviousConveyor(const UConveyorComponent* Conveyor);
+
+    /** Inventory of the buildable the connection is snapped to */
+    static UInventoryComponent* GetConnectedInventory(UBuildingConnectionComponent* Connection);
+
+    TArray<TWeakObjectPtr<UConveyorComponent>> Conveyors;
+
+    TArray<FConveyorSegment> Segments;
+
+    bool bSegmentsDirty = false;
+
+    /** Conveyors changed since the last rebuild */
+    TArray<TWeakObjectPtr<UConveyorComponent>> DirtyConveyors;
+
+    /** Segments the changed conveyors were on or next to, rebuilt in the next tick */
+    TSet<int32> DirtySegmentIndices;
+
+    /** Segment each conveyor is on where segments are built. Only read as keys, a removed conveyor is dropped with its segment */
+    TMap<const UConveyorComponent*, int32> ConveyorSegmentIndices;
+
+    /** Owner of the item instances */
+    UPROPERTY()
+    AActor* InstancesActor = nullptr;
+
+    UPROPERTY()
+    TMap<uint16, UInstancedStaticMeshComponent*> ItemInstances;
+
+    /** Blocks of instances no segment uses, hidden */
+    TArray<FConveyorInstanceBlock> FreeInstanceBlocks;
+
+    /** Transforms of a segment's items per item id, reused across segments and frames */
+    TMap<uint16, TArray<FTransform>> ItemTransforms;
+
+    /** Segments on a client by the conveyor they start at */
+    TMap<const UConveyorComponent*, int32> ReplicatedSegmentIndices;
+
+    /** Conveyors on a client whose state lists conveyors that did not replicate yet */
+    TArray<TWeakObjectPtr<UConveyorComponent>> PendingStateConveyors;
+};
@@ -0,0 +1,44 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UBuildingConnectionComponent;
+
+/**
+ *  Splits buildables into networks of directly or indirectly connected buildables.
+ *
+ *  Used by the subsystems that aggregate a resource per network, which partition again only when a connection changes
+ *  and keep per network state in between. Connections are treated as undirected.
+ */
+struct JCORE_API FNetworkPartition
+{
+    /**
+     *  Partitions the given actors, replacing the previous partition
+     *
+     *  @param Actors        Members of the networks, neighbors that are none are ignored
+     *  @param GetNeighbors  Appends the actors the given actor is directly connected to
+     */
+    void Build(const TArray<AActor*>& Actors, TFunctionRef<void(const AActor*, TArray<AActor*>&)> GetNeighbors);
+
+    void Reset();
+
+    /** Network of the actor, INDEX_NONE if it was not partitioned */
+    int32 GetNetworkIndex(const AActor* Actor) const;
+
+    int32 GetNumNetworks() const { return this->NumNetworks; }
+
+    /** Appends the owners of the connections the actor's UBuildingConnectionComponents are connected to */
+    static void GetConnectedActors(const AActor* Actor, TArray<AActor*>& OutActors);
+
+    /** Appends the owners of the nodes adjacent to the actor's node in the UGraphSubsystem graph */
+    static void GetGraphNeighbors(const AActor* Actor, TArray<AActor*>& OutActors);
+
+private:
+    static int32 FindRoot(TArray<int32>& Parents, int32 Index);
+
+    TMap<const AActor*, int32> NetworkIndices;
+
+    int32 NumNetworks = 0;
+};
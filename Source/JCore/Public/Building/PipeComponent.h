@@ -0,0 +1,68 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "PipeComponent.generated.h"
+
+class UBuildingConnectionComponent;
+
+/**
+ *  Makes its buildable part of a pipe network, for pipes as well as the pumps, tanks and machines attached to them.
+ *  The UPipeNetworkSubsystem groups buildables connected in the UGraphSubsystem graph into networks and moves the fluid,
+ *  the component only describes what the buildable adds to its network.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class JCORE_API UPipeComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UPipeComponent();
+
+    virtual void BeginPlay() override;
+
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    float GetCapacity() const { return this->Capacity; }
+
+    /** Sets the volume of fluid the owner holds, before it joins a network */
+    void SetCapacity(float InCapacity);
+
+    float GetFlowRate() const { return this->FlowRate; }
+
+    /** Sets the volume per second the owner pumps into its network, negative to draw from it */
+    UFUNCTION(BlueprintCallable, Category="Pipe")
+    void SetFlowRate(float InFlowRate);
+
+    /** Fraction of its network's capacity that is filled, 0 if it is in no network */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Pipe")
+    float GetFillRatio() const;
+
+    /** Fraction of its network's demand the last solve could meet, 0 if it is in no network */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Pipe")
+    float GetSatisfaction() const;
+
+    /** Whether the owner is a finished buildable, previews take no part in the networks */
+    bool IsConnectable() const;
+
+    /** Has the UPipeNetworkSubsystem merge the networks the owner is connected to into its own, e.g. once it is finished */
+    void UpdateNetwork();
+
+protected:
+    UFUNCTION()
+    void OnConnectionConnected(UBuildingConnectionComponent* OwnConnection, UBuildingConnectionComponent* OtherConnection);
+
+    UFUNCTION()
+    void OnConnectionDisconnected(UBuildingConnectionComponent* OwnConnection);
+
+    /** Volume of fluid the owner holds */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Pipe", meta=(ClampMin=0))
+    float Capacity = 100.f;
+
+    /** Volume per second the owner pumps into its network, negative to draw from it */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Pipe")
+    float FlowRate = 0.f;
+};
@@ -0,0 +1,120 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "Building/NetworkPartition.h"
+
+#include "PipeNetworkSubsystem.generated.h"
+
+class UPipeComponent;
+
+DECLARE_LOG_CATEGORY_CLASS(LogPipeNetworkSubsystem, Log, All)
+
+/** Connected pipes holding their fluid as one volume, so solving a network does not depend on its number of pipes */
+struct FPipeNetwork
+{
+    float Volume = 0.f;
+
+    float Capacity = 0.f;
+
+    /** Volume per second pumped into the network */
+    float Supply = 0.f;
+
+    /** Volume per second drawn from the network */
+    float Demand = 0.f;
+
+    /** Fraction of the demand the last solve could meet */
+    float Satisfaction = 1.f;
+
+    TArray<TWeakObjectPtr<UPipeComponent>> Members;
+
+    float GetFillRatio() const { return this->Capacity > 0.f ? this->Volume / this->Capacity : 0.f; }
+
+    /** Adds a pipe's flow rate to the supply or the demand, negative Weight to take it out again */
+    void AddFlow(float FlowRate, float Weight = 1.f);
+};
+
+/**
+ *  Moves the fluid of every UPipeComponent in the world.
+ *
+ *  Pipes connected in the UGraphSubsystem graph are grouped into FPipeNetworks. A pipe that is added or connected merges the
+ *  networks of its graph neighbors with its own, one that is removed or disconnected only partitions its own network again,
+ *  whose parts keep its fill ratio. Both wait for the next tick, as a finished buildable's graph node only gets its edges after
+ *  its connections were connected. Networks are solved at a low fixed rate, in O(networks) regardless of how many pipes they hold.
+ *
+ *  Runs where the world has authority.
+ */
+UCLASS()
+class JCORE_API UPipeNetworkSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    void RegisterPipe(UPipeComponent* Pipe);
+
+    /** Removes a pipe, the fluid it held is lost */
+    void UnregisterPipe(UPipeComponent* Pipe);
+
+    /** Moves a pipe's flow from its old rate to its current one */
+    void UpdatePipeFlow(const UPipeComponent* Pipe, float OldFlowRate);
+
+    /** Merges the networks of the pipe's graph neighbors with its own in the next tick, once it is connectable */
+    void ConnectPipe(UPipeComponent* Pipe);
+
+    /** Partitions the pipe's network again in the next tick after one of its connections was disconnected */
+    void DisconnectPipe(const UPipeComponent* Pipe);
+
+    /** Network of the pipe, nullptr until the pipe joined one */
+    const FPipeNetwork* GetNetwork(const UPipeComponent* Pipe) const;
+
+    int32 GetNumNetworks() const { return this->Networks.Num() - this->FreeNetworkIndices.Num(); }
+
+    /** Seconds between two solves */
+    static constexpr float SolveInterval = 0.5f;
+
+protected:
+    /** Partitions the networks that lost a connection, then merges the pipes that gained one into their neighbors' networks */
+    void UpdateNetworks();
+
+    /** Adds the pipe to the network of its graph neighbors, merging their networks if they are several */
+    void JoinNetwork(UPipeComponent* Pipe);
+
+    /** @return The index of a new empty network */
+    int32 AddNetwork();
+
+    /** Empties the network and keeps its index for the next added one */
+    void RemoveNetwork(int32 NetworkIndex);
+
+    /**
+     *  Moves the members and the fluid of the networks into the largest of them
+     *
+     *  @return The index of the network they were merged into
+     */
+    int32 MergeNetworks(const TArray<int32>& NetworkIndices);
+
+    /** Splits the network into its connected parts, the first keeping the index and every part the fill ratio */
+    void RepartitionNetwork(int32 NetworkIndex);
+
+    /** Pumps the supply in and draws the demand out over the given time, limited by the volume and the capacity */
+    static void SolveNetwork(FPipeNetwork& Network, float Seconds);
+
+    /** Network of every registered pipe, INDEX_NONE until it joined one */
+    TMap<const UPipeComponent*, int32> PipeNetworkIndices;
+
+    TArray<FPipeNetwork> Networks;
+
+    /** Networks that were removed, empty until they are reused */
+    TArray<int32> FreeNetworkIndices;
+
+    TArray<TWeakObjectPtr<UPipeComponent>> PipesToConnect;
+
+    TSet<int32> NetworksToRepartition;
+
+    float TimeSinceSolve = 0.f;
+};
@@ -0,0 +1,84 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "PowerComponent.generated.h"
+
+class UBuildingConnectionComponent;
+
+/**
+ *  Makes its buildable a power generator, a power consumer or both, on the network of buildables it is connected to through
+ *  UBuildingConnectionComponents. The UPowerSubsystem balances the networks, a consumer's UItemGeneratingComponents and
+ *  UCraftingComponents run at the fraction of the demand its network can supply.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class JCORE_API UPowerComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UPowerComponent();
+
+    virtual void BeginPlay() override;
+
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    UFUNCTION(BlueprintCallable, Category="Power")
+    void SetPowerSupply(float InPowerSupply);
+
+    UFUNCTION(BlueprintCallable, Category="Power")
+    void SetPowerDemand(float InPowerDemand);
+
+    /** Sets whether the owner is running, it neither supplies nor demands power while it is not */
+    UFUNCTION(BlueprintCallable, Category="Power")
+    void SetIsRunning(bool bInIsRunning);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+    bool IsRunning() const { return this->bIsRunning; }
+
+    /** Power the owner adds to its network right now */
+    float GetCurrentSupply() const { return this->bIsRunning ? this->PowerSupply : 0.f; }
+
+    /** Power the owner draws from its network right now */
+    float GetCurrentDemand() const { return this->bIsRunning ? this->PowerDemand : 0.f; }
+
+    /** Whether the owner needs power to work, and so is throttled by its network */
+    bool IsConsumer() const { return this->PowerDemand > 0.f; }
+
+    /** Fraction of its network's demand that is supplied, 0 if it is in no network */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+    float GetSatisfaction() const;
+
+    /** Scales the throughput of the owner's machines to the satisfaction of its network, called by the UPowerSubsystem */
+    void ApplySatisfaction(float Satisfaction);
+
+    /** Whether the owner is a finished buildable, previews take no part in the networks */
+    bool IsConnectable() const;
+
+    /** Has the UPowerSubsystem merge the networks the owner is connected to into its own, e.g. once it is finished */
+    void UpdateNetwork();
+
+protected:
+    UFUNCTION()
+    void OnConnectionConnected(UBuildingConnectionComponent* OwnConnection, UBuildingConnectionComponent* OtherConnection);
+
+    UFUNCTION()
+    void OnConnectionDisconnected(UBuildingConnectionComponent* OwnConnection);
+
+    /** Tells the UPowerSubsystem the current supply or demand changed */
+    void UpdateLedger();
+
+    /** Power the owner adds to its network while running */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Power", meta=(ClampMin=0))
+    float PowerSupply = 0.f;
+
+    /** Power the owner draws from its network while running */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Power", meta=(ClampMin=0))
+    float PowerDemand = 0.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Power")
+    bool bIsRunning = true;
+};
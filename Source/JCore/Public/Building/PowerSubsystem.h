@@ -0,0 +1,114 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "Building/NetworkPartition.h"
+
+#include "PowerSubsystem.generated.h"
+
+class UPowerComponent;
+
+DECLARE_LOG_CATEGORY_CLASS(LogPowerSubsystem, Log, All)
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnPowerSatisfactionChanged, int32, NetworkIndex, float, Satisfaction);
+
+/** Supply and demand ledger of connected power components */
+struct FPowerNetwork
+{
+    /** Summed in double, as the ledger is only ever changed by differences */
+    double Supply = 0.0;
+
+    double Demand = 0.0;
+
+    /** Fraction of the demand that is supplied, as last broadcast */
+    float Satisfaction = 1.f;
+
+    TArray<TWeakObjectPtr<UPowerComponent>> Members;
+
+    float ComputeSatisfaction() const { return this->Demand > 0.0 ? static_cast<float>(FMath::Min(this->Supply / this->Demand, 1.0)) : 1.f; }
+};
+
+/**
+ *  Balances the power of every UPowerComponent in the world.
+ *
+ *  Buildables connected through UBuildingConnectionComponents form FPowerNetworks. A component that is added or connected
+ *  merges the networks of the buildables it is connected to, one that is removed or disconnected only partitions its own network
+ *  again, whose parts keep its satisfaction. Adding, removing or changing a component updates its network's ledger by the
+ *  difference and marks the network changed, only changed networks are balanced in the next tick. A network whose satisfaction
+ *  changed broadcasts it and throttles its consumers' machines to it.
+ *
+ *  Runs where the world has authority.
+ */
+UCLASS()
+class JCORE_API UPowerSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    void RegisterPowerComponent(UPowerComponent* PowerComponent);
+
+    void UnregisterPowerComponent(UPowerComponent* PowerComponent);
+
+    /** Moves the component's entry in its network's ledger to its current supply and demand */
+    void UpdatePowerComponent(const UPowerComponent* PowerComponent);
+
+    /** Merges the networks of the buildables the component is connected to with its own, once it is connectable */
+    void ConnectPowerComponent(UPowerComponent* PowerComponent);
+
+    /** Partitions the component's network again after one of its connections was disconnected */
+    void DisconnectPowerComponent(const UPowerComponent* PowerComponent);
+
+    /** Network of the component, nullptr until the component was partitioned */
+    const FPowerNetwork* GetNetwork(const UPowerComponent* PowerComponent) const;
+
+    int32 GetNumNetworks() const { return this->Networks.Num() - this->FreeNetworkIndices.Num(); }
+
+    /** Broadcast when a network's satisfaction changed, the index of a network that was merged into another is reused */
+    UPROPERTY(BlueprintAssignable)
+    FOnPowerSatisfactionChanged OnSatisfactionChanged;
+
+protected:
+    /** What a component was last entered in the ledger with */
+    struct FPowerLedgerEntry
+    {
+        float Supply = 0.f;
+
+        float Demand = 0.f;
+
+        int32 NetworkIndex = INDEX_NONE;
+    };
+
+    /** @return The index of a new empty network, which broadcasts its first satisfaction */
+    int32 AddNetwork();
+
+    /** Empties the network and keeps its index for the next added one */
+    void RemoveNetwork(int32 NetworkIndex);
+
+    /**
+     *  Moves the members and ledgers of the networks into the largest of them
+     *
+     *  @return The index of the network they were merged into
+     */
+    int32 MergeNetworks(const TArray<int32>& NetworkIndices);
+
+    /** Splits the network into its connected parts, the first keeping the index and every part the satisfaction */
+    void RepartitionNetwork(int32 NetworkIndex);
+
+    /** Broadcasts the satisfaction of the changed networks whose satisfaction changed and throttles their consumers */
+    void BalanceChangedNetworks();
+
+    TMap<const UPowerComponent*, FPowerLedgerEntry> LedgerEntries;
+
+    TArray<FPowerNetwork> Networks;
+
+    /** Networks that were removed, empty until they are reused */
+    TArray<int32> FreeNetworkIndices;
+
+    TSet<int32> ChangedNetworks;
+};
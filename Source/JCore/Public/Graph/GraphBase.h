@@ -51,6 +51,17 @@ public:
     UFUNCTION(BlueprintCallable, BlueprintPure)
     bool IsRootNode(UNodeBase* InNode);
 
+    /** Nodes an edge leads to from the given node, both ways in an undirected graph */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    TArray<UNodeBase*> GetNeighbors(UNodeBase* InNode) const;
+
+    /**
+     *  Gets the nodes ordered so the source of every edge comes before its destination, e.g. to process producers before their consumers.
+     *  Nodes on a cycle, and the nodes of an undirected graph, follow in breadth first order from the first node added.
+     */
+    UFUNCTION(BlueprintCallable)
+    TArray<UNodeBase*> GetNodesInTopologicalOrder() const;
+
     //UFUNCTION(BlueprintCallable)
     //bool BreadthFirstSearch(UNodeBase* SourceNode, UNodeBase* TargetNode);
 
@@ -72,4 +83,11 @@ protected:
 
     UPROPERTY(EditAnywhere)
     bool bIsDirectedGraph;
+
+    /** Neighbors of every node, kept with Edges so walking the graph does not scan every edge */
+    TMap<UNodeBase*, TArray<UNodeBase*>> Adjacency;
+
+    void AddAdjacency(UNodeBase* FromNode, UNodeBase* ToNode);
+
+    void RemoveAdjacency(UNodeBase* FromNode, UNodeBase* ToNode);
 };
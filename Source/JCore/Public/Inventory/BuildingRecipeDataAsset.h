@@ -23,6 +23,10 @@ protected:
     UBuildingDataAsset* OutBuilding;
 
 public:
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
     UFUNCTION(BlueprintCallable)
     const TMap<UItemDataAsset*, int32>& GetInItems() const { return InItems; }
 
@@ -10,8 +10,63 @@
 
 #include "CraftingComponent.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCraftingQueueChanged);
+
 DECLARE_LOG_CATEGORY_CLASS(LogCraftingComponent, Log, All)
 
+/** A queued craft of a recipe, run NumCrafts times in a row */
+USTRUCT()
+struct FCraftingJob
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    int32 JobId = 0;
+
+    UPROPERTY()
+    UItemRecipeDataAsset* Recipe = nullptr;
+
+    /** Crafts left in this job */
+    UPROPERTY()
+    int32 NumCrafts = 0;
+
+    UPROPERTY()
+    TWeakObjectPtr<UInventoryComponent> SourceInventory;
+
+    UPROPERTY()
+    TWeakObjectPtr<UInventoryComponent> TargetInventory;
+};
+
+/** The job at the head of a crafting queue, all clients see of the queue */
+USTRUCT(BlueprintType)
+struct FCraftingQueueHead
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly)
+    int32 JobId = 0;
+
+    /** Recipe being crafted, nullptr if the queue is empty */
+    UPROPERTY(BlueprintReadOnly)
+    UItemRecipeDataAsset* Recipe = nullptr;
+
+    /** Crafts left in the head job, including the one in progress */
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumCrafts = 0;
+
+    /** Jobs in the queue, including the head job */
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumQueuedJobs = 0;
+
+    /** Server world time the craft in progress started at */
+    UPROPERTY(BlueprintReadOnly)
+    double StartTime = 0.0;
+
+    /** Server world time the craft in progress completes at */
+    UPROPERTY(BlueprintReadOnly)
+    double CompletionTime = 0.0;
+};
+
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class JCORE_API UCraftingComponent : public UActorComponent
 {
@@ -21,6 +76,8 @@ public:
     // Sets default values for this component's properties
     UCraftingComponent();
 
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
     /**
      *  Attempts to craft the given recipe
      *
@@ -51,17 +108,82 @@ public:
                                    UInventoryComponent*  SourceInventory,
                                    UInventoryComponent*  TargetInventory);
 
+    /**
+     *  Attempts to craft the given recipe several times at once, all crafts or none.
+     *  The inputs are removed and the outputs added once per item for the whole batch.
+     *
+     *  @note Expected to be called on the Server
+     *
+     *  @param Recipe  The recipe to craft
+     *  @param SourceInventory  The UInventoryComponent to remove input items from
+     *  @param TargetInventory  The UInventoryComponent to add the output items to
+     *  @param Count  How often to craft the recipe
+     *
+     *  @return True if the recipe was crafted Count times
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    bool TryCraftRecipeBatch(UItemRecipeDataAsset* Recipe,
+                             UInventoryComponent*  SourceInventory,
+                             UInventoryComponent*  TargetInventory,
+                             int32                 Count);
+
+    /** Crafts the given recipe several times on the server, see TryCraftRecipeBatch. Count is clamped to GetMaxCraftableCount */
+    UFUNCTION(Server, Reliable, BlueprintCallable, Category="Crafting")
+    void ServerCraftRecipeBatch(UItemRecipeDataAsset* Recipe,
+                                UInventoryComponent*  SourceInventory,
+                                UInventoryComponent*  TargetInventory,
+                                int32                 Count);
+
+    /**
+     *  Gets how often the given recipe can be crafted, from one pass over each inventory.
+     *  Like TryCraftRecipeToInventory, the space the removed inputs free up is not counted for the outputs.
+     *
+     *  @param Recipe  The recipe to craft
+     *  @param SourceInventory  The UInventoryComponent to remove input items from
+     *  @param TargetInventory  The UInventoryComponent to add the output items to
+     *
+     *  @return The number of crafts the inputs and the output space allow
+     */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Crafting")
+    static int32 GetMaxCraftableCount(UItemRecipeDataAsset* Recipe,
+                                      UInventoryComponent*  SourceInventory,
+                                      UInventoryComponent*  TargetInventory);
+
     /**
      *  Attempts to craft the given recipe on the server
      *
      *  @param Recipe  The recipe with the items to check
      *  @param SourceInventory  The UInventoryComponent to remove the input items from
      *  @param TargetInventory  The UInventoryComponent to add the output items to, defaults to the SourceInventory
+     *  @param PredictionKey  Key the owning client predicted the craft with, 0 if it was not predicted
      */
     UFUNCTION(Server, Reliable, Category="Crafting")
     void ServerCraftRecipe(UItemRecipeDataAsset* Recipe,
                            UInventoryComponent*  SourceInventory,
-                           UInventoryComponent*  TargetInventory);
+                           UInventoryComponent*  TargetInventory,
+                           int32                 PredictionKey = 0);
+
+    /**
+     *  Crafts the given recipe on the server, the owning client applies the craft to both inventories right away
+     *  and rolls it back if the server refuses it
+     *
+     *  @param Recipe  The recipe to craft
+     *  @param SourceInventory  The UInventoryComponent to remove the input items from
+     *  @param TargetInventory  The UInventoryComponent to add the output items to
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    void CraftRecipe(UItemRecipeDataAsset* Recipe,
+                     UInventoryComponent*  SourceInventory,
+                     UInventoryComponent*  TargetInventory);
+
+    /**
+     *  Tells the owning client whether the server crafted the recipe predicted with the given key
+     *
+     *  @param SourceSequence  SlotSequence of the source inventory right after the craft
+     *  @param TargetSequence  SlotSequence of the target inventory right after the craft
+     */
+    UFUNCTION(Client, Reliable)
+    void ClientResolveCraftPrediction(int32 PredictionKey, bool bCrafted, int32 SourceSequence, int32 TargetSequence);
 
     /**
      *  Checks whether a UInventoryComponent contains the necessary input items to craft the given recipe
@@ -74,4 +196,140 @@ public:
     UFUNCTION(BlueprintCallable, Category="Crafting")
     static bool InventoryHasItemsInRecipe(UItemRecipeDataAsset* Recipe,
                                           UInventoryComponent*  InventoryComponent);
+
+    /**
+     *  Queues crafts of the given recipe, each taking the recipe's CraftTime.
+     *  The inputs are removed and the outputs added when a craft completes, a craft that fails then drops its job.
+     *
+     *  @note Expected to be called on the Server
+     *
+     *  @param Recipe  The recipe to craft
+     *  @param SourceInventory  The UInventoryComponent to remove input items from
+     *  @param TargetInventory  The UInventoryComponent to add the output items to
+     *  @param NumCrafts  How often to craft the recipe
+     *
+     *  @return The id of the queued job, 0 if nothing was queued
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    int32 QueueCraft(UItemRecipeDataAsset* Recipe,
+                     UInventoryComponent*  SourceInventory,
+                     UInventoryComponent*  TargetInventory,
+                     int32                 NumCrafts = 1);
+
+    /** Queues crafts on the server, see QueueCraft. NumCrafts is clamped to MaxCraftsPerJob and nothing is queued past MaxQueuedJobs */
+    UFUNCTION(Server, Reliable, BlueprintCallable, Category="Crafting")
+    void ServerQueueCraft(UItemRecipeDataAsset* Recipe,
+                          UInventoryComponent*  SourceInventory,
+                          UInventoryComponent*  TargetInventory,
+                          int32                 NumCrafts = 1);
+
+    /**
+     *  Removes a job from the crafting queue, the craft in progress is lost if it is the head job
+     *
+     *  @note Expected to be called on the Server
+     *
+     *  @param JobId  The id QueueCraft returned
+     *
+     *  @return True if the job was queued
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    bool CancelCraft(int32 JobId);
+
+    /** Cancels a job on the server, see CancelCraft */
+    UFUNCTION(Server, Reliable, BlueprintCallable, Category="Crafting")
+    void ServerCancelCraft(int32 JobId);
+
+    /**
+     *  Completes the craft in progress of the given job, called by the UCraftingSchedulerSubsystem
+     *
+     *  @param JobId  The job the completion was scheduled for
+     *  @param CompletionTime  The time it was scheduled at, a completion the queue head was moved away from is skipped
+     */
+    void CompleteCraft(int32 JobId, double CompletionTime);
+
+    /**
+     *  Runs the crafts the queue would complete in the given time at once, e.g. for time the world was not loaded.
+     *  Each job crafts the crafts that fit as one batch, a job whose inputs or output space run out is dropped
+     *  where its failing craft would have completed, as in the timed queue.
+     *
+     *  @note Expected to be called on the Server
+     *
+     *  @param Seconds  Time to advance the queue by
+     */
+    void FastForwardQueue(double Seconds);
+
+    bool HasQueuedCrafts() const { return this->CraftingQueue.Num() > 0; }
+
+    /**
+     *  Scales how fast crafts progress, e.g. by the power the buildable gets. 0 pauses the queue until it is raised again.
+     *  The craft in progress keeps its progress and finishes its remaining time at the new throughput.
+     *
+     *  @note Expected to be called on the Server
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    void SetThroughputScale(float InThroughputScale);
+
+    float GetThroughputScale() const { return this->ThroughputScale; }
+
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Crafting")
+    const FCraftingQueueHead& GetQueueHead() const { return this->QueueHead; }
+
+    /** Gets how far the craft in progress is from 0 to 1, from the replicated start and completion time */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category="Crafting")
+    float GetCraftProgress() const;
+
+    /** Broadcast on the server and the clients when the queue head changed */
+    UPROPERTY(BlueprintAssignable)
+    FOnCraftingQueueChanged OnCraftingQueueChanged;
+
+protected:
+    /** Crafts the zero time jobs at the head of the queue and schedules the first timed craft to start at StartTime */
+    void StartQueueHead(double StartTime);
+
+    /**
+     *  Schedules the completion of the head job's craft, or pauses it while the throughput scale is 0
+     *
+     *  @param Now  Time to schedule from
+     *  @param RemainingCraftTime  Time left on the craft at full throughput
+     */
+    void ScheduleQueueHead(double Now, double RemainingCraftTime);
+
+    /** Runs one craft of the head job, removing the job when it is done or the craft failed */
+    void CraftQueueHead();
+
+    void UpdateQueueHead(double StartTime, double CompletionTime);
+
+    UFUNCTION()
+    void OnRep_QueueHead();
+
+    /** May this crafter take items from the source and put them into the target? Checked for every craft a client asks for */
+    bool CanCraftBetween(const UInventoryComponent* SourceInventory, const UInventoryComponent* TargetInventory) const;
+
+    /** Server world time, which the queue head's times are in */
+    double GetServerWorldTime() const;
+
+    /** Most crafts a client can queue in one job */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Crafting", meta=(ClampMin=1))
+    int32 MaxCraftsPerJob;
+
+    /** Most jobs clients can have queued at once */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Crafting", meta=(ClampMin=1))
+    int32 MaxQueuedJobs;
+
+    /** Queued jobs on the server, the first one is being crafted */
+    UPROPERTY()
+    TArray<FCraftingJob> CraftingQueue;
+
+    UPROPERTY(ReplicatedUsing = OnRep_QueueHead)
+    FCraftingQueueHead QueueHead;
+
+    int32 NextJobId = 1;
+
+    float ThroughputScale = 1.f;
+
+    /** Time left on the head job's craft at full throughput, while the queue is paused */
+    double PausedCraftTime = 0.0;
+
+    /** Inventories a predicted craft was applied to, by prediction key */
+    TMap<int32, TArray<TWeakObjectPtr<UInventoryComponent>>> PredictedCraftInventories;
 };
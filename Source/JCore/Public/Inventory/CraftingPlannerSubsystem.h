@@ -0,0 +1,151 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+
+#include "Inventory/ItemRecipeDataAsset.h"
+
+#include "CraftingPlannerSubsystem.generated.h"
+
+class UInventoryComponent;
+
+DECLARE_LOG_CATEGORY_CLASS(LogCraftingPlanner, Log, All)
+
+/** One recipe of a FCraftingPlan and how often to craft it */
+USTRUCT(BlueprintType)
+struct FCraftingPlanStep
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly)
+    UItemRecipeDataAsset* Recipe = nullptr;
+
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumCrafts = 0;
+};
+
+/** Ordered crafts to make a recipe from what an inventory holds, crafting the intermediates first */
+USTRUCT(BlueprintType)
+struct FCraftingPlan
+{
+    GENERATED_BODY()
+
+    /** Crafts in the order they have to run, every step only consumes items held or made by the steps before it */
+    UPROPERTY(BlueprintReadOnly)
+    TArray<FCraftingPlanStep> Steps;
+
+    /** Items no recipe produces that the inventory does not hold enough of */
+    UPROPERTY(BlueprintReadOnly)
+    TMap<UItemDataAsset*, int32> MissingItems;
+
+    bool IsComplete() const { return this->MissingItems.Num() == 0; }
+};
+
+/** A recipe flattened to item ids, so planning never copies the recipe's item maps */
+struct FCraftingPlannerRecipe
+{
+    UItemRecipeDataAsset* Recipe = nullptr;
+
+    TArray<TPair<uint16, int32>> InItems;
+
+    TArray<TPair<uint16, int32>> OutItems;
+
+    /** Sum of all output amounts, the inputs' cost is shared evenly by every unit of output */
+    int32 TotalOutAmount = 0;
+
+    int32 GetOutAmount(uint16 ItemId) const;
+};
+
+/**
+ *  Plans multi-level crafts: expands a recipe into the crafts of its intermediates, subtracting what an inventory already holds.
+ *
+ *  The item -> producing recipe index is built once from the URecipeRegistrySubsystem, and the raw materials one unit
+ *  of an item expands to are memoized per item, so the max craftable count of a whole recipe list can be refreshed live for the UI.
+ *  Recipes are flattened to item ids, so they are rebuilt when the UItemRegistrySubsystem finishes handing out ids as well.
+ */
+UCLASS()
+class JCORE_API UCraftingPlannerSubsystem : public UGameInstanceSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    /** Replaces the recipes to plan with, rebuilding the index and dropping the memoized expansions */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    void SetRecipes(const TArray<UItemRecipeDataAsset*>& InRecipes);
+
+    /**
+     *  Plans the crafts needed to craft the given recipe, including its intermediates
+     *
+     *  @param Recipe  The recipe to craft
+     *  @param NumCrafts  How often to craft the recipe
+     *  @param Inventory  The UInventoryComponent holding the items to craft from
+     *  @param OutPlan  The ordered crafts, and the items that are missing
+     *
+     *  @return True if the inventory holds everything the plan needs
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    bool BuildCraftPlan(UItemRecipeDataAsset* Recipe, int32 NumCrafts, UInventoryComponent* Inventory, FCraftingPlan& OutPlan);
+
+    /**
+     *  Gets how often the given recipe can be crafted from the inventory, crafting its intermediates as needed
+     *
+     *  @param Recipe  The recipe to craft
+     *  @param Inventory  The UInventoryComponent holding the items to craft from
+     *
+     *  @return The number of crafts a complete plan exists for
+     */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    int32 GetMaxPlannedCrafts(UItemRecipeDataAsset* Recipe, UInventoryComponent* Inventory);
+
+    /**
+     *  Raw items one unit of the given item expands to through its producing recipes, memoized per item.
+     *  The inputs of a recipe with several outputs are shared by all of its output units, byproducts included.
+     *  Inputs in CycleEdges count as raw, so the result does not depend on which item of a cycle was expanded first.
+     */
+    const TMap<uint16, double>& GetRawMaterials(uint16 ItemId);
+
+protected:
+    /** Re-reads the recipes from the URecipeRegistrySubsystem */
+    void HandleRecipesChanged();
+
+    /** Amount of each item id in the inventory */
+    static TMap<uint16, int32> CountInventoryItems(UInventoryComponent* Inventory);
+
+    /** Plans crafts for the amount of the item that is not available yet */
+    void PlanItem(uint16 ItemId, int32 Amount, TMap<uint16, int32>& Available, TMap<uint16, int32>& Missing, FCraftingPlan& OutPlan);
+
+    void PlanRecipe(int32 RecipeIndex, int32 NumCrafts, TMap<uint16, int32>& Available, TMap<uint16, int32>& Missing, FCraftingPlan& OutPlan);
+
+    /** Depth first search from the item through its producing recipes, adding the inputs that lead back to an item on the path to CycleEdges */
+    void FindCycleEdges(uint16 ItemId, TSet<uint16>& VisitedItems);
+
+    static uint32 MakeCycleEdge(uint16 ItemId, uint16 InItemId) { return static_cast<uint32>(ItemId) << 16 | InItemId; }
+
+    /** Recipes to plan with, kept loaded */
+    UPROPERTY()
+    TArray<UItemRecipeDataAsset*> AllItemRecipeDataAssets;
+
+    TArray<FCraftingPlannerRecipe> Recipes;
+
+    TMap<UItemRecipeDataAsset*, int32> RecipeIndices;
+
+    /** Recipe that produces each item id, the first one found if several do */
+    TMap<uint16, int32> ProducingRecipes;
+
+    /** Inputs that close a recipe cycle, as MakeCycleEdge of the produced item and the input. Found once per SetRecipes */
+    TSet<uint32> CycleEdges;
+
+    /** Memoized GetRawMaterials results */
+    TMap<uint16, TMap<uint16, double>> RawMaterials;
+
+    /** Items whose expansion goes through a recipe with several outputs, filled with RawMaterials */
+    TSet<uint16> ItemsWithByproducts;
+
+    /** Items being expanded or planned, a recipe cycle treats the item as raw instead of recursing */
+    TSet<uint16> VisitingItems;
+};
@@ -0,0 +1,60 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "CraftingSchedulerSubsystem.generated.h"
+
+class UCraftingComponent;
+
+DECLARE_LOG_CATEGORY_CLASS(LogCraftingScheduler, Log, All)
+
+/** A craft that completes at CompletionTime, ordered by time in the scheduler's heap */
+struct FScheduledCraft
+{
+    double CompletionTime = 0.0;
+
+    TWeakObjectPtr<UCraftingComponent> Crafter;
+
+    /** Job of the crafter the completion is for, a cancelled or fast-forwarded job no longer matches and is skipped */
+    int32 JobId = 0;
+
+    bool operator<(const FScheduledCraft& Other) const { return this->CompletionTime < Other.CompletionTime; }
+};
+
+/**
+ *  Completes the timed crafts of every UCraftingComponent in the world from one time-ordered heap,
+ *  so queued crafts do not register a timer each and a frame only touches the crafts that are due.
+ *
+ *  Only the craft at the head of each crafting queue is scheduled, the next one is scheduled when it completes.
+ */
+UCLASS()
+class JCORE_API UCraftingSchedulerSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    /**
+     *  Schedules the completion of a craft
+     *
+     *  @param Crafter  The UCraftingComponent to complete the job on
+     *  @param JobId  The job to complete
+     *  @param CompletionTime  World time in seconds the craft completes at
+     */
+    void ScheduleCraft(UCraftingComponent* Crafter, int32 JobId, double CompletionTime);
+
+    /** Number of scheduled completions, including ones of cancelled jobs that were not popped yet */
+    int32 GetNumScheduledCrafts() const { return this->ScheduledCrafts.Num(); }
+
+    /** Crafters with a scheduled completion and crafts still queued, each once */
+    TArray<UCraftingComponent*> GetScheduledCrafters() const;
+
+protected:
+    /** Min-heap by CompletionTime */
+    TArray<FScheduledCraft> ScheduledCrafts;
+};
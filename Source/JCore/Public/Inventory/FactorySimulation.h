@@ -0,0 +1,114 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Inventory/InventorySlot.h"
+#include "Inventory/ProductionSubsystem.h"
+
+/** A machine of a FFactorySimulation, looked up on the game thread so the simulation never touches a UObject */
+struct FFactorySimMachine
+{
+    int32 InventoryIndex = INDEX_NONE;
+
+    uint16 ItemId = UItemDataAsset::InvalidItemId;
+
+    int32 MaxStackSize = 0;
+
+    EProductionKind Kind = EProductionKind::Generate;
+
+    bool bLoop = true;
+
+    /** Steps between fires, at least 1 */
+    int64 PeriodSteps = 1;
+
+    /** Step the machine fires at next */
+    int64 NextFireStep = 0;
+
+    /** Set once a machine that does not loop fired */
+    bool bFinished = false;
+
+    /** Items the generates of the last AdvanceTo added */
+    int64 AmountGenerated = 0;
+
+    /** Items the consumes of the last AdvanceTo took */
+    int64 AmountConsumed = 0;
+};
+
+/**
+ *  Fixed-step factory simulation over plain arrays, so it can run on a worker thread.
+ *
+ *  Time is counted in whole steps and the machines due in a step fire in the order they were added, every generate before any consume.
+ *  Advancing the same inventories and machines by the same steps always ends in the same slots.
+ *
+ *  Inventories are kept between runs, so the game thread only has to write the slots that changed since the last run.
+ */
+class JCORE_API FFactorySimulation
+{
+public:
+    /** Drops every inventory and machine, keeping the allocations */
+    void Reset();
+
+    /** Drops every machine, keeping the inventories */
+    void ResetMachines();
+
+    /**
+     *  Adds an inventory, copying its slots
+     *
+     *  @return The index machines refer to the inventory by
+     */
+    int32 AddInventory(const TArray<FInventorySlot>& InSlots);
+
+    /** Overwrites one slot of an inventory */
+    void SetSlot(int32 InventoryIndex, int32 SlotIndex, const FInventorySlot& InSlot);
+
+    int32 GetNumSlots(int32 InventoryIndex) const { return this->InventorySlotStarts[InventoryIndex + 1] - this->InventorySlotStarts[InventoryIndex]; }
+
+    /** Gets the slots of an inventory the last AdvanceTo changed, by their index in the inventory */
+    void GetChangedSlots(int32 InventoryIndex, TArray<int32>& OutSlotIndices) const;
+
+    /** @return The index of the machine */
+    int32 AddMachine(const FFactorySimMachine& Machine);
+
+    /** Fires every machine due up to and including the given step */
+    void AdvanceTo(int64 TargetStep);
+
+    int64 GetStep() const { return this->Step; }
+
+    void SetStep(int64 InStep) { this->Step = InStep; }
+
+    /** Amount of the given item over the inventory's slots */
+    int64 CountItem(int32 InventoryIndex, uint16 ItemId) const;
+
+    const TArray<FFactorySimMachine>& GetMachines() const { return this->Machines; }
+
+protected:
+    /** Adds one item to the first partial stack, else the first empty slot. @return False if it does not fit */
+    bool AddItem(int32 InventoryIndex, uint16 ItemId, int32 MaxStackSize);
+
+    /** Removes one item from the last slot holding it. @return False if the inventory has none */
+    bool RemoveItem(int32 InventoryIndex, uint16 ItemId);
+
+    int64 Step = 0;
+
+    /** Slots of all inventories back to back, inventory N owns the slots from InventorySlotStarts[N] to InventorySlotStarts[N + 1] */
+    TArray<uint16> SlotItemIds;
+
+    TArray<int32> SlotStackSizes;
+
+    TArray<int32> SlotMaxStackSizes;
+
+    TArray<int32> InventorySlotStarts;
+
+    /** Slots the last AdvanceTo changed, parallel to SlotItemIds */
+    TBitArray<> ChangedSlots;
+
+    TArray<FFactorySimMachine> Machines;
+
+    /** Min-heap of fire step and machine index, so ties fire in machine order */
+    TArray<TPair<int64, int32>> FireQueue;
+
+    /** Machines due in the step being fired */
+    TArray<int32> DueMachines;
+};
@@ -4,16 +4,138 @@
 
 #include "CoreMinimal.h"
 #include "InventorySlot.h"
+#include "InventorySlotStorage.h"
 #include "Components/ActorComponent.h"
+#include "GameplayTagContainer.h"
 
 #include "InventoryComponent.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnItemChanged);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemAdded, UItemDataAsset*, ItemAdded, int32, AmountAdded);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnItemRemoved, UItemDataAsset*, ItemRemoved, int32, AmountRemoved);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnInventorySlotChanged, int32 /* Index */);
 
 DECLARE_LOG_CATEGORY_CLASS(LogInventoryComponent, Log, All);
 
+/** How an inventory lays out its slots for scanning */
+UENUM(BlueprintType)
+enum class EInventoryStorageMode : uint8
+{
+    /** Scan the replicated FInventorySlot array directly, best for small inventories */
+    Slots,
+    /** Mirror the slots into parallel item id/stack size arrays, for large storage containers */
+    StructOfArrays,
+    /**
+     *  Like StructOfArrays on the server, but the slots are not replicated. Clients only materialize the occupied slots
+     *  of the pages they view through ServerViewInventoryPages, for warehouse containers with thousands of slots
+     */
+    Paged
+};
+
+/** When an inventory merges and reorders its stacks */
+UENUM(BlueprintType)
+enum class EInventoryCompactPolicy : uint8
+{
+    /** Only when CompactInventory is called */
+    Manual,
+    /** Merge partial stacks as they appear, keeping at most one partial stack per item so it can be found without a scan */
+    Always,
+    /** Like Always, and also keep the slots sorted by item id and stack size */
+    Sorted
+};
+
+/** Which connections receive an inventory's slots */
+UENUM(BlueprintType)
+enum class EInventoryReplicationPolicy : uint8
+{
+    /** Every connection the owning actor is relevant to */
+    Everyone,
+    /** Only the owning connection */
+    OwnerOnly,
+    /** The owning connection, and players who opened the inventory through ServerOpenInventory */
+    OwnerAndViewers,
+    /** The owning connection, everyone else only gets an FInventorySummary while the owning actor is relevant to them */
+    Summary
+};
+
+/** What non-owning connections see of an inventory with EInventoryReplicationPolicy::Summary */
+USTRUCT(BlueprintType)
+struct FInventorySummary
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumUsedSlots = 0;
+
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumItems = 0;
+};
+
+/** Kind of operation a client applies to an inventory ahead of the server */
+enum class EInventoryPredictionOp : uint8
+{
+    AddItem,
+    RemoveItem,
+    SetSlot
+};
+
+/** An operation applied locally on a client, replayed on top of the replicated slots until the server resolves its key */
+struct FInventoryPrediction
+{
+    int32 PredictionKey = 0;
+
+    EInventoryPredictionOp Op = EInventoryPredictionOp::SetSlot;
+
+    /** Item and amount of AddItem/RemoveItem */
+    uint16 ItemId = UItemDataAsset::InvalidItemId;
+
+    int32 Amount = 0;
+
+    /** Index and new value of SetSlot */
+    int32 SlotIndex = INDEX_NONE;
+
+    FInventorySlot Slot;
+
+    /** The server accepted the operation, it is dropped once the replicated slots contain it */
+    bool bAccepted = false;
+
+    /** SlotSequence of the server's inventory right after it applied the operation */
+    int32 AppliedSequence = 0;
+
+    /** World time the server's acceptance arrived at */
+    double AcceptedTime = 0.0;
+};
+
+class UInventoryComponent;
+class UProductionSubsystem;
+
+/** A player viewing pages of an inventory with EInventoryStorageMode::Paged */
+struct FInventoryPageViewer
+{
+    TWeakObjectPtr<UInventoryComponent> Viewer;
+
+    TSet<int32> Pages;
+};
+
+/** Client prediction counters of an inventory */
+USTRUCT(BlueprintType)
+struct FInventoryPredictionStats
+{
+    GENERATED_BODY()
+
+    /** Prediction keys applied ahead of the server */
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumPredicted = 0;
+
+    /** Prediction keys the server refused, their operations were rolled back */
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumRejected = 0;
+
+    /** Replicated updates that did not match the accepted predictions they replaced */
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumCorrected = 0;
+};
+
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class JCORE_API UInventoryComponent : public UActorComponent
 {
@@ -33,19 +155,46 @@ public:
     UPROPERTY(BlueprintAssignable)
     FOnItemRemoved OnItemRemoved;
 
+    /** Broadcast on the server with the index of every slot written, INDEX_NONE when all slots were replaced */
+    FOnInventorySlotChanged OnSlotChanged;
+
     void InitializeInventorySlots();
 
+    /** Adds a given item and amount, returns false without adding anything if not all of it fits. *MUST BE CALLED ON SERVER* */
     UFUNCTION(BlueprintCallable)
     bool TryAddItem(UItemDataAsset* ItemToAdd, const int Amount = 1);
 
+    /**
+     *  Adds as much of the given amount as fits, filling partial stacks before empty slots.
+     *  The slots are found in one forward pass, which stops once the partial stacks take the amount.
+     *  *MUST BE CALLED ON SERVER*
+     *
+     *  @param ItemToAdd  The item to add
+     *  @param Amount  The amount to add, may span several stacks
+     *
+     *  @return The amount that did not fit
+     */
+    UFUNCTION(BlueprintCallable)
+    int32 AddItemAmount(UItemDataAsset* ItemToAdd, int32 Amount);
+
     UFUNCTION(BlueprintCallable)
     bool TryAddItems(const TMap<UItemDataAsset*, int32> &ItemsToAdd);
 
+    /**
+     *  Adds an item on the server.
+     *
+     *  @param PredictionKey  Key the owning client predicted the add with, 0 if it was not predicted
+     */
     UFUNCTION(Server, BlueprintCallable, Reliable)
-    void ServerAddItem(UItemDataAsset* ItemToAdd, const int Amount = 1);
+    void ServerAddItem(UItemDataAsset* ItemToAdd, const int Amount = 1, int32 PredictionKey = 0);
+
+    /** Adds an item, applied right away on the owning client and confirmed by the server */
+    UFUNCTION(BlueprintCallable)
+    void RequestAddItem(UItemDataAsset* ItemToAdd, const int Amount = 1);
 
-    UFUNCTION(Client, BlueprintCallable, Reliable)
-    void ClientOnAddItem(UItemDataAsset* ItemToAdd, const int Amount = 1);
+    /** Notifies the owning client of an added item, the item is sent as its UItemRegistrySubsystem id */
+    UFUNCTION(Client, Reliable)
+    void ClientOnAddItem(uint16 ItemIdAdded, const int Amount = 1);
 
     /** Removes a given item and amount. *MUST BE CALLED ON SERVER* */
     UFUNCTION(BlueprintCallable)
@@ -59,11 +208,21 @@ public:
     UFUNCTION(BlueprintCallable)
     bool TryRemoveItemAtIndex(int32 IndexToRemove, const int Amount = 1);
 
+    /**
+     *  Removes an item on the server.
+     *
+     *  @param PredictionKey  Key the owning client predicted the removal with, 0 if it was not predicted
+     */
     UFUNCTION(Server, BlueprintCallable, Reliable)
-    void ServerRemoveItem(UItemDataAsset* ItemToRemove, const int Amount = 1);
+    void ServerRemoveItem(UItemDataAsset* ItemToRemove, const int Amount = 1, int32 PredictionKey = 0);
 
-    UFUNCTION(Client, BlueprintCallable, Reliable)
-    void ClientRemoveItem(UItemDataAsset* ItemToRemove, const int Amount = 1);
+    /** Removes an item, applied right away on the owning client and confirmed by the server */
+    UFUNCTION(BlueprintCallable)
+    void RequestRemoveItem(UItemDataAsset* ItemToRemove, const int Amount = 1);
+
+    /** Notifies the owning client of a removed item, the item is sent as its UItemRegistrySubsystem id */
+    UFUNCTION(Client, Reliable)
+    void ClientRemoveItem(uint16 ItemIdRemoved, const int Amount = 1);
 
     UFUNCTION(BlueprintCallable, BlueprintPure)
     bool ContainsItemAmount(UItemDataAsset* ItemToCheck, const int Amount = 1) const;
@@ -94,13 +253,255 @@ public:
     void SetNumberOfSlots(int InNumberOfSlots);
 
     UFUNCTION(BlueprintCallable, BlueprintPure)
-    TArray<FInventorySlot>& GetInventorySlots() { return this->InventorySlots; };
+    int32 GetNumberOfSlots() const { return this->NumberOfSlots; }
+
+    /**
+     *  Gets the slot at the given index, works with every storage mode.
+     *  Slots of pages that are not viewed on a client with EInventoryStorageMode::Paged are returned empty.
+     */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    FInventorySlot GetInventorySlot(int32 Index) const;
+
+    /**
+     *  Gets the inventory slots, write them through SetInventorySlot.
+     *
+     *  @note On clients with pending predictions these are the predicted slots, not the replicated ones
+     *  @note Empty on clients when using EInventoryStorageMode::Paged, use GetInventorySlot instead
+     */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    const TArray<FInventorySlot>& GetInventorySlots() const { return this->GetSlotView(); };
+
+    /**
+     *  Overwrites the slot at the given index, keeping the slot storage, the indices, the summary and replication in sync.
+     *  *MUST BE CALLED ON SERVER*
+     */
+    UFUNCTION(BlueprintCallable)
+    void SetInventorySlot(int32 Index, const FInventorySlot& NewSlot);
+
+    UFUNCTION(BlueprintCallable)
+    void SetStorageMode(EInventoryStorageMode InStorageMode);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    EInventoryStorageMode GetStorageMode() const { return this->StorageMode; }
+
+    /** Re-copies the slot view into the structure-of-arrays storage and rebuilds the partial stack and tag indices */
+    UFUNCTION(BlueprintCallable)
+    void RebuildSlotStorage();
+
+    /**
+     *  Merges all partial stacks of the same item and sorts the slots by item id and stack size, empty slots last.
+     *  Runs in one O(n log n) pass and only writes the slots that changed, so it costs a single replication update.
+     *  *MUST BE CALLED ON SERVER*
+     *
+     *  @return True if any slot changed
+     */
+    UFUNCTION(BlueprintCallable)
+    bool CompactInventory();
+
+    UFUNCTION(Server, Reliable, BlueprintCallable)
+    void ServerCompactInventory();
+
+    UFUNCTION(BlueprintCallable)
+    void SetCompactPolicy(EInventoryCompactPolicy InCompactPolicy);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    EInventoryCompactPolicy GetCompactPolicy() const { return this->CompactPolicy; }
+
+    /** Returns the total amount of items with the given tag or one of its child tags */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    int32 CountItemsWithTag(FGameplayTag Tag) const;
+
+    /** Returns the indices of the slots holding an item with the given tag or one of its child tags, in ascending order */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    TArray<int32> FindSlotsWithTag(FGameplayTag Tag) const;
+
+    /**
+     *  Removes items with the given tag or one of its child tags, visiting only the slots that hold them.
+     *  *MUST BE CALLED ON SERVER*
+     *
+     *  @param Tag  The tag to remove items of
+     *  @param Amount  Max amount of items to remove, negative to remove all of them
+     *
+     *  @return The amount of items removed
+     */
+    UFUNCTION(BlueprintCallable)
+    int32 RemoveItemsWithTag(FGameplayTag Tag, int32 Amount = -1);
 
+    /** Swaps two slots, applied right away on the owning client and confirmed by the server */
     UFUNCTION(BlueprintCallable)
     void SwapInventorySlots(int32 SourceIndex, UInventoryComponent* SourceInventory, int32 TargetIndex);
 
     UFUNCTION(Server, Reliable)
-    void ServerSwapInventorySlots(int32 SourceIndex, UInventoryComponent* SourceInventory, int32 TargetIndex);
+    void ServerSwapInventorySlots(int32 SourceIndex,
+                                  UInventoryComponent* SourceInventory,
+                                  int32 TargetIndex,
+                                  int32 PredictionKey = 0);
+
+    /**
+     *  Tells the owning client whether the server accepted the operations predicted with the given key
+     *
+     *  @param AppliedSequence  SlotSequence of this inventory right after the server applied the operations
+     *  @param ParticipantSequence  SlotSequence of the other inventory of a swap, see AddPredictionParticipant
+     */
+    UFUNCTION(Client, Reliable)
+    void ClientResolvePrediction(int32 PredictionKey, bool bAccepted, int32 AppliedSequence, int32 ParticipantSequence = 0);
+
+    /** Can operations on this inventory be applied ahead of the server? */
+    bool CanPredict() const;
+
+    /** Returns a new key to predict one operation with, unique within the process */
+    static int32 CreatePredictionKey();
+
+    void PredictAddItem(int32 PredictionKey, UItemDataAsset* ItemToAdd, int32 Amount);
+
+    void PredictRemoveItem(int32 PredictionKey, UItemDataAsset* ItemToRemove, int32 Amount);
+
+    void PredictSetSlot(int32 PredictionKey, int32 Index, const FInventorySlot& NewSlot);
+
+    /**
+     *  Resolves the operations predicted with the given key.
+     *  Accepted operations stay applied until the replicated SlotSequence reaches AppliedSequence, rejected ones are rolled back right away.
+     *  The resolution is forwarded to the other inventories that predicted with the same key, with ParticipantSequence.
+     */
+    void ResolvePrediction(int32 PredictionKey, bool bAccepted, int32 AppliedSequence = 0, int32 ParticipantSequence = 0);
+
+    /** Number of slot writes the server made to this inventory, as last replicated on clients */
+    int32 GetSlotSequence() const { return this->SlotSequence; }
+
+    /** Registers another inventory to resolve together with this one, e.g. the other side of a swap */
+    void AddPredictionParticipant(int32 PredictionKey, UInventoryComponent* Participant);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    FInventoryPredictionStats GetPredictionStats() const { return this->PredictionStats; }
+
+    /** Share of predicted keys that were rejected or corrected by the server */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    float GetMispredictionRate() const;
+
+    /**
+     *  Moves a set of items from one inventory to another in a single planned pass.
+     *  Moved items are merged into the target's partial stacks first, then placed into empty slots,
+     *  and each inventory is notified once.
+     *
+     *  @note Expected to be called on the Server
+     *
+     *  @param Source  The UInventoryComponent to take the items from
+     *  @param Target  The UInventoryComponent to move the items into
+     *  @param Filter  The items to move, an empty filter moves everything
+     *  @param MaxAmount  Max total amount of items to move, negative for no limit
+     *
+     *  @return The total amount of items moved
+     */
+    UFUNCTION(BlueprintCallable, Category="Inventory")
+    static int32 TransferItems(UInventoryComponent* Source,
+                               UInventoryComponent* Target,
+                               const TArray<UItemDataAsset*>& Filter,
+                               int32 MaxAmount = -1);
+
+    /**
+     *  Moves a set of items between this inventory and another one on the server, see TransferItems.
+     *  The other inventory has to belong to the same player or be close enough to view, see CanBeModifiedBy
+     */
+    UFUNCTION(Server, Reliable, BlueprintCallable)
+    void ServerTransferItems(UInventoryComponent* Source,
+                             UInventoryComponent* Target,
+                             const TArray<UItemDataAsset*>& Filter,
+                             int32 MaxAmount = -1);
+
+    /**
+     *  May a server RPC of the given component change this inventory? True for components of the same actor or player,
+     *  and for a player close enough to view the inventory
+     *
+     *  @param Caller  The component whose owning client called the RPC
+     */
+    bool CanBeModifiedBy(const UActorComponent* Caller) const;
+
+    /** Notifies the owning client of several added items at once */
+    UFUNCTION(Client, Reliable)
+    void ClientOnItemsAdded(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts);
+
+    /** Notifies the owning client of several removed items at once */
+    UFUNCTION(Client, Reliable)
+    void ClientOnItemsRemoved(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts);
+
+    UFUNCTION(BlueprintCallable)
+    void SetReplicationPolicy(EInventoryReplicationPolicy InReplicationPolicy);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    EInventoryReplicationPolicy GetReplicationPolicy() const { return this->ReplicationPolicy; }
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    FInventorySummary GetInventorySummary() const { return this->Summary; }
+
+    /**
+     *  Starts sending the slots of another inventory to this inventory's owning client, e.g. when a player opens a storage container.
+     *  Only inventories using EInventoryReplicationPolicy::OwnerAndViewers accept viewers.
+     *
+     *  @param InventoryToView  The inventory to receive the slots of
+     */
+    UFUNCTION(Server, Reliable, BlueprintCallable)
+    void ServerOpenInventory(UInventoryComponent* InventoryToView);
+
+    /** Stops sending the slots of another inventory to this inventory's owning client */
+    UFUNCTION(Server, Reliable, BlueprintCallable)
+    void ServerCloseInventory(UInventoryComponent* InventoryToView);
+
+    /**
+     *  Receives slots of an inventory this inventory's owning client is viewing
+     *
+     *  @param ViewedInventory  The viewed inventory
+     *  @param NumSlots  Number of slots of the viewed inventory
+     *  @param SlotIndices  Indices of the changed slots, all slots are sent when a viewer opens the inventory
+     *  @param Slots  The changed slots
+     *  @param InSlotSequence  SlotSequence of the viewed inventory with these changes applied
+     */
+    UFUNCTION(Client, Reliable)
+    void ClientReceiveViewedSlots(UInventoryComponent* ViewedInventory,
+                                  int32 NumSlots,
+                                  const TArray<int32>& SlotIndices,
+                                  const TArray<FInventorySlot>& Slots,
+                                  int32 InSlotSequence);
+
+    /**
+     *  Sets the pages of an EInventoryStorageMode::Paged inventory sent to this inventory's owning client.
+     *  Newly viewed pages are sent in full, changes to viewed pages are sent as they happen.
+     *
+     *  @param InventoryToView  The paged inventory to view
+     *  @param Pages  The pages to view, replacing the previously viewed ones. Empty to stop viewing
+     */
+    UFUNCTION(Server, Reliable, BlueprintCallable)
+    void ServerViewInventoryPages(UInventoryComponent* InventoryToView, const TArray<int32>& Pages);
+
+    /**
+     *  Replaces the slots of pages of a paged inventory this inventory's owning client is viewing
+     *
+     *  @param ViewedInventory  The viewed inventory
+     *  @param NumSlots  Number of slots of the viewed inventory
+     *  @param Pages  The pages to replace, pages that are no longer viewed are sent without slots
+     *  @param SlotIndices  Indices of the occupied slots in these pages
+     *  @param Slots  The occupied slots
+     */
+    UFUNCTION(Client, Reliable)
+    void ClientReceiveInventoryPages(UInventoryComponent* ViewedInventory,
+                                     int32 NumSlots,
+                                     const TArray<int32>& Pages,
+                                     const TArray<int32>& SlotIndices,
+                                     const TArray<FInventorySlot>& Slots);
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    int32 GetSlotsPerPage() const { return this->SlotsPerPage; }
+
+    /**
+     *  Applies the fires of the production machines in EProductionMode::Analytic working on this inventory, up to now.
+     *  Changes and replication settle first, reads don't: call this before reading an inventory analytic machines work on
+     */
+    UFUNCTION(BlueprintCallable)
+    void SettleProduction();
+
+    /** Set by the UProductionSubsystem while analytic machines work on this inventory */
+    void SetAnalyticProduction(UProductionSubsystem* InAnalyticProduction) { this->AnalyticProduction = InAnalyticProduction; }
+
+    virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 protected:
     virtual void OnRegister() override;
@@ -108,11 +509,235 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated)
     int NumberOfSlots;
 
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    EInventoryReplicationPolicy ReplicationPolicy;
+
+    UPROPERTY(ReplicatedUsing = OnRep_Summary)
+    FInventorySummary Summary;
+
+    /** Inventories of the players viewing this inventory, only used with EInventoryReplicationPolicy::OwnerAndViewers */
+    TArray<TWeakObjectPtr<UInventoryComponent>> Viewers;
+
+    /** Slots changed since the viewers were last updated */
+    TSet<int32> ViewerDirtySlots;
+
+    bool bViewerUpdatePending = false;
+
+    /** Number of slots per page with EInventoryStorageMode::Paged */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin=1))
+    int32 SlotsPerPage;
+
+    /** Max distance between the owners of a viewer and this inventory for the viewer to open it, 0 for no limit */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin=0))
+    float MaxViewerDistance;
+
+    /** May the given player inventory open this one? Checks that it belongs to a player and is close enough. Checked again on every update */
+    bool CanBeViewedBy(const UInventoryComponent* Viewer) const;
+
+    /** Viewers whose snapshot waits for this inventory's owner to become relevant to them, sent from PreReplication */
+    TArray<TWeakObjectPtr<UInventoryComponent>> PendingSnapshotViewers;
+
+    /** Can the viewer's client resolve this inventory yet? False until the owner's actor channel is open on the viewer's connection */
+    bool IsNetRelevantToViewer(const UInventoryComponent* Viewer) const;
+
+    /** Sends the snapshots that waited for the channel to open to the viewers that can resolve this inventory by now */
+    void SendPendingSnapshots();
+
+    /** Is the actor within MaxViewerDistance of this inventory's owner? */
+    bool IsWithinViewerDistance(const AActor* ViewerOwner) const;
+
+    /** Players viewing pages of this inventory, only used with EInventoryStorageMode::Paged */
+    TArray<FInventoryPageViewer> PageViewers;
+
+    /** Occupied slots of the viewed pages, only used on clients with EInventoryStorageMode::Paged */
+    TMap<int32, FInventorySlot> PagedSlots;
+
+    /** Is this a client copy of a paged inventory, which only holds the viewed pages? */
+    bool IsPagedClient() const;
+
+    /** Sends the occupied slots of PagesToSend and tells the viewer to drop PagesToDrop */
+    void SendPagesToViewer(UInventoryComponent* Viewer, const TArray<int32>& PagesToSend, const TArray<int32>& PagesToDrop);
+
+    /** Replaces the materialized slots of the given pages */
+    void ApplyInventoryPages(int32 NumSlots, const TArray<int32>& Pages, const TArray<int32>& SlotIndices, const TArray<FInventorySlot>& Slots);
+
+    /** Is this the server's copy of the inventory, or an inventory outside of any network game? */
+    bool IsInventoryAuthority() const;
+
+    /** Applies the replication policy to the dynamic replication conditions */
+    void UpdateReplicationConditions();
+
+    /** Marks InventorySlots dirty for push model replication and queues the slot for viewers */
+    void MarkSlotDirty(int32 Index);
+
+    /** Queues the slot for the next batched update of the viewers */
+    void QueueViewerUpdate(int32 Index);
+
+    void RecalculateSummary();
+
+    /** Sends the slots changed this frame to every viewer */
+    void FlushViewerUpdates();
+
+    /** Sends every slot to the viewer, or queues it in PendingSnapshotViewers while its client cannot resolve this inventory */
+    void SendAllSlotsToViewer(UInventoryComponent* Viewer);
+
+    /** Applies slots received as a viewer */
+    void ApplyViewedSlots(int32 NumSlots, const TArray<int32>& SlotIndices, const TArray<FInventorySlot>& Slots, int32 InSlotSequence);
+
+    /** Resolves items and reconciles predictions after the authoritative slots changed */
+    void HandleAuthoritativeSlotsChanged();
+
+    /** Drops the accepted predictions the authoritative slots contain by now, returns true if any was dropped */
+    bool ReconcilePredictions();
+
+    /** Counts the server's slot writes, so clients know which accepted predictions the replicated slots contain */
+    UPROPERTY(ReplicatedUsing = OnRep_SlotSequence)
+    int32 SlotSequence = 0;
+
     UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_InventorySlots)
     TArray<FInventorySlot> InventorySlots;
 
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    EInventoryStorageMode StorageMode;
+
+    /** Scan copy of the slot view, only filled when StorageMode is StructOfArrays */
+    FInventorySlotStorage SlotStorage;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    EInventoryCompactPolicy CompactPolicy;
+
+    /** Slot index of the partial stack of each item id, INDEX_NONE if none. Only kept when CompactPolicy is not Manual */
+    TArray<int32> PartialStackIndices;
+
+    /** Items that got a second partial stack during the current operation */
+    TArray<uint16> ItemsToMerge;
+
+    /** Set while stacks are being merged, so the writes do not queue more merges */
+    bool bMergingStacks = false;
+
+    bool UsesPartialStackIndex() const;
+
+    void RebuildPartialStackIndex();
+
+    /** Entry of the given item in PartialStackIndices, grown as needed */
+    int32& GetPartialStackIndexRef(uint16 ItemId);
+
+    void UpdatePartialStackIndex(int32 Index, const FInventorySlot& OldSlot, const FInventorySlot& NewSlot);
+
+    /** Merges the stacks of one item in place, leaving at most one partial stack */
+    void MergeItemStacks(uint16 ItemId);
+
+    /** Compacts the slots without broadcasting, see CompactInventory */
+    bool CompactSlots();
+
+    /** Restores the invariant of the compact policy after an operation changed the slots */
+    void ApplyCompactPolicy();
+
+    /** Amount of items per tag in the slot view, parent tags included */
+    TMap<FGameplayTag, int32> TagItemCounts;
+
+    /** Slots holding an item with the tag, parent tags included */
+    TMap<FGameplayTag, TSet<int32>> TagSlotIndices;
+
+    void RebuildTagIndex();
+
+    void UpdateTagIndex(int32 Index, const FInventorySlot& OldSlot, const FInventorySlot& NewSlot);
+
+    /** Apply operations locally on clients before the server confirms them */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    bool bEnablePrediction;
+
+    /** Predicted operations in the order they were applied */
+    TArray<FInventoryPrediction> PendingPredictions;
+
+    /** InventorySlots with PendingPredictions applied, empty while nothing is pending */
+    TArray<FInventorySlot> PredictedSlots;
+
+    /** Other inventories to resolve with a prediction key of this inventory */
+    TMap<int32, TArray<TWeakObjectPtr<UInventoryComponent>>> PredictionParticipants;
+
+    FInventoryPredictionStats PredictionStats;
+
+    /** The slots reads should see, the predicted slots while predictions are pending */
+    const TArray<FInventorySlot>& GetSlotView() const;
+
+    void AddPrediction(const FInventoryPrediction& Prediction);
+
+    /** Re-applies the pending predictions on top of InventorySlots, updating the indices of the slots that changed in the view */
+    void RebuildPredictedSlots();
+
+    /** Drops accepted predictions whose replicated update never arrived, e.g. while the owner was not relevant */
+    void DropStaleAcceptedPredictions();
+
+    /** World time predictions are accepted and timed out in, 0 outside of a world */
+    double GetPredictionTime() const;
+
+    /**
+     *  Applies a predicted operation to the given slots
+     *
+     *  @param OutOldSlots  If set, gets the index and previous value of every slot the operation wrote
+     */
+    void ApplyPrediction(TArray<FInventorySlot>& Slots, const FInventoryPrediction& Prediction, TArray<TPair<int32, FInventorySlot>>* OutOldSlots = nullptr) const;
+
+    /** Swaps two slots, returns false if either index is invalid */
+    bool TrySwapInventorySlots(int32 SourceIndex, UInventoryComponent* SourceInventory, int32 TargetIndex);
+
+    bool UsesSlotStorage() const;
+
+    /** Writes a slot, every slot change goes through here to keep the storage in sync */
+    void SetSlot(int32 Index, const FInventorySlot& NewSlot);
+
+    /** Updates the slot storage, the partial stack index and the tag index for one slot of the slot view */
+    void UpdateSlotIndices(int32 Index, const FInventorySlot& OldSlot, const FInventorySlot& NewSlot);
+
+    int32 FindPartialStackIndex(uint16 ItemId) const;
+
+    int32 FindEmptySlotIndex() const;
+
+    /**
+     *  Finds the slots to add an amount of an item to in one forward pass, partial stacks first and then empty slots in slot order.
+     *  Empty slots are remembered on the way, the pass ends early once the partial stacks take the amount
+     *
+     *  @param OutSlotIndices  The partial stacks to fill, followed by the empty slots to start stacks in
+     *
+     *  @return The amount that does not fit
+     */
+    int32 FindSlotsToAdd(uint16 ItemId, int32 Amount, TArray<int32, TInlineAllocator<8>>& OutSlotIndices) const;
+
+    /**
+     *  Adds an amount of an item to the slots FindSlotsToAdd finds
+     *
+     *  @param bAllOrNothing  Add nothing unless all of the amount fits
+     *
+     *  @return The amount that was not added
+     */
+    int32 AddItemToSlots(UItemDataAsset* ItemToAdd, int32 Amount, bool bAllOrNothing);
+
+    UItemDataAsset* GetItemFromId(uint16 ItemId) const;
+
+    /** Subsystem settling the analytic machines of this inventory, nullptr if there are none */
+    UProductionSubsystem* AnalyticProduction = nullptr;
+
+    /** Set while settling, so the settle's own operations do not settle again */
+    bool bSettlingProduction = false;
+
+    /** Broadcasts OnItemAdded per item, then OnItemChanged once, and notifies the owning client with a single RPC */
+    void NotifyItemsAdded(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts);
+
+    /** Broadcasts OnItemRemoved per item, then OnItemChanged once, and notifies the owning client with a single RPC */
+    void NotifyItemsRemoved(const TArray<uint16>& ItemIds, const TArray<int32>& Amounts);
+
 private:
+    /** Reads the slot view without settling, to schedule its wake-ups from the settled fires */
+    friend class UProductionSubsystem;
+
     //! @brief  Called on clients when InventorySlots is updated
     UFUNCTION()
     void OnRep_InventorySlots();
+
+    UFUNCTION()
+    void OnRep_SlotSequence();
+
+    UFUNCTION()
+    void OnRep_Summary();
 };
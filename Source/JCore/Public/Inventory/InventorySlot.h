@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "ItemDataAsset.h"
+#include "ItemRegistrySubsystem.h"
 #include "InventorySlot.generated.h"
 
 /**
@@ -17,31 +18,81 @@ struct FInventorySlot
     FInventorySlot()
     {
         Item = nullptr;
+        ItemId = UItemDataAsset::InvalidItemId;
         CurrentStackSize = 0;
+        MaxStackSize = 0;
     };
 
     FInventorySlot(UItemDataAsset* NewItem)
     {
         Item = NewItem;
+        ItemId = UItemRegistrySubsystem::GetItemId(NewItem);
         CurrentStackSize = 1;
+        MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
     };
 
     FInventorySlot(UItemDataAsset* NewItem, int32 Amount)
     {
         Item = NewItem;
+        ItemId = UItemRegistrySubsystem::GetItemId(NewItem);
         CurrentStackSize = Amount;
+        MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
     };
 
-    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    /** Resolved from ItemId on clients, only the id is sent over the network */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, NotReplicated)
     UItemDataAsset* Item;
 
+    /** Dense id of Item from the UItemRegistrySubsystem */
+    UPROPERTY()
+    uint16 ItemId;
+
     UPROPERTY(EditAnywhere, BlueprintReadOnly)
     int CurrentStackSize;
 
+    /** Max stack size of the item, cached when the item is placed so fullness checks never leave the slot */
+    UPROPERTY(BlueprintReadOnly, Transient, NotReplicated)
+    int32 MaxStackSize;
+
     void Clear()
     {
         Item = nullptr;
+        ItemId = UItemDataAsset::InvalidItemId;
         CurrentStackSize = 0;
+        MaxStackSize = 0;
+    }
+
+    /** Sets the item by its id, resolving the data asset and caching its max stack size */
+    void SetItemId(uint16 NewItemId)
+    {
+        UItemRegistrySubsystem* ItemRegistry = UItemRegistrySubsystem::Get();
+
+        Item = ItemRegistry ? ItemRegistry->GetItem(NewItemId) : nullptr;
+        ItemId = NewItemId;
+        MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(NewItemId);
+    }
+
+    /**
+     *  Derives ItemId and MaxStackSize from Item, for slots that only set the item,
+     *  e.g. authored in the editor or made with the Blueprint Make node
+     */
+    void ResolveItemId()
+    {
+        if (ItemId != UItemDataAsset::InvalidItemId || !Item)
+        {
+            return;
+        }
+
+        ItemId = UItemRegistrySubsystem::GetItemId(Item);
+        MaxStackSize = UItemRegistrySubsystem::GetMaxStackSize(ItemId);
+    }
+
+    void PostSerialize(const FArchive& Ar)
+    {
+        if (Ar.IsLoading())
+        {
+            ResolveItemId();
+        }
     }
 
     /**
@@ -53,14 +104,7 @@ struct FInventorySlot
      */
     static bool IsSlotFull(const FInventorySlot& SlotToCheck)
     {
-        UItemDataAsset* ItemDataAsset = SlotToCheck.Item;
-
-        if (!ItemDataAsset)
-        {
-            return false;
-        }
-
-        return SlotToCheck.CurrentStackSize == ItemDataAsset->GetMaxStackSize();
+        return !IsSlotEmpty(SlotToCheck) && SlotToCheck.CurrentStackSize >= SlotToCheck.MaxStackSize;
     };
 
     /**
@@ -72,18 +116,27 @@ struct FInventorySlot
      */
     static bool IsSlotEmpty(const FInventorySlot& SlotToCheck)
     {
-        return SlotToCheck.Item == nullptr;
+        return SlotToCheck.ItemId == UItemDataAsset::InvalidItemId;
     }
 
     FORCEINLINE bool operator==(const FInventorySlot& OtherSlot) const
     {
-        return (Item             == OtherSlot.Item &&
+        return (ItemId           == OtherSlot.ItemId &&
                 CurrentStackSize == OtherSlot.CurrentStackSize);
     }
 
     FORCEINLINE bool operator!=(const FInventorySlot& OtherSlot) const
     {
-        return (Item             != OtherSlot.Item ||
+        return (ItemId           != OtherSlot.ItemId ||
                 CurrentStackSize != OtherSlot.CurrentStackSize);
     }
 };
+
+template<>
+struct TStructOpsTypeTraits<FInventorySlot> : public TStructOpsTypeTraitsBase2<FInventorySlot>
+{
+    enum
+    {
+        WithPostSerialize = true
+    };
+};
@@ -0,0 +1,47 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "InventorySlot.h"
+
+/**
+ *  Structure-of-arrays copy of an inventory's slots, used to scan large containers.
+ *
+ *  Item ids and stack sizes are kept in parallel arrays and max stack sizes come from the UItemRegistrySubsystem's flat table,
+ *  so the scans below are linear passes over plain integers that the compiler can vectorize.
+ */
+struct JCORE_API FInventorySlotStorage
+{
+    void Init(int32 NumSlots);
+
+    void Reset();
+
+    int32 Num() const { return this->ItemIds.Num(); }
+
+    void SetSlot(int32 Index, const FInventorySlot& InSlot);
+
+    void SetSlot(int32 Index, uint16 ItemId, int32 StackSize);
+
+    /** Copies the slots of an inventory into the parallel arrays */
+    void CopyFrom(const TArray<FInventorySlot>& InSlots);
+
+    /** Returns the index of the first slot holding a partial stack of the given item, INDEX_NONE if none */
+    int32 FindFirstPartialStack(uint16 ItemId) const;
+
+    /** Returns the index of the first empty slot, INDEX_NONE if none */
+    int32 FindFirstEmptySlot() const;
+
+    /** Returns the total amount of the given item over all slots */
+    int32 SumItemCount(uint16 ItemId) const;
+
+    /** Returns how many of the given item still fit into partial stacks and empty slots */
+    int32 GetAvailableSpace(uint16 ItemId) const;
+
+    int32 GetNumEmptySlots() const;
+
+    TArray<uint16> ItemIds;
+
+    TArray<int32> StackSizes;
+};
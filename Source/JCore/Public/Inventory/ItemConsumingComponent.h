@@ -5,6 +5,7 @@
 #include "Components/ActorComponent.h"
 
 #include "Inventory/InventoryComponent.h"
+#include "Inventory/ProductionSubsystem.h"
 
 #include "ItemConsumingComponent.generated.h"
 
@@ -20,9 +21,26 @@ class JCORE_API UItemConsumingComponent : public UActorComponent
 public:
     UItemConsumingComponent();
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    /** Broadcast with the amount consumed per frame, per settle in EProductionMode::Analytic or per published run in EProductionMode::Simulated */
     UPROPERTY(BlueprintAssignable)
     FOnItemConsumed OnItemConsumed;
 
+    UFUNCTION(BlueprintCallable)
+    void SetInventoryComponent(UInventoryComponent* InInventoryComponent);
+
+    UFUNCTION(BlueprintCallable)
+    void SetItemToConsume(UItemDataAsset* InItemToConsume);
+
+    /** Seconds between two consumed items, takes effect when it starts consuming again */
+    UFUNCTION(BlueprintCallable)
+    void SetTimeToConsume(float InTimeToConsume);
+
+    /** Takes effect when it starts consuming again */
+    UFUNCTION(BlueprintCallable)
+    void SetProductionMode(EProductionMode InProductionMode);
+
     UFUNCTION(BlueprintCallable)
     void StartConsuming();
 
@@ -37,14 +55,13 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool bLoop;
 
+    /** Analytic fires are applied when the inventory is read or changed instead of every period, for machines running steadily */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    EProductionMode ProductionMode = EProductionMode::Discrete;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     UItemDataAsset* ItemToConsume;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     UInventoryComponent* InventoryComponent;
-
-    FTimerHandle ConsumingTimerHandle;
-
-    UFUNCTION()
-    void OnConsumingTimerEnded();
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
+#include "GameplayTagContainer.h"
 #include "ItemDataAsset.generated.h"
 
 /**
@@ -18,10 +19,12 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     FString Name;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    /** Searchable so the UItemRegistrySubsystem can read it from the asset registry without loading the item */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, AssetRegistrySearchable)
     bool bStackable;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    /** Searchable so the UItemRegistrySubsystem can read it from the asset registry without loading the item */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, AssetRegistrySearchable)
     int32 MaxStackSize;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -33,7 +36,21 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     UStaticMesh* StaticMesh;
 
+    /** Tags inventories can query items by, e.g. Item.Fuel */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, AssetRegistrySearchable)
+    FGameplayTagContainer Tags;
+
 public:
+    /** Id reserved for 'no item' by the UItemRegistrySubsystem */
+    static constexpr uint16 InvalidItemId = 0;
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+    /** Dense id assigned by the UItemRegistrySubsystem, InvalidItemId until the item is registered */
+    uint16 GetItemId() const { return this->ItemId; }
+
     UFUNCTION(BlueprintCallable, BlueprintPure)
     FString GetName() { return this->Name; }
 
@@ -45,4 +62,12 @@ public:
 
     UFUNCTION(BlueprintCallable, BlueprintPure)
     UStaticMesh* GetStaticMesh() const { return this->StaticMesh; }
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    const FGameplayTagContainer& GetTags() const { return this->Tags; }
+
+private:
+    friend class UItemRegistrySubsystem;
+
+    uint16 ItemId = InvalidItemId;
 };
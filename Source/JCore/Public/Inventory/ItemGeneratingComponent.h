@@ -5,6 +5,7 @@
 #include "Components/ActorComponent.h"
 
 #include "Inventory/InventoryComponent.h"
+#include "Inventory/ProductionSubsystem.h"
 
 #include "ItemGeneratingComponent.generated.h"
 
@@ -18,18 +19,34 @@ class JCORE_API UItemGeneratingComponent : public UActorComponent
 public:
     UItemGeneratingComponent();
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     UFUNCTION(BlueprintCallable)
     void SetInventoryComponent(UInventoryComponent* InInventoryComponent);
 
     UFUNCTION(BlueprintCallable)
     void SetItemToGenerate(UItemDataAsset* InItemToGenerate);
 
+    /** Seconds between two generated items at full throughput, takes effect when it starts generating again */
+    UFUNCTION(BlueprintCallable)
+    void SetTimeToGenerate(float InTimeToGenerate);
+
+    /** Takes effect when it starts generating again */
+    UFUNCTION(BlueprintCallable)
+    void SetProductionMode(EProductionMode InProductionMode);
+
     UFUNCTION(BlueprintCallable)
     void StartGenerating();
 
     UFUNCTION(BlueprintCallable)
     void StopGenerating();
 
+    /** Scales how often an item is generated, e.g. by the power its buildable gets. 0 pauses generating until it is raised again */
+    UFUNCTION(BlueprintCallable)
+    void SetThroughputScale(float InThroughputScale);
+
+    float GetThroughputScale() const { return this->ThroughputScale; }
+
 protected:
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -38,14 +55,21 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool bLoop;
 
+    /** Analytic fires are applied when the inventory is read or changed instead of every period, for machines running steadily */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    EProductionMode ProductionMode = EProductionMode::Discrete;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     UItemDataAsset* ItemToGenerate;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     UInventoryComponent* InventoryComponent;
 
-    FTimerHandle GeneratingTimerHandle;
+    float ThroughputScale = 1.f;
+
+    /** Time left on the item in progress at full throughput, while generating is paused */
+    double PausedGenerateTime = 0.0;
 
-    UFUNCTION()
-    void OnGeneratingTimerEnded();
+    /** StartGenerating was called and StopGenerating was not, also while paused by the throughput scale */
+    bool bGenerating = false;
 };
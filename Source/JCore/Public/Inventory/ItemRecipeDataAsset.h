@@ -23,8 +23,24 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     TMap<UItemDataAsset*, int32> OutItems;
 
+    /** Seconds a queued craft of this recipe takes, 0 crafts it as soon as it reaches the head of the queue */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin=0))
+    float CraftTime = 0.f;
+
 public:
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
     TMap<UItemDataAsset*, int32> GetInItems() { return InItems; }
 
     TMap<UItemDataAsset*, int32> GetOutItems() { return OutItems; }
+
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    float GetCraftTime() const { return this->CraftTime; }
+
+    /** Sets what a recipe created at runtime takes and makes, before it is registered */
+    void SetItems(const TMap<UItemDataAsset*, int32>& InInItems, const TMap<UItemDataAsset*, int32>& InOutItems);
+
+    void SetCraftTime(float InCraftTime);
 };
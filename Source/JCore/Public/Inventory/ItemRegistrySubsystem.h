@@ -0,0 +1,135 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+
+#include "Inventory/ItemDataAsset.h"
+
+#include "ItemRegistrySubsystem.generated.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogItemRegistry, Log, All)
+
+struct FAssetData;
+
+/**
+ *  Assigns every UItemDataAsset a dense integer id and keeps flat lookup tables of the item fields used in hot inventory paths.
+ *
+ *  Ids are assigned in asset path order from the asset registry, so a server and its clients agree on them for the same content.
+ *  The scan always runs before the first lazy registration, waiting for the asset registry if needed, so lazily registered
+ *  items (e.g. created at runtime) get ids after all content items and are only valid within the current process.
+ *  The cached fields of items that are not loaded come from their asset registry tags.
+ */
+UCLASS()
+class JCORE_API UItemRegistrySubsystem : public UEngineSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    UItemRegistrySubsystem();
+
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    /** Returns the registry, nullptr before the engine subsystems are initialized */
+    static UItemRegistrySubsystem* Get() { return Instance; }
+
+    /**
+     *  Gets the dense id of the given item, registering the item if needed.
+     *
+     *  @param Item  The item to get the id of
+     *
+     *  @return The id of the item, UItemDataAsset::InvalidItemId for nullptr
+     */
+    static uint16 GetItemId(UItemDataAsset* Item)
+    {
+        if (!Item)
+        {
+            return UItemDataAsset::InvalidItemId;
+        }
+
+        if (Item->GetItemId() != UItemDataAsset::InvalidItemId)
+        {
+            return Item->GetItemId();
+        }
+
+        return Instance ? Instance->RegisterItem(Item) : UItemDataAsset::InvalidItemId;
+    }
+
+    /** Gets the max stack size of the item with the given id without touching the item's data asset */
+    static int32 GetMaxStackSize(uint16 ItemId)
+    {
+        if (!Instance || !Instance->MaxStackSizes.IsValidIndex(ItemId))
+        {
+            return 0;
+        }
+
+        return Instance->MaxStackSizes[ItemId];
+    }
+
+    /** Is the item with the given id stackable? */
+    static bool IsStackable(uint16 ItemId)
+    {
+        if (!Instance || !Instance->StackableFlags.IsValidIndex(ItemId))
+        {
+            return false;
+        }
+
+        return Instance->StackableFlags[ItemId];
+    }
+
+    /** Gets the tags of the item with the given id, including their parent tags so a query for Item.Fuel matches Item.Fuel.Coal */
+    static const FGameplayTagContainer& GetItemTags(uint16 ItemId)
+    {
+        if (!Instance || !Instance->ItemTags.IsValidIndex(ItemId))
+        {
+            return FGameplayTagContainer::EmptyContainer;
+        }
+
+        return Instance->ItemTags[ItemId];
+    }
+
+    /** Resolves the item with the given id, loading its data asset if it is not loaded yet */
+    UItemDataAsset* GetItem(uint16 ItemId);
+
+    /** Registers the given item, or refreshes its cached fields if it is already registered */
+    uint16 RegisterItem(UItemDataAsset* Item);
+
+    /** Number of ids handed out, including the reserved invalid id */
+    int32 GetNumItemIds() const { return this->ItemPaths.Num(); }
+
+    /** Broadcast once the content items got their ids, anything keyed by ids from before should be rebuilt */
+    FSimpleMulticastDelegate OnItemsScanned;
+
+protected:
+    uint16 AddItemPath(const FSoftObjectPath& ItemPath);
+
+    void CacheItem(uint16 ItemId, UItemDataAsset* Item);
+
+    /** Fills the lookup tables of an item that is not loaded from its asset registry tags */
+    void CacheItemAssetData(uint16 ItemId, const FAssetData& Asset);
+
+    void ScanItemAssets();
+
+    static UItemRegistrySubsystem* Instance;
+
+    /** Has ScanItemAssets handed out the ids of the content items yet? */
+    bool bScannedItemAssets;
+
+    /** Asset path of each id, index 0 is the reserved invalid id */
+    TArray<FSoftObjectPath> ItemPaths;
+
+    TMap<FSoftObjectPath, uint16> ItemIdsByPath;
+
+    /** Resolved item of each id, nullptr until the item has been loaded */
+    UPROPERTY()
+    TArray<UItemDataAsset*> Items;
+
+    TArray<int32> MaxStackSizes;
+
+    TArray<bool> StackableFlags;
+
+    /** Tags of each id with their parents */
+    TArray<FGameplayTagContainer> ItemTags;
+};
@@ -0,0 +1,444 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ProductionSubsystem.generated.h"
+
+class FFactorySimulation;
+class UCraftingComponent;
+class UInventoryComponent;
+class UItemConsumingComponent;
+class UItemDataAsset;
+
+DECLARE_LOG_CATEGORY_CLASS(LogProductionSubsystem, Log, All)
+
+enum class EProductionKind : uint8
+{
+    Generate,
+    Consume
+};
+
+/** How the UProductionSubsystem runs a machine */
+UENUM(BlueprintType)
+enum class EProductionMode : uint8
+{
+    /** Fire every period in the subsystem's pass of the frame */
+    Discrete,
+    /**
+     *  Only store when the machine started and its period. The fires since then are applied when the inventory is changed or replicated,
+     *  when the output would fill it or when UInventoryComponent::SettleProduction is called, so a running machine costs nothing per frame
+     */
+    Analytic,
+    /**
+     *  Fire on the fixed-step FFactorySimulation, which runs on a worker thread and is published to the inventories
+     *  in one sync on the game thread. The period is rounded to whole steps
+     */
+    Simulated
+};
+
+/** A generating or consuming machine, copied out of its component so a pass never touches the component */
+struct FProductionMachine
+{
+    /** Time of fire NumFires + 1 */
+    double NextFireTime = 0.0;
+
+    double StartTime = 0.0;
+
+    int64 NumFires = 0;
+
+    TWeakObjectPtr<UActorComponent> Machine;
+
+    TWeakObjectPtr<UInventoryComponent> Inventory;
+
+    UItemDataAsset* Item = nullptr;
+
+    EProductionKind Kind = EProductionKind::Generate;
+
+    bool bLoop = true;
+
+    /** Registration order, machines firing at the same time fire in this order */
+    int64 Order = 0;
+};
+
+/**
+ *  Machines sharing a period. A machine fires again one period after it fired, behind every other machine of the bucket,
+ *  so the machines stay ordered by NextFireTime when read from Cursor on and wrapping around. A pass pops the due ones off the front.
+ */
+struct FProductionBucket
+{
+    double Period = 0.0;
+
+    TArray<FProductionMachine> Machines;
+
+    /** Machine that fires next */
+    int32 Cursor = 0;
+};
+
+/** Consecutive fires of one machine on an inventory, copied out of the machine so inventory callbacks may register and unregister machines */
+struct FProductionFires
+{
+    TWeakObjectPtr<UActorComponent> Machine;
+
+    UItemDataAsset* Item = nullptr;
+
+    EProductionKind Kind = EProductionKind::Generate;
+
+    double StartTime = 0.0;
+
+    double Period = 0.0;
+
+    /** Index of the first fire, as in UProductionSubsystem::GetFireTime */
+    int64 NextFire = 0;
+
+    int64 NumFires = 0;
+
+    /** Registration order of the machine */
+    int64 Order = 0;
+
+    int32 AmountConsumed = 0;
+};
+
+/** Fires one frame applies to an inventory */
+struct FProductionDelta
+{
+    TWeakObjectPtr<UInventoryComponent> Inventory;
+
+    TArray<FProductionFires> Fires;
+};
+
+/** A machine in EProductionMode::Analytic, its fires are counted from its start time when they are settled */
+struct FAnalyticMachine
+{
+    TWeakObjectPtr<UActorComponent> Machine;
+
+    UItemDataAsset* Item = nullptr;
+
+    EProductionKind Kind = EProductionKind::Generate;
+
+    double StartTime = 0.0;
+
+    double Period = 0.0;
+
+    bool bLoop = true;
+
+    /** Registration order, machines firing at the same time fire in this order */
+    int64 Order = 0;
+
+    /** Fires already applied to the inventory */
+    int64 NumSettledFires = 0;
+
+    /** Fires up to the given time, a machine that does not loop fires once */
+    int64 GetNumFires(double Time) const;
+};
+
+/** The analytic machines of one inventory */
+struct FAnalyticInventory
+{
+    TWeakObjectPtr<UInventoryComponent> Inventory;
+
+    TArray<FAnalyticMachine> Machines;
+
+    /** Time of the earliest wake-up in the heap for this inventory, MAX_dbl if none */
+    double WakeUpTime = MAX_dbl;
+};
+
+/** A machine in EProductionMode::Simulated, as the game thread keeps it between simulation runs */
+struct FSimulatedMachine
+{
+    TWeakObjectPtr<UActorComponent> Machine;
+
+    TWeakObjectPtr<UInventoryComponent> Inventory;
+
+    UItemDataAsset* Item = nullptr;
+
+    EProductionKind Kind = EProductionKind::Generate;
+
+    bool bLoop = true;
+
+    int64 PeriodSteps = 1;
+
+    int64 NextFireStep = 0;
+};
+
+/** An inventory the simulation keeps a mirror of, and what the game thread still has to sync to it or publish from it */
+struct FSimulatedInventory
+{
+    TWeakObjectPtr<UInventoryComponent> Inventory;
+
+    /** Index of the mirror in the simulation */
+    int32 SimulationIndex = INDEX_NONE;
+
+    /** Slots written since the mirror was last synced */
+    TSet<int32> DirtySlots;
+
+    /** Every slot was replaced, the mirror is synced in full */
+    bool bAllSlotsDirty = false;
+
+    /** Items runs added or removed that are not in the inventory yet, e.g. generates that no longer fit when they were published */
+    TMap<UItemDataAsset*, int64> UnpublishedAmounts;
+};
+
+/** Time an analytic inventory has to be settled at without being read, e.g. when a generator fills it */
+struct FProductionWakeUp
+{
+    double Time = 0.0;
+
+    const UInventoryComponent* Inventory = nullptr;
+
+    bool operator<(const FProductionWakeUp& Other) const { return this->Time < Other.Time; }
+};
+
+/**
+ *  Runs every UItemGeneratingComponent and UItemConsumingComponent of the world, replacing their timers.
+ *  Machines live in contiguous arrays bucketed by period and are advanced in one pass per frame that only visits the machines that fire.
+ *  The fires are collected per inventory and applied through ApplyFires.
+ *
+ *  Machines in EProductionMode::Analytic are not part of the pass, the inventory settles them through SettleInventory.
+ *  Both modes fire at StartTime + N * Period and apply their fires through ApplyFires, in fire time order and ties in registration order,
+ *  so they end with the same slots.
+ *
+ *  Machines in EProductionMode::Simulated are mirrored into a FFactorySimulation each tick the previous run completed,
+ *  which advances them to the current step on a worker thread. The next tick publishes the run's item changes to the inventories.
+ *  The simulation keeps its copies of the inventories between runs, only the slots written since the last run are synced to it.
+ */
+UCLASS()
+class JCORE_API UProductionSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    /**
+     *  Starts running a machine, restarting its period if it is already running.
+     *  A machine without an inventory or item keeps its period running but its fires do nothing until UpdateMachine gives it both.
+     *
+     *  @param Machine  The UItemGeneratingComponent or UItemConsumingComponent
+     *  @param Kind  Whether the machine adds or removes its item
+     *  @param Inventory  The UInventoryComponent the machine works on, may be nullptr
+     *  @param Item  The item to add or remove, one per fire, may be nullptr
+     *  @param Period  Seconds between fires
+     *  @param bLoop  False to fire once
+     *  @param Mode  Whether to fire in the pass of each frame or to settle the fires lazily
+     *
+     *  @return True if the machine was registered
+     */
+    bool RegisterMachine(UActorComponent*     Machine,
+                         EProductionKind      Kind,
+                         UInventoryComponent* Inventory,
+                         UItemDataAsset*      Item,
+                         double               Period,
+                         bool                 bLoop,
+                         EProductionMode      Mode = EProductionMode::Discrete);
+
+    /** Updates the inventory and item of a running machine, keeping its period's phase */
+    void UpdateMachine(UActorComponent* Machine, UInventoryComponent* Inventory, UItemDataAsset* Item);
+
+    /**
+     *  Changes the period of a running machine and when it fires next, keeping the fires it made so far.
+     *  Used to scale a machine's throughput without restarting its period
+     *
+     *  @param Machine  A registered machine
+     *  @param Period  Seconds between fires from the next one on
+     *  @param TimeToNextFire  Seconds from now until the next fire, at most Period
+     */
+    void RescheduleMachine(UActorComponent* Machine, double Period, double TimeToNextFire);
+
+    /** Seconds until a running machine fires next, negative if it is not registered */
+    double GetTimeToNextFire(const UActorComponent* Machine) const;
+
+    /** Stops running a machine, an analytic machine gets its fires up to now settled first */
+    void UnregisterMachine(UActorComponent* Machine);
+
+    bool IsMachineRegistered(const UActorComponent* Machine) const;
+
+    int32 GetNumMachines() const
+    {
+        return this->MachineBuckets.Num() + this->AnalyticMachineInventories.Num() + this->IdleAnalyticMachines.Num() + this->SimulatedMachines.Num();
+    }
+
+    /** Periods the discrete machines run at */
+    int32 GetNumBuckets() const { return this->Buckets.Num(); }
+
+    /**
+     *  Applies the fires of the analytic machines of an inventory up to now, called through UInventoryComponent::SettleProduction
+     *
+     *  @param Inventory  The UInventoryComponent to settle
+     */
+    void SettleInventory(UInventoryComponent* Inventory);
+
+    /**
+     *  Advances every machine and queued craft of the world by the given time at once, e.g. for the time a save was not loaded.
+     *
+     *  The time is split into at most MaxFastForwardSteps steps. Each step moves every machine's clock back by the step,
+     *  counts the fires that became due in closed form and applies them like one frame's, so full inventories and missing
+     *  items limit the machines per step. The crafting queues then advance by the step, in the order of the production graph.
+     *
+     *  @param ElapsedSeconds  Time to advance by
+     */
+    UFUNCTION(BlueprintCallable, Category="Production")
+    void FastForward(double ElapsedSeconds);
+
+    /** Length of a fast-forward step, shorter steps get items to their consumers sooner */
+    static constexpr double FastForwardStepSeconds = 60.0;
+
+    /** Steps a fast-forward is split into at most, however long it is */
+    static constexpr int32 MaxFastForwardSteps = 64;
+
+    /**
+     *  Sets the fixed step of the simulated machines, only while none are registered
+     *
+     *  @param StepSeconds  Length of a simulation step
+     *
+     *  @return True if the step was set
+     */
+    bool SetSimulationStepSeconds(double StepSeconds);
+
+    double GetSimulationStepSeconds() const { return this->SimulationStepSeconds; }
+
+    /** Time of the given fire, 1 for the first one. Both modes fire at these times */
+    static double GetFireTime(double StartTime, double Period, int64 FireIndex) { return StartTime + FireIndex * Period; }
+
+    /** Number of fires at or before the given time, consistent with GetFireTime */
+    static int64 GetNumFiresAt(double StartTime, double Period, double Time);
+
+protected:
+    /** Fires the due machines of a bucket, adding their fires to the frame's deltas */
+    void AdvanceBucket(FProductionBucket& Bucket, double Now);
+
+    /**
+     *  Adds fires of a machine to the frame's deltas
+     *
+     *  @param FirstFire  Index of the first of the fires
+     *  @param NumFires  Number of consecutive fires
+     */
+    void AddDelta(UInventoryComponent* Inventory, const FProductionMachine& Machine, double Period, int64 FirstFire, int64 NumFires);
+
+    void ApplyDeltas();
+
+    /**
+     *  Applies fires of several machines to an inventory as if each had been applied at its fire time, ties in registration order.
+     *  If no order of the fires can run out of items or space, every item's fires are applied as one add and one remove,
+     *  otherwise they are applied one by one.
+     */
+    void ApplyFires(UInventoryComponent* Inventory, TArrayView<FProductionFires> Fires);
+
+    /** Shifts the machines of a bucket back by the given time and adds the fires that became due, in closed form */
+    void FastForwardBucket(FProductionBucket& Bucket, double Seconds, double Now);
+
+    bool RegisterSimulatedMachine(const FSimulatedMachine& SimulatedMachine, double Period);
+
+    void UnregisterSimulatedMachine(const UActorComponent* Machine);
+
+    /** Current simulation step by the world time */
+    int64 GetSimulationStepAt(double Time) const;
+
+    /** Copies the simulated machines and the dirty slots of their inventories into the simulation and advances it to the given step on a worker thread */
+    void LaunchSimulation(int64 TargetStep);
+
+    /** Waits for the running simulation and publishes its item changes and machine states */
+    void PublishSimulation();
+
+    /** Gets the mirror of an inventory, adding it to the simulation with all of its slots if it has none yet */
+    FSimulatedInventory& FindOrAddSimulatedInventory(UInventoryComponent* Inventory);
+
+    /** Drops the mirrors and adds the inventories to the simulation again, once their slot count changed or too many mirrors are unused */
+    void RebuildSimulatedInventories();
+
+    void HandleSimulatedSlotChanged(int32 SlotIndex, const UInventoryComponent* Inventory);
+
+    /** Sorts crafters by the position of their owner's node in the production graph, upstream first */
+    void SortByProductionGraph(TArray<UCraftingComponent*>& Crafters) const;
+
+    FProductionMachine* FindMachine(const UActorComponent* Machine, int32* OutMachineIndex = nullptr);
+
+    /** Index of the bucket of the given period, added if there is none */
+    int32 FindOrAddBucket(double Period);
+
+    /** Inserts a machine at its place by NextFireTime, which has to be within one period of the bucket from now */
+    void InsertMachine(FProductionBucket& Bucket, const FProductionMachine& Machine);
+
+    /** Removes a machine from its bucket. The bucket stays until PruneEmptyBuckets, a pass may still be iterating the buckets */
+    void RemoveMachineAt(FProductionBucket& Bucket, int32 MachineIndex);
+
+    /** Removes the buckets without machines, e.g. of a period no machine runs at any more */
+    void PruneEmptyBuckets();
+
+    bool RegisterAnalyticMachine(UActorComponent* Machine, const FAnalyticMachine& AnalyticMachine, UInventoryComponent* Inventory);
+
+    /** Removes an analytic machine, settling its inventory first */
+    void UnregisterAnalyticMachine(UActorComponent* Machine);
+
+    /**
+     *  Applies the pending fires of an inventory's analytic machines through ApplyFires
+     *
+     *  @return True if any fires were pending
+     */
+    bool ApplyAnalyticFires(UInventoryComponent* Inventory, FAnalyticInventory& AnalyticInventory, double Now);
+
+    /** Pushes a wake-up for the next time the inventory's buffer fills or a machine that does not loop fires */
+    void ScheduleWakeUp(UInventoryComponent* Inventory, FAnalyticInventory& AnalyticInventory);
+
+    TArray<FProductionBucket> Buckets;
+
+    /** Bucket index of every registered machine */
+    TMap<const UActorComponent*, int32> MachineBuckets;
+
+    /** Deltas of the current frame, reused across frames */
+    TArray<FProductionDelta> Deltas;
+
+    /** Index into Deltas by inventory */
+    TMap<const UInventoryComponent*, int32> DeltaIndices;
+
+    /** Order of the next registered machine */
+    int64 NextMachineOrder = 0;
+
+    TMap<const UInventoryComponent*, FAnalyticInventory> AnalyticInventories;
+
+    /** Inventory of every analytic machine */
+    TMap<const UActorComponent*, const UInventoryComponent*> AnalyticMachineInventories;
+
+    /** Analytic machines without an inventory or item, they keep their start time but none of their fires count until they get both */
+    TMap<const UActorComponent*, FAnalyticMachine> IdleAnalyticMachines;
+
+    /** Min-heap by Time, entries that are no longer an inventory's WakeUpTime are stale and only settle early */
+    TArray<FProductionWakeUp> WakeUps;
+
+    /** Analytic inventories settled this frame, their wake-up is recomputed after the frame's changes in the next tick */
+    TSet<const UInventoryComponent*> SettledInventories;
+
+    /** Machines in EProductionMode::Simulated */
+    TArray<FSimulatedMachine> SimulatedMachines;
+
+    /** Index into SimulatedMachines by machine */
+    TMap<const UActorComponent*, int32> SimulatedMachineIndices;
+
+    double SimulationStepSeconds = 0.1;
+
+    /** World time of simulation step 0 */
+    double SimulationStartTime = 0.0;
+
+    /** Step the simulated machines are at once the running simulation completed */
+    int64 SimulationStep = 0;
+
+    /** Only touched by the worker while SimulationTask runs */
+    TSharedPtr<FFactorySimulation> Simulation;
+
+    TFuture<void> SimulationTask;
+
+    /** Inventories mirrored in the simulation */
+    TMap<const UInventoryComponent*, FSimulatedInventory> SimulatedInventories;
+
+    /** Inventories by their index in the simulation, unused mirrors stay in the simulation until it is rebuilt */
+    TArray<TWeakObjectPtr<UInventoryComponent>> SimulationInventories;
+
+    /** Machines of the running simulation by its machine index, as they were when it launched */
+    TArray<FSimulatedMachine> SimulationMachines;
+};
@@ -0,0 +1,130 @@
+// Copyright Joshua Gangl. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/EngineSubsystem.h"
+
+#include "Inventory/BuildingRecipeDataAsset.h"
+#include "Inventory/ItemRecipeDataAsset.h"
+
+#include "RecipeRegistrySubsystem.generated.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogRecipeRegistry, Log, All)
+
+/** Index keys a recipe was last registered with, so it can be removed from the indexes after its asset changed */
+struct FRegisteredRecipeKeys
+{
+    TArray<uint16> InItemIds;
+
+    TArray<uint16> OutItemIds;
+
+    FTopLevelAssetPath OutBuildableClass;
+};
+
+/**
+ *  Knows every UItemRecipeDataAsset and UBuildingRecipeDataAsset and indexes them by buildable class, input item and output item,
+ *  so finding the recipes of an item or a buildable is a hash lookup instead of a scan over all recipes.
+ *
+ *  The recipe assets found in the asset registry on startup are loaded asynchronously and indexed once they arrive, so lookups
+ *  made before that return nothing; OnRecipesChanged is broadcast when they are in. Afterwards the indexes follow the asset registry
+ *  (added, removed and renamed assets) and are updated per recipe when a recipe asset is edited.
+ *
+ *  Building recipes are keyed by the path of their buildable class, not the class object, so reloaded or renamed Blueprint
+ *  classes don't leave stale keys behind.
+ */
+UCLASS()
+class JCORE_API URecipeRegistrySubsystem : public UEngineSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    /** Returns the registry, nullptr before the engine subsystems are initialized */
+    static URecipeRegistrySubsystem* Get() { return Instance; }
+
+    /** Gets the recipe building the given buildable class, nullptr if none */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    UBuildingRecipeDataAsset* GetBuildingRecipe(TSubclassOf<ABuildable> BuildableClass) const;
+
+    /** Gets the item recipes that consume the given item */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    TArray<UItemRecipeDataAsset*> GetRecipesConsuming(UItemDataAsset* Item) const;
+
+    /** Gets the item recipes that produce the given item */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    TArray<UItemRecipeDataAsset*> GetRecipesProducing(UItemDataAsset* Item) const;
+
+    /** Gets the building recipes that consume the given item */
+    UFUNCTION(BlueprintCallable, Category="Crafting")
+    TArray<UBuildingRecipeDataAsset*> GetBuildingRecipesConsuming(UItemDataAsset* Item) const;
+
+    /** Item recipes producing the item with the given id, nullptr if none */
+    const TArray<UItemRecipeDataAsset*>* FindRecipesProducing(uint16 ItemId) const { return this->ItemRecipesByOutput.Find(ItemId); }
+
+    const TArray<UItemRecipeDataAsset*>& GetItemRecipes() const { return this->ItemRecipes; }
+
+    const TArray<UBuildingRecipeDataAsset*>& GetBuildingRecipes() const { return this->BuildingRecipes; }
+
+    /** Adds the given recipe to the indexes, or re-indexes it if it is already registered */
+    void RegisterItemRecipe(UItemRecipeDataAsset* Recipe);
+
+    /** Adds the given recipe to the indexes, or re-indexes it if it is already registered */
+    void RegisterBuildingRecipe(UBuildingRecipeDataAsset* Recipe);
+
+    /** Removes the given recipe from the recipes and the indexes */
+    void UnregisterRecipe(UObject* Recipe);
+
+    /** Broadcast after recipes were added, removed or re-indexed */
+    FSimpleMulticastDelegate OnRecipesChanged;
+
+protected:
+    void ScanRecipeAssets();
+
+    /** Loads the given recipe assets asynchronously and registers them once they are loaded */
+    void LoadRecipeAssets(const TArray<FSoftObjectPath>& RecipePaths);
+
+    void HandleRecipeAssetsLoaded(TArray<FSoftObjectPath> RecipePaths);
+
+    void HandleAssetAdded(const FAssetData& AssetData);
+
+    void HandleAssetRemoved(const FAssetData& AssetData);
+
+    void HandleAssetRenamed(const FAssetData& AssetData, const FString& OldObjectPath);
+
+    /** Adds the recipe to its list and indexes it, returns false if the object is not a recipe */
+    bool AddRecipe(UObject* RecipeAsset);
+
+    void IndexItemRecipe(UItemRecipeDataAsset* Recipe);
+
+    void UnindexItemRecipe(UItemRecipeDataAsset* Recipe);
+
+    void IndexBuildingRecipe(UBuildingRecipeDataAsset* Recipe);
+
+    void UnindexBuildingRecipe(UBuildingRecipeDataAsset* Recipe);
+
+    static URecipeRegistrySubsystem* Instance;
+
+    UPROPERTY()
+    TArray<UItemRecipeDataAsset*> ItemRecipes;
+
+    UPROPERTY()
+    TArray<UBuildingRecipeDataAsset*> BuildingRecipes;
+
+    /** Building recipes by the path of the buildable class they build */
+    TMap<FTopLevelAssetPath, UBuildingRecipeDataAsset*> BuildingRecipesByClass;
+
+    /** Recipes by item id */
+    TMap<uint16, TArray<UItemRecipeDataAsset*>> ItemRecipesByInput;
+
+    TMap<uint16, TArray<UItemRecipeDataAsset*>> ItemRecipesByOutput;
+
+    TMap<uint16, TArray<UBuildingRecipeDataAsset*>> BuildingRecipesByInput;
+
+    TMap<const UObject*, FRegisteredRecipeKeys> RegisteredKeys;
+
+    FStreamableManager StreamableManager;
+};